@@ -26,6 +26,8 @@
 #	include "fssh_auto_deleter.h"
 #else
 #	include <dirent.h>
+#	include <stdarg.h>
+#	include <stdio.h>
 #	include <stdlib.h>
 #	include <string.h>
 
@@ -77,6 +79,17 @@ template<typename QueryPolicy> class Term;
 template<typename QueryPolicy> class Query;
 
 
+static const int32 kMaxEquations = 32;
+static const int32 kMaxCandidates = 128 * 1024;
+	// an index range that yields more nodes is not worth keeping in memory
+static const int32 kCandidateScoreFactor = 32;
+	// how much larger than the driving equation's index range another index
+	// range may be so that collecting its candidates still pays off
+static const int32 kMaxPatternTrigrams = 32;
+static const int32 kTrigramScoreDivisor = 256;
+	// roughly how much of a trigram index a single trigram covers
+
+
 enum ops {
 	OP_NONE,
 
@@ -107,6 +120,269 @@ union value {
 };
 
 
+static inline const char*
+operatorSymbol(int8 op)
+{
+	switch (op) {
+		case OP_EQUAL: return "==";
+		case OP_UNEQUAL: return "!=";
+		case OP_GREATER_THAN: return ">";
+		case OP_GREATER_THAN_OR_EQUAL: return ">=";
+		case OP_LESS_THAN: return "<";
+		case OP_LESS_THAN_OR_EQUAL: return "<=";
+		case OP_AND: return "&&";
+		case OP_OR: return "||";
+	}
+	return "???";
+}
+
+
+/*!	A sorted set of node IDs, collected from an index without loading any of
+	the nodes. The sets of several equations are intersected (for "&&") or
+	united (for "||") to narrow down the nodes a query has to look at.
+*/
+class CandidateSet {
+public:
+	CandidateSet()
+		:
+		fIDs(NULL),
+		fCount(0),
+		fCapacity(0),
+		fSorted(true)
+	{
+	}
+
+	~CandidateSet()
+	{
+		free(fIDs);
+	}
+
+	int32 Count() const
+	{
+		return fCount;
+	}
+
+	void MakeEmpty()
+	{
+		fCount = 0;
+		fSorted = true;
+	}
+
+	status_t Add(ino_t id)
+	{
+		if (fCount == fCapacity) {
+			int32 capacity = fCapacity > 0 ? fCapacity * 2 : 256;
+			ino_t* ids = (ino_t*)realloc(fIDs, capacity * sizeof(ino_t));
+			if (ids == NULL)
+				return B_NO_MEMORY;
+
+			fIDs = ids;
+			fCapacity = capacity;
+		}
+
+		if (fCount > 0 && id < fIDs[fCount - 1])
+			fSorted = false;
+		fIDs[fCount++] = id;
+		return B_OK;
+	}
+
+	/*!	Sorts the IDs and removes duplicates; needs to be called after the
+		last Add() before the set can be used.
+	*/
+	void Sort()
+	{
+		if (!fSorted) {
+			qsort(fIDs, fCount, sizeof(ino_t), &_CompareIDs);
+			fSorted = true;
+		}
+
+		int32 count = 0;
+		for (int32 i = 0; i < fCount; i++) {
+			if (count == 0 || fIDs[count - 1] != fIDs[i])
+				fIDs[count++] = fIDs[i];
+		}
+		fCount = count;
+	}
+
+	bool Contains(ino_t id) const
+	{
+		int32 lower = 0;
+		int32 upper = fCount;
+		while (lower < upper) {
+			int32 middle = (lower + upper) / 2;
+			if (fIDs[middle] < id)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+		return lower < fCount && fIDs[lower] == id;
+	}
+
+	void Intersect(const CandidateSet& other)
+	{
+		int32 count = 0;
+		int32 otherIndex = 0;
+		for (int32 i = 0; i < fCount && otherIndex < other.fCount; i++) {
+			while (otherIndex < other.fCount
+				&& other.fIDs[otherIndex] < fIDs[i]) {
+				otherIndex++;
+			}
+			if (otherIndex < other.fCount && other.fIDs[otherIndex] == fIDs[i])
+				fIDs[count++] = fIDs[i];
+		}
+		fCount = count;
+	}
+
+	status_t Unite(const CandidateSet& other)
+	{
+		if (other.fCount == 0)
+			return B_OK;
+		if (fCount + other.fCount > kMaxCandidates)
+			return B_BUFFER_OVERFLOW;
+
+		ino_t* ids = (ino_t*)malloc((fCount + other.fCount) * sizeof(ino_t));
+		if (ids == NULL)
+			return B_NO_MEMORY;
+
+		int32 count = 0;
+		int32 i = 0;
+		int32 otherIndex = 0;
+		while (i < fCount || otherIndex < other.fCount) {
+			if (otherIndex == other.fCount
+				|| (i < fCount && fIDs[i] < other.fIDs[otherIndex])) {
+				ids[count++] = fIDs[i++];
+			} else if (i == fCount || other.fIDs[otherIndex] < fIDs[i])
+				ids[count++] = other.fIDs[otherIndex++];
+			else {
+				ids[count++] = fIDs[i++];
+				otherIndex++;
+			}
+		}
+
+		free(fIDs);
+		fIDs = ids;
+		fCapacity = fCount + other.fCount;
+		fCount = count;
+		return B_OK;
+	}
+
+	void Swap(CandidateSet& other)
+	{
+		ino_t* ids = fIDs;
+		int32 count = fCount;
+		int32 capacity = fCapacity;
+		bool sorted = fSorted;
+
+		fIDs = other.fIDs;
+		fCount = other.fCount;
+		fCapacity = other.fCapacity;
+		fSorted = other.fSorted;
+
+		other.fIDs = ids;
+		other.fCount = count;
+		other.fCapacity = capacity;
+		other.fSorted = sorted;
+	}
+
+private:
+	CandidateSet(const CandidateSet& other);
+	CandidateSet& operator=(const CandidateSet& other);
+		// no implementation
+
+	static int _CompareIDs(const void* _a, const void* _b)
+	{
+		ino_t a = *(const ino_t*)_a;
+		ino_t b = *(const ino_t*)_b;
+		return a < b ? -1 : (a > b ? 1 : 0);
+	}
+
+	ino_t*	fIDs;
+	int32	fCount;
+	int32	fCapacity;
+	bool	fSorted;
+};
+
+
+/*!	Collects the textual description of a query plan in a fixed buffer. */
+class PlanPrinter {
+public:
+	PlanPrinter(char* buffer, size_t bufferSize)
+		:
+		fBuffer(buffer),
+		fBufferSize(bufferSize),
+		fLength(0)
+	{
+		if (fBufferSize > 0)
+			fBuffer[0] = '\0';
+	}
+
+	void Print(const char* format, ...)
+	{
+		if (fLength + 1 >= fBufferSize)
+			return;
+
+		va_list args;
+		va_start(args, format);
+		int length = vsnprintf(fBuffer + fLength, fBufferSize - fLength,
+			format, args);
+		va_end(args);
+
+		if (length > 0) {
+			fLength += length;
+			if (fLength >= fBufferSize)
+				fLength = fBufferSize - 1;
+		}
+	}
+
+private:
+	char*	fBuffer;
+	size_t	fBufferSize;
+	size_t	fLength;
+};
+
+
+/*!	Restricts the nodes the driving equation of a query has to look at to the
+	candidates gathered from the indices of the other "&&" terms. The terms
+	whose candidates are exact do not need to be matched against the nodes
+	anymore.
+*/
+template<typename QueryPolicy>
+struct CandidateFilter {
+	CandidateSet		candidates;
+	bool				active;
+	Term<QueryPolicy>*	coveredTerms[kMaxEquations];
+	int32				coveredTermCount;
+
+	CandidateFilter()
+		:
+		active(false),
+		coveredTermCount(0)
+	{
+	}
+
+	void Unset()
+	{
+		candidates.MakeEmpty();
+		active = false;
+		coveredTermCount = 0;
+	}
+
+	bool Accepts(ino_t id) const
+	{
+		return !active || candidates.Contains(id);
+	}
+
+	bool Covers(Term<QueryPolicy>* term) const
+	{
+		for (int32 i = 0; i < coveredTermCount; i++) {
+			if (coveredTerms[i] == term)
+				return true;
+		}
+		return false;
+	}
+};
+
+
 template<typename QueryPolicy>
 class Query {
 public:
@@ -130,6 +406,8 @@ public:
 			status_t		Rewind();
 	inline	status_t		GetNextEntry(struct dirent* dirent, size_t size);
 
+			status_t		DescribePlan(char* buffer, size_t bufferSize);
+
 			void			LiveUpdate(Entry* entry, Node* node,
 								const char* attribute, int32 type,
 								const uint8* oldKey, size_t oldLength,
@@ -147,6 +425,8 @@ public:
 
 private:
 			status_t		_GetNextEntry(struct dirent* dirent, size_t size);
+			status_t		_PrepareFilter(Equation<QueryPolicy>* equation,
+								PlanPrinter* printer = NULL);
 			void			_SendEntryNotification(Entry* entry,
 								status_t (*notify)(port_id, int32, dev_t, ino_t,
 									const char*, ino_t));
@@ -158,6 +438,7 @@ private:
 			IndexIterator*	fIterator;
 			Index			fIndex;
 			Stack<Equation<QueryPolicy>*> fStack;
+			CandidateFilter<QueryPolicy> fFilter;
 
 			uint32			fFlags;
 			port_id			fPort;
@@ -195,11 +476,17 @@ public:
 
 	virtual	void		CalculateScore(Index& index) = 0;
 	virtual	int32		Score() const = 0;
+	virtual	int32		MatchCost() const = 0;
+
+	virtual	status_t	CollectCandidates(Context* context, Index& index,
+							CandidateSet& candidates, bool& _exact) = 0;
 
 	virtual	status_t	InitCheck() = 0;
 
 	virtual	bool		NeedsEntry() = 0;
 
+	virtual	void		Describe(PlanPrinter& printer) = 0;
+
 #ifdef DEBUG_QUERY
 	virtual	void		PrintToStream() = 0;
 #endif
@@ -250,14 +537,23 @@ public:
 			status_t	PrepareQuery(Context* context, Index& index,
 							IndexIterator** iterator, bool queryNonIndexed);
 			status_t	GetNextMatching(Context* context,
-							IndexIterator* iterator, struct dirent* dirent,
-							size_t bufferSize);
+							IndexIterator* iterator,
+							const CandidateFilter<QueryPolicy>& filter,
+							struct dirent* dirent, size_t bufferSize);
 
 	virtual	void		CalculateScore(Index &index);
 	virtual	int32		Score() const { return fScore; }
+	virtual	int32		MatchCost() const;
+
+	virtual	status_t	CollectCandidates(Context* context, Index& index,
+							CandidateSet& candidates, bool& _exact);
 
 	virtual	bool		NeedsEntry();
 
+	virtual	void		Describe(PlanPrinter& printer);
+			bool		HasIndex() const { return fHasIndex; }
+			bool		UsesTrigrams() const { return fUsesTrigrams; }
+
 #ifdef DEBUG_QUERY
 	virtual	void		PrintToStream();
 #endif
@@ -267,8 +563,19 @@ private:
 						Equation& operator=(const Equation& other);
 							// no implementation
 
+			int32		_GetTrigrams(uint32* trigrams) const;
+			status_t	_PrepareTrigramQuery(Index& index,
+							IndexIterator** iterator);
+			status_t	_CollectTrigramCandidates(Index& index,
+							CandidateSet& candidates);
+			status_t	_CollectTrigramList(IndexIterator* iterator,
+							uint32 trigram, CandidateSet& candidates);
+			int32		_CountTrigramList(IndexIterator* iterator,
+							uint32 trigram, int32 maxCount);
+
 			status_t	ConvertValue(type_code type, uint32 size);
 			bool		CompareTo(const uint8* value, size_t size);
+			status_t	FetchNextIndexMatch(IndexIterator* iterator);
 			uint8*		Value() const { return (uint8*)&fValue; }
 
 			char*		fAttribute;
@@ -280,6 +587,8 @@ private:
 
 			int32		fScore;
 			bool		fHasIndex;
+			bool		fUsesTrigrams;
+			uint32		fTrigram;
 };
 
 
@@ -310,11 +619,17 @@ public:
 
 	virtual	void		CalculateScore(Index& index);
 	virtual	int32		Score() const;
+	virtual	int32		MatchCost() const;
+
+	virtual	status_t	CollectCandidates(Context* context, Index& index,
+							CandidateSet& candidates, bool& _exact);
 
 	virtual	status_t	InitCheck();
 
 	virtual	bool		NeedsEntry();
 
+	virtual	void		Describe(PlanPrinter& printer);
+
 #ifdef DEBUG_QUERY
 	virtual	void		PrintToStream();
 #endif
@@ -368,8 +683,12 @@ Equation<QueryPolicy>::Equation(const char** expr)
 	fAttribute(NULL),
 	fString(NULL),
 	fType(0),
+	fSize(0),
 	fIsPattern(false),
-	fScore(INT32_MAX)
+	fScore(INT32_MAX),
+	fHasIndex(false),
+	fUsesTrigrams(false),
+	fTrigram(0)
 {
 	const char* string = *expr;
 	const char* start = string;
@@ -780,11 +1099,26 @@ Equation<QueryPolicy>::CalculateScore(Index &index)
 		// Guess how much of the index we will be able to skip.
 		const int32 divisor = (firstSymbolIndex > 3) ? 4 : (firstSymbolIndex + 1);
 		fScore /= divisor;
+
+		// a trigram index might help more than that
+		uint32 trigrams[kMaxPatternTrigrams];
+		int32 count = _GetTrigrams(trigrams);
+		if (count > 0
+			&& QueryPolicy::IndexSetToTrigrams(index, fAttribute) == B_OK) {
+			int64 score = (int64)QueryPolicy::IndexGetSize(index) * count
+				/ kTrigramScoreDivisor;
+			if (score < fScore)
+				fScore = score > 0 ? score : 1;
+		}
 	} else {
 		// Score by operator
 		if (Term<QueryPolicy>::fOp == OP_EQUAL) {
 			// higher than most patterns
-			fScore /= (fSize > 8) ? 8 : fSize;
+			if (ConvertValue(QueryPolicy::IndexGetType(index),
+					QueryPolicy::IndexGetKeySize(index)) == B_OK
+				&& fSize > 0) {
+				fScore /= (fSize > 8) ? 8 : fSize;
+			}
 		} else {
 			// better than nothing, anyway
 			fScore /= 2;
@@ -798,7 +1132,13 @@ status_t
 Equation<QueryPolicy>::PrepareQuery(Context* /*context*/, Index& index,
 	IndexIterator** iterator, bool queryNonIndexed)
 {
-	status_t status = QueryPolicy::IndexSetTo(index, fAttribute);
+	fUsesTrigrams = false;
+
+	status_t status = _PrepareTrigramQuery(index, iterator);
+	if (status != B_ENTRY_NOT_FOUND)
+		return status;
+
+	status = QueryPolicy::IndexSetTo(index, fAttribute);
 
 	// if we should query attributes without an index, we can just proceed here
 	if (status != B_OK && !queryNonIndexed)
@@ -886,13 +1226,14 @@ Equation<QueryPolicy>::PrepareQuery(Context* /*context*/, Index& index,
 }
 
 
+/*!	Advances \a iterator to the next index entry that matches the equation,
+	without looking at the node behind it.
+*/
 template<typename QueryPolicy>
 status_t
-Equation<QueryPolicy>::GetNextMatching(Context* context,
-	IndexIterator* iterator, struct dirent* dirent, size_t bufferSize)
+Equation<QueryPolicy>::FetchNextIndexMatch(IndexIterator* iterator)
 {
 	while (true) {
-		NodeHolder nodeHolder;
 		union value<QueryPolicy> indexValue;
 		size_t keyLength;
 		size_t duplicate = 0;
@@ -902,6 +1243,16 @@ Equation<QueryPolicy>::GetNextMatching(Context* context,
 		if (status != B_OK)
 			return status;
 
+		if (fUsesTrigrams) {
+			// we are only interested in the nodes of a single trigram; the
+			// key is only valid for the first of its duplicates
+			if (duplicate < 2 && (keyLength != sizeof(uint32)
+					|| indexValue.Uint32 != fTrigram)) {
+				return B_ENTRY_NOT_FOUND;
+			}
+			return B_OK;
+		}
+
 		// only compare against the index entry when this is the correct
 		// index for the equation
 		if (fHasIndex && duplicate < 2 && !CompareTo((uint8*)&indexValue, keyLength)) {
@@ -919,6 +1270,29 @@ Equation<QueryPolicy>::GetNextMatching(Context* context,
 			continue;
 		}
 
+		return B_OK;
+	}
+}
+
+
+template<typename QueryPolicy>
+status_t
+Equation<QueryPolicy>::GetNextMatching(Context* context,
+	IndexIterator* iterator, const CandidateFilter<QueryPolicy>& filter,
+	struct dirent* dirent, size_t bufferSize)
+{
+	while (true) {
+		NodeHolder nodeHolder;
+
+		status_t status = FetchNextIndexMatch(iterator);
+		if (status != B_OK)
+			return status;
+
+		// skip the nodes the other terms' indices have already ruled out
+		// before we load them
+		if (!filter.Accepts(QueryPolicy::IndexIteratorGetNodeID(iterator)))
+			continue;
+
 		Entry* entry = NULL;
 		status = QueryPolicy::IndexIteratorGetEntry(context, iterator,
 			nodeHolder, &entry);
@@ -962,10 +1336,16 @@ Equation<QueryPolicy>::GetNextMatching(Context* context,
 						"(parent = %p)\n", parent);
 					break;
 				}
-				status = other->Match(entry, QueryPolicy::EntryGetNode(entry));
-				if (status < 0) {
-					QUERY_REPORT_ERROR(status);
-					status = NO_MATCH;
+
+				// terms whose index candidates are part of the filter have
+				// already been matched
+				if (!filter.Covers(other)) {
+					status = other->Match(entry,
+						QueryPolicy::EntryGetNode(entry));
+					if (status < 0) {
+						QUERY_REPORT_ERROR(status);
+						status = NO_MATCH;
+					}
 				}
 			}
 			term = (Term<QueryPolicy>*)parent;
@@ -994,6 +1374,293 @@ Equation<QueryPolicy>::GetNextMatching(Context* context,
 }
 
 
+/*!	Returns a rough estimate of how expensive it is to match a node against
+	this equation: the "fake" attributes are part of the node itself, while
+	real attributes may have to be read from disk.
+*/
+template<typename QueryPolicy>
+int32
+Equation<QueryPolicy>::MatchCost() const
+{
+	if (!strcmp(fAttribute, "name") || !strcmp(fAttribute, "size")
+		|| !strcmp(fAttribute, "last_modified"))
+		return 1;
+
+	return 4;
+}
+
+
+/*!	Collects the IDs of all nodes matching this equation from its index,
+	without loading any of them. Fails if the equation has no index, or if
+	it would need to scan the whole index anyway.
+*/
+template<typename QueryPolicy>
+status_t
+Equation<QueryPolicy>::CollectCandidates(Context* context, Index& index,
+	CandidateSet& candidates, bool& _exact)
+{
+	if (Term<QueryPolicy>::fOp == OP_UNEQUAL)
+		return B_NOT_SUPPORTED;
+
+	status_t status = _CollectTrigramCandidates(index, candidates);
+	if (status != B_NOT_SUPPORTED) {
+		// the trigrams don't tell us if the pattern actually matches
+		_exact = false;
+		return status;
+	}
+
+	if (QueryPolicy::IndexSetTo(index, fAttribute) != B_OK)
+		return B_NOT_SUPPORTED;
+
+	IndexIterator* iterator = NULL;
+	status = PrepareQuery(context, index, &iterator, false);
+	if (iterator == NULL)
+		return status != B_OK ? status : B_ERROR;
+
+	if (status == B_OK) {
+		while ((status = FetchNextIndexMatch(iterator)) == B_OK) {
+			if (candidates.Count() >= kMaxCandidates) {
+				status = B_BUFFER_OVERFLOW;
+				break;
+			}
+
+			status = candidates.Add(
+				QueryPolicy::IndexIteratorGetNodeID(iterator));
+			if (status != B_OK)
+				break;
+		}
+	}
+
+	QueryPolicy::IndexIteratorDelete(iterator);
+
+	// B_ENTRY_NOT_FOUND just means that we reached the end of the range
+	if (status != B_ENTRY_NOT_FOUND)
+		return status;
+
+	candidates.Sort();
+	_exact = true;
+	return B_OK;
+}
+
+
+/*!	Fills \a trigrams with the trigrams of the pattern, if it is one a trigram
+	index could help with: one that doesn't start with a prefix that can be
+	looked up in the regular index already.
+*/
+template<typename QueryPolicy>
+int32
+Equation<QueryPolicy>::_GetTrigrams(uint32* trigrams) const
+{
+	if (!fIsPattern || Term<QueryPolicy>::fOp != OP_EQUAL
+		|| getFirstPatternSymbol(fString) >= 3)
+		return 0;
+
+	return getPatternTrigrams(fString, trigrams, kMaxPatternTrigrams);
+}
+
+
+/*!	Prepares \a iterator to walk the nodes that contain the least common
+	trigram of the pattern, if there is a trigram index for the attribute.
+	The nodes still need to be matched, but the query can rule out most of
+	them by the other trigrams, see CollectCandidates().
+	Returns \c B_ENTRY_NOT_FOUND if the trigram index can't be used.
+*/
+template<typename QueryPolicy>
+status_t
+Equation<QueryPolicy>::_PrepareTrigramQuery(Index& index,
+	IndexIterator** iterator)
+{
+	uint32 trigrams[kMaxPatternTrigrams];
+	int32 count = _GetTrigrams(trigrams);
+	if (count == 0
+		|| QueryPolicy::IndexSetToTrigrams(index, fAttribute) != B_OK)
+		return B_ENTRY_NOT_FOUND;
+
+	if (ConvertValue(B_STRING_TYPE, 0) < B_OK)
+		return B_BAD_VALUE;
+
+	*iterator = QueryPolicy::IndexCreateIterator(index);
+	if (*iterator == NULL)
+		return B_NO_MEMORY;
+
+	fTrigram = trigrams[0];
+	int32 trigramCount = _CountTrigramList(*iterator, fTrigram, INT32_MAX);
+	for (int32 i = 1; i < count && trigramCount > 0; i++) {
+		int32 otherCount = _CountTrigramList(*iterator, trigrams[i],
+			trigramCount);
+		if (otherCount < trigramCount) {
+			fTrigram = trigrams[i];
+			trigramCount = otherCount;
+		}
+	}
+
+	fHasIndex = false;
+	fUsesTrigrams = true;
+
+	status_t status = QueryPolicy::IndexIteratorFind(*iterator, &fTrigram,
+		sizeof(uint32));
+	if (status == B_ENTRY_NOT_FOUND) {
+		// FetchNextIndexMatch() will stop at the next trigram
+		return B_OK;
+	}
+
+	QUERY_RETURN_ERROR(status);
+}
+
+
+/*!	Collects the nodes that contain all trigrams of the pattern from the
+	trigram index. Trigrams that are too common are ignored.
+	Returns \c B_NOT_SUPPORTED if there is no trigram index to use.
+*/
+template<typename QueryPolicy>
+status_t
+Equation<QueryPolicy>::_CollectTrigramCandidates(Index& index,
+	CandidateSet& candidates)
+{
+	uint32 trigrams[kMaxPatternTrigrams];
+	int32 count = _GetTrigrams(trigrams);
+	if (count == 0
+		|| QueryPolicy::IndexSetToTrigrams(index, fAttribute) != B_OK)
+		return B_NOT_SUPPORTED;
+
+	IndexIterator* iterator = QueryPolicy::IndexCreateIterator(index);
+	if (iterator == NULL)
+		return B_NO_MEMORY;
+
+	// Count the posting lists first, so that the shortest ones are read
+	// first, and those that would hardly narrow down the result any further
+	// are not read at all
+	int32 counts[kMaxPatternTrigrams];
+	int32 shortest = kMaxCandidates;
+	for (int32 i = 0; i < count; i++) {
+		int32 limit = shortest < kMaxCandidates / kCandidateScoreFactor
+			? shortest * kCandidateScoreFactor + 1 : kMaxCandidates;
+		counts[i] = _CountTrigramList(iterator, trigrams[i], limit);
+		if (counts[i] < shortest)
+			shortest = counts[i];
+
+		for (int32 j = i; j > 0 && counts[j] < counts[j - 1]; j--) {
+			int32 otherCount = counts[j];
+			counts[j] = counts[j - 1];
+			counts[j - 1] = otherCount;
+			uint32 otherTrigram = trigrams[j];
+			trigrams[j] = trigrams[j - 1];
+			trigrams[j - 1] = otherTrigram;
+		}
+	}
+
+	bool collected = false;
+	status_t status = B_OK;
+
+	for (int32 i = 0; i < count; i++) {
+		if (counts[i] >= kMaxCandidates
+			|| (collected
+				&& counts[i] > candidates.Count() * kCandidateScoreFactor)) {
+			break;
+		}
+
+		CandidateSet list;
+		status = _CollectTrigramList(iterator, trigrams[i], list);
+		if (status == B_BUFFER_OVERFLOW) {
+			status = B_OK;
+			break;
+		}
+		if (status != B_OK)
+			break;
+
+		if (collected)
+			candidates.Intersect(list);
+		else {
+			candidates.Swap(list);
+			collected = true;
+		}
+
+		if (candidates.Count() == 0)
+			break;
+	}
+
+	QueryPolicy::IndexIteratorDelete(iterator);
+
+	if (status != B_OK)
+		return status;
+
+	return collected ? B_OK : B_NOT_SUPPORTED;
+}
+
+
+template<typename QueryPolicy>
+status_t
+Equation<QueryPolicy>::_CollectTrigramList(IndexIterator* iterator,
+	uint32 trigram, CandidateSet& candidates)
+{
+	status_t status = QueryPolicy::IndexIteratorFind(iterator, &trigram,
+		sizeof(uint32));
+	if (status == B_ENTRY_NOT_FOUND)
+		return B_OK;
+	if (status != B_OK)
+		return status;
+
+	while (true) {
+		union value<QueryPolicy> indexValue;
+		size_t keyLength;
+		size_t duplicate = 0;
+
+		status = QueryPolicy::IndexIteratorFetchNextEntry(iterator,
+			&indexValue, &keyLength, (size_t)sizeof(indexValue), &duplicate);
+		if (status == B_ENTRY_NOT_FOUND
+			|| (status == B_OK && duplicate < 2
+				&& (keyLength != sizeof(uint32)
+					|| indexValue.Uint32 != trigram))) {
+			break;
+		}
+		if (status != B_OK)
+			return status;
+
+		if (candidates.Count() >= kMaxCandidates)
+			return B_BUFFER_OVERFLOW;
+
+		status = candidates.Add(QueryPolicy::IndexIteratorGetNodeID(iterator));
+		if (status != B_OK)
+			return status;
+	}
+
+	candidates.Sort();
+	return B_OK;
+}
+
+
+/*!	Returns how many nodes contain the trigram, but stops counting at
+	\a maxCount.
+*/
+template<typename QueryPolicy>
+int32
+Equation<QueryPolicy>::_CountTrigramList(IndexIterator* iterator,
+	uint32 trigram, int32 maxCount)
+{
+	if (QueryPolicy::IndexIteratorFind(iterator, &trigram, sizeof(uint32))
+			!= B_OK)
+		return 0;
+
+	int32 count = 0;
+	while (count < maxCount) {
+		union value<QueryPolicy> indexValue;
+		size_t keyLength;
+		size_t duplicate = 0;
+
+		if (QueryPolicy::IndexIteratorFetchNextEntry(iterator, &indexValue,
+				&keyLength, (size_t)sizeof(indexValue), &duplicate) != B_OK
+			|| (duplicate < 2 && (keyLength != sizeof(uint32)
+				|| indexValue.Uint32 != trigram))) {
+			break;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+
 template<typename QueryPolicy>
 bool
 Equation<QueryPolicy>::NeedsEntry()
@@ -1002,6 +1669,15 @@ Equation<QueryPolicy>::NeedsEntry()
 }
 
 
+template<typename QueryPolicy>
+void
+Equation<QueryPolicy>::Describe(PlanPrinter& printer)
+{
+	printer.Print("%s %s \"%s\"", fAttribute,
+		operatorSymbol(Term<QueryPolicy>::fOp), fString);
+}
+
+
 //	#pragma mark -
 
 
@@ -1034,12 +1710,20 @@ Operator<QueryPolicy>::Match(Entry* entry, Node* node, const char* attribute,
 	int32 type, const uint8* key, size_t size)
 {
 	if (Term<QueryPolicy>::fOp == OP_AND) {
-		status_t status = fLeft->Match(entry, node, attribute, type, key,
+		// match the cheaper term first, the other one might not be needed
+		Term<QueryPolicy>* first = fLeft;
+		Term<QueryPolicy>* second = fRight;
+		if (fRight->MatchCost() < fLeft->MatchCost()) {
+			first = fRight;
+			second = fLeft;
+		}
+
+		status_t status = first->Match(entry, node, attribute, type, key,
 			size);
 		if (status != MATCH_OK)
 			return status;
 
-		return fRight->Match(entry, node, attribute, type, key, size);
+		return second->Match(entry, node, attribute, type, key, size);
 	} else {
 		// choose the term with the better score for OP_OR
 		Term<QueryPolicy>* first;
@@ -1103,6 +1787,61 @@ Operator<QueryPolicy>::Score() const
 }
 
 
+template<typename QueryPolicy>
+int32
+Operator<QueryPolicy>::MatchCost() const
+{
+	return fLeft->MatchCost() + fRight->MatchCost();
+}
+
+
+/*!	Intersects (for "&&") or unites (for "||") the candidates of both terms.
+	An "&&" can still narrow down the candidates if only one of its terms
+	has an index, but then the result is no longer exact.
+*/
+template<typename QueryPolicy>
+status_t
+Operator<QueryPolicy>::CollectCandidates(Context* context, Index& index,
+	CandidateSet& candidates, bool& _exact)
+{
+	bool leftExact = false;
+	status_t status = fLeft->CollectCandidates(context, index, candidates,
+		leftExact);
+	if (status != B_OK) {
+		candidates.MakeEmpty();
+		if (Term<QueryPolicy>::fOp == OP_OR)
+			return status;
+	}
+
+	CandidateSet rightCandidates;
+	bool rightExact = false;
+	status_t rightStatus = fRight->CollectCandidates(context, index,
+		rightCandidates, rightExact);
+
+	if (Term<QueryPolicy>::fOp == OP_OR) {
+		if (rightStatus != B_OK)
+			return rightStatus;
+
+		_exact = leftExact && rightExact;
+		return candidates.Unite(rightCandidates);
+	}
+
+	if (status != B_OK && rightStatus != B_OK)
+		return status;
+
+	if (status != B_OK) {
+		candidates.Swap(rightCandidates);
+		_exact = false;
+	} else if (rightStatus != B_OK)
+		_exact = false;
+	else {
+		candidates.Intersect(rightCandidates);
+		_exact = leftExact && rightExact;
+	}
+	return B_OK;
+}
+
+
 template<typename QueryPolicy>
 status_t
 Operator<QueryPolicy>::InitCheck()
@@ -1124,6 +1863,18 @@ Operator<QueryPolicy>::NeedsEntry()
 }
 
 
+template<typename QueryPolicy>
+void
+Operator<QueryPolicy>::Describe(PlanPrinter& printer)
+{
+	printer.Print("(");
+	fLeft->Describe(printer);
+	printer.Print(") %s (", operatorSymbol(Term<QueryPolicy>::fOp));
+	fRight->Describe(printer);
+	printer.Print(")");
+}
+
+
 //	#pragma mark -
 
 #ifdef DEBUG_QUERY
@@ -1155,16 +1906,8 @@ template<typename QueryPolicy>
 void
 Equation<QueryPolicy>::PrintToStream()
 {
-	const char* symbol = "???";
-	switch (Term<QueryPolicy>::fOp) {
-		case OP_EQUAL: symbol = "=="; break;
-		case OP_UNEQUAL: symbol = "!="; break;
-		case OP_GREATER_THAN: symbol = ">"; break;
-		case OP_GREATER_THAN_OR_EQUAL: symbol = ">="; break;
-		case OP_LESS_THAN: symbol = "<"; break;
-		case OP_LESS_THAN_OR_EQUAL: symbol = "<="; break;
-	}
-	QUERY_D(__out("[\"%s\" %s \"%s\"]", fAttribute, symbol, fString));
+	QUERY_D(__out("[\"%s\" %s \"%s\"]", fAttribute,
+		operatorSymbol(Term<QueryPolicy>::fOp), fString));
 }
 
 #endif	// DEBUG_QUERY
@@ -1191,7 +1934,6 @@ Expression<QueryPolicy>::Init(const char* expr, const char** position)
 
 	status_t status = B_OK;
 	int32 equations = 0;
-	const int32 kMaxEquations = 32;
 
 	struct ExpressionNode {
 		Term<QueryPolicy>* term = NULL;
@@ -1482,6 +2224,7 @@ Query<QueryPolicy>::Rewind()
 	// free previous stuff
 
 	fStack.MakeEmpty();
+	fFilter.Unset();
 
 	QueryPolicy::IndexIteratorDelete(fIterator);
 	fIterator = NULL;
@@ -1652,6 +2395,8 @@ Query<QueryPolicy>::_GetNextEntry(struct dirent* dirent, size_t size)
 				|| fCurrent == NULL)
 				return B_ENTRY_NOT_FOUND;
 
+			fFilter.Unset();
+
 			status_t status = fCurrent->PrepareQuery(fContext, fIndex,
 				&fIterator, fFlags & B_QUERY_NON_INDEXED);
 			if (status == B_ENTRY_NOT_FOUND) {
@@ -1661,12 +2406,24 @@ Query<QueryPolicy>::_GetNextEntry(struct dirent* dirent, size_t size)
 
 			if (status != B_OK)
 				return status;
+
+			status = _PrepareFilter(fCurrent);
+			if (status != B_OK)
+				return status;
+
+			if (fFilter.active && fFilter.candidates.Count() == 0) {
+				// the other terms don't leave anything to look at
+				QueryPolicy::IndexIteratorDelete(fIterator);
+				fIterator = NULL;
+				fCurrent = NULL;
+				continue;
+			}
 		}
 		if (fCurrent == NULL)
 			QUERY_RETURN_ERROR(B_ERROR);
 
-		status_t status = fCurrent->GetNextMatching(fContext, fIterator, dirent,
-			size);
+		status_t status = fCurrent->GetNextMatching(fContext, fIterator,
+			fFilter, dirent, size);
 		if (status != B_OK) {
 			QueryPolicy::IndexIteratorDelete(fIterator);
 			fIterator = NULL;
@@ -1679,6 +2436,155 @@ Query<QueryPolicy>::_GetNextEntry(struct dirent* dirent, size_t size)
 }
 
 
+/*!	Gathers the candidates of the terms that are "&&"-ed with \a equation
+	from their indices, as far as that is cheaper than loading the nodes the
+	equation's own index yields, and sets up fFilter with them.
+	If \a printer is given, the decisions are described there as well.
+*/
+template<typename QueryPolicy>
+status_t
+Query<QueryPolicy>::_PrepareFilter(Equation<QueryPolicy>* equation,
+	PlanPrinter* printer)
+{
+	fFilter.Unset();
+
+	// Use a separate index object, as fIndex must stay with the iterator
+	Index index(fContext);
+
+	int64 maxScore = (int64)(equation->Score() > 0 ? equation->Score() : 1)
+		* kCandidateScoreFactor;
+
+	if (equation->UsesTrigrams()) {
+		// only the nodes that contain all of the pattern's trigrams can match
+		CandidateSet candidates;
+		bool exact = false;
+		status_t status = equation->CollectCandidates(fContext, index,
+			candidates, exact);
+		QueryPolicy::IndexUnset(index);
+
+		if (status == B_NO_MEMORY)
+			return status;
+		if (status == B_OK) {
+			if (printer != NULL) {
+				printer->Print("    trigrams: %" B_PRId32 " candidates\n",
+					candidates.Count());
+			}
+			fFilter.candidates.Swap(candidates);
+			fFilter.active = true;
+		}
+	}
+
+	Term<QueryPolicy>* term = equation;
+	while (Operator<QueryPolicy>* parent
+			= (Operator<QueryPolicy>*)term->Parent()) {
+		if (parent->Op() != OP_AND) {
+			term = parent;
+			continue;
+		}
+
+		Term<QueryPolicy>* other = parent->Right();
+		if (other == term)
+			other = parent->Left();
+		term = parent;
+
+		if (printer != NULL) {
+			printer->Print("    && ");
+			other->Describe(*printer);
+		}
+
+		if (other->Score() > maxScore) {
+			if (printer != NULL)
+				printer->Print(": match (score %" B_PRId32 ")\n", other->Score());
+			continue;
+		}
+
+		CandidateSet candidates;
+		bool exact = false;
+		status_t status = other->CollectCandidates(fContext, index, candidates,
+			exact);
+		QueryPolicy::IndexUnset(index);
+
+		if (status == B_NO_MEMORY)
+			return status;
+		if (status != B_OK) {
+			if (printer != NULL)
+				printer->Print(": match (no usable index)\n");
+			continue;
+		}
+
+		if (printer != NULL) {
+			printer->Print(": %" B_PRId32 " candidates from index%s\n",
+				candidates.Count(), exact ? "" : ", then match");
+		}
+
+		if (fFilter.active)
+			fFilter.candidates.Intersect(candidates);
+		else {
+			fFilter.candidates.Swap(candidates);
+			fFilter.active = true;
+		}
+
+		if (exact)
+			fFilter.coveredTerms[fFilter.coveredTermCount++] = other;
+	}
+
+	if (printer != NULL && fFilter.active) {
+		printer->Print("    -> %" B_PRId32 " nodes to look at\n",
+			fFilter.candidates.Count());
+	}
+
+	return B_OK;
+}
+
+
+/*!	Describes how the query is going to be evaluated: which equations walk
+	an index, and how the other terms narrow down the nodes they yield.
+	This gathers the candidate sets, but does not look at any node.
+*/
+template<typename QueryPolicy>
+status_t
+Query<QueryPolicy>::DescribePlan(char* buffer, size_t bufferSize)
+{
+	PlanPrinter printer(buffer, bufferSize);
+
+	status_t status = Rewind();
+	if (status != B_OK)
+		return status;
+
+	for (int32 i = fStack.CountItems() - 1; i >= 0; i--) {
+		Equation<QueryPolicy>* equation = fStack.Array()[i];
+
+		printer.Print("%" B_PRId32 ". ", fStack.CountItems() - i);
+		equation->Describe(printer);
+
+		Index index(fContext);
+		IndexIterator* iterator = NULL;
+		status = equation->PrepareQuery(fContext, index, &iterator,
+			(fFlags & B_QUERY_NON_INDEXED) != 0);
+		QueryPolicy::IndexIteratorDelete(iterator);
+		QueryPolicy::IndexUnset(index);
+
+		if (status == B_ENTRY_NOT_FOUND && iterator == NULL) {
+			printer.Print(": no index, skipped\n");
+			continue;
+		}
+		printer.Print(": %s (score %" B_PRId32 ")\n",
+			equation->UsesTrigrams() ? "walk trigram index"
+				: equation->HasIndex() ? "walk index" : "scan name index",
+			equation->Score());
+
+		status = _PrepareFilter(equation, &printer);
+		if (status != B_OK) {
+			fFilter.Unset();
+			return status;
+		}
+	}
+
+	fFilter.Unset();
+	return B_OK;
+}
+
+
 template<typename QueryPolicy>
 void
 Query<QueryPolicy>::_SendEntryNotification(Entry* entry,
@@ -38,6 +38,9 @@ enum {
 	PATTERN_INVALID_SET
 };
 
+// the most trigrams a key of an index can consist of
+static const int32 kMaxKeyTrigrams = 256;
+
 
 __BEGIN_DECLS
 
@@ -50,6 +53,10 @@ uint32		utf8ToUnicode(const char** string);
 int32		getFirstPatternSymbol(const char* string);
 status_t	isValidPattern(const char* pattern);
 status_t	matchString(const char* pattern, const char* string);
+int32		getTrigrams(const char* string, size_t length, uint32* trigrams,
+				int32 maxCount);
+int32		getPatternTrigrams(const char* pattern, uint32* trigrams,
+				int32 maxCount);
 
 
 __END_DECLS
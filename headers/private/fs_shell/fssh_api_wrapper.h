@@ -63,6 +63,8 @@
 #define atomic_and			fssh_atomic_and
 #define atomic_or			fssh_atomic_or
 #define atomic_get			fssh_atomic_get
+#define atomic_set64		fssh_atomic_set64
+#define atomic_get64		fssh_atomic_get64
 
 
 ////////////////////////////////////////////////////////////////////////////////
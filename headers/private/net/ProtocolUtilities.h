@@ -117,9 +117,13 @@ public:
 			status_t			EnqueueClone(net_buffer* buffer);
 
 			status_t			Dequeue(uint32 flags, net_buffer** _buffer);
+			status_t			Dequeue(uint32 flags, net_buffer** _buffers,
+									size_t* _count);
 			net_buffer*			Dequeue(bool clone);
 			status_t			BlockingDequeue(bool peek, bigtime_t timeout,
 									net_buffer** _buffer);
+			status_t			BlockingDequeue(bool peek, bigtime_t timeout,
+									net_buffer** _buffers, size_t* _count);
 
 			void				Clear();
 
@@ -221,6 +225,17 @@ DECL_DATAGRAM_SOCKET(inline status_t)::Dequeue(uint32 flags,
 }
 
 
+DECL_DATAGRAM_SOCKET(inline status_t)::Dequeue(uint32 flags,
+	net_buffer** _buffers, size_t* _count)
+{
+	 if ((flags & ~(MSG_DONTWAIT | MSG_PEEK)) != 0)
+		return EOPNOTSUPP;
+
+	return BlockingDequeue((flags & MSG_PEEK) != 0, _SocketTimeout(flags),
+		_buffers, _count);
+}
+
+
 DECL_DATAGRAM_SOCKET(inline net_buffer*)::Dequeue(bool peek)
 {
 	AutoLocker _(fLock);
@@ -263,6 +278,56 @@ DECL_DATAGRAM_SOCKET(inline status_t)::BlockingDequeue(bool peek,
 }
 
 
+/*!	Dequeues up to \a _count buffers while holding the lock only once. Waits
+	until at least one buffer is available, but not for any further ones.
+	On success, \a _count is set to the number of buffers returned. When
+	peeking, only the first buffer is returned.
+*/
+DECL_DATAGRAM_SOCKET(inline status_t)::BlockingDequeue(bool peek,
+	bigtime_t timeout, net_buffer** _buffers, size_t* _count)
+{
+	size_t maxCount = peek ? min_c(*_count, 1) : *_count;
+	if (maxCount == 0)
+		return B_BAD_VALUE;
+
+	AutoLocker _(fLock);
+
+	bool waited = false;
+	while (fBuffers.IsEmpty()) {
+		status_t status = SocketStatus(peek);
+		if (status != B_OK) {
+			if (peek)
+				_NotifyOneReader(false);
+			return status;
+		}
+
+		status = _Wait(timeout);
+		if (status != B_OK)
+			return status;
+
+		waited = true;
+	}
+
+	size_t count = 0;
+	while (count < maxCount) {
+		net_buffer* buffer = _Dequeue(peek);
+		if (buffer == NULL)
+			break;
+
+		_buffers[count++] = buffer;
+	}
+
+	if (peek && waited)
+		_NotifyOneReader(false);
+
+	*_count = count;
+	if (count == 0)
+		return B_NO_MEMORY;
+
+	return B_OK;
+}
+
+
 DECL_DATAGRAM_SOCKET(inline void)::Clear()
 {
 	AutoLocker _(fLock);
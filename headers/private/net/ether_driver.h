@@ -28,6 +28,8 @@ enum {
 
 	ETHER_SEND_NET_BUFFER,					/* send a net_buffer */
 	ETHER_RECEIVE_NET_BUFFER,				/* receive a net_buffer */
+	ETHER_RECEIVE_NET_BUFFERS,
+		/* receive several net_buffers (ether_receive_net_buffers_t *) */
 };
 
 
@@ -36,6 +38,12 @@ typedef struct ether_address {
 	uint8	ebyte[6];
 } ether_address_t;
 
+/* ETHER_RECEIVE_NET_BUFFERS - waits for the first buffer only */
+typedef struct ether_receive_net_buffers {
+	struct net_buffer**	buffers;
+	uint32				count;	/* in: size of buffers, out: # received */
+} ether_receive_net_buffers_t;
+
 /* ETHER_GETLINKSTATE */
 typedef struct ether_link_state {
 	uint32	media;		/* as specified in net/if_media.h */
@@ -61,6 +61,9 @@ struct net_device_module_info {
 					const struct sockaddr* address);
 	status_t	(*remove_multicast)(net_device* device,
 					const struct sockaddr* address);
+
+	status_t	(*receive_data_batch)(net_device* device, net_buffer** _buffers,
+					uint32* _count);
 };
 
 
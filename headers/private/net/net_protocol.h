@@ -114,6 +114,10 @@ struct net_protocol_module_info {
 					size_t vecCount, ancillary_data_container** _ancillaryData,
 					struct sockaddr* _address, socklen_t* _addressLength,
 					int flags);
+
+	status_t	(*read_data_batch)(net_protocol* self, uint32 flags,
+					net_buffer** _buffers, size_t* _count);
+	status_t	(*receive_data_batch)(net_buffer** buffers, size_t count);
 };
 
 
@@ -113,6 +113,12 @@ struct net_socket_module_info {
 	int			(*shutdown)(net_socket* socket, int direction);
 	status_t	(*socketpair)(int family, int type, int protocol,
 					net_socket* _sockets[2]);
+
+	// batched datagram API
+	ssize_t		(*receive_batch)(net_socket* socket, struct mmsghdr* messages,
+					size_t count, int flags, bigtime_t timeout);
+	ssize_t		(*send_batch)(net_socket* socket, struct mmsghdr* messages,
+					size_t count, int flags);
 };
 
 
@@ -42,6 +42,8 @@ struct net_stack_interface_module_info {
 					int flags, struct sockaddr* address,
 					socklen_t* _addressLength);
 	ssize_t (*recvmsg)(net_socket* socket, struct msghdr* message, int flags);
+	ssize_t (*recvmmsg)(net_socket* socket, struct mmsghdr* messages,
+					size_t count, int flags, bigtime_t timeout);
 
 	ssize_t (*send)(net_socket* socket, const void* data, size_t length,
 					int flags);
@@ -50,6 +52,8 @@ struct net_stack_interface_module_info {
 					socklen_t addressLength);
 	ssize_t (*sendmsg)(net_socket* socket, const struct msghdr* message,
 					int flags);
+	ssize_t (*sendmmsg)(net_socket* socket, struct mmsghdr* messages,
+					size_t count, int flags);
 
 	status_t (*getsockopt)(net_socket* socket, int level, int option,
 					void* value, socklen_t* _length);
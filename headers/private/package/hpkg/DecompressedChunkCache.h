@@ -0,0 +1,103 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__HPKG__PRIVATE__DECOMPRESSED_CHUNK_CACHE_H_
+#define _PACKAGE__HPKG__PRIVATE__DECOMPRESSED_CHUNK_CACHE_H_
+
+
+#include <pthread.h>
+
+#include <SupportDefs.h>
+
+#include <util/DoublyLinkedList.h>
+#include <util/OpenHashTable.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+/*!	A bounded LRU cache of decompressed heap chunks, shared by all heap
+	readers of the team.
+
+	Chunks are identified by the ID of the heap they belong to -- clones of a
+	heap reader share the ID -- and their index. A chunk returned by Get() or
+	Create() is referenced and must be released with Put().
+*/
+class DecompressedChunkCache {
+public:
+			class Chunk;
+
+public:
+								DecompressedChunkCache(size_t maxChunks);
+								~DecompressedChunkCache();
+
+	static	DecompressedChunkCache* Default();
+	static	uint64				AllocateHeapID();
+
+			Chunk*				Get(uint64 heapID, size_t chunkIndex);
+			Chunk*				Create(size_t size);
+									// NULL, if the cache is disabled
+			void				Add(uint64 heapID, size_t chunkIndex,
+									Chunk* chunk);
+			void				Put(Chunk* chunk);
+
+			void				SetMaxChunks(size_t maxChunks);
+									// 0 disables the cache
+			void				GetStatistics(uint64& _hits,
+									uint64& _misses) const;
+
+private:
+			struct ChunkHashDefinition;
+
+			typedef BOpenHashTable<ChunkHashDefinition> ChunkTable;
+			typedef DoublyLinkedList<Chunk> ChunkList;
+
+private:
+			void				_Evict();
+			void				_Delete(Chunk* chunk);
+
+private:
+	mutable	pthread_mutex_t		fLock;
+			ChunkTable*			fChunks;
+			ChunkList			fUnusedChunks;
+									// least recently used first
+			size_t				fChunkCount;
+			size_t				fMaxChunks;
+			uint64				fHits;
+			uint64				fMisses;
+};
+
+
+class DecompressedChunkCache::Chunk
+	: public DoublyLinkedListLinkImpl<Chunk> {
+public:
+			void*				Data() const	{ return fData; }
+			size_t				Size() const	{ return fSize; }
+
+private:
+			friend class DecompressedChunkCache;
+
+private:
+			Chunk*				fHashNext;
+			uint64				fHeapID;
+			size_t				fIndex;
+			void*				fData;
+			size_t				fSize;
+			int32				fReferenceCount;
+			bool				fCached;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
+
+
+#endif	// _PACKAGE__HPKG__PRIVATE__DECOMPRESSED_CHUNK_CACHE_H_
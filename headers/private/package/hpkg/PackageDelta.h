@@ -0,0 +1,139 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__HPKG__PRIVATE__PACKAGE_DELTA_H_
+#define _PACKAGE__HPKG__PRIVATE__PACKAGE_DELTA_H_
+
+
+#include <SupportDefs.h>
+
+
+class BPositionIO;
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+
+class BErrorOutput;
+
+
+namespace BPrivate {
+
+
+/*!	A package delta allows reconstructing a package file from an older version
+	of the package.
+
+	The delta is a list of commands, each of which produces the next piece of
+	the new package file: either by copying a range of the old package file or
+	by copying literal data stored in the delta right after the command. Since
+	the heap chunks are compressed independently, an unchanged chunk is
+	byte-identical in both packages and can be copied as is. This includes the
+	TOC and package attributes sections, which are stored at the end of the
+	heap. All values are stored big endian.
+*/
+
+
+enum {
+	B_HPKG_DELTA_MAGIC		= 'hpkd',
+	B_HPKG_DELTA_VERSION	= 1
+};
+
+
+enum {
+	B_HPKG_DELTA_COMMAND_COPY	= 1,
+		// copy <size> bytes at <offset> of the old package
+	B_HPKG_DELTA_COMMAND_DATA	= 2
+		// copy the <size> bytes following the command
+};
+
+
+// delta file header
+struct hpkg_delta_header {
+	uint32	magic;							// "hpkd"
+	uint16	header_size;
+	uint16	version;
+	uint64	command_count;
+	uint64	old_package_size;
+	uint64	new_package_size;
+	uint8	old_package_checksum[32];		// SHA-256
+	uint8	new_package_checksum[32];		// SHA-256
+};
+
+
+struct hpkg_delta_command {
+	uint32	type;
+	uint32	reserved;
+	uint64	offset;
+	uint64	size;
+};
+
+
+class PackageDeltaWriter {
+public:
+								PackageDeltaWriter(BErrorOutput* errorOutput);
+								~PackageDeltaWriter();
+
+			status_t			WriteDelta(BPositionIO* oldPackageFile,
+									BPositionIO* newPackageFile,
+									BPositionIO* deltaFile);
+
+			uint64				CopiedSize() const
+									{ return fCopiedSize; }
+			uint64				DataSize() const
+									{ return fDataSize; }
+
+private:
+			status_t			_AddCommand(uint32 type, uint64 offset,
+									uint64 size);
+			status_t			_FlushCommand();
+
+private:
+			BErrorOutput*		fErrorOutput;
+			BPositionIO*		fNewPackageFile;
+			BPositionIO*		fDeltaFile;
+			off_t				fDeltaOffset;
+			uint64				fCommandCount;
+			hpkg_delta_command	fPendingCommand;
+			uint64				fCopiedSize;
+			uint64				fDataSize;
+};
+
+
+class PackageDeltaReader {
+public:
+								PackageDeltaReader(BErrorOutput* errorOutput);
+								~PackageDeltaReader();
+
+			status_t			Init(BPositionIO* deltaFile);
+
+			uint64				OldPackageSize() const
+									{ return fHeader.old_package_size; }
+			uint64				NewPackageSize() const
+									{ return fHeader.new_package_size; }
+
+			status_t			Apply(BPositionIO* oldPackageFile,
+									BPositionIO* newPackageFile);
+									// verifies the checksums of both the old
+									// and the reconstructed package
+
+private:
+			status_t			_CheckOldPackage(BPositionIO* oldPackageFile);
+
+private:
+			BErrorOutput*		fErrorOutput;
+			BPositionIO*		fDeltaFile;
+			hpkg_delta_header	fHeader;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
+
+
+#endif	// _PACKAGE__HPKG__PRIVATE__PACKAGE_DELTA_H_
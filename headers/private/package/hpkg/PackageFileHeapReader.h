@@ -39,6 +39,12 @@ public:
 			const OffsetArray&	Offsets() const
 									{ return fOffsets; }
 
+#ifndef _KERNEL_MODE
+	// BAbstractBufferedDataReader
+	virtual	status_t			ReadDataToOutput(off_t offset,
+									size_t size, BDataIO* output);
+#endif
+
 protected:
 	virtual	status_t			ReadAndDecompressChunk(size_t chunkIndex,
 									void* compressedDataBuffer,
@@ -47,6 +53,11 @@ protected:
 
 private:
 			OffsetArray			fOffsets;
+#ifndef _KERNEL_MODE
+			uint64				fHeapID;
+									// shared with clones, identifies the
+									// heap's chunks in the chunk cache
+#endif
 };
 
 
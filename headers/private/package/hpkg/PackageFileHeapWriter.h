@@ -42,7 +42,8 @@ public:
 										decompressionAlgorithm);
 								~PackageFileHeapWriter();
 
-			void				Init();
+			void				Init(int32 compressionThreadCount = -1);
+									// -1: one thread per CPU
 			void				Reinit(PackageFileHeapReader* heapReader);
 
 			status_t			AddData(BDataReader& dataReader, off_t size,
@@ -64,6 +65,8 @@ private:
 			struct Chunk;
 			struct ChunkSegment;
 			struct ChunkBuffer;
+			struct CompressionJob;
+			class CompressionPool;
 
 			friend struct ChunkBuffer;
 
@@ -71,6 +74,8 @@ private:
 			void				_Uninit();
 
 			status_t			_FlushPendingData();
+			status_t			_QueuePendingData();
+			status_t			_WriteQueuedChunks(int32 maxQueued = 0);
 			status_t			_WriteChunk(const void* data, size_t size,
 									bool mayCompress);
 			status_t			_WriteDataCompressed(const void* data,
@@ -88,6 +93,8 @@ private:
 			size_t				fPendingDataSize;
 			Array<uint64>		fOffsets;
 			CompressionAlgorithmOwner* fCompressionAlgorithm;
+			CompressionPool*	fCompressionPool;
+			int32				fCompressionThreadCount;
 };
 
 
@@ -77,6 +77,9 @@ public:
 
 			void				SetDebugLevel(int32 level);
 									// 0 - 10 (passed to libsolv)
+			void				SetPrefetchDownloads(bool prefetch);
+									// download all packages concurrently
+									// before preparing the transactions
 
 			BSolver*			Solver() const
 									{ return fSolver; }
@@ -133,6 +136,18 @@ private:
 										installationRepository);
 			void				_CommitPackageChanges(Transaction& transaction);
 
+			void				_PrefetchPackages();
+			status_t			_GetDownloadCacheEntry(
+									const BPackageInfo& info, BEntry& _entry);
+			void				_PruneDownloadCache();
+
+			bool				_ReconstructPackageFromDelta(
+									RemoteRepository* repository,
+									InstalledRepository&
+										installationRepository,
+									BSolverPackage* package,
+									BDirectory& directory,
+									const BEntry& entry);
 			void				_ClonePackageFile(
 									LocalRepository* repository,
 									BSolverPackage* package,
@@ -167,6 +182,7 @@ protected:
 			RemoteRepositoryList fOtherRepositories;
 			MiscLocalRepository* fLocalRepository;
 			TransactionList		fTransactions;
+			bool				fPrefetchDownloads;
 
 			// must be set by the derived class
 			InstallationInterface* fInstallationInterface;
@@ -181,8 +197,19 @@ public:
 
 			const BRepositoryConfig& Config() const;
 
+			bool				IsDeltaIndexLoaded() const
+									{ return fDeltaIndexLoaded; }
+			void				LoadDeltaIndex(const BEntry& entry);
+			BString				DeltaFileName(const BString& oldFileName,
+									const BString& newFileName) const;
+
+private:
+			typedef std::map<std::string, std::string> DeltaFileNameMap;
+
 private:
 			BRepositoryConfig	fConfig;
+			DeltaFileNameMap	fDeltaFileNames;
+			bool				fDeltaIndexLoaded;
 };
 
 
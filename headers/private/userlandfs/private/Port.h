@@ -20,10 +20,12 @@ public:
 				port_id			owner_port;
 				port_id			client_port;
 				int32			size;
+				area_id			shared_area;
+				int32			shared_area_size;
 			};
 
 public:
-								Port(int32 size);
+								Port(int32 size, int32 sharedAreaSize = 0);
 								Port(const Info* info);
 								~Port();
 
@@ -40,6 +42,21 @@ public:
 			void				Unreserve(int32 endOffset);
 			int32				ReservedSize() const { return fReservedSize; }
 
+			// The shared area is mapped on both sides. Each side writes only
+			// to its own half, the owner to the first, the client to the
+			// second one. Offsets are relative to that half.
+			void*				GetSharedArea() const
+									{ return fSharedAreaAddress; }
+			int32				GetSharedAreaSize() const
+									{ return fInfo.shared_area_size; }
+			int32				GetSharedBufferOffset() const;
+			int32				GetSharedBufferCapacity() const;
+
+			void				ReserveShared(int32 endOffset);
+			void				UnreserveShared(int32 endOffset);
+			int32				SharedReservedSize() const
+									{ return fSharedReservedSize; }
+
 			status_t			Send(const void* message, int32 size);
 			status_t			Receive(void** _message, size_t* _size,
 									bigtime_t timeout = -1);
@@ -51,6 +68,9 @@ private:
 			uint8*				fBuffer;
 			int32				fCapacity;
 			int32				fReservedSize;
+			area_id				fSharedArea;
+			uint8*				fSharedAreaAddress;
+			int32				fSharedReservedSize;
 			status_t			fInitStatus;
 			bool				fOwner;
 };
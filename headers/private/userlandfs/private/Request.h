@@ -11,6 +11,11 @@ enum {
 	ADDRESS_IS_STRING	= 0x02,
 };
 
+// pseudo area ID for addresses within the port's shared area
+enum {
+	PORT_SHARED_AREA	= -2,
+};
+
 namespace UserlandFSUtil {
 
 class RequestAllocator;
@@ -35,6 +35,9 @@ public:
 			Request*			GetRequest() const;
 			int32				GetRequestSize() const;
 
+			bool				HasAreas() const
+									{ return fAllocatedAreaCount > 0; }
+
 			status_t			AllocateAddress(Address& address, int32 size,
 									int32 align, void** data,
 									bool deferredInit = false, int32 reserveForNextRequests = 0);
@@ -62,12 +65,14 @@ private:
 			Request*			fRequest;
 			int32				fRequestSize;
 			int32				fPortReservedOffset;
+			int32				fSharedReservedOffset;
 			int32				fRequestOffset;
 			area_id				fAllocatedAreas[MAX_REQUEST_ADDRESS_COUNT];
 			int32				fAllocatedAreaCount;
 			DeferredInitInfo	fDeferredInitInfos[MAX_REQUEST_ADDRESS_COUNT];
 			int32				fDeferredInitInfoCount;
 			bool				fRequestInPortBuffer;
+			bool				fSharedReserved;
 };
 
 // AllocateRequest
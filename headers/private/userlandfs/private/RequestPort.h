@@ -13,7 +13,8 @@ class RequestHandler;
 // RequestPort
 class RequestPort {
 public:
-								RequestPort(int32 size);
+								RequestPort(int32 size,
+									int32 sharedAreaSize = 0);
 								RequestPort(const Port::Info* info);
 								~RequestPort();
 
@@ -37,6 +38,8 @@ public:
 
 			void				ReleaseRequest(Request* request);
 
+			bool				NeedsReceipt(Request* request) const;
+
 private:
 			void				_PopAllocator();
 
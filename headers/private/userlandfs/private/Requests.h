@@ -2399,7 +2399,8 @@ status_t get_request_address_infos(Request* request, AddressInfo* infos,
 	int32* count);
 status_t check_request(Request* request);
 status_t relocate_request(Request* request, int32 requestBufferSize,
-	area_id* areas, int32* count);
+	area_id* areas, int32* count, void* sharedArea = NULL,
+	int32 sharedAreaSize = 0);
 
 }	// namespace UserlandFSUtil
 
@@ -333,6 +333,9 @@ BFSPartitionHandle::Repair(bool checkOnly)
 		result.stats.double_indirect_array_blocks,
 		size_string(1.0 * result.stats.blocks_in_double_indirect
 			* result.stats.block_size).String());
+	printf("\tinline files\t\t\t%" B_PRIu64 " (%s)\n",
+		result.stats.inline_files,
+		size_string(1.0 * result.stats.bytes_in_inline).String());
 	// TODO: this is currently not maintained correctly
 	//printf("\tpartial block runs\t%" B_PRIu64 "\n",
 	//	result.stats.partial_block_runs);
@@ -210,6 +210,8 @@ int nvme_admin_create_ioq(struct nvme_ctrlr *ctrlr,
 		cmd.opc = NVME_OPC_CREATE_IO_CQ;
 #ifdef __HAIKU__ // TODO: Option!
 		cmd.cdw11 = 0x1 | 0x2; /* enable interrupts */
+		if (qpair->id < ctrlr->io_interrupt_vectors)
+			cmd.cdw11 |= (uint32_t)qpair->id << 16;
 #else
 		cmd.cdw11 = 0x1;
 #endif
@@ -583,6 +583,16 @@ struct nvme_ctrlr {
 	 */
 	struct nvme_ctrlr_opts		opts;
 
+#ifdef __HAIKU__
+	/*
+	 * Number of interrupt vectors available for the I/O completion
+	 * queues: an I/O queue pair whose ID is below this number gets its
+	 * own vector (equal to its ID), any other one shares vector 0 with
+	 * the admin queue.
+	 */
+	unsigned int			io_interrupt_vectors;
+#endif
+
 	/*
 	 * BAR mapping address which contains controller memory buffer.
 	 */
@@ -76,7 +76,7 @@ static const uint8 kDriveIcon[] = {
 
 static device_manager_info* sDeviceManager;
 
-typedef struct {
+typedef struct nvme_disk_driver_info {
 	device_node*			node;
 	pci_info				info;
 
@@ -93,11 +93,15 @@ typedef struct {
 
 	rw_lock					rounded_write_lock;
 
-	ConditionVariable		interrupt;
+	uint32					irq;
 	int32					polling;
 
 	struct qpair_info {
+		struct nvme_disk_driver_info* info;
 		struct nvme_qpair*	qpair;
+		ConditionVariable	interrupt;
+		uint32				irq;
+			// 0 if the qpair shares the controller's interrupt
 	}						qpairs[NVME_MAX_QPAIRS];
 	uint32					qpair_count;
 } nvme_disk_driver_info;
@@ -148,6 +152,7 @@ nvme_disk_set_capacity(nvme_disk_driver_info* info, uint64 capacity,
 
 
 static int32 nvme_interrupt_handler(void* _info);
+static int32 nvme_qpair_interrupt_handler(void* _qpinfo);
 
 
 static status_t
@@ -229,17 +234,44 @@ nvme_disk_init_device(void* _info, void** _cookie)
 	command &= ~(PCI_command_int_disable);
 	pci->write_pci_config(pcidev, PCI_command, 2, command);
 
+	// Decide on the number of qpairs first, so that we know how many
+	// interrupt vectors we can make use of.
+	uint32 try_qpairs = cstat.io_qpairs;
+	try_qpairs = min_c(try_qpairs, NVME_MAX_QPAIRS);
+	if (try_qpairs >= (uint32)smp_get_num_cpus()) {
+		try_qpairs = smp_get_num_cpus();
+	} else {
+		// Find the highest number of qpairs that evenly divides the number of CPUs.
+		while ((smp_get_num_cpus() % try_qpairs) != 0)
+			try_qpairs--;
+	}
+
 	uint32 irq = info->info.u.h0.interrupt_line;
 	if (irq == 0xFF)
 		irq = 0;
 
-	if (pci->get_msix_count(pcidev)) {
+	// With MSI-X, each I/O qpair gets its own vector (the admin queue uses
+	// vector 0), so that a completion only wakes up the threads waiting on
+	// that very qpair.
+	uint32 msixCount = pci->get_msix_count(pcidev);
+	uint32 vectorCount = 0;
+	if (msixCount > 0) {
 		uint32 msixVector = 0;
-		if (pci->configure_msix(pcidev, 1, &msixVector) == B_OK
-			&& pci->enable_msix(pcidev) == B_OK) {
-			TRACE_ALWAYS("using MSI-X\n");
-			irq = msixVector;
+		vectorCount = min_c(msixCount, try_qpairs + 1);
+		if (vectorCount > 1
+			&& pci->configure_msix(pcidev, vectorCount, &msixVector) != B_OK) {
+			vectorCount = 1;
 		}
+		if (vectorCount == 1
+			&& pci->configure_msix(pcidev, vectorCount, &msixVector) != B_OK) {
+			vectorCount = 0;
+		}
+		if (vectorCount > 0 && pci->enable_msix(pcidev) == B_OK) {
+			TRACE_ALWAYS("using MSI-X with %" B_PRIu32 " vectors\n",
+				vectorCount);
+			irq = msixVector;
+		} else
+			vectorCount = 0;
 	} else if (pci->get_msi_count(pcidev) >= 1) {
 		uint32 msiVector = 0;
 		if (pci->configure_msi(pcidev, 1, &msiVector) == B_OK
@@ -253,12 +285,18 @@ nvme_disk_init_device(void* _info, void** _cookie)
 		TRACE_ERROR("device PCI:%d:%d:%d was assigned an invalid IRQ\n",
 			info->info.bus, info->info.device, info->info.function);
 		info->polling = 1;
+		vectorCount = 0;
 	} else {
 		info->polling = 0;
 	}
-	info->interrupt.Init(info, "nvme_disk interrupt");
+	info->irq = irq;
+	info->qpair_count = 0;
 	install_io_interrupt_handler(irq, nvme_interrupt_handler, (void*)info, B_NO_HANDLED_INFO);
 
+	// The I/O completion queues are created with the vector matching their
+	// ID, if there is one.
+	info->ctrlr->io_interrupt_vectors = vectorCount;
+
 	if (info->ctrlr->feature_supported[NVME_FEAT_INTERRUPT_COALESCING]) {
 		uint32 microseconds = 16, threshold = 32;
 		nvme_admin_set_feature(info->ctrlr, false, NVME_FEAT_INTERRUPT_COALESCING,
@@ -266,22 +304,21 @@ nvme_disk_init_device(void* _info, void** _cookie)
 	}
 
 	// allocate qpairs
-	uint32 try_qpairs = cstat.io_qpairs;
-	try_qpairs = min_c(try_qpairs, NVME_MAX_QPAIRS);
-	if (try_qpairs >= (uint32)smp_get_num_cpus()) {
-		try_qpairs = smp_get_num_cpus();
-	} else {
-		// Find the highest number of qpairs that evenly divides the number of CPUs.
-		while ((smp_get_num_cpus() % try_qpairs) != 0)
-			try_qpairs--;
-	}
-	info->qpair_count = 0;
 	for (uint32 i = 0; i < try_qpairs; i++) {
-		info->qpairs[i].qpair = nvme_ioqp_get(info->ctrlr,
-			(enum nvme_qprio)0, 0);
-		if (info->qpairs[i].qpair == NULL)
+		qpair_info* qpinfo = &info->qpairs[i];
+		qpinfo->info = info;
+		qpinfo->irq = 0;
+		qpinfo->interrupt.Init(qpinfo, "nvme_disk qpair interrupt");
+		qpinfo->qpair = nvme_ioqp_get(info->ctrlr, (enum nvme_qprio)0, 0);
+		if (qpinfo->qpair == NULL)
 			break;
 
+		if (qpinfo->qpair->id < vectorCount) {
+			qpinfo->irq = irq + qpinfo->qpair->id;
+			install_io_interrupt_handler(qpinfo->irq,
+				nvme_qpair_interrupt_handler, (void*)qpinfo, B_NO_HANDLED_INFO);
+		}
+
 		info->qpair_count++;
 	}
 	if (info->qpair_count == 0) {
@@ -333,8 +370,15 @@ nvme_disk_uninit_device(void* _cookie)
 	CALLED();
 	nvme_disk_driver_info* info = (nvme_disk_driver_info*)_cookie;
 
-	remove_io_interrupt_handler(info->info.u.h0.interrupt_line,
-		nvme_interrupt_handler, (void*)info);
+	for (uint32 i = 0; i < info->qpair_count; i++) {
+		qpair_info* qpinfo = &info->qpairs[i];
+		if (qpinfo->irq != 0) {
+			remove_io_interrupt_handler(qpinfo->irq,
+				nvme_qpair_interrupt_handler, (void*)qpinfo);
+		}
+	}
+	remove_io_interrupt_handler(info->irq, nvme_interrupt_handler,
+		(void*)info);
 
 	rw_lock_destroy(&info->rounded_write_lock);
 
@@ -392,12 +436,25 @@ static int32
 nvme_interrupt_handler(void* _info)
 {
 	nvme_disk_driver_info* info = (nvme_disk_driver_info*)_info;
-	info->interrupt.NotifyAll();
+	for (uint32 i = 0; i < info->qpair_count; i++) {
+		if (info->qpairs[i].irq == 0)
+			info->qpairs[i].interrupt.NotifyAll();
+	}
 	info->polling = -1;
 	return 0;
 }
 
 
+static int32
+nvme_qpair_interrupt_handler(void* _qpinfo)
+{
+	qpair_info* qpinfo = (qpair_info*)_qpinfo;
+	qpinfo->interrupt.NotifyAll();
+	qpinfo->info->polling = -1;
+	return 0;
+}
+
+
 static qpair_info*
 get_qpair(nvme_disk_driver_info* info)
 {
@@ -413,14 +470,15 @@ io_finished_callback(status_t* status, const struct nvme_cpl* cpl)
 
 
 static void
-await_status(nvme_disk_driver_info* info, struct nvme_qpair* qpair, status_t& status)
+await_status(nvme_disk_driver_info* info, qpair_info* qpinfo, status_t& status)
 {
 	CALLED();
 
+	struct nvme_qpair* qpair = qpinfo->qpair;
 	ConditionVariableEntry entry;
 	int timeouts = 0;
 	while (status == EINPROGRESS) {
-		info->interrupt.Add(&entry);
+		qpinfo->interrupt.Add(&entry);
 
 		nvme_qpair_poll(qpair, 0);
 
@@ -433,7 +491,7 @@ await_status(nvme_disk_driver_info* info, struct nvme_qpair* qpair, status_t& st
 			timeouts++;
 		} else if (entry.Wait(B_RELATIVE_TIMEOUT, 5 * 1000 * 1000) != B_OK) {
 			// This should never happen, as we are woken up on every interrupt
-			// no matter the qpair or transfer within; so if it does occur,
+			// of our qpair no matter the transfer within; so if it does occur,
 			// that probably means the controller stalled, or maybe cannot
 			// generate interrupts at all.
 
@@ -455,6 +513,9 @@ await_status(nvme_disk_driver_info* info, struct nvme_qpair* qpair, status_t& st
 }
 
 
+static const int32 kMaxQueuedIORequests = 8;
+
+
 struct nvme_io_request {
 	status_t status;
 
@@ -506,11 +567,11 @@ ior_next_sge(nvme_io_request* request, uint64_t* address, uint32_t* length)
 
 
 static status_t
-do_nvme_io_request(nvme_disk_driver_info* info, nvme_io_request* request)
+submit_nvme_io_request(nvme_disk_driver_info* info, qpair_info* qpinfo,
+	nvme_io_request* request)
 {
 	request->status = EINPROGRESS;
 
-	qpair_info* qpinfo = get_qpair(info);
 	int ret = -1;
 	if (request->write) {
 		ret = nvme_ns_writev(info->ns, qpinfo->qpair, request->lba_start,
@@ -529,10 +590,18 @@ do_nvme_io_request(nvme_disk_driver_info* info, nvme_io_request* request)
 			request->lba_start, request->lba_count);
 
 		request->lba_count = 0;
+		request->status = ret;
 		return ret;
 	}
+	return B_OK;
+}
 
-	await_status(info, qpinfo->qpair, request->status);
+
+static status_t
+await_nvme_io_request(nvme_disk_driver_info* info, qpair_info* qpinfo,
+	nvme_io_request* request)
+{
+	await_status(info, qpinfo, request->status);
 
 	if (request->status != B_OK) {
 		TRACE_ERROR("%s at LBA %" B_PRIdOFF " of %" B_PRIuSIZE
@@ -545,6 +614,18 @@ do_nvme_io_request(nvme_disk_driver_info* info, nvme_io_request* request)
 }
 
 
+static status_t
+do_nvme_io_request(nvme_disk_driver_info* info, nvme_io_request* request)
+{
+	qpair_info* qpinfo = get_qpair(info);
+	status_t status = submit_nvme_io_request(info, qpinfo, request);
+	if (status != B_OK)
+		return status;
+
+	return await_nvme_io_request(info, qpinfo, request);
+}
+
+
 static status_t
 nvme_disk_bounced_io(nvme_disk_handle* handle, io_request* request)
 {
@@ -745,34 +826,66 @@ nvme_disk_io(void* cookie, io_request* request)
 		return status;
 	}
 
+	// Queue up to kMaxQueuedIORequests commands before waiting for the first
+	// one, so that the controller can work on them in parallel. They are
+	// waited for in order, so that the transferred bytes are easy to track.
+	qpair_info* qpinfo = get_qpair(handle->info);
+	nvme_io_request queued[kMaxQueuedIORequests];
+	int32 queuedCount = 0, finishedCount = 0;
+
 	const uint32 max_io_blocks = handle->info->max_io_blocks;
 	int32 remaining = nvme_request.iovec_count;
 	nvme_request.lba_start = rounded_pos / block_size;
-	while (remaining > 0) {
-		nvme_request.iovec_count = min_c(remaining,
-			NVME_MAX_SGL_DESCRIPTORS / 2);
-
-		nvme_request.lba_count = 0;
-		for (int i = 0; i < nvme_request.iovec_count; i++) {
-			uint32 new_lba_count = nvme_request.lba_count
-				+ (nvme_request.iovecs[i].size / block_size);
-			if (nvme_request.lba_count > 0 && new_lba_count > max_io_blocks) {
-				// We already have a nonzero length, and adding this vec would
-				// make us go over (or we already are over.) Stop adding.
-				nvme_request.iovec_count = i;
-				break;
+	off_t transferred_lba_end = nvme_request.lba_start;
+	bool transferredAll = true;
+	while (remaining > 0 || finishedCount < queuedCount) {
+		if (status == B_OK && remaining > 0
+			&& (queuedCount - finishedCount) < kMaxQueuedIORequests) {
+			nvme_request.iovec_count = min_c(remaining,
+				NVME_MAX_SGL_DESCRIPTORS / 2);
+
+			nvme_request.lba_count = 0;
+			for (int i = 0; i < nvme_request.iovec_count; i++) {
+				uint32 new_lba_count = nvme_request.lba_count
+					+ (nvme_request.iovecs[i].size / block_size);
+				if (nvme_request.lba_count > 0 && new_lba_count > max_io_blocks) {
+					// We already have a nonzero length, and adding this vec would
+					// make us go over (or we already are over.) Stop adding.
+					nvme_request.iovec_count = i;
+					break;
+				}
+
+				nvme_request.lba_count = new_lba_count;
 			}
 
-			nvme_request.lba_count = new_lba_count;
+			nvme_io_request* next = &queued[queuedCount % kMaxQueuedIORequests];
+			*next = nvme_request;
+			status = submit_nvme_io_request(handle->info, qpinfo, next);
+			if (status != B_OK)
+				continue;
+			queuedCount++;
+
+			nvme_request.iovecs += nvme_request.iovec_count;
+			remaining -= nvme_request.iovec_count;
+			nvme_request.lba_start += nvme_request.lba_count;
+			continue;
 		}
 
-		status = do_nvme_io_request(handle->info, &nvme_request);
-		if (status != B_OK)
+		if (finishedCount == queuedCount)
 			break;
 
-		nvme_request.iovecs += nvme_request.iovec_count;
-		remaining -= nvme_request.iovec_count;
-		nvme_request.lba_start += nvme_request.lba_count;
+		nvme_io_request* finished
+			= &queued[finishedCount % kMaxQueuedIORequests];
+		status_t finishedStatus = await_nvme_io_request(handle->info, qpinfo,
+			finished);
+		finishedCount++;
+
+		if (finishedStatus != B_OK) {
+			transferredAll = false;
+			if (status == B_OK)
+				status = finishedStatus;
+		} else if (transferredAll)
+			transferred_lba_end = finished->lba_start + finished->lba_count;
 	}
 
 	if (status != B_OK)
@@ -781,7 +894,7 @@ nvme_disk_io(void* cookie, io_request* request)
 	readLocker.Unlock();
 
 	request->SetTransferredBytes(status != B_OK,
-		(nvme_request.lba_start * block_size) - rounded_pos);
+		(transferred_lba_end * block_size) - rounded_pos);
 	request->SetStatusAndNotify(status);
 	return status;
 }
@@ -845,7 +958,7 @@ nvme_disk_flush(nvme_disk_driver_info* info)
 	if (ret != 0)
 		return ret;
 
-	await_status(info, qpinfo->qpair, status);
+	await_status(info, qpinfo, status);
 	return status;
 }
 
@@ -912,7 +1025,7 @@ nvme_disk_trim(nvme_disk_driver_info* info, fs_trim_data* trimData)
 			(nvme_cmd_cb)io_finished_callback, &status) != 0)
 		return B_IO_ERROR;
 
-	await_status(info, qpair->qpair, status);
+	await_status(info, qpair, status);
 	if (status != B_OK)
 		return status;
 
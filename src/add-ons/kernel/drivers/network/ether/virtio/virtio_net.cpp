@@ -614,13 +614,54 @@ virtio_net_rxDone(void* driverCookie, void* cookie)
 }
 
 
+static void
+virtio_net_set_checksum_flags(net_buffer* buffer, uint8 flags)
+{
+	if ((flags & (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM)) == 0)
+		return;
+
+	buffer->buffer_flags |= NET_BUFFER_L3_CHECKSUM_VALID;
+
+	// virtio also checks the L4 checksum for common protocols.
+	uint16 etherType;
+	if (sBufferModule->read(buffer, offsetof(ether_header, type),
+			&etherType, sizeof(etherType)) == B_OK) {
+		uint8 protocol = 0;
+		etherType = ntohs(etherType);
+		if (etherType == ETHER_TYPE_IP) {
+			sBufferModule->read(buffer,
+				ETHER_HEADER_LENGTH + offsetof(struct ip, ip_p),
+				&protocol, sizeof(protocol));
+		} else if (etherType == ETHER_TYPE_IPV6) {
+			sBufferModule->read(buffer,
+				ETHER_HEADER_LENGTH + offsetof(struct ip6_hdr, ip6_nxt),
+				&protocol, sizeof(protocol));
+		}
+		if (protocol == IPPROTO_TCP || protocol == IPPROTO_UDP)
+			buffer->buffer_flags |= NET_BUFFER_L4_CHECKSUM_VALID;
+	}
+
+	if ((flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0) {
+		// The data is known to be valid but the checksum in the packet is incomplete.
+		// Ignore this flag for now; the stack accepts packets with CHECKSUM_VALID set.
+	}
+}
+
+
+/*!	Receives up to \a _count buffers, but only waits for the first one. The
+	receive lock is only acquired twice per call, independent of the number of
+	buffers returned.
+*/
 static status_t
-virtio_net_receive(void* cookie, net_buffer** _buffer)
+virtio_net_receive_batch(void* cookie, net_buffer** _buffers, uint32* _count)
 {
 	CALLED();
 	virtio_net_handle* handle = (virtio_net_handle*)cookie;
 	virtio_net_driver_info* info = handle->info;
 
+	if (*_count == 0)
+		return B_BAD_VALUE;
+
 	MutexLocker rxLocker(info->rxLock);
 	while (info->rxFullList.Head() == NULL) {
 		rxLocker.Unlock();
@@ -656,55 +697,55 @@ virtio_net_receive(void* cookie, net_buffer** _buffer)
 		TRACE("virtio_net_read: finished waiting\n");
 	}
 
-	net_buffer* buffer = sBufferModule->create(0);
-	if (buffer == NULL)
-		return B_NO_MEMORY;
+	// take over as many filled buffers as we can use
+	BufInfoList fullList;
+	uint32 bufCount = 0;
+	while (bufCount < *_count) {
+		BufInfo* buf = info->rxFullList.RemoveHead();
+		if (buf == NULL)
+			break;
 
-	BufInfo* buf = info->rxFullList.RemoveHead();
+		fullList.Add(buf);
+		bufCount++;
+	}
 	rxLocker.Unlock();
 
-	if (sBufferModule->append(buffer, buf->buffer, buf->rxUsedLength) != B_OK) {
-		sBufferModule->free(buffer);
-		buffer = NULL;
+	uint32 count = 0;
+	BufInfoList::Iterator iterator = fullList.GetIterator();
+	while (BufInfo* buf = iterator.Next()) {
+		net_buffer* buffer = sBufferModule->create(0);
+		if (buffer == NULL)
+			continue;
+
+		if (sBufferModule->append(buffer, buf->buffer, buf->rxUsedLength)
+				!= B_OK) {
+			sBufferModule->free(buffer);
+			continue;
+		}
+
+		virtio_net_set_checksum_flags(buffer, buf->hdr->flags);
+		_buffers[count++] = buffer;
 	}
-	const uint8_t flags = buf->hdr->flags;
+
+	// give the descriptors back to the device
 	rxLocker.Lock();
-	virtio_net_rx_enqueue_buf(info, buf);
+	while (BufInfo* buf = fullList.RemoveHead())
+		virtio_net_rx_enqueue_buf(info, buf);
 	rxLocker.Unlock();
 
-	if (buffer == NULL)
+	if (count == 0)
 		return B_NO_MEMORY;
 
-	if ((flags & (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM)) != 0) {
-		buffer->buffer_flags |= NET_BUFFER_L3_CHECKSUM_VALID;
-
-		// virtio also checks the L4 checksum for common protocols.
-		uint16 etherType;
-		if (sBufferModule->read(buffer, offsetof(ether_header, type),
-				&etherType, sizeof(etherType)) == B_OK) {
-			uint8 protocol = 0;
-			etherType = ntohs(etherType);
-			if (etherType == ETHER_TYPE_IP) {
-				sBufferModule->read(buffer,
-					ETHER_HEADER_LENGTH + offsetof(struct ip, ip_p),
-					&protocol, sizeof(protocol));
-			} else if (etherType == ETHER_TYPE_IPV6) {
-				sBufferModule->read(buffer,
-					ETHER_HEADER_LENGTH + offsetof(struct ip6_hdr, ip6_nxt),
-					&protocol, sizeof(protocol));
-			}
-			if (protocol == IPPROTO_TCP || protocol == IPPROTO_UDP)
-				buffer->buffer_flags |= NET_BUFFER_L4_CHECKSUM_VALID;
-		}
+	*_count = count;
+	return B_OK;
+}
 
-		if ((flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0) {
-			// The data is known to be valid but the checksum in the packet is incomplete.
-			// Ignore this flag for now; the stack accepts packets with CHECKSUM_VALID set.
-		}
-	}
 
-	*_buffer = buffer;
-	return B_OK;
+static status_t
+virtio_net_receive(void* cookie, net_buffer** _buffer)
+{
+	uint32 count = 1;
+	return virtio_net_receive_batch(cookie, _buffer, &count);
 }
 
 
@@ -926,6 +967,21 @@ virtio_net_ioctl(void* cookie, uint32 op, void* buffer, size_t length)
 				return B_BAD_ADDRESS;
 			return virtio_net_receive(cookie, (net_buffer**)buffer);
 
+		case ETHER_RECEIVE_NET_BUFFERS:
+		{
+			if (buffer == NULL || length != sizeof(ether_receive_net_buffers_t))
+				return B_BAD_DATA;
+			if (!IS_KERNEL_ADDRESS(buffer))
+				return B_BAD_ADDRESS;
+
+			ether_receive_net_buffers_t* request
+				= (ether_receive_net_buffers_t*)buffer;
+			if (!IS_KERNEL_ADDRESS(request->buffers))
+				return B_BAD_ADDRESS;
+			return virtio_net_receive_batch(cookie, request->buffers,
+				&request->count);
+		}
+
 		case SIOCGIFSTATS:
 			break;
 
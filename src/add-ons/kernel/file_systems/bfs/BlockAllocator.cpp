@@ -34,6 +34,9 @@
 // be improved a lot. Furthermore, the allocation policies used here should
 // have some real world tests.
 
+static const uint32 kFreedTrimRanges = 32;
+	// the maximum number of ranges trimmed by TrimCollectedBlocks()
+
 #if BFS_TRACING && !defined(FS_SHELL)
 namespace BFSBlockTracing {
 
@@ -529,18 +532,27 @@ AllocationGroup::Free(Transaction& transaction, uint16 start, int32 length)
 BlockAllocator::BlockAllocator(Volume* volume)
 	:
 	fVolume(volume),
-	fGroups(NULL)
+	fGroups(NULL),
 	//fCheckBitmap(NULL),
 	//fCheckCookie(NULL)
+	fFreedRanges(NULL),
+	fFreedRangeCount(0),
+	fTrimSupported(true),
+	fTrimData(NULL),
+	fTrimming(0)
 {
 	recursive_lock_init(&fLock, "bfs allocator");
+	mutex_init(&fTrimLock, "bfs trim");
 }
 
 
 BlockAllocator::~BlockAllocator()
 {
+	mutex_destroy(&fTrimLock);
 	recursive_lock_destroy(&fLock);
 	delete[] fGroups;
+	free(fFreedRanges);
+	free(fTrimData);
 }
 
 
@@ -920,6 +932,8 @@ BlockAllocator::AllocateBlocks(Transaction& transaction, int32 groupIndex,
 		bestLength = round_down(bestLength, minimum);
 	}
 
+	_WaitForTrim(bestGroup, bestStart, bestLength);
+
 	if (fGroups[bestGroup].Allocate(transaction, bestStart, bestLength) != B_OK)
 		RETURN_ERROR(B_IO_ERROR);
 
@@ -1082,6 +1096,8 @@ BlockAllocator::Free(Transaction& transaction, block_run run)
 
 	fVolume->SuperBlock().used_blocks =
 		HOST_ENDIAN_TO_BFS_INT64(fVolume->UsedBlocks() - run.Length());
+
+	_AddFreedRange(fVolume->ToBlock(run), run.Length());
 	return B_OK;
 }
 
@@ -1194,14 +1210,17 @@ BlockAllocator::_CheckGroup(int32 groupIndex) const
 status_t
 BlockAllocator::Trim(uint64 offset, uint64 size, uint64& trimmedSize)
 {
-	// TODO: Remove this check when offset and size handling is implemented
-	if (offset != 0
-		|| fVolume->NumBlocks() < 0
-		|| size < (uint64)fVolume->NumBlocks() * fVolume->BlockSize()) {
-		INFORM(("BFS Trim: Ranges smaller than the file system size"
-			" are not supported yet.\n"));
-		return B_UNSUPPORTED;
-	}
+	trimmedSize = 0;
+
+	// only whole blocks inside the given range can be trimmed
+	uint32 blockShift = fVolume->BlockShift();
+	uint64 numBlocks = fVolume->NumBlocks();
+	uint64 start = (offset + fVolume->BlockSize() - 1) >> blockShift;
+	uint64 end = numBlocks;
+	if (offset + size >= offset)
+		end = min_c((offset + size) >> blockShift, numBlocks);
+	if (start >= end)
+		return B_OK;
 
 	const uint32 kTrimRanges = 128;
 	fs_trim_data* trimData = (fs_trim_data*)malloc(sizeof(fs_trim_data)
@@ -1212,62 +1231,116 @@ BlockAllocator::Trim(uint64 offset, uint64 size, uint64& trimmedSize)
 	MemoryDeleter deleter(trimData);
 	RecursiveLocker locker(fLock);
 
-	// TODO: take given offset and size into account!
-	int32 lastGroup = fNumGroups - 1;
-	uint32 firstBlock = 0;
-	uint32 firstBit = 0;
-	uint64 currentBlock = 0;
-	uint32 blockShift = fVolume->BlockShift();
-
-	uint64 firstFree = 0;
-	uint64 freeLength = 0;
-
 	trimData->range_count = 0;
-	trimmedSize = 0;
 
-	AllocationBlock cached(fVolume);
-	for (int32 groupIndex = 0; groupIndex <= lastGroup; groupIndex++) {
-		AllocationGroup& group = fGroups[groupIndex];
+	status_t status = _TrimFreeBlocks(*trimData, kTrimRanges, start, end,
+		trimmedSize);
+	if (status != B_OK)
+		return status;
 
-		for (uint32 block = firstBlock; block < group.NumBitmapBlocks(); block++) {
-			cached.SetTo(group, block);
-
-			for (uint32 i = firstBit; i < cached.NumBlockBits(); i++) {
-				if (cached.IsUsed(i)) {
-					// Block is in use
-					if (freeLength > 0) {
-						// Overflow is unlikely to happen, but check it anyway
-						if ((firstFree << blockShift) >> blockShift
-								!= firstFree
-							|| (freeLength << blockShift) >> blockShift
-								!= freeLength) {
-							FATAL(("BlockAllocator::Trim:"
-								" Overflow detected!\n"));
-							return B_ERROR;
-						}
-						status_t status = _TrimNext(*trimData, kTrimRanges,
-							firstFree << blockShift, freeLength << blockShift,
-							false, trimmedSize);
-						if (status != B_OK)
-							return status;
+	return _TrimNext(*trimData, kTrimRanges, 0, 0, true, trimmedSize);
+}
 
-						freeLength = 0;
-					}
-				} else if (freeLength++ == 0) {
-					// Block is free, start new free range
-					firstFree = currentBlock;
-				}
 
-				currentBlock++;
-			}
+/*!	Takes up to \a maxRanges of the block ranges that have been freed
+	since they were last trimmed, and collects those parts of them that are
+	still free, so that TrimCollectedBlocks() can let the device reuse them
+	early on.
+	Since the blocks must not be discarded before the transactions that
+	freed them are safely in the log, the caller needs to hold the journal
+	lock, and must have written back the log. Until the collected blocks
+	have been trimmed, allocating any of them waits for the trim to finish.
+	Only one thread may trim freed blocks.
+*/
+status_t
+BlockAllocator::CollectFreedBlocks(uint32 maxRanges)
+{
+	// we're not in a hurry, and the allocator stays locked on unmount
+	if (recursive_lock_trylock(&fLock) != B_OK)
+		return B_WOULD_BLOCK;
+	RecursiveLocker locker(fLock, true);
+
+	if (!fTrimSupported || fFreedRangeCount == 0)
+		return B_ENTRY_NOT_FOUND;
+
+	if (fTrimData == NULL) {
+		fTrimData = (fs_trim_data*)malloc(sizeof(fs_trim_data)
+			+ 2 * sizeof(uint64) * (kFreedTrimRanges - 1));
+		if (fTrimData == NULL)
+			return B_NO_MEMORY;
+	}
+
+	fTrimData->range_count = 0;
+
+	while (fFreedRangeCount > 0 && maxRanges-- > 0) {
+		freed_range& range = fFreedRanges[fFreedRangeCount - 1];
+		off_t end = range.start + range.length;
+		off_t next;
+		status_t status = _CollectFreeBlocks(*fTrimData, kFreedTrimRanges,
+			range.start, end, next);
+		if (status != B_OK)
+			return status;
+
+		if (next < end) {
+			// there is no more room, leave the rest for next time
+			range.length = end - next;
+			range.start = next;
+			break;
 		}
+		fFreedRangeCount--;
+	}
+
+	if (fTrimData->range_count == 0)
+		return B_ENTRY_NOT_FOUND;
+
+	mutex_lock(&fTrimLock);
+	atomic_set(&fTrimming, 1);
+	return B_OK;
+}
+
 
-		firstBlock = 0;
-		firstBit = 0;
+/*!	Discards the blocks that CollectFreedBlocks() has collected. As the
+	device might take its time, no locks must be held when calling this.
+	If the device doesn't support trimming, it is not tried again; on other
+	errors, the blocks are queued again to be retried later.
+*/
+status_t
+BlockAllocator::TrimCollectedBlocks()
+{
+	if (atomic_get(&fTrimming) == 0)
+		return B_OK;
+
+	status_t status = B_OK;
+	fTrimData->trimmed_size = 0;
+	if (ioctl(fVolume->Device(), B_TRIM_DEVICE, fTrimData,
+			sizeof(fs_trim_data)
+				+ 2 * sizeof(uint64) * (fTrimData->range_count - 1)) != 0) {
+		status = errno;
 	}
 
-	return _TrimNext(*trimData, kTrimRanges, firstFree << blockShift,
-		freeLength << blockShift, true, trimmedSize);
+	atomic_set(&fTrimming, 0);
+	mutex_unlock(&fTrimLock);
+
+	if (status == B_OK)
+		return B_OK;
+
+	RecursiveLocker locker(fLock);
+
+	if (status == B_UNSUPPORTED || status == B_DEV_INVALID_IOCTL) {
+		INFORM(("bfs: device doesn't support trimming: %s\n",
+			strerror(status)));
+		fTrimSupported = false;
+		fFreedRangeCount = 0;
+		return status;
+	}
+
+	uint32 blockShift = fVolume->BlockShift();
+	for (uint32 i = 0; i < fTrimData->range_count; i++) {
+		_AddFreedRange(fTrimData->ranges[i].offset >> blockShift,
+			fTrimData->ranges[i].size >> blockShift);
+	}
+
+	return status;
 }
 
 
@@ -1360,6 +1433,197 @@ BlockAllocator::CheckBlockRun(block_run run, const char* type, bool allocated)
 }
 
 
+/*!	Remembers a range of freed blocks to be trimmed later on. Adjacent
+	ranges are merged; if there are too many ranges already, the blocks
+	will only be trimmed by the next explicit trim of the volume.
+*/
+void
+BlockAllocator::_AddFreedRange(off_t start, off_t length)
+{
+	static const int32 kMaxFreedRanges = 256;
+
+	if (!fTrimSupported || fVolume->IsInitializing())
+		return;
+
+	if (fFreedRangeCount > 0) {
+		freed_range& last = fFreedRanges[fFreedRangeCount - 1];
+		if (last.start + last.length == start) {
+			last.length += length;
+			return;
+		}
+		if (start + length == last.start) {
+			last.start = start;
+			last.length += length;
+			return;
+		}
+	}
+
+	if (fFreedRanges == NULL) {
+		fFreedRanges = (freed_range*)malloc(
+			sizeof(freed_range) * kMaxFreedRanges);
+		if (fFreedRanges == NULL)
+			return;
+	}
+	if (fFreedRangeCount == kMaxFreedRanges)
+		return;
+
+	fFreedRanges[fFreedRangeCount].start = start;
+	fFreedRanges[fFreedRangeCount].length = length;
+	fFreedRangeCount++;
+}
+
+
+/*!	Adds the free blocks between \a start and \a end to \a trimData, as
+	long as there is room. \a _next is set to the first block that has not
+	been looked at, or that did not fit anymore.
+*/
+status_t
+BlockAllocator::_CollectFreeBlocks(fs_trim_data& trimData, uint32 maxRanges,
+	off_t start, off_t end, off_t& _next)
+{
+	uint32 blockShift = fVolume->BlockShift();
+	uint32 bitsPerBlock = fVolume->BlockSize() << 3;
+
+	int32 groupIndex = start >> fVolume->AllocationGroupShift();
+	uint32 bitmapBlock = (start / bitsPerBlock) % fBlocksPerGroup;
+	uint32 bit = start % bitsPerBlock;
+
+	off_t block = start;
+	off_t firstFree = 0;
+	off_t freeLength = 0;
+
+	AllocationBlock cached(fVolume);
+	while (block < end && groupIndex < fNumGroups) {
+		AllocationGroup& group = fGroups[groupIndex];
+		if (bitmapBlock >= group.NumBitmapBlocks()) {
+			groupIndex++;
+			bitmapBlock = 0;
+			continue;
+		}
+
+		if (cached.SetTo(group, bitmapBlock) != B_OK)
+			RETURN_ERROR(B_IO_ERROR);
+
+		for (; bit < cached.NumBlockBits() && block < end; bit++, block++) {
+			if (!cached.IsUsed(bit)) {
+				if (freeLength++ == 0)
+					firstFree = block;
+				continue;
+			}
+
+			if (freeLength > 0) {
+				if (trimData.range_count == maxRanges) {
+					_next = firstFree;
+					return B_OK;
+				}
+				_AddTrim(trimData, maxRanges, firstFree << blockShift,
+					freeLength << blockShift);
+				freeLength = 0;
+			}
+		}
+
+		bit = 0;
+		bitmapBlock++;
+	}
+
+	if (freeLength > 0) {
+		if (trimData.range_count == maxRanges) {
+			_next = firstFree;
+			return B_OK;
+		}
+		_AddTrim(trimData, maxRanges, firstFree << blockShift,
+			freeLength << blockShift);
+	}
+
+	_next = end;
+	return B_OK;
+}
+
+
+/*!	Blocks that are being trimmed must not be handed out before the device
+	has discarded them, as it could discard their new contents as well.
+	Waits for the trim to finish if that is the case for the given range.
+*/
+void
+BlockAllocator::_WaitForTrim(int32 group, uint16 start, uint16 length)
+{
+	if (atomic_get(&fTrimming) == 0)
+		return;
+
+	uint32 blockShift = fVolume->BlockShift();
+	uint64 offset = ((((off_t)group << fVolume->AllocationGroupShift())
+		| start) << blockShift);
+	uint64 size = (uint64)length << blockShift;
+
+	for (uint32 i = 0; i < fTrimData->range_count; i++) {
+		if (offset < fTrimData->ranges[i].offset + fTrimData->ranges[i].size
+			&& fTrimData->ranges[i].offset < offset + size) {
+			// the trim is done once we get the lock
+			mutex_lock(&fTrimLock);
+			mutex_unlock(&fTrimLock);
+			return;
+		}
+	}
+}
+
+
+/*!	Adds all free blocks between \a start and \a end to \a trimData, and
+	trims them whenever it has been filled.
+*/
+status_t
+BlockAllocator::_TrimFreeBlocks(fs_trim_data& trimData, uint32 maxRanges,
+	off_t start, off_t end, uint64& trimmedSize)
+{
+	uint32 blockShift = fVolume->BlockShift();
+	uint32 bitsPerBlock = fVolume->BlockSize() << 3;
+
+	int32 groupIndex = start >> fVolume->AllocationGroupShift();
+	uint32 bitmapBlock = (start / bitsPerBlock) % fBlocksPerGroup;
+	uint32 bit = start % bitsPerBlock;
+
+	off_t block = start;
+	off_t firstFree = 0;
+	off_t freeLength = 0;
+
+	AllocationBlock cached(fVolume);
+	while (block < end && groupIndex < fNumGroups) {
+		AllocationGroup& group = fGroups[groupIndex];
+		if (bitmapBlock >= group.NumBitmapBlocks()) {
+			groupIndex++;
+			bitmapBlock = 0;
+			continue;
+		}
+
+		if (cached.SetTo(group, bitmapBlock) != B_OK)
+			RETURN_ERROR(B_IO_ERROR);
+
+		for (; bit < cached.NumBlockBits() && block < end; bit++, block++) {
+			if (!cached.IsUsed(bit)) {
+				if (freeLength++ == 0)
+					firstFree = block;
+				continue;
+			}
+
+			if (freeLength > 0) {
+				status_t status = _TrimNext(trimData, maxRanges,
+					firstFree << blockShift, freeLength << blockShift, false,
+					trimmedSize);
+				if (status != B_OK)
+					return status;
+
+				freeLength = 0;
+			}
+		}
+
+		bit = 0;
+		bitmapBlock++;
+	}
+
+	return _TrimNext(trimData, maxRanges, firstFree << blockShift,
+		freeLength << blockShift, false, trimmedSize);
+}
+
+
 bool
 BlockAllocator::_AddTrim(fs_trim_data& trimData, uint32 maxRanges,
 	uint64 offset, uint64 size)
@@ -1385,7 +1649,7 @@ BlockAllocator::_TrimNext(fs_trim_data& trimData, uint32 maxRanges,
 
 	const bool rangesFilled = _AddTrim(trimData, maxRanges, offset, size);
 
-	if (rangesFilled || force) {
+	if ((rangesFilled || force) && trimData.range_count > 0) {
 		// Trim now
 		trimData.trimmed_size = 0;
 #ifdef DEBUG_TRIM
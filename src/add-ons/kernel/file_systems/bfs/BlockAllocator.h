@@ -45,6 +45,10 @@ public:
 
 			status_t		Trim(uint64 offset, uint64 size,
 								uint64& trimmedSize);
+			bool			HasFreedBlocks() const
+								{ return fFreedRangeCount > 0; }
+			status_t		CollectFreedBlocks(uint32 maxRanges);
+			status_t		TrimCollectedBlocks();
 
 			status_t		CheckBlocks(off_t start, off_t length,
 								bool allocated = true,
@@ -68,6 +72,15 @@ private:
 #ifdef DEBUG_ALLOCATION_GROUPS
 			void			_CheckGroup(int32 group) const;
 #endif
+			void			_AddFreedRange(off_t start, off_t length);
+			status_t		_CollectFreeBlocks(fs_trim_data& trimData,
+								uint32 maxRanges, off_t start, off_t end,
+								off_t& _next);
+			void			_WaitForTrim(int32 group, uint16 start,
+								uint16 length);
+			status_t		_TrimFreeBlocks(fs_trim_data& trimData,
+								uint32 maxRanges, off_t start, off_t end,
+								uint64& trimmedSize);
 			bool			_AddTrim(fs_trim_data& trimData, uint32 maxRanges,
 								uint64 offset, uint64 size);
 			status_t		_TrimNext(fs_trim_data& trimData, uint32 maxRanges,
@@ -83,6 +96,20 @@ private:
 			int32			fNumGroups;
 			uint32			fBlocksPerGroup;
 			uint32			fNumBitmapBlocks;
+
+			struct freed_range {
+				off_t		start;
+				off_t		length;
+			};
+			freed_range*	fFreedRanges;
+			int32			fFreedRangeCount;
+				// blocks freed since they were last trimmed, in blocks
+			bool			fTrimSupported;
+			fs_trim_data*	fTrimData;
+			int32			fTrimming;
+				// fTrimData is being trimmed, see CollectFreedBlocks()
+			mutex			fTrimLock;
+				// held while fTrimming is set
 };
 
 #ifdef BFS_DEBUGGER_COMMANDS
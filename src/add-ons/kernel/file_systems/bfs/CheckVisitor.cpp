@@ -479,6 +479,31 @@ CheckVisitor::_CheckInodeBlocks(Inode* inode, const char* name)
 		return B_OK;
 	}
 
+	if (inode->HasInlineData()) {
+		// the file data is stored in the small_data section, and the file
+		// must not have a data stream
+		const data_stream& data = inode->Node().data;
+		if (!GetVolume()->HasInlineData() || !inode->IsFile()
+			|| data.MaxDirectRange() != 0 || !data.direct[0].IsZero()
+			|| data.Size() > GetVolume()->MaxInlineDataSize())
+			return B_BAD_DATA;
+
+		RecursiveLocker locker(inode->SmallDataLock());
+		NodeGetter node(GetVolume());
+		status = node.SetTo(inode);
+		if (status != B_OK)
+			return status;
+
+		const char dataTag[2] = {FILE_DATA_NAME, 0};
+		small_data* item = inode->FindSmallData(node.Node(), dataTag);
+		if ((item != NULL ? item->DataSize() : 0) != data.Size())
+			return B_BAD_DATA;
+
+		Control().stats.inline_files++;
+		Control().stats.bytes_in_inline += data.Size();
+		return B_OK;
+	}
+
 	data_stream* data = &inode->Node().data;
 
 	// check the direct range
@@ -66,6 +66,7 @@ dump_super_block(const disk_super_block* superBlock)
 	kprintf("  num_ags        = %u\n", (unsigned)superBlock->AllocationGroups());
 	kprintf("  flags          = %#08x (%s)\n", (int)superBlock->Flags(),
 		get_tupel(superBlock->Flags()));
+	kprintf("  features       = %#08x\n", (int)superBlock->Features());
 	dump_block_run("  log_blocks     = ", superBlock->log_blocks);
 	kprintf("  log_start      = %" B_PRIdOFF "\n", superBlock->LogStart());
 	kprintf("  log_end        = %" B_PRIdOFF "\n", superBlock->LogEnd());
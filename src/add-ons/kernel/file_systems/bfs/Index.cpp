@@ -17,6 +17,16 @@
 #include "BPlusTree.h"
 
 
+using QueryParser::getTrigrams;
+using QueryParser::kMaxKeyTrigrams;
+
+
+static const char* kTrigramsSuffix = "@trigrams";
+	// the trigram index of the index "foo" is called "foo@trigrams"
+static const int32 kMaxTrigramsFillKeys = 256;
+	// the maximum number of keys added to a trigram index per transaction
+
+
 Index::Index(Volume* volume)
 	:
 	fVolume(volume),
@@ -98,6 +108,29 @@ Index::SetTo(const char* name)
 }
 
 
+/*!	Sets the index to the trigram index that belongs to the index \a name.
+	Fails if there is none.
+*/
+status_t
+Index::SetToTrigrams(const char* name)
+{
+	char trigramsName[INODE_FILE_NAME_LENGTH];
+	status_t status = GetTrigramsName(name, trigramsName,
+		sizeof(trigramsName));
+	if (status == B_OK)
+		status = SetTo(trigramsName);
+
+	// the name is only valid during this call
+	fName = NULL;
+
+	if (status == B_OK && Type() != B_UINT32_TYPE) {
+		Unset();
+		return B_BAD_TYPE;
+	}
+	return status;
+}
+
+
 /*!	Returns a standard type code for the stat() index type codes. Returns
 	zero if the type is not known (can only happen if the mode field is
 	corrupted somehow or not that of an index).
@@ -210,6 +243,112 @@ Index::Create(Transaction& transaction, const char* name, uint32 type)
 }
 
 
+/*!	Creates the trigram index for the string index \a name, and fills it
+	with the trigrams of the keys the index already contains.
+	A trigram index maps every sequence of three characters (with ASCII
+	letters folded to lower case) to the IDs of all nodes whose key contains
+	it; the query code uses it to narrow down wildcard patterns that don't
+	start with a fixed prefix.
+	Since filling the index may need a lot of transactions, this method
+	starts them itself.
+*/
+status_t
+Index::CreateTrigrams(const char* name)
+{
+	Unset();
+
+	char trigramsName[INODE_FILE_NAME_LENGTH];
+	status_t status = GetTrigramsName(name, trigramsName,
+		sizeof(trigramsName));
+	if (status != B_OK)
+		return status;
+
+	Index index(fVolume);
+	status = index.SetTo(name);
+	if (status != B_OK)
+		return status;
+	if (index.Type() != B_STRING_TYPE)
+		return B_BAD_TYPE;
+
+	TrigramFill fill(name);
+
+	Transaction transaction(fVolume, fVolume->Indices());
+
+	// only one trigram index can be filled at a time
+	if (fVolume->TrigramFill() != NULL)
+		return B_BUSY;
+
+	status = Create(transaction, trigramsName, B_UINT32_TYPE);
+	if (status == B_OK) {
+		fVolume->SetTrigramFill(&fill);
+		fVolume->TrigramIndexAdded();
+		status = transaction.Done();
+		if (status != B_OK) {
+			fVolume->TrigramIndexRemoved();
+			fVolume->SetTrigramFill(NULL);
+		}
+	}
+	if (status != B_OK)
+		RETURN_ERROR(status);
+
+	// From now on, Update() keeps the trigrams up to date, and remembers the
+	// nodes it changed in the fill, so that they are not added twice.
+	status = index._FillTrigrams(*this, fill);
+
+	Transaction doneTransaction(fVolume, fVolume->Indices());
+	fVolume->SetTrigramFill(NULL);
+	bool removed = false;
+	if (status != B_OK) {
+		// an incomplete trigram index would make queries miss entries
+		Unset();
+		if (fVolume->IndicesNode()->Remove(doneTransaction, trigramsName)
+				== B_OK) {
+			fVolume->TrigramIndexRemoved();
+			removed = true;
+		}
+	}
+	if (doneTransaction.Done() != B_OK && removed)
+		fVolume->TrigramIndexAdded();
+
+	return status;
+}
+
+
+/*static*/ status_t
+Index::GetTrigramsName(const char* name, char* buffer, size_t bufferSize)
+{
+	if (strlcpy(buffer, name, bufferSize) >= bufferSize
+		|| strlcat(buffer, kTrigramsSuffix, bufferSize) >= bufferSize)
+		return B_NAME_TOO_LONG;
+
+	return B_OK;
+}
+
+
+/*!	The reverse of GetTrigramsName(): if \a trigramsName is the name of a
+	trigram index, the name of its index is copied into \a buffer.
+	Otherwise, \c B_BAD_VALUE is returned.
+*/
+/*static*/ status_t
+Index::GetTrigramsIndexName(const char* trigramsName, char* buffer,
+	size_t bufferSize)
+{
+	size_t length = strlen(trigramsName);
+	size_t suffixLength = strlen(kTrigramsSuffix);
+	if (length <= suffixLength
+		|| strcmp(trigramsName + length - suffixLength, kTrigramsSuffix) != 0)
+		return B_BAD_VALUE;
+
+	length -= suffixLength;
+	if (length >= bufferSize)
+		return B_NAME_TOO_LONG;
+
+	memcpy(buffer, trigramsName, length);
+	buffer[length] = '\0';
+	return B_OK;
+}
+
+
 /*!	Updates the specified index, the oldKey will be removed from, the newKey
 	inserted into the tree.
 	If the method returns B_BAD_INDEX, it means the index couldn't be found -
@@ -277,6 +416,11 @@ Index::Update(Transaction& transaction, const char* name, int32 type,
 			inode->ID());
 	}
 
+	if (status == B_OK && type == B_STRING_TYPE) {
+		status = _UpdateTrigrams(transaction, name, oldKey, oldLength, newKey,
+			newLength, inode);
+	}
+
 	RETURN_ERROR(status);
 }
 
@@ -396,3 +540,210 @@ Index::UpdateLastModified(Transaction& transaction, Inode* inode,
 	return status;
 }
 
+
+//	#pragma mark - trigrams
+
+
+/*!	Updates the trigram index of the index \a name, if there is one. Only
+	the trigrams that differ between the old and the new key are touched.
+*/
+status_t
+Index::_UpdateTrigrams(Transaction& transaction, const char* name,
+	const uint8* oldKey, uint16 oldLength, const uint8* newKey,
+	uint16 newLength, Inode* inode)
+{
+	if (!fVolume->HasTrigramIndices())
+		return B_OK;
+
+	Index trigrams(fVolume);
+	if (trigrams.SetToTrigrams(name) != B_OK)
+		return B_OK;
+
+	BPlusTree* tree = trigrams.Node()->Tree();
+	if (tree == NULL)
+		return B_BAD_VALUE;
+
+	TrigramFill* fill = fVolume->TrigramFill();
+	if (fill != NULL && strcmp(fill->Name(), name) == 0) {
+		status_t status = fill->Touch(inode->ID());
+		if (status != B_OK)
+			return status;
+	}
+
+	trigrams.Node()->WriteLockInTransaction(transaction);
+
+	return _UpdateTrigrams(transaction, tree, oldKey, oldLength, newKey,
+		newLength, inode->ID());
+}
+
+
+status_t
+Index::_UpdateTrigrams(Transaction& transaction, BPlusTree* tree,
+	const uint8* oldKey, uint16 oldLength, const uint8* newKey,
+	uint16 newLength, off_t id)
+{
+	uint32* oldTrigrams = (uint32*)malloc(2 * kMaxKeyTrigrams
+		* sizeof(uint32));
+	if (oldTrigrams == NULL)
+		return B_NO_MEMORY;
+
+	MemoryDeleter deleter(oldTrigrams);
+	uint32* newTrigrams = oldTrigrams + kMaxKeyTrigrams;
+
+	int32 oldCount = oldKey != NULL ? getTrigrams((const char*)oldKey,
+		oldLength, oldTrigrams, kMaxKeyTrigrams) : 0;
+	int32 newCount = newKey != NULL ? getTrigrams((const char*)newKey,
+		newLength, newTrigrams, kMaxKeyTrigrams) : 0;
+
+	// both lists are sorted, so we can just merge them
+	int32 oldIndex = 0;
+	int32 newIndex = 0;
+	while (oldIndex < oldCount || newIndex < newCount) {
+		status_t status = B_OK;
+
+		if (newIndex == newCount
+			|| (oldIndex < oldCount
+				&& oldTrigrams[oldIndex] < newTrigrams[newIndex])) {
+			status = tree->Remove(transaction,
+				(const uint8*)&oldTrigrams[oldIndex++], sizeof(uint32), id);
+			if (status == B_ENTRY_NOT_FOUND)
+				status = B_OK;
+		} else if (oldIndex == oldCount
+			|| newTrigrams[newIndex] < oldTrigrams[oldIndex]) {
+			status = tree->Insert(transaction,
+				(const uint8*)&newTrigrams[newIndex++], sizeof(uint32), id);
+		} else {
+			// this trigram stays
+			oldIndex++;
+			newIndex++;
+		}
+
+		if (status != B_OK)
+			RETURN_ERROR(status);
+	}
+
+	return B_OK;
+}
+
+
+/*!	Adds the trigrams of all keys of this index to \a trigrams. The keys
+	are added in batches, each of which gets a transaction of its own.
+*/
+status_t
+Index::_FillTrigrams(Index& trigrams, TrigramFill& fill)
+{
+	BPlusTree* tree = Node()->Tree();
+	BPlusTree* trigramsTree = trigrams.Node()->Tree();
+	if (tree == NULL || trigramsTree == NULL)
+		return B_BAD_VALUE;
+
+	TreeIterator iterator(tree);
+	Journal* journal = fVolume->GetJournal(0);
+	size_t maxTransactionSize = fVolume->Log().Length() / 4;
+
+	// the iterator only fills in the key for the first of its duplicates
+	uint8 key[BPLUSTREE_MAX_KEY_LENGTH + 1];
+	uint16 keyLength = 0;
+
+	while (true) {
+		Transaction transaction(fVolume, trigrams.Node()->BlockNumber());
+		trigrams.Node()->WriteLockInTransaction(transaction);
+
+		status_t status = B_OK;
+		for (int32 i = 0; i < kMaxTrigramsFillKeys
+				&& journal->CurrentTransactionSize() < maxTransactionSize;
+				i++) {
+			off_t id;
+			status = iterator.GetNextEntry(key, &keyLength, sizeof(key), &id);
+			if (status != B_OK)
+				break;
+
+			// the trigrams of this node are already up to date
+			if (fill.WasTouched(id))
+				continue;
+
+			status = _UpdateTrigrams(transaction, trigramsTree, NULL, 0, key,
+				keyLength, id);
+			if (status != B_OK)
+				break;
+		}
+
+		if (status != B_OK && status != B_ENTRY_NOT_FOUND)
+			RETURN_ERROR(status);
+
+		status_t doneStatus = transaction.Done();
+		if (doneStatus != B_OK)
+			RETURN_ERROR(doneStatus);
+
+		if (status == B_ENTRY_NOT_FOUND)
+			return B_OK;
+	}
+}
+
+
+//	#pragma mark - TrigramFill
+
+
+TrigramFill::TrigramFill(const char* name)
+	:
+	fName(name),
+	fIDs(NULL),
+	fCount(0),
+	fCapacity(0)
+{
+}
+
+
+TrigramFill::~TrigramFill()
+{
+	free(fIDs);
+}
+
+
+status_t
+TrigramFill::Touch(ino_t id)
+{
+	// keep the IDs sorted
+	int32 lower = 0;
+	int32 upper = fCount;
+	while (lower < upper) {
+		int32 middle = (lower + upper) / 2;
+		if (fIDs[middle] < id)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	if (lower < fCount && fIDs[lower] == id)
+		return B_OK;
+
+	if (fCount == fCapacity) {
+		int32 capacity = fCapacity > 0 ? fCapacity * 2 : 64;
+		ino_t* ids = (ino_t*)realloc(fIDs, capacity * sizeof(ino_t));
+		if (ids == NULL)
+			return B_NO_MEMORY;
+
+		fIDs = ids;
+		fCapacity = capacity;
+	}
+
+	memmove(&fIDs[lower + 1], &fIDs[lower], (fCount - lower) * sizeof(ino_t));
+	fIDs[lower] = id;
+	fCount++;
+	return B_OK;
+}
+
+
+bool
+TrigramFill::WasTouched(ino_t id) const
+{
+	int32 lower = 0;
+	int32 upper = fCount;
+	while (lower < upper) {
+		int32 middle = (lower + upper) / 2;
+		if (fIDs[middle] < id)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower < fCount && fIDs[lower] == id;
+}
@@ -9,7 +9,9 @@
 #include "system_dependencies.h"
 
 
+class BPlusTree;
 class Transaction;
+class TrigramFill;
 class Volume;
 class Inode;
 
@@ -20,6 +22,7 @@ public:
 							~Index();
 
 			status_t		SetTo(const char* name);
+			status_t		SetToTrigrams(const char* name);
 			void			Unset();
 
 			Inode*			Node() const { return fNode; };
@@ -28,6 +31,12 @@ public:
 
 			status_t		Create(Transaction& transaction, const char* name,
 								uint32 type);
+			status_t		CreateTrigrams(const char* name);
+
+	static	status_t		GetTrigramsName(const char* name, char* buffer,
+								size_t bufferSize);
+	static	status_t		GetTrigramsIndexName(const char* trigramsName,
+								char* buffer, size_t bufferSize);
 
 			status_t		Update(Transaction& transaction, const char* name,
 								int32 type, const uint8* oldKey,
@@ -58,6 +67,17 @@ private:
 							Index& operator=(const Index& other);
 								// no implementation
 
+			status_t		_UpdateTrigrams(Transaction& transaction,
+								const char* name, const uint8* oldKey,
+								uint16 oldLength, const uint8* newKey,
+								uint16 newLength, Inode* inode);
+			status_t		_UpdateTrigrams(Transaction& transaction,
+								BPlusTree* tree, const uint8* oldKey,
+								uint16 oldLength, const uint8* newKey,
+								uint16 newLength, off_t id);
+			status_t		_FillTrigrams(Index& trigrams,
+								TrigramFill& fill);
+
 private:
 			Volume*			fVolume;
 			Inode*			fNode;
@@ -65,4 +85,25 @@ private:
 };
 
 
+/*!	Keeps track of the nodes whose trigrams have been updated while a new
+	trigram index is being filled; those must not be added again.
+*/
+class TrigramFill {
+public:
+							TrigramFill(const char* name);
+							~TrigramFill();
+
+			const char*		Name() const { return fName; }
+
+			status_t		Touch(ino_t id);
+			bool			WasTouched(ino_t id) const;
+
+private:
+			const char*		fName;
+			ino_t*			fIDs;
+			int32			fCount;
+			int32			fCapacity;
+};
+
+
 #endif	// INDEX_H
@@ -344,7 +344,11 @@ Inode::Inode(Volume* volume, ino_t id)
 	fTree(NULL),
 	fAttributes(NULL),
 	fCache(NULL),
-	fMap(NULL)
+	fMap(NULL),
+	fDelayedSize(0),
+	fReservedBlocks(0),
+	fAllocatingSize(0),
+	fAllocatingReservation(0)
 {
 	PRINT(("Inode::Inode(volume = %p, id = %" B_PRIdINO ") @ %p\n",
 		volume, id, this));
@@ -378,7 +382,11 @@ Inode::Inode(Volume* volume, Transaction& transaction, ino_t id, mode_t mode,
 	fTree(NULL),
 	fAttributes(NULL),
 	fCache(NULL),
-	fMap(NULL)
+	fMap(NULL),
+	fDelayedSize(0),
+	fReservedBlocks(0),
+	fAllocatingSize(0),
+	fAllocatingReservation(0)
 {
 	PRINT(("Inode::Inode(volume = %p, transaction = %p, id = %" B_PRIdINO
 		") @ %p\n", volume, &transaction, id, this));
@@ -420,6 +428,9 @@ Inode::~Inode()
 {
 	PRINT(("Inode::~Inode() @ %p\n", this));
 
+	if (fReservedBlocks != 0)
+		fVolume->UnreserveBlocks(fReservedBlocks);
+
 	file_cache_delete(FileCache());
 	file_map_delete(Map());
 	delete fTree;
@@ -568,7 +579,9 @@ Inode::_MakeSpaceForSmallData(Transaction& transaction, bfs_inode* node,
 		int32 index = 0, maxIndex = 0;
 		for (; !item->IsLast(node); item = item->Next(), index++) {
 			// should not remove those
-			if (*item->Name() == FILE_NAME_NAME || !strcmp(name, item->Name()))
+			if (*item->Name() == FILE_NAME_NAME
+				|| *item->Name() == FILE_DATA_NAME
+				|| !strcmp(name, item->Name()))
 				continue;
 
 			if (max == NULL || max->Size() < item->Size()) {
@@ -1428,8 +1441,9 @@ Inode::ContainerContentsChanged(Transaction& transaction)
 off_t
 Inode::AllocatedSize() const
 {
-	if (IsSymLink() && (Flags() & INODE_LONG_SYMLINK) == 0) {
-		// This symlink does not have a data stream
+	if ((IsSymLink() && (Flags() & INODE_LONG_SYMLINK) == 0)
+		|| HasInlineData()) {
+		// This symlink or file does not have a data stream
 		return Node().InodeSize();
 	}
 
@@ -1601,15 +1615,48 @@ Inode::WriteAt(Transaction& transaction, off_t pos, const uint8* buffer,
 
 	locker.Unlock();
 
+	if (changeSize && HasInlineData()) {
+		// Writing back inline data needs a transaction, too, so we must not
+		// keep the journal locked while writing to the file cache below
+		Transaction inlineTransaction(fVolume, BlockNumber());
+		WriteLockInTransaction(inlineTransaction);
+
+		status_t status = B_OK;
+		if (HasInlineData() && !HasDelayedAllocation()
+			&& (uint64)pos + (uint64)length > (uint64)Size()) {
+			status = _SetInlineDataSize(inlineTransaction, pos + length);
+			if (status == B_OK) {
+				file_cache_set_size(FileCache(), pos + length);
+				status = WriteBack(inlineTransaction);
+				changeSize = false;
+			} else if (status == B_DEVICE_FULL) {
+				// The file grows like any other below; its data is moved
+				// out of the inode once its blocks are allocated
+				status = B_OK;
+			}
+		}
+		if (status == B_OK)
+			status = inlineTransaction.Done();
+		if (status != B_OK) {
+			*_length = 0;
+			RETURN_ERROR(status);
+		}
+	}
+
+	// Files only reserve the blocks they grow by here; they are allocated
+	// when their data is written back, or when the file is closed, at which
+	// point we know much better how large the file is going to be.
+	bool delayAllocation = IsFile();
+
 	// the transaction doesn't have to be started already
-	if (changeSize && !transaction.IsStarted())
+	if (changeSize && !delayAllocation && !transaction.IsStarted())
 		transaction.Start(fVolume, BlockNumber());
 
 	WriteLocker writeLocker(fLock);
 
 	// Work around possible race condition: Someone might have shrunken the file
 	// while we had no lock.
-	if (!transaction.IsStarted()
+	if (!delayAllocation && !transaction.IsStarted()
 		&& (uint64)pos + (uint64)length > (uint64)Size()) {
 		writeLocker.Unlock();
 		transaction.Start(fVolume, BlockNumber());
@@ -1618,7 +1665,14 @@ Inode::WriteAt(Transaction& transaction, off_t pos, const uint8* buffer,
 
 	off_t oldSize = Size();
 
-	if ((uint64)pos + (uint64)length > (uint64)oldSize) {
+	if ((uint64)pos + (uint64)length > (uint64)oldSize && delayAllocation) {
+		// let the file grow, but leave its data stream alone for now
+		status_t status = _DelayAllocation(pos + length);
+		if (status != B_OK) {
+			*_length = 0;
+			RETURN_ERROR(status);
+		}
+	} else if ((uint64)pos + (uint64)length > (uint64)oldSize) {
 		// let's grow the data stream to the size needed
 		status_t status = SetFileSize(transaction, pos + length);
 		if (status != B_OK) {
@@ -1686,6 +1740,173 @@ Inode::FillGapWithZeros(off_t pos, off_t newSize)
 }
 
 
+/*!	Reads the data of a file that is stored in its small_data section.
+	Returns the number of bytes read in \a _length, which is less than
+	requested when reading beyond the end of the file.
+	The inode must be locked.
+*/
+status_t
+Inode::ReadInlineData(off_t pos, uint8* buffer, size_t* _length)
+{
+	NodeGetter node(fVolume);
+	status_t status = node.SetTo(this);
+	if (status != B_OK)
+		return status;
+
+	RecursiveLocker locker(fSmallDataLock);
+
+	const char dataTag[2] = {FILE_DATA_NAME, 0};
+	small_data* item = FindSmallData(node.Node(), dataTag);
+	if (item == NULL || pos >= item->DataSize()) {
+		*_length = 0;
+		return B_OK;
+	}
+
+	size_t length = min_c(*_length, (size_t)(item->DataSize() - pos));
+	memcpy(buffer, item->Data() + pos, length);
+
+	*_length = length;
+	return B_OK;
+}
+
+
+/*!	Writes the data of a file that is stored in its small_data section.
+	Anything beyond the end of the file is ignored; use SetFileSize() to
+	let it grow first.
+	The inode must be write locked in \a transaction.
+*/
+status_t
+Inode::WriteInlineData(Transaction& transaction, off_t pos,
+	const uint8* buffer, size_t length)
+{
+	if (!HasInlineData())
+		return B_BAD_VALUE;
+
+	NodeGetter node(fVolume);
+	status_t status = node.SetToWritable(transaction, this);
+	if (status != B_OK)
+		return status;
+
+	RecursiveLocker locker(fSmallDataLock);
+
+	const char dataTag[2] = {FILE_DATA_NAME, 0};
+	small_data* item = FindSmallData(node.Node(), dataTag);
+	if (item == NULL || pos >= item->DataSize())
+		return B_OK;
+
+	length = min_c(length, (size_t)(item->DataSize() - pos));
+	memcpy(item->Data() + pos, buffer, length);
+	return B_OK;
+}
+
+
+/*!	Resizes the inline data of a file, filling any new space with zeros.
+	Returns B_DEVICE_FULL if the data does not fit into the small_data
+	section anymore; the attributes in there are never moved out to make
+	room for it.
+	The inode must be write locked in \a transaction.
+*/
+status_t
+Inode::_SetInlineDataSize(Transaction& transaction, off_t size)
+{
+	if (size > fVolume->MaxInlineDataSize())
+		return B_DEVICE_FULL;
+
+	NodeGetter node(fVolume);
+	status_t status = node.SetToWritable(transaction, this);
+	if (status != B_OK)
+		return status;
+
+	const char dataTag[2] = {FILE_DATA_NAME, 0};
+
+	if (size == 0) {
+		status = _RemoveSmallData(transaction, node, dataTag);
+		if (status == B_ENTRY_NOT_FOUND)
+			status = B_OK;
+	} else if (Node().data.Size() == 0) {
+		// there is no data item yet
+		uint8* zeros = (uint8*)malloc(size);
+		if (zeros == NULL)
+			return B_NO_MEMORY;
+		MemoryDeleter zerosDeleter(zeros);
+
+		memset(zeros, 0, size);
+		status = _AddSmallData(transaction, node, dataTag, FILE_DATA_TYPE, 0,
+			zeros, size);
+	} else {
+		// resizing the existing item fills the gap up to its end with zeros
+		status = _AddSmallData(transaction, node, dataTag, FILE_DATA_TYPE,
+			size, (const uint8*)"", 0);
+	}
+	if (status != B_OK)
+		return status;
+
+	Node().data.size = HOST_ENDIAN_TO_BFS_INT64(size);
+	return B_OK;
+}
+
+
+/*!	Moves the data of a file out of its small_data section, once the file
+	has outgrown it. This only happens when the delayed part of the file is
+	allocated, so that the data stream grows to the full file size at once.
+	The inline data is written to the first block before the transaction is
+	done, so that the file is never left without it.
+	The inode must be write locked in \a transaction.
+*/
+status_t
+Inode::_MoveInlineData(Transaction& transaction)
+{
+	// the inline data is always smaller than a block
+	uint8* block = (uint8*)malloc(fVolume->BlockSize());
+	if (block == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter blockDeleter(block);
+
+	memset(block, 0, fVolume->BlockSize());
+
+	size_t length = fVolume->BlockSize();
+	status_t status = ReadInlineData(0, block, &length);
+	if (status != B_OK)
+		return status;
+
+	// the data stream starts out empty
+	off_t inlineSize = Node().data.Size();
+	Node().data.size = 0;
+	Node().flags &= ~HOST_ENDIAN_TO_BFS_INT32(INODE_INLINE_DATA);
+
+	status = AllocateDelayed(transaction);
+	if (status != B_OK) {
+		Node().data.size = HOST_ENDIAN_TO_BFS_INT64(inlineSize);
+		Node().flags |= HOST_ENDIAN_TO_BFS_INT32(INODE_INLINE_DATA);
+		return status;
+	}
+
+	if (length > 0) {
+		block_run run;
+		off_t offset;
+		status = FindBlockRun(0, run, offset);
+		if (status != B_OK)
+			return status;
+
+		if (write_pos(fVolume->Device(), fVolume->ToOffset(run), block,
+				fVolume->BlockSize()) != (ssize_t)fVolume->BlockSize())
+			return B_IO_ERROR;
+	}
+
+	NodeGetter node(fVolume);
+	status = node.SetToWritable(transaction, this);
+	if (status != B_OK)
+		return status;
+
+	const char dataTag[2] = {FILE_DATA_NAME, 0};
+	status = _RemoveSmallData(transaction, node, dataTag);
+	if (status == B_ENTRY_NOT_FOUND)
+		status = B_OK;
+
+	return status;
+}
+
+
 /*!	Allocates \a length blocks, and clears their contents. Growing
 	the indirect and double indirect range uses this method.
 	The allocated block_run is saved in "run"
@@ -1720,7 +1941,7 @@ Inode::_AllocateBlockArray(Transaction& transaction, block_run& run,
 	This method will also determine the size of the preallocation, if any.
 */
 status_t
-Inode::_GrowStream(Transaction& transaction, off_t size)
+Inode::_GrowStream(Transaction& transaction, off_t size, bool preallocate)
 {
 	data_stream* data = &Node().data;
 
@@ -1752,10 +1973,12 @@ Inode::_GrowStream(Transaction& transaction, off_t size)
 			minimum = data->double_indirect.Length();
 	}
 
-	// do we have enough free blocks on the disk?
+	// do we have enough free blocks on the disk? (we may use what has been
+	// reserved for us)
 	off_t blocksNeeded = (bytes + fVolume->BlockSize() - 1)
 		>> fVolume->BlockShift();
-	if (blocksNeeded > fVolume->FreeBlocks())
+	off_t availableBlocks = fVolume->AvailableBlocks() + fReservedBlocks;
+	if (blocksNeeded > availableBlocks)
 		return B_DEVICE_FULL;
 
 	off_t blocksRequested = blocksNeeded;
@@ -1768,8 +1991,8 @@ Inode::_GrowStream(Transaction& transaction, off_t size)
 	// that big, and should stay close to the inode - preallocating could be
 	// counterproductive.
 	// Also, if free disk space is tight, don't preallocate.
-	if (!IsAttribute() && !IsAttributeDirectory() && !IsSymLink()
-		&& fVolume->FreeBlocks() > 128) {
+	if (preallocate && !IsAttribute() && !IsAttributeDirectory()
+		&& !IsSymLink() && availableBlocks > 128) {
 		off_t roundTo = 0;
 		if (IsFile()) {
 			// Request preallocated blocks depending on the file size and growth
@@ -2279,6 +2502,38 @@ Inode::SetFileSize(Transaction& transaction, off_t size)
 
 	T(Resize(this, oldSize, size, false));
 
+	if (HasInlineData()) {
+		status_t status = _SetInlineDataSize(transaction, size);
+		if (status == B_OK) {
+			// anything beyond the inline data only existed in the file cache
+			if (HasDelayedAllocation())
+				_DiscardDelayedAllocation();
+
+			file_cache_set_size(FileCache(), size);
+			return WriteBack(transaction);
+		}
+		if (status != B_DEVICE_FULL)
+			return status;
+
+		// the data doesn't fit into the inode anymore
+		status = _DelayAllocation(size);
+		if (status == B_OK)
+			status = AllocateDelayed(transaction);
+		return status;
+	}
+
+	if (HasDelayedAllocation()) {
+		// get the delayed part out of the way first
+		if (size <= Node().data.Size())
+			_DiscardDelayedAllocation();
+		else {
+			status_t status = AllocateDelayed(transaction);
+			if (status != B_OK)
+				return status;
+		}
+		oldSize = Size();
+	}
+
 	// should the data stream grow or shrink?
 	status_t status;
 	if (size > oldSize) {
@@ -2345,6 +2600,153 @@ Inode::TrimPreallocation(Transaction& transaction)
 }
 
 
+/*!	Returns the file size, including the part that has not been allocated
+	yet. Since this is also used without holding the inode lock, the delayed
+	size is only changed atomically, and cleared only once the data stream
+	has grown to it.
+*/
+off_t
+Inode::Size() const
+{
+	off_t delayedSize = atomic_get64((int64*)&fDelayedSize);
+	return delayedSize != 0 ? delayedSize : fNode.data.Size();
+}
+
+
+/*!	Returns the file offset up to which blocks have been allocated for the
+	data stream, including preallocated ones.
+*/
+off_t
+Inode::StreamEnd() const
+{
+	const data_stream& data = Node().data;
+
+	if (data.MaxDoubleIndirectRange() != 0)
+		return data.MaxDoubleIndirectRange();
+	if (data.MaxIndirectRange() != 0)
+		return data.MaxIndirectRange();
+
+	return data.MaxDirectRange();
+}
+
+
+/*!	Grows the data stream to the file size, allocating the blocks that
+	have only been reserved so far. Since this usually happens for the
+	whole file at once, it is much more likely to end up in a single
+	block run than growing it with every write.
+	Nothing is preallocated: the reservation doesn't account for it, and
+	the file will be allocated again when it grows further anyway.
+	The inode must be write locked in \a transaction.
+*/
+status_t
+Inode::AllocateDelayed(Transaction& transaction)
+{
+	if (fDelayedSize == 0)
+		return B_OK;
+	if (HasInlineData())
+		return _MoveInlineData(transaction);
+
+	off_t size = fDelayedSize;
+	off_t oldSize = Node().data.Size();
+	off_t reserved = fReservedBlocks;
+
+	// Volume::Allocate() takes the blocks out of our reservation
+	status_t status = _GrowStream(transaction, size, false);
+	if (status != B_OK) {
+		_ShrinkStream(transaction, oldSize);
+		fVolume->RestoreReservedBlocks(reserved - fReservedBlocks);
+		fReservedBlocks = reserved;
+		RETURN_ERROR(status);
+	}
+
+	// the file map might still know the delayed part as a sparse extent
+	file_map_invalidate(Map(), oldSize, size - oldSize);
+
+	// What is left of the reservation was only needed in the worst case
+	fVolume->UnreserveBlocks(fReservedBlocks);
+	fReservedBlocks = 0;
+
+	// the stream has the full size now, so Size() never goes back
+	atomic_set64((int64*)&fDelayedSize, 0);
+
+	fAllocatingSize = size;
+	fAllocatingReservation += reserved;
+
+	return WriteBack(transaction);
+}
+
+
+//!	Allocates the delayed part of the file in a transaction of its own.
+status_t
+Inode::AllocateDelayed()
+{
+	{
+		InodeReadLocker locker(this);
+		if (!HasDelayedAllocation())
+			return B_OK;
+	}
+
+	Transaction transaction(fVolume, BlockNumber());
+	WriteLockInTransaction(transaction);
+
+	status_t status = AllocateDelayed(transaction);
+	if (status == B_OK)
+		status = transaction.Done();
+
+	return status;
+}
+
+
+/*!	Lets the file grow to \a size, but only reserves the blocks needed for
+	that; see AllocateDelayed().
+	The inode must be write locked.
+*/
+status_t
+Inode::_DelayAllocation(off_t size)
+{
+	off_t streamEnd = StreamEnd();
+	off_t blocks = 0;
+
+	if (size > streamEnd) {
+		blocks = (size - streamEnd + fVolume->BlockSize() - 1)
+			>> fVolume->BlockShift();
+
+		// Small files always fit into the direct range, larger ones might
+		// need the block arrays of the indirect and double indirect ranges
+		if ((size >> fVolume->BlockShift()) >= NUM_DIRECT_BLOCKS) {
+			blocks += NUM_ARRAY_BLOCKS + _DoubleIndirectBlockLength()
+				+ blocks / (fVolume->BlockSize() / sizeof(block_run));
+		}
+	}
+
+	if (blocks > fReservedBlocks) {
+		status_t status = fVolume->ReserveBlocks(blocks - fReservedBlocks);
+		if (status != B_OK)
+			return status;
+
+		fReservedBlocks = blocks;
+	}
+
+	atomic_set64((int64*)&fDelayedSize, size);
+
+	file_cache_set_size(FileCache(), size);
+	file_map_set_size(Map(), size);
+	return B_OK;
+}
+
+
+void
+Inode::_DiscardDelayedAllocation()
+{
+	if (fReservedBlocks != 0) {
+		fVolume->UnreserveBlocks(fReservedBlocks);
+		fReservedBlocks = 0;
+	}
+
+	atomic_set64((int64*)&fDelayedSize, 0);
+}
+
+
 //!	Frees the file's data stream and removes all attributes
 status_t
 Inode::Free(Transaction& transaction)
@@ -2494,7 +2896,19 @@ Inode::TransactionDone(bool success)
 		// Revert any changes made to the cached bfs_inode
 		// TODO: return code gets eaten
 		UpdateNodeFromDisk();
+
+		// the delayed part has not been allocated after all, and its
+		// blocks are free again
+		if (fAllocatingSize > fDelayedSize)
+			atomic_set64((int64*)&fDelayedSize, fAllocatingSize);
+		if (fAllocatingReservation != 0) {
+			fVolume->RestoreReservedBlocks(fAllocatingReservation);
+			fReservedBlocks += fAllocatingReservation;
+		}
 	}
+
+	fAllocatingSize = 0;
+	fAllocatingReservation = 0;
 }
 
 
@@ -2741,6 +3155,11 @@ Inode::Create(Transaction& transaction, Inode* parent, const char* name,
 
 	node->type = HOST_ENDIAN_TO_BFS_INT32(type);
 
+	if (inode->IsFile() && volume->HasInlineData()) {
+		// new files start with their data in the small_data section
+		node->flags |= HOST_ENDIAN_TO_BFS_INT32(INODE_INLINE_DATA);
+	}
+
 	inode->WriteBack(transaction);
 		// make sure the initialized node is available to others
 
@@ -2894,8 +3313,10 @@ AttributeIterator::GetNext(char* name, size_t* _length, uint32* _type,
 
 		int32 index = 0;
 		for (; !item->IsLast(node); item = item->Next(), index++) {
-			if (item->NameSize() == FILE_NAME_NAME_LENGTH
-				&& *item->Name() == FILE_NAME_NAME)
+			if ((item->NameSize() == FILE_NAME_NAME_LENGTH
+					&& *item->Name() == FILE_NAME_NAME)
+				|| (item->NameSize() == FILE_DATA_NAME_LENGTH
+					&& *item->Name() == FILE_DATA_NAME))
 				continue;
 
 			if (index >= fCurrentSmallData)
@@ -75,6 +75,9 @@ public:
 			bool				IsLongSymLink() const
 									{ return (Flags() & INODE_LONG_SYMLINK)
 										!= 0; }
+			bool				HasInlineData() const
+									{ return (Flags() & INODE_INLINE_DATA)
+										!= 0; }
 
 			bool				HasUserAccessableStream() const
 									{ return IsFile(); }
@@ -91,7 +94,7 @@ public:
 			uint32				Type() const { return fNode.Type(); }
 			int32				Flags() const { return fNode.Flags(); }
 
-			off_t				Size() const { return fNode.data.Size(); }
+			off_t				Size() const;
 			off_t				AllocatedSize() const;
 			off_t				LastModified() const
 									{ return fNode.LastModifiedTime(); }
@@ -150,12 +153,30 @@ public:
 									const uint8* buffer, size_t* length);
 			status_t			FillGapWithZeros(off_t oldSize, off_t newSize);
 
+			// files with their data in the small_data section
+			status_t			ReadInlineData(off_t pos, uint8* buffer,
+									size_t* _length);
+			status_t			WriteInlineData(Transaction& transaction,
+									off_t pos, const uint8* buffer,
+									size_t length);
+
 			status_t			SetFileSize(Transaction& transaction,
 									off_t size);
 			status_t			Append(Transaction& transaction, off_t bytes);
 			status_t			TrimPreallocation(Transaction& transaction);
 			bool				NeedsTrimming() const;
 
+			// delayed allocation (the inode must be locked)
+			bool				HasDelayedAllocation() const
+									{ return fDelayedSize != 0; }
+			off_t				StreamEnd() const;
+			status_t			AllocateDelayed(Transaction& transaction);
+			status_t			AllocateDelayed();
+			off_t				ReservedBlocks() const
+									{ return fReservedBlocks; }
+			void				UsedReservedBlocks(off_t blocks)
+									{ fReservedBlocks -= blocks; }
+
 			status_t			Free(Transaction& transaction);
 			status_t			Sync();
 
@@ -236,6 +257,13 @@ private:
 									const char* name, bool hasIndex,
 									Index* index);
 
+			status_t			_SetInlineDataSize(Transaction& transaction,
+									off_t size);
+			status_t			_MoveInlineData(Transaction& transaction);
+
+			status_t			_DelayAllocation(off_t size);
+			void				_DiscardDelayedAllocation();
+
 			void				_AddIterator(AttributeIterator* iterator);
 			void				_RemoveIterator(AttributeIterator* iterator);
 
@@ -250,7 +278,7 @@ private:
 									block_run& run, size_t length,
 									bool variableSize = false);
 			status_t			_GrowStream(Transaction& transaction,
-									off_t size);
+									off_t size, bool preallocate = true);
 			status_t			_ShrinkStream(Transaction& transaction,
 									off_t size);
 
@@ -269,6 +297,16 @@ private:
 				// we need those values to ensure we will remove
 				// the correct keys from the indices
 
+			off_t				fDelayedSize;
+				// the file size, if the data stream has not been grown to
+				// it yet, or 0; only changed atomically, see Size()
+			off_t				fReservedBlocks;
+				// blocks reserved on the volume for the delayed part
+			off_t				fAllocatingSize;
+			off_t				fAllocatingReservation;
+				// the delayed size and its reservation while they are being
+				// allocated, in case the transaction fails
+
 			mutable recursive_lock fSmallDataLock;
 			SinglyLinkedList<AttributeIterator> fIterators;
 };
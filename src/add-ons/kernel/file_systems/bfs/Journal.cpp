@@ -15,6 +15,17 @@
 #include "Inode.h"
 
 
+// Every sub transaction has to look at all blocks of the transaction it is
+// added to, so batching too many of them becomes slower again, no matter
+// how large the log is. This is what a 2048 blocks log used to allow.
+static const uint32 kMaxBatchedTransactionSize = 1019;
+
+// Freed blocks are trimmed a few ranges at a time, so that this does not
+// get in the way of other I/O.
+static const bigtime_t kTrimInterval = 500000;
+static const uint32 kTrimRangesPerInterval = 16;
+
+
 struct run_array {
 	int32		count;
 	int32		max_runs;
@@ -403,14 +414,17 @@ Journal::Journal(Volume* volume)
 	fVolume(volume),
 	fOwner(NULL),
 	fLogSize(volume->Log().Length()),
-	fMaxTransactionSize(fLogSize / 2 - 5),
+	fMaxTransactionSize(min_c(fLogSize / 2 - 5, kMaxBatchedTransactionSize)),
 	fUsed(0),
 	fUnwrittenTransactions(0),
 	fHasSubtransaction(false),
-	fSeparateSubTransactions(false)
+	fSeparateSubTransactions(false),
+	fDeviceFlushes(0),
+	fDeviceFlushStatus(B_OK)
 {
 	recursive_lock_init(&fLock, "bfs journal");
 	mutex_init(&fEntriesLock, "bfs journal entries");
+	mutex_init(&fFlushLock, "bfs journal flush");
 
 	fLogFlusherSem = create_sem(0, "bfs log flusher");
 	fLogFlusher = spawn_kernel_thread(&Journal::_LogFlusher, "bfs log flusher",
@@ -424,13 +438,14 @@ Journal::~Journal()
 {
 	FlushLogAndBlocks();
 
-	recursive_lock_destroy(&fLock);
-	mutex_destroy(&fEntriesLock);
-
 	sem_id logFlusher = fLogFlusherSem;
 	fLogFlusherSem = -1;
 	delete_sem(logFlusher);
 	wait_for_thread(fLogFlusher, NULL);
+
+	recursive_lock_destroy(&fLock);
+	mutex_destroy(&fEntriesLock);
+	mutex_destroy(&fFlushLock);
 }
 
 
@@ -710,15 +725,44 @@ Journal::_LogFlusher(void* _journal)
 {
 	Journal* journal = (Journal*)_journal;
 	while (journal->fLogFlusherSem >= 0) {
-		if (acquire_sem(journal->fLogFlusherSem) != B_OK)
-			continue;
-
-		journal->_FlushLog(false, false);
+		// As long as there are freed blocks to trim, wake up regularly to
+		// trim a few of them at a time
+		bigtime_t timeout = journal->fVolume->Allocator().HasFreedBlocks()
+			? kTrimInterval : B_INFINITE_TIMEOUT;
+		status_t status = acquire_sem_etc(journal->fLogFlusherSem, 1,
+			B_RELATIVE_TIMEOUT, timeout);
+		if (status == B_TIMED_OUT)
+			journal->_TrimFreedBlocks();
+		else if (status == B_OK)
+			journal->_FlushLog(false, false);
 	}
 	return B_OK;
 }
 
 
+/*!	Lets the device discard some of the blocks that have been freed. This is
+	only done when the journal is not in use, and the transactions that freed
+	the blocks are in the log already, as the blocks would otherwise still be
+	in use after replaying the log.
+*/
+void
+Journal::_TrimFreedBlocks()
+{
+	if (recursive_lock_trylock(&fLock) != B_OK)
+		return;
+
+	status_t status = B_BUSY;
+	if (fUnwrittenTransactions == 0 && recursive_lock_get_recursion(&fLock) == 1)
+		status = fVolume->Allocator().CollectFreedBlocks(kTrimRangesPerInterval);
+
+	recursive_lock_unlock(&fLock);
+
+	// the device may take a while, so don't keep the journal locked
+	if (status == B_OK)
+		fVolume->Allocator().TrimCollectedBlocks();
+}
+
+
 /*!	Writes the blocks that are part of current transaction into the log,
 	and ends the current transaction.
 	If the current transaction is too large to fit into the log, it will
@@ -948,16 +992,39 @@ Journal::_FlushLog(bool canWait, bool flushBlocks)
 			FATAL(("writing current log entry failed: %s\n", strerror(status)));
 	}
 
+	recursive_lock_unlock(&fLock);
+
+	// Writing back the blocks can take a while, and doesn't need the journal
+	// anymore, so new transactions may already be started in the mean time
 	if (flushBlocks)
-		status = fVolume->FlushDevice();
+		status = _FlushDevice();
 
-	recursive_lock_unlock(&fLock);
 	return status;
 }
 
 
+/*!	Writes back all blocks of completed transactions. Concurrent callers are
+	combined into a single flush: if another flush was started after we got
+	here, it has already written back everything we would have.
+*/
+status_t
+Journal::_FlushDevice()
+{
+	int32 flushes = atomic_get(&fDeviceFlushes);
+
+	MutexLocker locker(fFlushLock);
+	if (atomic_get(&fDeviceFlushes) != flushes)
+		return fDeviceFlushStatus;
+
+	atomic_add(&fDeviceFlushes, 1);
+	fDeviceFlushStatus = fVolume->FlushDevice();
+	return fDeviceFlushStatus;
+}
+
+
 /*!	Flushes the current log entry to disk, and also writes back all dirty
 	blocks for this volume (completing all open transactions).
+	Several threads syncing at the same time share a single device flush.
 */
 status_t
 Journal::FlushLogAndBlocks()
@@ -50,6 +50,7 @@ private:
 								{ return fHasSubtransaction; }
 
 			status_t		_FlushLog(bool canWait, bool flushBlocks);
+			status_t		_FlushDevice();
 			uint32			_TransactionSize() const;
 			status_t		_WriteTransactionToLog();
 			status_t		_CheckRunArray(const run_array* array);
@@ -61,6 +62,7 @@ private:
 	static	void			_TransactionIdle(int32 transactionID, int32 event,
 								void* _journal);
 	static	status_t		_LogFlusher(void* _journal);
+			void			_TrimFreedBlocks();
 
 private:
 			Volume*			fVolume;
@@ -77,6 +79,10 @@ private:
 			bool			fHasSubtransaction;
 			bool			fSeparateSubTransactions;
 
+			mutex			fFlushLock;
+			int32			fDeviceFlushes;
+			status_t		fDeviceFlushStatus;
+
 			thread_id		fLogFlusher;
 			sem_id			fLogFlusherSem;
 };
@@ -117,6 +117,12 @@ struct Query::QueryPolicy {
 		return status;
 	}
 
+	static status_t IndexSetToTrigrams(Index& index, const char* attribute)
+	{
+		index.isSpecialTime = false;
+		return index.SetToTrigrams(attribute);
+	}
+
 	static void IndexUnset(Index& index)
 	{
 		index.Unset();
@@ -206,6 +212,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* iterator)
+	{
+		return iterator->offset;
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* iterator)
 	{
 		iterator->SkipDuplicates();
@@ -347,6 +358,13 @@ Query::GetNextEntry(struct dirent* entry, size_t size)
 }
 
 
+status_t
+Query::DescribePlan(char* buffer, size_t bufferSize)
+{
+	return fImpl->DescribePlan(buffer, bufferSize);
+}
+
+
 void
 Query::LiveUpdate(Inode* inode, const char* attribute, int32 type,
 	const void* oldKey, size_t oldLength, const void* newKey, size_t newLength)
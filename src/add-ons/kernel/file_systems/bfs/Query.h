@@ -29,6 +29,8 @@ public:
 			status_t		Rewind();
 			status_t		GetNextEntry(struct dirent* entry, size_t size);
 
+			status_t		DescribePlan(char* buffer, size_t bufferSize);
+
 			void			LiveUpdate(Inode* inode,
 								const char* attribute, int32 type,
 								const void* oldKey, size_t oldLength,
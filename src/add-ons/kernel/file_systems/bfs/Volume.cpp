@@ -8,9 +8,11 @@
 
 
 #include "Attribute.h"
+#include "BPlusTree.h"
 #include "CheckVisitor.h"
 #include "Debug.h"
 #include "file_systems/DeviceOpener.h"
+#include "Index.h"
 #include "Inode.h"
 #include "Journal.h"
 #include "Query.h"
@@ -129,9 +131,12 @@ Volume::Volume(fs_volume* volume)
 	:
 	fVolume(volume),
 	fBlockAllocator(this),
+	fReservedBlocks(0),
 	fRootNode(NULL),
 	fIndicesNode(NULL),
 	fDirtyCachedBlocks(0),
+	fTrigramFill(NULL),
+	fTrigramIndexCount(0),
 	fFlags(0),
 	fCheckingThread(-1),
 	fCheckVisitor(NULL)
@@ -200,6 +205,13 @@ Volume::Mount(const char* deviceName, uint32 flags)
 		return B_BAD_VALUE;
 	}
 
+	if ((fSuperBlock.Features() & ~SUPER_BLOCK_KNOWN_FEATURES) != 0) {
+		// the volume was changed in a way we don't know how to maintain
+		INFORM(("bfs: unknown features %#" B_PRIx32 ", volume read-only.\n",
+			fSuperBlock.Features() & ~SUPER_BLOCK_KNOWN_FEATURES));
+		fFlags |= VOLUME_READ_ONLY;
+	}
+
 	// initialize short hands to the superblock (to save byte swapping)
 	fBlockSize = fSuperBlock.BlockSize();
 	fBlockShift = fSuperBlock.BlockShift();
@@ -276,6 +288,7 @@ Volume::Mount(const char* deviceName, uint32 flags)
 				}
 			} else {
 				// we don't use the vnode layer to access the indices node
+				_CountTrigramIndices();
 			}
 		} else {
 			FATAL(("could not create root node: publish_vnode() failed!\n"));
@@ -355,6 +368,45 @@ Volume::ToBlockRun(off_t block) const
 }
 
 
+/*!	Returns how many bytes of file data fit into the small_data section of
+	an inode. This always leaves enough room for the longest possible name.
+*/
+uint32
+Volume::MaxInlineDataSize() const
+{
+	int32 size = InodeSize() - sizeof(bfs_inode)
+		- (sizeof(small_data) + FILE_NAME_NAME_LENGTH + 3 + B_FILE_NAME_LENGTH)
+		- (sizeof(small_data) + FILE_DATA_NAME_LENGTH + 3 + 1);
+
+	return size > 0 ? size : 0;
+}
+
+
+/*!	Counts the trigram indices of the volume, so that updating a string
+	index doesn't have to look for its trigram index if there are none.
+*/
+void
+Volume::_CountTrigramIndices()
+{
+	fTrigramIndexCount = 0;
+
+	BPlusTree* tree = fIndicesNode->Tree();
+	if (tree == NULL)
+		return;
+
+	TreeIterator iterator(tree);
+	char name[B_FILE_NAME_LENGTH];
+	char indexName[INODE_FILE_NAME_LENGTH];
+	uint16 length;
+	off_t id;
+	while (iterator.GetNextEntry(name, &length, sizeof(name), &id) == B_OK) {
+		if (Index::GetTrigramsIndexName(name, indexName, sizeof(indexName))
+				== B_OK)
+			fTrigramIndexCount++;
+	}
+}
+
+
 status_t
 Volume::CreateIndicesRoot(Transaction& transaction)
 {
@@ -398,8 +450,121 @@ status_t
 Volume::AllocateForInode(Transaction& transaction, const Inode* parent,
 	mode_t type, block_run& run)
 {
-	return fBlockAllocator.AllocateForInode(transaction, &parent->BlockRun(),
-		type, run);
+	return AllocateForInode(transaction, &parent->BlockRun(), type, run);
+}
+
+
+status_t
+Volume::AllocateForInode(Transaction& transaction, const block_run* parent,
+	mode_t type, block_run& run)
+{
+	// the blocks reserved for delayed allocations are off limits; the block
+	// is reserved while it is being allocated, so that no one else can
+	// reserve it in the mean time
+	status_t status = ReserveBlocks(1);
+	if (status != B_OK)
+		return status;
+
+	status = fBlockAllocator.AllocateForInode(transaction, parent, type, run);
+
+	UnreserveBlocks(1);
+	return status;
+}
+
+
+/*!	Allocates up to \a numBlocks blocks for \a inode. Blocks that have been
+	reserved for the delayed allocations of other inodes are never handed
+	out; those reserved for \a inode itself are used first, and are no longer
+	counted as reserved once they are allocated.
+	The inode must be write locked.
+*/
+status_t
+Volume::Allocate(Transaction& transaction, Inode* inode, off_t numBlocks,
+	block_run& run, uint16 minimum)
+{
+	MutexLocker locker(fLock);
+
+	off_t reserved = inode->ReservedBlocks();
+	off_t available = FreeBlocks() - fReservedBlocks + reserved;
+	if (available < max_c(minimum, 1))
+		return B_DEVICE_FULL;
+
+	if (numBlocks > available) {
+		numBlocks = available;
+		if (minimum > 1)
+			numBlocks -= numBlocks % minimum;
+	}
+
+	// The lock is not held while allocating; until then, the blocks beyond
+	// the inode's own reservation are reserved, so that they cannot be
+	// promised to anyone else.
+	off_t claimed = max_c(numBlocks - reserved, 0);
+	fReservedBlocks += claimed;
+	locker.Unlock();
+
+	status_t status = fBlockAllocator.Allocate(transaction, inode, numBlocks,
+		run, minimum);
+
+	locker.Lock();
+	fReservedBlocks -= claimed;
+	if (status != B_OK)
+		return status;
+
+	off_t used = min_c(run.Length(), reserved);
+	if (used > 0) {
+		fReservedBlocks -= used;
+		inode->UsedReservedBlocks(used);
+	}
+	return B_OK;
+}
+
+
+/*!	Returns the number of free blocks that have not been reserved for
+	delayed allocations yet.
+*/
+off_t
+Volume::AvailableBlocks()
+{
+	MutexLocker locker(fLock);
+	return FreeBlocks() - fReservedBlocks;
+}
+
+
+/*!	Reserves \a numBlocks free blocks for a delayed allocation, so that
+	the allocation cannot fail later on for lack of space.
+*/
+status_t
+Volume::ReserveBlocks(off_t numBlocks)
+{
+	MutexLocker locker(fLock);
+
+	if (numBlocks > FreeBlocks() - fReservedBlocks)
+		return B_DEVICE_FULL;
+
+	fReservedBlocks += numBlocks;
+	return B_OK;
+}
+
+
+void
+Volume::UnreserveBlocks(off_t numBlocks)
+{
+	MutexLocker locker(fLock);
+
+	ASSERT(numBlocks <= fReservedBlocks);
+	fReservedBlocks -= numBlocks;
+}
+
+
+/*!	Reserves blocks again that were given up by an allocation that did not
+	make it to disk after all. Since the blocks have just been freed again,
+	this doesn't check if there are enough free blocks.
+*/
+void
+Volume::RestoreReservedBlocks(off_t numBlocks)
+{
+	MutexLocker locker(fLock);
+	fReservedBlocks += numBlocks;
 }
 
 
@@ -548,7 +713,7 @@ Volume::Identify(int fd, disk_super_block* superBlock)
 
 status_t
 Volume::Initialize(int fd, const char* name, uint32 blockSize,
-	uint32 flags)
+	uint32 logSize, uint32 flags)
 {
 	// although there is no really good reason for it, we won't
 	// accept '/' in disk names (mkbfs does this, too - and since
@@ -580,22 +745,40 @@ Volume::Initialize(int fd, const char* name, uint32 blockSize,
 
 	fSuperBlock.Initialize(name, numBlocks, blockSize);
 
+	if ((flags & VOLUME_INLINE_DATA) != 0) {
+		fSuperBlock.features |= HOST_ENDIAN_TO_BFS_INT32(
+			SUPER_BLOCK_FEATURE_INLINE_DATA);
+	}
+
 	// initialize short hands to the superblock (to save byte swapping)
 	fBlockSize = fSuperBlock.BlockSize();
 	fBlockShift = fSuperBlock.BlockShift();
 	fAllocationGroupShift = fSuperBlock.AllocationGroupShift();
 
-	// determine log size depending on the size of the volume
-	off_t logSize = 2048;
-	if (numBlocks <= 20480)
-		logSize = 512;
-	if (deviceSize > 1LL * 1024 * 1024 * 1024)
-		logSize = 4096;
+	// determine log size depending on the size of the volume, unless it
+	// has been specified
+	bool defaultLogSize = logSize == 0;
+	if (defaultLogSize) {
+		logSize = 2048;
+		if (numBlocks <= 20480)
+			logSize = 512;
+		if (deviceSize > 1LL * 1024 * 1024 * 1024)
+			logSize = 4096;
+	}
 
 	// since the allocator has not been initialized yet, we
 	// cannot use BlockAllocator::BitmapSize() here
 	off_t bitmapBlocks = (numBlocks + blockSize * 8 - 1) / (blockSize * 8);
 
+	// the log must not cross the end of its allocation group
+	off_t groupBlocks = 1LL << fAllocationGroupShift;
+	off_t logOffset = (bitmapBlocks + 1) & (groupBlocks - 1);
+	if (!defaultLogSize && (logOffset + logSize > groupBlocks
+			|| logSize > numBlocks / 4))
+		return B_BAD_VALUE;
+	if (logOffset + logSize > groupBlocks)
+		logSize = groupBlocks - logOffset;
+
 	fSuperBlock.log_blocks = ToBlockRun(bitmapBlocks + 1);
 	fSuperBlock.log_blocks.length = HOST_ENDIAN_TO_BFS_INT16(logSize);
 	fSuperBlock.log_start = fSuperBlock.log_end = HOST_ENDIAN_TO_BFS_INT64(
@@ -16,6 +16,7 @@ class CheckVisitor;
 class Journal;
 class Inode;
 class Query;
+class TrigramFill;
 
 
 enum volume_flags {
@@ -24,6 +25,7 @@ enum volume_flags {
 
 enum volume_initialize_flags {
 	VOLUME_NO_INDICES	= 0x0001,
+	VOLUME_INLINE_DATA	= 0x0002,
 };
 
 typedef DoublyLinkedList<Inode> InodeList;
@@ -37,7 +39,8 @@ public:
 			status_t		Mount(const char* device, uint32 flags);
 			status_t		Unmount();
 			status_t		Initialize(int fd, const char* name,
-								uint32 blockSize, uint32 flags);
+								uint32 blockSize, uint32 logSize,
+								uint32 flags);
 
 			bool			IsInitializing() const { return fVolume == NULL; }
 
@@ -66,6 +69,7 @@ public:
 								{ return fSuperBlock.UsedBlocks(); }
 			off_t			FreeBlocks() const
 								{ return NumBlocks() - UsedBlocks(); }
+			off_t			AvailableBlocks();
 			off_t			NumBitmapBlocks() const
 								{ return (NumBlocks() + fBlockSize * 8 - 1)
 									/ (fBlockSize * 8); }
@@ -81,6 +85,11 @@ public:
 								{ return fAllocationGroupShift; }
 			disk_super_block& SuperBlock() { return fSuperBlock; }
 
+			bool			HasInlineData() const
+								{ return (fSuperBlock.Features()
+									& SUPER_BLOCK_FEATURE_INLINE_DATA) != 0; }
+			uint32			MaxInlineDataSize() const;
+
 			off_t			ToOffset(block_run run) const
 								{ return ToBlock(run) << BlockShift(); }
 			off_t			ToBlock(block_run run) const
@@ -114,6 +123,9 @@ public:
 								off_t numBlocks, block_run& run,
 								uint16 minimum = 1);
 			status_t		Free(Transaction& transaction, block_run run);
+			status_t		ReserveBlocks(off_t numBlocks);
+			void			UnreserveBlocks(off_t numBlocks);
+			void			RestoreReservedBlocks(off_t numBlocks);
 			void			SetCheckingThread(thread_id thread)
 								{ fCheckingThread = thread; }
 			bool			IsCheckingThread() const
@@ -139,6 +151,16 @@ public:
 			void			AddQuery(Query* query);
 			void			RemoveQuery(Query* query);
 
+			// only to be accessed in a transaction; changes to the trigram
+			// index count have to be undone if it fails
+			::TrigramFill*	TrigramFill() const { return fTrigramFill; }
+			void			SetTrigramFill(::TrigramFill* fill)
+								{ fTrigramFill = fill; }
+			bool			HasTrigramIndices() const
+								{ return fTrigramIndexCount > 0; }
+			void			TrigramIndexAdded() { fTrigramIndexCount++; }
+			void			TrigramIndexRemoved() { fTrigramIndexCount--; }
+
 			status_t		Sync();
 			Journal*		GetJournal(off_t refBlock) const;
 
@@ -150,6 +172,7 @@ public:
 
 private:
 			status_t		_EraseUnusedBootBlock();
+			void			_CountTrigramIndices();
 
 protected:
 			fs_volume*		fVolume;
@@ -163,6 +186,8 @@ protected:
 
 			BlockAllocator	fBlockAllocator;
 			mutex			fLock;
+			off_t			fReservedBlocks;
+				// blocks promised to delayed allocations, guarded by fLock
 			Journal*		fJournal;
 			vint32			fLogStart;
 			vint32			fLogEnd;
@@ -174,6 +199,8 @@ protected:
 
 			mutex			fQueryLock;
 			DoublyLinkedList<Query> fQueries;
+			::TrigramFill*	fTrigramFill;
+			int32			fTrigramIndexCount;
 
 			uint32			fFlags;
 
@@ -208,23 +235,6 @@ Volume::Allocator()
 }
 
 
-inline status_t
-Volume::AllocateForInode(Transaction& transaction, const block_run* parent,
-	mode_t type, block_run& run)
-{
-	return fBlockAllocator.AllocateForInode(transaction, parent, type, run);
-}
-
-
-inline status_t
-Volume::Allocate(Transaction& transaction, Inode* inode, off_t numBlocks,
-	block_run& run, uint16 minimum)
-{
-	return fBlockAllocator.Allocate(transaction, inode, numBlocks, run,
-		minimum);
-}
-
-
 inline status_t
 Volume::Free(Transaction& transaction, block_run run)
 {
@@ -76,7 +76,8 @@ struct disk_super_block {
 	int32		magic3;
 	inode_addr	root_dir;
 	inode_addr	indices;
-	int32		_reserved[8];
+	uint32		features;
+	int32		_reserved[7];
 	int32		pad_to_block[87];
 		// this also contains parts of the boot block
 
@@ -95,6 +96,7 @@ struct disk_super_block {
 	int32 AllocationGroupShift() const
 		{ return BFS_ENDIAN_TO_HOST_INT32(ag_shift); }
 	int32 Flags() const { return BFS_ENDIAN_TO_HOST_INT32(flags); }
+	uint32 Features() const { return BFS_ENDIAN_TO_HOST_INT32(features); }
 	off_t LogStart() const { return BFS_ENDIAN_TO_HOST_INT64(log_start); }
 	off_t LogEnd() const { return BFS_ENDIAN_TO_HOST_INT64(log_end); }
 
@@ -113,6 +115,15 @@ struct disk_super_block {
 #define SUPER_BLOCK_DISK_CLEAN		'CLEN'		/* CLEN */
 #define SUPER_BLOCK_DISK_DIRTY		'DIRT'		/* DIRT */
 
+// on-disk features that not every BFS implementation understands
+#define SUPER_BLOCK_FEATURE_INLINE_DATA	0x00000001
+	// small files store their data in the small_data section of their inode
+#define SUPER_BLOCK_KNOWN_FEATURES		SUPER_BLOCK_FEATURE_INLINE_DATA
+
+// the log must fit into a single block_run
+#define MIN_LOG_SIZE				512
+#define MAX_LOG_SIZE				MAX_BLOCK_RUN_LENGTH
+
 //**************************************
 
 #define NUM_DIRECT_BLOCKS			12
@@ -172,6 +183,11 @@ struct small_data {
 #define FILE_NAME_NAME			0x13
 #define FILE_NAME_NAME_LENGTH	1
 
+// The data of files with the INODE_INLINE_DATA flag is part of it, too
+#define FILE_DATA_TYPE			'RAWT'
+#define FILE_DATA_NAME			0x14
+#define FILE_DATA_NAME_LENGTH	1
+
 // The maximum key length of attribute data that is put  in the index.
 // This excludes a terminating null byte.
 // This must be smaller than or equal as BPLUSTREE_MAX_KEY_LENGTH.
@@ -259,6 +275,7 @@ enum inode_flags {
 	INODE_DELETED			= 0x00000010,
 	INODE_NOT_READY			= 0x00000020,	// used during Inode construction
 	INODE_LONG_SYMLINK		= 0x00000040,	// symlink in data stream
+	INODE_INLINE_DATA		= 0x00000080,	// file data in small_data section
 
 	INODE_PERMANENT_FLAGS	= 0x0000ffff,
 
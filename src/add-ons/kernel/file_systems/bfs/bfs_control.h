@@ -66,6 +66,8 @@ struct check_control {
 		uint64	blocks_in_double_indirect;
 		uint64	partial_block_runs;
 		uint32	block_size;
+		uint64	inline_files;
+		uint64	bytes_in_inline;
 	} stats;
 	status_t	status;
 };
@@ -104,4 +106,18 @@ struct check_control {
 #define BFS_IOCTL_RESIZE		14205
 
 
+/* For debugging queries: describes which indices BFS would walk for the
+ * query, and how it narrows down the nodes it has to look at, without
+ * returning any entries. The parameter is a struct query_plan_control.
+ */
+#define BFS_IOCTL_EXPLAIN_QUERY	14206
+
+struct query_plan_control {
+	uint32	flags;
+		/* query flags, ie. B_QUERY_NON_INDEXED */
+	char	query[1024];
+	char	plan[4096];
+};
+
+
 #endif	/* BFS_CONTROL_H */
@@ -22,6 +22,8 @@ parse_initialize_parameters(const char* parameterString,
 
 	if (get_driver_boolean_parameter(handle, "noindex", false, true))
 		parameters.flags |= VOLUME_NO_INDICES;
+	if (get_driver_boolean_parameter(handle, "inline_data", false, true))
+		parameters.flags |= VOLUME_INLINE_DATA;
 	if (get_driver_boolean_parameter(handle, "verbose", false, true))
 		parameters.verbose = true;
 
@@ -31,6 +33,12 @@ parse_initialize_parameters(const char* parameterString,
 	if (string != NULL)
 		blockSize = strtoul(string, NULL, 0);
 
+	// the log size is given in blocks, 0 lets the size of the volume decide
+	string = get_driver_parameter(handle, "log_size", NULL, NULL);
+	uint32 logSize = 0;
+	if (string != NULL)
+		logSize = strtoul(string, NULL, 0);
+
 	unload_driver_settings(handle);
 
 	if (blockSize != 1024 && blockSize != 2048 && blockSize != 4096
@@ -38,7 +46,11 @@ parse_initialize_parameters(const char* parameterString,
 		return B_BAD_VALUE;
 	}
 
+	if (logSize != 0 && (logSize < MIN_LOG_SIZE || logSize > MAX_LOG_SIZE))
+		return B_BAD_VALUE;
+
 	parameters.blockSize = blockSize;
+	parameters.logSize = logSize;
 
 	return B_OK;
 }
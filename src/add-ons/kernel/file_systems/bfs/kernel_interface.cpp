@@ -214,6 +214,10 @@ bfs_read_fs_stat(fs_volume* _volume, struct fs_info* info)
 	FUNCTION();
 
 	Volume* volume = (Volume*)_volume->private_volume;
+
+	// this takes the volume lock itself
+	info->free_blocks = volume->AvailableBlocks();
+
 	MutexLocker locker(volume->Lock());
 
 	// File system flags.
@@ -227,7 +231,6 @@ bfs_read_fs_stat(fs_volume* _volume, struct fs_info* info)
 
 	info->block_size = volume->BlockSize();
 	info->total_blocks = volume->NumBlocks();
-	info->free_blocks = volume->FreeBlocks();
 
 	// Volume name
 	strlcpy(info->volume_name, volume->Name(), sizeof(info->volume_name));
@@ -341,12 +344,17 @@ bfs_put_vnode(fs_volume* _volume, fs_vnode* _node, bool reenter)
 	Inode* inode = (Inode*)_node->private_node;
 
 	// since a directory's size can be changed without having it opened,
-	// we need to take care about their preallocated blocks here
+	// we need to take care about their preallocated blocks here (and files
+	// might not have all of their blocks allocated yet)
 	if (!volume->IsReadOnly() && !volume->IsCheckingThread()
-		&& inode->NeedsTrimming()) {
+		&& (inode->NeedsTrimming() || inode->HasDelayedAllocation())) {
 		Transaction transaction(volume, inode->BlockNumber());
 
-		if (inode->TrimPreallocation(transaction) == B_OK)
+		status_t status = inode->AllocateDelayed(transaction);
+		if (status == B_OK && inode->NeedsTrimming())
+			status = inode->TrimPreallocation(transaction);
+
+		if (status == B_OK)
 			transaction.Done();
 		else if (transaction.HasParent()) {
 			// TODO: for now, we don't let sub-transactions fail
@@ -400,6 +408,73 @@ bfs_remove_vnode(fs_volume* _volume, fs_vnode* _node, bool reenter)
 }
 
 
+/*!	Copies the data of a file that is stored in its inode into \a vecs, and
+	clears the rest of them. The inode must be read locked.
+*/
+static status_t
+read_inline_data(Inode* inode, off_t pos, const iovec* vecs, size_t count,
+	size_t numBytes)
+{
+	for (size_t i = 0; i < count && numBytes > 0; i++) {
+		size_t length = min_c(vecs[i].iov_len, numBytes);
+		size_t bytesRead = length;
+		status_t status = inode->ReadInlineData(pos,
+			(uint8*)vecs[i].iov_base, &bytesRead);
+		if (status != B_OK)
+			return status;
+
+		memset((uint8*)vecs[i].iov_base + bytesRead, 0, length - bytesRead);
+		pos += length;
+		numBytes -= length;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Writes \a vecs to the data of a file that is stored in its inode.
+	Returns B_ENTRY_NOT_FOUND if the file does not store its data there (any
+	longer), in which case nothing has been written.
+*/
+static status_t
+write_inline_data(Volume* volume, Inode* inode, off_t pos, const iovec* vecs,
+	size_t count, size_t numBytes)
+{
+	// anything beyond the inode size is beyond the end of the file, too
+	size_t length = min_c(numBytes, volume->InodeSize());
+	uint8* buffer = (uint8*)malloc(length);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter bufferDeleter(buffer);
+
+	size_t offset = 0;
+	for (size_t i = 0; i < count && offset < length; i++) {
+		size_t bytes = min_c(vecs[i].iov_len, length - offset);
+		memcpy(buffer + offset, vecs[i].iov_base, bytes);
+		offset += bytes;
+	}
+
+	Transaction transaction(volume, inode->BlockNumber());
+	inode->WriteLockInTransaction(transaction);
+
+	status_t status = B_ENTRY_NOT_FOUND;
+	if (inode->HasInlineData() && inode->HasDelayedAllocation()) {
+		// The file has outgrown its inode; its data is moved out now, and
+		// the caller writes to its new blocks instead
+		status = inode->AllocateDelayed(transaction);
+		if (status == B_OK)
+			status = B_ENTRY_NOT_FOUND;
+	} else if (inode->HasInlineData())
+		status = inode->WriteInlineData(transaction, pos, buffer, length);
+
+	// the transaction is not aborted, as that would revert the inode
+	if (transaction.Done() != B_OK && status == B_OK)
+		status = B_ERROR;
+
+	return status;
+}
+
+
 static bool
 bfs_can_page(fs_volume* _volume, fs_vnode* _v, void* _cookie)
 {
@@ -420,6 +495,9 @@ bfs_read_pages(fs_volume* _volume, fs_vnode* _node, void* _cookie,
 
 	InodeReadLocker _(inode);
 
+	if (inode->HasInlineData())
+		return read_inline_data(inode, pos, vecs, count, *_numBytes);
+
 	uint32 vecIndex = 0;
 	size_t vecOffset = 0;
 	size_t bytesLeft = *_numBytes;
@@ -451,24 +529,19 @@ bfs_read_pages(fs_volume* _volume, fs_vnode* _node, void* _cookie,
 
 
 static status_t
-bfs_write_pages(fs_volume* _volume, fs_vnode* _node, void* _cookie,
-	off_t pos, const iovec* vecs, size_t count, size_t* _numBytes)
+write_file_pages(Volume* volume, Inode* inode, off_t pos, const iovec* vecs,
+	size_t count, size_t* _numBytes)
 {
-	Volume* volume = (Volume*)_volume->private_volume;
-	Inode* inode = (Inode*)_node->private_node;
-
-	if (volume->IsReadOnly())
-		return B_READ_ONLY_DEVICE;
-
-	if (inode->FileCache() == NULL)
-		RETURN_ERROR(B_BAD_VALUE);
+	// the blocks have to exist before we can write to them
+	status_t status = inode->AllocateDelayed();
+	if (status != B_OK)
+		RETURN_ERROR(status);
 
 	InodeReadLocker _(inode);
 
 	uint32 vecIndex = 0;
 	size_t vecOffset = 0;
 	size_t bytesLeft = *_numBytes;
-	status_t status;
 
 	while (true) {
 		file_io_vec fileVecs[8];
@@ -495,6 +568,76 @@ bfs_write_pages(fs_volume* _volume, fs_vnode* _node, void* _cookie,
 }
 
 
+#ifndef FS_SHELL
+/*!	Serves an I/O request for a file that stores its data in its inode.
+	Returns B_ENTRY_NOT_FOUND if the file does not do that (any longer), in
+	which case the request has not been touched.
+*/
+static status_t
+inline_data_io(Volume* volume, Inode* inode, io_request* request)
+{
+	off_t pos = io_request_offset(request);
+	size_t length = io_request_length(request);
+
+	uint8* buffer = (uint8*)malloc(length);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter bufferDeleter(buffer);
+
+	iovec vec = { buffer, length };
+
+	if (io_request_is_write(request)) {
+		status_t status = read_from_io_request(request, buffer, length);
+		if (status != B_OK)
+			return status;
+
+		status = write_inline_data(volume, inode, pos, &vec, 1, length);
+		if (status == B_ENTRY_NOT_FOUND) {
+			// The data has been moved out of the inode in the mean time, and
+			// we cannot give the data back to the request anymore
+			status = write_file_pages(volume, inode, pos, &vec, 1, &length);
+		}
+		return status;
+	}
+
+	InodeReadLocker locker(inode);
+	if (!inode->HasInlineData())
+		return B_ENTRY_NOT_FOUND;
+
+	status_t status = read_inline_data(inode, pos, &vec, 1, length);
+	locker.Unlock();
+
+	if (status == B_OK)
+		status = write_to_io_request(request, buffer, length);
+	return status;
+}
+#endif
+
+
+static status_t
+bfs_write_pages(fs_volume* _volume, fs_vnode* _node, void* _cookie,
+	off_t pos, const iovec* vecs, size_t count, size_t* _numBytes)
+{
+	Volume* volume = (Volume*)_volume->private_volume;
+	Inode* inode = (Inode*)_node->private_node;
+
+	if (volume->IsReadOnly())
+		return B_READ_ONLY_DEVICE;
+
+	if (inode->FileCache() == NULL)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	if (inode->HasInlineData()) {
+		status_t status = write_inline_data(volume, inode, pos, vecs, count,
+			*_numBytes);
+		if (status != B_ENTRY_NOT_FOUND)
+			return status;
+	}
+
+	return write_file_pages(volume, inode, pos, vecs, count, _numBytes);
+}
+
+
 static status_t
 bfs_io(fs_volume* _volume, fs_vnode* _node, void* _cookie, io_request* request)
 {
@@ -520,6 +663,25 @@ bfs_io(fs_volume* _volume, fs_vnode* _node, void* _cookie, io_request* request)
 		RETURN_ERROR(B_BAD_VALUE);
 	}
 
+#ifndef FS_SHELL
+	if (inode->HasInlineData()) {
+		status_t status = inline_data_io(volume, inode, request);
+		if (status != B_ENTRY_NOT_FOUND) {
+			notify_io_request(request, status);
+			return status;
+		}
+	}
+
+	if (io_request_is_write(request)) {
+		// the blocks have to exist before we can write to them
+		status_t status = inode->AllocateDelayed();
+		if (status != B_OK) {
+			notify_io_request(request, status);
+			RETURN_ERROR(status);
+		}
+	}
+#endif
+
 	// We lock the node here and will unlock it in the "finished" hook.
 	rw_lock_read_lock(&inode->Lock());
 
@@ -548,7 +710,21 @@ bfs_get_file_map(fs_volume* _volume, fs_vnode* _node, off_t offset, size_t size,
 
 	//FUNCTION_START(("offset = %lld, size = %lu\n", offset, size));
 
+	// the data of this file has no blocks of its own
+	if (inode->HasInlineData())
+		return B_UNSUPPORTED;
+
 	while (true) {
+		if (inode->HasDelayedAllocation() && offset >= inode->StreamEnd()) {
+			// there are no blocks for the rest of the file yet, it only
+			// exists in the file cache
+			vecs[index].offset = -1;
+			vecs[index].length = round_up(inode->Size(), volume->BlockSize())
+				- offset;
+			*_count = index + 1;
+			return B_OK;
+		}
+
 		status_t status = inode->FindBlockRun(offset, run, fileOffset);
 		if (status != B_OK)
 			return status;
@@ -793,6 +969,36 @@ bfs_ioctl(fs_volume* _volume, fs_vnode* _node, void* _cookie, uint32 cmd,
 			ResizeVisitor resizer(volume);
 			return resizer.Resize(size, -1);
 		}
+		case BFS_IOCTL_EXPLAIN_QUERY:
+		{
+			if (bufferLength != sizeof(query_plan_control))
+				return B_BAD_VALUE;
+
+			query_plan_control* control
+				= (query_plan_control*)malloc(sizeof(query_plan_control));
+			if (control == NULL)
+				return B_NO_MEMORY;
+			MemoryDeleter controlDeleter(control);
+
+			if (user_memcpy(control, buffer, sizeof(query_plan_control))
+					!= B_OK) {
+				return B_BAD_ADDRESS;
+			}
+			control->query[sizeof(control->query) - 1] = '\0';
+
+			Query* query;
+			status_t status = Query::Create(volume, control->query,
+				control->flags & ~B_LIVE_QUERY, -1, 0, query);
+			if (status != B_OK)
+				return status;
+
+			status = query->DescribePlan(control->plan, sizeof(control->plan));
+			delete query;
+			if (status != B_OK)
+				return status;
+
+			return user_memcpy(buffer, control, sizeof(query_plan_control));
+		}
 
 #ifdef DEBUG_FRAGMENTER
 		case 56741:
@@ -1506,7 +1712,7 @@ bfs_free_cookie(fs_volume* _volume, fs_vnode* _node, void* _cookie)
 
 		if ((cookie->open_mode & O_RWMASK) != 0
 			&& !inode->IsDeleted()
-			&& (needsTrimming
+			&& (needsTrimming || inode->HasDelayedAllocation()
 				|| inode->OldLastModified() != inode->LastModified()
 				|| (inode->InSizeIndex()
 					// TODO: this can prevent the size update notification
@@ -1527,6 +1733,18 @@ bfs_free_cookie(fs_volume* _volume, fs_vnode* _node, void* _cookie)
 		bool changedSize = false, changedTime = false;
 		Index index(volume);
 
+		if (inode->HasDelayedAllocation()) {
+			// We know the file size now, so we don't need to preallocate
+			// anything. If this fails, writing back the file will try again.
+			status = inode->AllocateDelayed(transaction);
+			if (status != B_OK) {
+				FATAL(("Could not allocate delayed blocks: inode %" B_PRIdINO
+					", transaction %d: %s!\n", inode->ID(),
+					(int)transaction.ID(), strerror(status)));
+				status = B_OK;
+			}
+			needsTrimming = inode->NeedsTrimming();
+		}
 		if (needsTrimming) {
 			status = inode->TrimPreallocation(transaction);
 			if (status < B_OK) {
@@ -2018,6 +2236,10 @@ bfs_remove_attr(fs_volume* _volume, fs_vnode* _node, const char* name)
 	Volume* volume = (Volume*)_volume->private_volume;
 	Inode* inode = (Inode*)_node->private_node;
 
+	// the file's data might be stored as an attribute
+	if (name[0] == FILE_DATA_NAME && name[1] == '\0')
+		return B_NOT_ALLOWED;
+
 	status_t status = inode->CheckPermissions(W_OK);
 	if (status != B_OK)
 		return status;
@@ -2189,6 +2411,14 @@ bfs_create_index(fs_volume* _volume, const char* name, uint32 type,
 	if (geteuid() != 0)
 		return B_NOT_ALLOWED;
 
+	// "<index>@trigrams" requests the trigram index of an existing index
+	char indexName[INODE_FILE_NAME_LENGTH];
+	if (Index::GetTrigramsIndexName(name, indexName, sizeof(indexName))
+			== B_OK) {
+		Index trigrams(volume);
+		RETURN_ERROR(trigrams.CreateTrigrams(indexName));
+	}
+
 	Transaction transaction(volume, volume->Indices());
 
 	Index index(volume);
@@ -2221,9 +2451,36 @@ bfs_remove_index(fs_volume* _volume, const char* name)
 
 	Transaction transaction(volume, volume->Indices());
 
+	int32 removedTrigrams = 0;
+	char indexName[INODE_FILE_NAME_LENGTH];
+	if (Index::GetTrigramsIndexName(name, indexName, sizeof(indexName))
+			== B_OK)
+		removedTrigrams++;
+
 	status_t status = indices->Remove(transaction, name);
-	if (status == B_OK)
+	if (status == B_OK) {
+		// the trigram index is of no use without its index
+		char trigramsName[INODE_FILE_NAME_LENGTH];
+		if (Index::GetTrigramsName(name, trigramsName, sizeof(trigramsName))
+				== B_OK) {
+			status_t trigramsStatus = indices->Remove(transaction,
+				trigramsName);
+			if (trigramsStatus == B_OK)
+				removedTrigrams++;
+			else if (trigramsStatus != B_ENTRY_NOT_FOUND)
+				status = trigramsStatus;
+		}
+	}
+	if (status == B_OK) {
+		for (int32 i = 0; i < removedTrigrams; i++)
+			volume->TrigramIndexRemoved();
+
 		status = transaction.Done();
+		if (status != B_OK) {
+			for (int32 i = 0; i < removedTrigrams; i++)
+				volume->TrigramIndexAdded();
+		}
+	}
 
 	RETURN_ERROR(status);
 }
@@ -2366,7 +2623,7 @@ bfs_initialize(int fd, partition_id partitionID, const char* name,
 	// initialize the volume
 	Volume volume(NULL);
 	status = volume.Initialize(fd, name, parameters.blockSize,
-		parameters.flags);
+		parameters.logSize, parameters.flags);
 	if (status < B_OK) {
 		INFORM(("Initializing volume failed: %s\n", strerror(status)));
 		return status;
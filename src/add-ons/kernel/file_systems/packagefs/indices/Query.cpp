@@ -89,6 +89,12 @@ struct Query::QueryPolicy {
 		return index.index != NULL ? B_OK : B_ENTRY_NOT_FOUND;
 	}
 
+	static status_t IndexSetToTrigrams(Index& index, const char* attribute)
+	{
+		// there are no trigram indices
+		return B_ENTRY_NOT_FOUND;
+	}
+
 	static void IndexUnset(Index& index)
 	{
 		index.index = NULL;
@@ -157,6 +163,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* indexIterator)
+	{
+		return indexIterator->entry->ID();
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* indexIterator)
 	{
 		// Nothing to do.
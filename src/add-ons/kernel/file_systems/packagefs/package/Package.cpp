@@ -27,6 +27,7 @@
 #include "DebugSupport.h"
 #include "PackageDirectory.h"
 #include "PackageFile.h"
+#include "PackagesCache.h"
 #include "PackagesDirectory.h"
 #include "PackageSettings.h"
 #include "PackageSymlink.h"
@@ -567,9 +568,10 @@ Package::Init(const char* fileName)
 
 
 status_t
-Package::Load(const PackageSettings& settings)
+Package::Load(const PackageSettings& settings, const struct stat& st,
+	PackagesCache* cache)
 {
-	status_t error = _Load(settings);
+	status_t error = _Load(settings, st, cache);
 	if (error != B_OK)
 		return error;
 
@@ -704,16 +706,36 @@ status_t
 Package::CreateDataReader(const PackageData& data,
 	BAbstractBufferedDataReader*& _reader)
 {
-	if (fHeapReader == NULL)
-		return B_BAD_VALUE;
+	if (fHeapReader == NULL) {
+		status_t error = _InitHeapReader();
+		if (error != B_OK)
+			return error;
+	}
 
 	return fHeapReader->CreateDataReader(data, _reader);
 }
 
 
 status_t
-Package::_Load(const PackageSettings& settings)
+Package::_Load(const PackageSettings& settings, const struct stat& st,
+	PackagesCache* cache)
 {
+	if (cache != NULL) {
+		// Try to replay the contents from the cache. The heap reader is only
+		// created when the data are actually needed.
+		LoaderContentHandler handler(this, settings);
+		status_t error = handler.Init();
+		if (error != B_OK)
+			RETURN_ERROR(error);
+
+		error = cache->Replay(fFileName, st, &handler);
+		if (error == B_OK)
+			return B_OK;
+
+		// start over with the package file
+		_UnloadContents();
+	}
+
 	// open package file
 	int fd = Open();
 	if (fd < 0)
@@ -735,7 +757,14 @@ Package::_Load(const PackageSettings& settings)
 			if (error != B_OK)
 				RETURN_ERROR(error);
 
-			error = packageReader.ParseContent(&handler);
+			if (cache != NULL) {
+				// record the content for the next mount
+				PackagesCache::Recorder recorder(fFileName, st, &handler);
+				error = packageReader.ParseContent(&recorder);
+				if (error == B_OK)
+					cache->Add(recorder);
+			} else
+				error = packageReader.ParseContent(&handler);
 			if (error != B_OK)
 				RETURN_ERROR(error);
 
@@ -753,6 +782,50 @@ Package::_Load(const PackageSettings& settings)
 }
 
 
+status_t
+Package::_InitHeapReader()
+{
+	// The contents were loaded from the packages cache, so we have not
+	// looked at the package file yet. The caller has it open.
+	MutexLocker locker(fLock);
+	if (fHeapReader != NULL)
+		return B_OK;
+
+	if (fFD < 0)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	LoaderErrorOutput errorOutput(this);
+	CachingPackageReader packageReader(&errorOutput);
+	status_t error = packageReader.Init(fFD, false,
+		BHPKG::B_HPKG_READER_DONT_PRINT_VERSION_MISMATCH_MESSAGE);
+	if (error != B_OK)
+		RETURN_ERROR(error == B_MISMATCHED_VALUES ? B_BAD_DATA : error);
+
+	fHeapReader = packageReader.DetachCachedHeapReader();
+	return B_OK;
+}
+
+
+void
+Package::_UnloadContents()
+{
+	while (PackageNode* node = fNodes.RemoveHead())
+		node->ReleaseReference();
+
+	while (Resolvable* resolvable = fResolvables.RemoveHead())
+		delete resolvable;
+
+	while (Dependency* dependency = fDependencies.RemoveHead())
+		delete dependency;
+
+	SetVersion(NULL);
+	fName = String();
+	fInstallPath = String();
+	fFlags = 0;
+	fArchitecture = B_PACKAGE_ARCHITECTURE_ENUM_COUNT;
+}
+
+
 bool
 Package::_InitVersionedName()
 {
@@ -29,6 +29,7 @@ using BPackageKit::BHPKG::BAbstractBufferedDataReader;
 
 
 class PackageLinkDirectory;
+class PackagesCache;
 class PackagesDirectory;
 class PackageSettings;
 class Volume;
@@ -44,7 +45,9 @@ public:
 								~Package();
 
 			status_t			Init(const char* fileName);
-			status_t			Load(const PackageSettings& settings);
+			status_t			Load(const PackageSettings& settings,
+									const struct stat& st,
+									PackagesCache* cache = NULL);
 
 			::Volume*			Volume() const		{ return fVolume; }
 			const String&		FileName() const	{ return fFileName; }
@@ -117,7 +120,11 @@ private:
 			struct CachingPackageReader;
 
 private:
-			status_t			_Load(const PackageSettings& settings);
+			status_t			_Load(const PackageSettings& settings,
+									const struct stat& st,
+									PackagesCache* cache);
+			status_t			_InitHeapReader();
+			void				_UnloadContents();
 			bool				_InitVersionedName();
 
 private:
@@ -0,0 +1,1037 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "PackagesCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <new>
+
+#include <package/hpkg/PackageData.h>
+#include <package/hpkg/PackageEntry.h>
+#include <package/hpkg/PackageEntryAttribute.h>
+#include <package/hpkg/PackageInfoAttributeValue.h>
+
+#include <AutoDeleter.h>
+#include <PackagesDirectoryDefs.h>
+#include <syscalls.h>
+#include <util/AutoLock.h>
+
+#include "DebugSupport.h"
+
+
+using namespace BPackageKit;
+
+using BPackageKit::BHPKG::BPackageData;
+using BPackageKit::BHPKG::BPackageResolvableData;
+using BPackageKit::BHPKG::BPackageResolvableExpressionData;
+using BPackageKit::BHPKG::BPackageVersionData;
+
+
+static const char* const kCacheFilePath
+	= PACKAGES_DIRECTORY_ADMIN_DIRECTORY "/"
+		PACKAGES_DIRECTORY_MOUNT_CACHE_FILE;
+static const char* const kTemporaryCacheFilePath
+	= PACKAGES_DIRECTORY_ADMIN_DIRECTORY "/"
+		PACKAGES_DIRECTORY_MOUNT_CACHE_FILE ".new";
+
+static const uint32 kCacheFileMagic = 'pfsC';
+static const uint32 kCacheFileVersion = 1;
+
+// sanity limit for the cache file size
+static const size_t kMaxCacheFileSize = 64 * 1024 * 1024;
+
+static const uint32 kNullStringLength = 0xffffffff;
+
+enum {
+	EVENT_END					= 0,
+	EVENT_PACKAGE_ATTRIBUTE,
+	EVENT_ENTRY,
+	EVENT_ENTRY_ATTRIBUTE,
+	EVENT_ENTRY_DONE
+};
+
+
+struct cache_file_header {
+	uint32	magic;
+	uint32	version;
+	uint32	entry_count;
+	uint32	checksum;
+	uint64	size;
+		// of the whole file
+};
+
+
+static uint32
+compute_checksum(const void* _data, size_t size, uint32 checksum = 2166136261U)
+{
+	// FNV-1a
+	const uint8* data = (const uint8*)_data;
+	for (size_t i = 0; i < size; i++) {
+		checksum ^= data[i];
+		checksum *= 16777619;
+	}
+
+	return checksum;
+}
+
+
+// #pragma mark - Entry
+
+
+struct PackagesCache::Entry {
+	Entry*			hashNext;
+	const char*		fileName;
+	ino_t			nodeID;
+	off_t			fileSize;
+	timespec		modifiedTime;
+	const uint8*	record;
+	size_t			recordSize;
+	const uint8*	events;
+	size_t			eventsSize;
+	uint8*			ownedData;
+	bool			used;
+
+	Entry()
+		:
+		ownedData(NULL),
+		used(false)
+	{
+	}
+
+	~Entry()
+	{
+		free(ownedData);
+	}
+
+	bool Matches(const struct stat& st) const
+	{
+		return nodeID == st.st_ino && fileSize == st.st_size
+			&& modifiedTime.tv_sec == st.st_mtim.tv_sec
+			&& modifiedTime.tv_nsec == st.st_mtim.tv_nsec;
+	}
+};
+
+
+struct PackagesCache::EntryHashDefinition {
+	typedef const char*		KeyType;
+	typedef	Entry			ValueType;
+
+	size_t HashKey(const char* key) const
+	{
+		return hash_hash_string(key);
+	}
+
+	size_t Hash(const Entry* value) const
+	{
+		return HashKey(value->fileName);
+	}
+
+	bool Compare(const char* key, const Entry* value) const
+	{
+		return strcmp(value->fileName, key) == 0;
+	}
+
+	Entry*& GetLink(Entry* value) const
+	{
+		return value->hashNext;
+	}
+};
+
+
+// #pragma mark - Reader
+
+
+class PackagesCache::Reader {
+public:
+	Reader(const uint8* data, size_t size)
+		:
+		fData(data),
+		fEnd(data + size)
+	{
+	}
+
+	const uint8* Position() const
+	{
+		return fData;
+	}
+
+	size_t BytesRemaining() const
+	{
+		return fEnd - fData;
+	}
+
+	void Skip(size_t size)
+	{
+		fData += size;
+	}
+
+	bool Read(void* buffer, size_t size)
+	{
+		if (size > BytesRemaining())
+			return false;
+
+		memcpy(buffer, fData, size);
+		fData += size;
+		return true;
+	}
+
+	template<typename Type>
+	bool Read(Type& value)
+	{
+		return Read(&value, sizeof(value));
+	}
+
+	bool ReadString(const char*& _string)
+	{
+		uint32 length;
+		if (!Read(length))
+			return false;
+
+		if (length == kNullStringLength) {
+			_string = NULL;
+			return true;
+		}
+
+		// the string is stored null-terminated, so we can use it in place
+		if (length >= BytesRemaining() || fData[length] != '\0')
+			return false;
+
+		_string = (const char*)fData;
+		fData += length + 1;
+		return true;
+	}
+
+	bool ReadData(BPackageData& data)
+	{
+		uint64 size;
+		uint8 encodedInline;
+		if (!Read(size) || !Read(encodedInline))
+			return false;
+
+		if (encodedInline != 0) {
+			uint8 inlineData[BHPKG::B_HPKG_MAX_INLINE_DATA_SIZE];
+			if (size > sizeof(inlineData) || !Read(inlineData, size))
+				return false;
+			data.SetData((uint8)size, inlineData);
+			return true;
+		}
+
+		uint64 offset;
+		if (!Read(offset))
+			return false;
+		data.SetData(size, offset);
+		return true;
+	}
+
+	bool ReadVersion(BPackageVersionData& version)
+	{
+		return ReadString(version.major) && ReadString(version.minor)
+			&& ReadString(version.micro) && ReadString(version.preRelease)
+			&& Read(version.revision);
+	}
+
+private:
+	const uint8*	fData;
+	const uint8*	fEnd;
+};
+
+
+// #pragma mark - Writer
+
+
+class PackagesCache::Writer {
+public:
+	Writer()
+		:
+		fData(NULL),
+		fSize(0),
+		fCapacity(0),
+		fError(B_OK)
+	{
+	}
+
+	~Writer()
+	{
+		free(fData);
+	}
+
+	status_t Status() const
+	{
+		return fError;
+	}
+
+	size_t Size() const
+	{
+		return fSize;
+	}
+
+	uint8* DetachData()
+	{
+		uint8* data = fData;
+		fData = NULL;
+		fSize = fCapacity = 0;
+		return data;
+	}
+
+	void Write(const void* buffer, size_t size)
+	{
+		if (fError != B_OK)
+			return;
+
+		if (fSize + size > fCapacity) {
+			size_t capacity = fCapacity == 0 ? 4096 : fCapacity * 2;
+			while (capacity < fSize + size)
+				capacity *= 2;
+
+			if (capacity > kMaxCacheFileSize) {
+				fError = B_BUFFER_OVERFLOW;
+				return;
+			}
+
+			uint8* data = (uint8*)realloc(fData, capacity);
+			if (data == NULL) {
+				fError = B_NO_MEMORY;
+				return;
+			}
+
+			fData = data;
+			fCapacity = capacity;
+		}
+
+		memcpy(fData + fSize, buffer, size);
+		fSize += size;
+	}
+
+	template<typename Type>
+	void Write(Type value)
+	{
+		Write(&value, sizeof(value));
+	}
+
+	void WriteAt(size_t offset, const void* buffer, size_t size)
+	{
+		if (fError == B_OK)
+			memcpy(fData + offset, buffer, size);
+	}
+
+	void WriteString(const char* string)
+	{
+		if (string == NULL) {
+			Write(kNullStringLength);
+			return;
+		}
+
+		uint32 length = strlen(string);
+		Write(length);
+		Write(string, length + 1);
+	}
+
+	void WriteData(const BPackageData& data)
+	{
+		Write((uint64)data.Size());
+		Write((uint8)data.IsEncodedInline());
+		if (data.IsEncodedInline())
+			Write(data.InlineData(), data.Size());
+		else
+			Write((uint64)data.Offset());
+	}
+
+	void WriteVersion(const BPackageVersionData& version)
+	{
+		WriteString(version.major);
+		WriteString(version.minor);
+		WriteString(version.micro);
+		WriteString(version.preRelease);
+		Write(version.revision);
+	}
+
+private:
+	uint8*		fData;
+	size_t		fSize;
+	size_t		fCapacity;
+	status_t	fError;
+};
+
+
+// #pragma mark - Recorder
+
+
+PackagesCache::Recorder::Recorder(const char* fileName, const struct stat& st,
+	BPackageContentHandler* target)
+	:
+	fTarget(target),
+	fWriter(new(std::nothrow) Writer),
+	fErrorOccurred(false)
+{
+	if (fWriter == NULL)
+		return;
+
+	// the record size is filled in by PackagesCache::Add()
+	fWriter->Write((uint32)0);
+	fWriter->Write((uint64)st.st_ino);
+	fWriter->Write((int64)st.st_size);
+	fWriter->Write((int64)st.st_mtim.tv_sec);
+	fWriter->Write((int64)st.st_mtim.tv_nsec);
+	fWriter->WriteString(fileName);
+}
+
+
+PackagesCache::Recorder::~Recorder()
+{
+	delete fWriter;
+}
+
+
+status_t
+PackagesCache::Recorder::InitCheck() const
+{
+	if (fWriter == NULL)
+		return B_NO_MEMORY;
+	if (fErrorOccurred)
+		return B_BAD_DATA;
+	return fWriter->Status();
+}
+
+
+status_t
+PackagesCache::Recorder::HandleEntry(BPackageEntry* entry)
+{
+	if (fWriter != NULL) {
+		fWriter->Write((uint8)EVENT_ENTRY);
+		fWriter->WriteString(entry->Name());
+		fWriter->Write((uint32)entry->Mode());
+		fWriter->Write((uint32)entry->ModifiedTime().tv_sec);
+		fWriter->Write((uint32)entry->ModifiedTime().tv_nsec);
+		fWriter->WriteData(entry->Data());
+		if (S_ISLNK(entry->Mode()))
+			fWriter->WriteString(entry->SymlinkPath());
+	}
+
+	return fTarget->HandleEntry(entry);
+}
+
+
+status_t
+PackagesCache::Recorder::HandleEntryAttribute(BPackageEntry* entry,
+	BPackageEntryAttribute* attribute)
+{
+	if (fWriter != NULL) {
+		fWriter->Write((uint8)EVENT_ENTRY_ATTRIBUTE);
+		fWriter->WriteString(attribute->Name());
+		fWriter->Write((uint32)attribute->Type());
+		fWriter->WriteData(attribute->Data());
+	}
+
+	return fTarget->HandleEntryAttribute(entry, attribute);
+}
+
+
+status_t
+PackagesCache::Recorder::HandleEntryDone(BPackageEntry* entry)
+{
+	if (fWriter != NULL)
+		fWriter->Write((uint8)EVENT_ENTRY_DONE);
+
+	return fTarget->HandleEntryDone(entry);
+}
+
+
+status_t
+PackagesCache::Recorder::HandlePackageAttribute(
+	const BPackageInfoAttributeValue& value)
+{
+	if (fWriter == NULL)
+		return fTarget->HandlePackageAttribute(value);
+
+	// Only record the attributes the package loader is interested in.
+	switch (value.attributeID) {
+		case B_PACKAGE_INFO_NAME:
+		case B_PACKAGE_INFO_INSTALL_PATH:
+			fWriter->Write((uint8)EVENT_PACKAGE_ATTRIBUTE);
+			fWriter->Write((uint8)value.attributeID);
+			fWriter->WriteString(value.string);
+			break;
+
+		case B_PACKAGE_INFO_VERSION:
+			fWriter->Write((uint8)EVENT_PACKAGE_ATTRIBUTE);
+			fWriter->Write((uint8)value.attributeID);
+			fWriter->WriteVersion(value.version);
+			break;
+
+		case B_PACKAGE_INFO_FLAGS:
+		case B_PACKAGE_INFO_ARCHITECTURE:
+			fWriter->Write((uint8)EVENT_PACKAGE_ATTRIBUTE);
+			fWriter->Write((uint8)value.attributeID);
+			fWriter->Write((uint64)value.unsignedInt);
+			break;
+
+		case B_PACKAGE_INFO_PROVIDES:
+			fWriter->Write((uint8)EVENT_PACKAGE_ATTRIBUTE);
+			fWriter->Write((uint8)value.attributeID);
+			fWriter->WriteString(value.resolvable.name);
+			fWriter->Write((uint8)value.resolvable.haveVersion);
+			fWriter->Write((uint8)value.resolvable.haveCompatibleVersion);
+			fWriter->WriteVersion(value.resolvable.version);
+			fWriter->WriteVersion(value.resolvable.compatibleVersion);
+			break;
+
+		case B_PACKAGE_INFO_REQUIRES:
+			fWriter->Write((uint8)EVENT_PACKAGE_ATTRIBUTE);
+			fWriter->Write((uint8)value.attributeID);
+			fWriter->WriteString(value.resolvableExpression.name);
+			fWriter->Write(
+				(uint8)value.resolvableExpression.haveOpAndVersion);
+			fWriter->Write((uint32)value.resolvableExpression.op);
+			fWriter->WriteVersion(value.resolvableExpression.version);
+			break;
+
+		default:
+			break;
+	}
+
+	return fTarget->HandlePackageAttribute(value);
+}
+
+
+void
+PackagesCache::Recorder::HandleErrorOccurred()
+{
+	fErrorOccurred = true;
+	fTarget->HandleErrorOccurred();
+}
+
+
+// #pragma mark - PackagesCache
+
+
+PackagesCache::PackagesCache()
+	:
+	fFileData(NULL),
+	fEntries(NULL),
+	fReplayedCount(0),
+	fModified(false)
+{
+	mutex_init(&fLock, "packagefs packages cache");
+}
+
+
+PackagesCache::~PackagesCache()
+{
+	if (fEntries != NULL) {
+		Entry* entry = fEntries->Clear(true);
+		while (entry != NULL) {
+			Entry* next = entry->hashNext;
+			delete entry;
+			entry = next;
+		}
+		delete fEntries;
+	}
+
+	free(fFileData);
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+PackagesCache::Init(int packagesDirectoryFD)
+{
+	fEntries = new(std::nothrow) EntryTable;
+	if (fEntries == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+
+	status_t error = fEntries->Init();
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	error = _ReadFile(packagesDirectoryFD);
+	if (error != B_OK) {
+		// start from scratch
+		Entry* entry = fEntries->Clear(true);
+		while (entry != NULL) {
+			Entry* next = entry->hashNext;
+			delete entry;
+			entry = next;
+		}
+
+		free(fFileData);
+		fFileData = NULL;
+		fModified = true;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PackagesCache::Replay(const char* fileName, const struct stat& st,
+	BPackageContentHandler* handler)
+{
+	MutexLocker locker(fLock);
+	Entry* entry = _Lookup(fileName, st);
+	if (entry == NULL)
+		return B_ENTRY_NOT_FOUND;
+	locker.Unlock();
+
+	// The entry can only go away via a call for the same file, so we don't
+	// need to hold the lock while replaying.
+	status_t error = _Replay(entry, handler);
+
+	locker.Lock();
+	if (error != B_OK) {
+		ERROR("Failed to replay cached package \"%s\": %s\n", fileName,
+			strerror(error));
+		_RemoveEntry(entry);
+		return error;
+	}
+
+	entry->used = true;
+	fReplayedCount++;
+	return B_OK;
+}
+
+
+status_t
+PackagesCache::Add(Recorder& recorder)
+{
+	status_t error = recorder.InitCheck();
+	if (error != B_OK)
+		return error;
+
+	Writer* writer = recorder.fWriter;
+	writer->Write((uint8)EVENT_END);
+
+	uint32 recordSize = writer->Size() - sizeof(uint32);
+	writer->WriteAt(0, &recordSize, sizeof(recordSize));
+	if (writer->Status() != B_OK)
+		return writer->Status();
+
+	size_t size = writer->Size();
+	uint8* data = writer->DetachData();
+
+	Entry* entry;
+	error = _ParseRecord(data, size, entry);
+	if (error != B_OK) {
+		free(data);
+		RETURN_ERROR(error);
+	}
+	entry->ownedData = data;
+	entry->used = true;
+
+	// replace an older entry for the same file
+	MutexLocker locker(fLock);
+	Entry* oldEntry = fEntries->Lookup(entry->fileName);
+	if (oldEntry != NULL)
+		_RemoveEntry(oldEntry);
+
+	fEntries->Insert(entry);
+	fModified = true;
+	return B_OK;
+}
+
+
+bool
+PackagesCache::NeedsUpdate() const
+{
+	if (fEntries == NULL)
+		return false;
+	if (fModified)
+		return true;
+
+	// drop the entries of packages that are no longer activated
+	for (EntryTable::Iterator it = fEntries->GetIterator();
+			Entry* entry = it.Next();) {
+		if (!entry->used)
+			return true;
+	}
+
+	return false;
+}
+
+
+status_t
+PackagesCache::Write(int packagesDirectoryFD)
+{
+	cache_file_header header;
+	header.magic = kCacheFileMagic;
+	header.version = kCacheFileVersion;
+	header.entry_count = 0;
+	header.checksum = compute_checksum(NULL, 0);
+	header.size = sizeof(header);
+
+	for (EntryTable::Iterator it = fEntries->GetIterator();
+			Entry* entry = it.Next();) {
+		if (!entry->used)
+			continue;
+
+		header.entry_count++;
+		header.checksum = compute_checksum(entry->record, entry->recordSize,
+			header.checksum);
+		header.size += entry->recordSize;
+	}
+
+	if (header.size > kMaxCacheFileSize)
+		RETURN_ERROR(B_BUFFER_OVERFLOW);
+
+	// Write a temporary file first and move it over the old one when
+	// complete, so that the cache is never seen half written.
+	FileDescriptorCloser fd(openat(packagesDirectoryFD,
+		kTemporaryCacheFilePath, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+	if (!fd.IsSet())
+		RETURN_ERROR(errno);
+
+	status_t error = B_OK;
+	if (write(fd.Get(), &header, sizeof(header)) != (ssize_t)sizeof(header))
+		error = B_IO_ERROR;
+
+	for (EntryTable::Iterator it = fEntries->GetIterator();
+			Entry* entry = it.Next();) {
+		if (error != B_OK)
+			break;
+		if (!entry->used)
+			continue;
+
+		if (write(fd.Get(), entry->record, entry->recordSize)
+				!= (ssize_t)entry->recordSize) {
+			error = B_IO_ERROR;
+		}
+	}
+
+	if (error == B_OK && fsync(fd.Get()) != 0)
+		error = errno;
+
+	fd.Unset();
+
+	if (error == B_OK) {
+		error = _kern_rename(packagesDirectoryFD, kTemporaryCacheFilePath,
+			packagesDirectoryFD, kCacheFilePath);
+	}
+
+	if (error != B_OK) {
+		unlinkat(packagesDirectoryFD, kTemporaryCacheFilePath, 0);
+		RETURN_ERROR(error);
+	}
+
+	fModified = false;
+	return B_OK;
+}
+
+
+status_t
+PackagesCache::_ReadFile(int packagesDirectoryFD)
+{
+	FileDescriptorCloser fd(openat(packagesDirectoryFD, kCacheFilePath,
+		O_RDONLY));
+	if (!fd.IsSet())
+		return errno;
+
+	struct stat st;
+	if (fstat(fd.Get(), &st) != 0)
+		RETURN_ERROR(errno);
+
+	if (st.st_size < (off_t)sizeof(cache_file_header)
+		|| st.st_size > (off_t)kMaxCacheFileSize) {
+		RETURN_ERROR(B_BAD_DATA);
+	}
+
+	// read the whole file at once, all entries refer to it directly
+	fFileData = (uint8*)malloc(st.st_size);
+	if (fFileData == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+
+	ssize_t bytesRead = read(fd.Get(), fFileData, st.st_size);
+	if (bytesRead != st.st_size)
+		RETURN_ERROR(bytesRead < 0 ? errno : B_IO_ERROR);
+
+	cache_file_header header;
+	memcpy(&header, fFileData, sizeof(header));
+	if (header.magic != kCacheFileMagic
+		|| header.version != kCacheFileVersion
+		|| header.size != (uint64)st.st_size) {
+		RETURN_ERROR(B_BAD_DATA);
+	}
+
+	const uint8* records = fFileData + sizeof(header);
+	size_t recordsSize = st.st_size - sizeof(header);
+	if (compute_checksum(records, recordsSize) != header.checksum)
+		RETURN_ERROR(B_BAD_DATA);
+
+	Reader reader(records, recordsSize);
+	for (uint32 i = 0; i < header.entry_count; i++) {
+		uint32 recordSize;
+		const uint8* record = reader.Position();
+		if (!reader.Read(recordSize) || recordSize > reader.BytesRemaining())
+			RETURN_ERROR(B_BAD_DATA);
+
+		Entry* entry;
+		status_t error = _ParseRecord(record, recordSize + sizeof(uint32),
+			entry);
+		if (error != B_OK)
+			RETURN_ERROR(error);
+
+		Entry* oldEntry = fEntries->Lookup(entry->fileName);
+		if (oldEntry != NULL)
+			_RemoveEntry(oldEntry);
+		fEntries->Insert(entry);
+
+		reader.Skip(recordSize);
+	}
+
+	if (reader.BytesRemaining() != 0)
+		RETURN_ERROR(B_BAD_DATA);
+
+	return B_OK;
+}
+
+
+status_t
+PackagesCache::_ParseRecord(const uint8* record, size_t size, Entry*& _entry)
+{
+	Entry* entry = new(std::nothrow) Entry;
+	if (entry == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+	ObjectDeleter<Entry> entryDeleter(entry);
+
+	Reader reader(record, size);
+	uint32 recordSize;
+	uint64 nodeID;
+	int64 fileSize;
+	int64 seconds;
+	int64 nanoSeconds;
+	if (!reader.Read(recordSize) || recordSize != size - sizeof(uint32)
+		|| !reader.Read(nodeID) || !reader.Read(fileSize)
+		|| !reader.Read(seconds) || !reader.Read(nanoSeconds)
+		|| !reader.ReadString(entry->fileName) || entry->fileName == NULL) {
+		RETURN_ERROR(B_BAD_DATA);
+	}
+
+	// the events must be terminated
+	if (reader.BytesRemaining() == 0 || record[size - 1] != EVENT_END)
+		RETURN_ERROR(B_BAD_DATA);
+
+	entry->hashNext = NULL;
+	entry->nodeID = nodeID;
+	entry->fileSize = fileSize;
+	entry->modifiedTime.tv_sec = seconds;
+	entry->modifiedTime.tv_nsec = nanoSeconds;
+	entry->record = record;
+	entry->recordSize = size;
+	entry->events = reader.Position();
+	entry->eventsSize = reader.BytesRemaining();
+
+	_entry = entryDeleter.Detach();
+	return B_OK;
+}
+
+
+PackagesCache::Entry*
+PackagesCache::_Lookup(const char* fileName, const struct stat& st) const
+{
+	if (fEntries == NULL)
+		return NULL;
+
+	Entry* entry = fEntries->Lookup(fileName);
+	if (entry == NULL || !entry->Matches(st))
+		return NULL;
+
+	return entry;
+}
+
+
+void
+PackagesCache::_RemoveEntry(Entry* entry)
+{
+	fEntries->Remove(entry);
+	delete entry;
+	fModified = true;
+}
+
+
+status_t
+PackagesCache::_Replay(const Entry* cacheEntry,
+	BPackageContentHandler* handler)
+{
+	Reader reader(cacheEntry->events, cacheEntry->eventsSize);
+	BPackageEntry* entry = NULL;
+	status_t error = B_OK;
+
+	while (error == B_OK) {
+		uint8 event;
+		if (!reader.Read(event)) {
+			error = B_BAD_DATA;
+			break;
+		}
+
+		switch (event) {
+			case EVENT_END:
+				if (entry != NULL || reader.BytesRemaining() != 0)
+					error = B_BAD_DATA;
+				return error;
+
+			case EVENT_PACKAGE_ATTRIBUTE:
+			{
+				BPackageInfoAttributeValue value;
+				uint8 id;
+				if (!reader.Read(id)) {
+					error = B_BAD_DATA;
+					break;
+				}
+
+				value.attributeID = (BPackageInfoAttributeID)id;
+				bool valid;
+				switch (id) {
+					case B_PACKAGE_INFO_NAME:
+					case B_PACKAGE_INFO_INSTALL_PATH:
+						valid = reader.ReadString(value.string)
+							&& value.string != NULL;
+						break;
+
+					case B_PACKAGE_INFO_VERSION:
+						valid = reader.ReadVersion(value.version);
+						break;
+
+					case B_PACKAGE_INFO_FLAGS:
+					case B_PACKAGE_INFO_ARCHITECTURE:
+						valid = reader.Read(value.unsignedInt);
+						break;
+
+					case B_PACKAGE_INFO_PROVIDES:
+					{
+						BPackageResolvableData& resolvable = value.resolvable;
+						uint8 haveVersion;
+						uint8 haveCompatibleVersion;
+						valid = reader.ReadString(resolvable.name)
+							&& resolvable.name != NULL
+							&& reader.Read(haveVersion)
+							&& reader.Read(haveCompatibleVersion)
+							&& reader.ReadVersion(resolvable.version)
+							&& reader.ReadVersion(
+								resolvable.compatibleVersion);
+						resolvable.haveVersion = haveVersion != 0;
+						resolvable.haveCompatibleVersion
+							= haveCompatibleVersion != 0;
+						break;
+					}
+
+					case B_PACKAGE_INFO_REQUIRES:
+					{
+						BPackageResolvableExpressionData& expression
+							= value.resolvableExpression;
+						uint8 haveOpAndVersion;
+						uint32 op;
+						valid = reader.ReadString(expression.name)
+							&& expression.name != NULL
+							&& reader.Read(haveOpAndVersion)
+							&& reader.Read(op)
+							&& reader.ReadVersion(expression.version);
+						expression.haveOpAndVersion = haveOpAndVersion != 0;
+						expression.op = (BPackageResolvableOperator)op;
+						break;
+					}
+
+					default:
+						valid = false;
+						break;
+				}
+
+				if (!valid) {
+					error = B_BAD_DATA;
+					break;
+				}
+
+				error = handler->HandlePackageAttribute(value);
+				break;
+			}
+
+			case EVENT_ENTRY:
+			{
+				const char* name;
+				uint32 mode;
+				uint32 seconds;
+				uint32 nanoSeconds;
+				BPackageData data;
+				const char* symlinkPath = NULL;
+				if (!reader.ReadString(name) || name == NULL
+					|| !reader.Read(mode) || !reader.Read(seconds)
+					|| !reader.Read(nanoSeconds) || !reader.ReadData(data)
+					|| (S_ISLNK(mode) && !reader.ReadString(symlinkPath))) {
+					error = B_BAD_DATA;
+					break;
+				}
+
+				BPackageEntry* child = new(std::nothrow) BPackageEntry(entry,
+					name);
+				if (child == NULL) {
+					error = B_NO_MEMORY;
+					break;
+				}
+
+				child->SetType(mode);
+				child->SetPermissions(mode);
+				child->SetModifiedTime(seconds);
+				child->SetModifiedTimeNanos(nanoSeconds);
+				child->Data() = data;
+				child->SetSymlinkPath(symlinkPath);
+				entry = child;
+
+				error = handler->HandleEntry(entry);
+				break;
+			}
+
+			case EVENT_ENTRY_ATTRIBUTE:
+			{
+				const char* name;
+				uint32 type;
+				BPackageData data;
+				if (entry == NULL || !reader.ReadString(name) || name == NULL
+					|| !reader.Read(type) || !reader.ReadData(data)) {
+					error = B_BAD_DATA;
+					break;
+				}
+
+				BPackageEntryAttribute attribute(name);
+				attribute.SetType(type);
+				attribute.Data() = data;
+
+				error = handler->HandleEntryAttribute(entry, &attribute);
+				break;
+			}
+
+			case EVENT_ENTRY_DONE:
+			{
+				if (entry == NULL) {
+					error = B_BAD_DATA;
+					break;
+				}
+
+				error = handler->HandleEntryDone(entry);
+
+				BPackageEntry* parent = const_cast<BPackageEntry*>(
+					entry->Parent());
+				delete entry;
+				entry = parent;
+				break;
+			}
+
+			default:
+				error = B_BAD_DATA;
+				break;
+		}
+	}
+
+	// clean up the entries still open after an error
+	while (entry != NULL) {
+		BPackageEntry* parent = const_cast<BPackageEntry*>(entry->Parent());
+		delete entry;
+		entry = parent;
+	}
+
+	return error;
+}
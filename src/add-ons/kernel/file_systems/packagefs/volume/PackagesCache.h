@@ -0,0 +1,118 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PACKAGES_CACHE_H
+#define PACKAGES_CACHE_H
+
+
+#include <sys/stat.h>
+
+#include <lock.h>
+#include <package/hpkg/PackageContentHandler.h>
+#include <util/OpenHashTable.h>
+#include <util/StringHash.h>
+
+
+using BPackageKit::BHPKG::BPackageContentHandler;
+using BPackageKit::BHPKG::BPackageEntry;
+using BPackageKit::BHPKG::BPackageEntryAttribute;
+using BPackageKit::BHPKG::BPackageInfoAttributeValue;
+
+
+/*!	Persistent cache of the parsed contents of the packages of a volume.
+
+	Parsing the TOC of every activated package dominates the mount time of
+	a packagefs volume. The cache file stores the content handler events a
+	package's TOC and package attributes section produced, so that they can
+	be replayed at the next mount without opening the package file at all.
+	Since the events are replayed through the regular loader, the package
+	settings (blocked entries) are still applied as usual.
+
+	An entry is only used when the package file's name, node ID, size, and
+	modification time still match; the whole file is ignored when its
+	version or checksum doesn't.
+
+	Replay() and Add() may be called concurrently, as long as they are for
+	different package files.
+*/
+class PackagesCache {
+public:
+			class Recorder;
+
+public:
+								PackagesCache();
+								~PackagesCache();
+
+			status_t			Init(int packagesDirectoryFD);
+									// reads the cache file, if any
+
+			status_t			Replay(const char* fileName,
+									const struct stat& st,
+									BPackageContentHandler* handler);
+									// B_ENTRY_NOT_FOUND, if not cached
+			status_t			Add(Recorder& recorder);
+
+			bool				NeedsUpdate() const;
+			status_t			Write(int packagesDirectoryFD);
+
+			int32				CountReplayed() const
+									{ return fReplayedCount; }
+
+private:
+			struct Entry;
+			struct EntryHashDefinition;
+			class Reader;
+			class Writer;
+
+			typedef BOpenHashTable<EntryHashDefinition> EntryTable;
+
+private:
+			status_t			_ReadFile(int packagesDirectoryFD);
+			status_t			_ParseRecord(const uint8* record,
+									size_t size, Entry*& _entry);
+			Entry*				_Lookup(const char* fileName,
+									const struct stat& st) const;
+			void				_RemoveEntry(Entry* entry);
+			status_t			_Replay(const Entry* entry,
+									BPackageContentHandler* handler);
+
+private:
+			mutex				fLock;
+			uint8*				fFileData;
+			EntryTable*			fEntries;
+			int32				fReplayedCount;
+			bool				fModified;
+};
+
+
+class PackagesCache::Recorder : public BPackageContentHandler {
+public:
+								Recorder(const char* fileName,
+									const struct stat& st,
+									BPackageContentHandler* target);
+								~Recorder();
+
+			status_t			InitCheck() const;
+
+	virtual	status_t			HandleEntry(BPackageEntry* entry);
+	virtual	status_t			HandleEntryAttribute(BPackageEntry* entry,
+									BPackageEntryAttribute* attribute);
+	virtual	status_t			HandleEntryDone(BPackageEntry* entry);
+
+	virtual	status_t			HandlePackageAttribute(
+									const BPackageInfoAttributeValue& value);
+
+	virtual	void				HandleErrorOccurred();
+
+private:
+			friend class PackagesCache;
+
+private:
+			BPackageContentHandler* fTarget;
+			Writer*				fWriter;
+			bool				fErrorOccurred;
+};
+
+
+#endif	// PACKAGES_CACHE_H
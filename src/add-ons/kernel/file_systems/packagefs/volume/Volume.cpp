@@ -26,6 +26,7 @@
 #include <AutoDeleterDrivers.h>
 #include <PackagesDirectoryDefs.h>
 
+#include <smp.h>
 #include <vfs.h>
 
 #include "AttributeIndex.h"
@@ -37,6 +38,7 @@
 #include "PackageFSRoot.h"
 #include "PackageLinkDirectory.h"
 #include "PackageLinksDirectory.h"
+#include "PackagesCache.h"
 #include "Resolvable.h"
 #include "SizeIndex.h"
 #include "UnpackingLeafNode.h"
@@ -63,6 +65,9 @@ const size_t kMaxActivationRequestSize = 10 * 1024 * 1024;
 // sanity limit for activation file size
 const size_t kMaxActivationFileSize = 10 * 1024 * 1024;
 
+// maximum number of threads loading the initial packages
+const int32 kMaxInitialPackageLoaderThreads = 16;
+
 static const char* const kAdministrativeDirectoryName
 	= PACKAGES_DIRECTORY_ADMIN_DIRECTORY;
 static const char* const kActivationFileName
@@ -161,6 +166,136 @@ private:
 };
 
 
+// #pragma mark - InitialPackageLoader
+
+
+/*!	Loads the initial packages of the volume in parallel.
+	The packages are only loaded (i.e. their contents parsed); adding them to
+	the volume is left to the caller, which can do that in the original order.
+*/
+struct Volume::InitialPackageLoader {
+public:
+	InitialPackageLoader(Volume* volume, PackagesDirectory* packagesDirectory)
+		:
+		fVolume(volume),
+		fPackagesDirectory(packagesDirectory),
+		fItems(NULL),
+		fCount(0),
+		fCapacity(0),
+		fNextIndex(0)
+	{
+	}
+
+	~InitialPackageLoader()
+	{
+		for (int32 i = 0; i < fCount; i++) {
+			if (fItems[i].package != NULL)
+				fItems[i].package->ReleaseReference();
+			free(fItems[i].name);
+		}
+		free(fItems);
+	}
+
+	status_t AddPackage(const char* name)
+	{
+		if (fCount == fCapacity) {
+			int32 capacity = fCapacity > 0 ? fCapacity * 2 : 64;
+			Item* items = (Item*)realloc(fItems, capacity * sizeof(Item));
+			if (items == NULL)
+				RETURN_ERROR(B_NO_MEMORY);
+			fItems = items;
+			fCapacity = capacity;
+		}
+
+		Item& item = fItems[fCount];
+		item.name = strdup(name);
+		if (item.name == NULL)
+			RETURN_ERROR(B_NO_MEMORY);
+		item.package = NULL;
+		item.error = B_OK;
+		fCount++;
+		return B_OK;
+	}
+
+	int32 CountPackages() const
+	{
+		return fCount;
+	}
+
+	const char* PackageNameAt(int32 index) const
+	{
+		return fItems[index].name;
+	}
+
+	Package* PackageAt(int32 index) const
+	{
+		return fItems[index].package;
+	}
+
+	status_t PackageErrorAt(int32 index) const
+	{
+		return fItems[index].error;
+	}
+
+	void LoadPackages()
+	{
+		// The calling thread participates, so we spawn one thread less.
+		int32 threadCount = min_c(min_c((int32)smp_get_num_cpus(),
+			kMaxInitialPackageLoaderThreads), fCount);
+		thread_id threads[kMaxInitialPackageLoaderThreads];
+		int32 spawnedCount = 0;
+		for (int32 i = 1; i < threadCount; i++) {
+			thread_id thread = spawn_kernel_thread(&_LoaderThreadEntry,
+				"packagefs package loader", B_NORMAL_PRIORITY, this);
+			if (thread < 0)
+				break;
+			resume_thread(thread);
+			threads[spawnedCount++] = thread;
+		}
+
+		_LoadPackages();
+
+		for (int32 i = 0; i < spawnedCount; i++)
+			wait_for_thread(threads[i], NULL);
+	}
+
+private:
+	struct Item {
+		char*		name;
+		Package*	package;
+		status_t	error;
+	};
+
+private:
+	static status_t _LoaderThreadEntry(void* data)
+	{
+		((InitialPackageLoader*)data)->_LoadPackages();
+		return B_OK;
+	}
+
+	void _LoadPackages()
+	{
+		for (;;) {
+			int32 index = atomic_add(&fNextIndex, 1);
+			if (index >= fCount)
+				break;
+
+			Item& item = fItems[index];
+			item.error = fVolume->_LoadPackage(fPackagesDirectory, item.name,
+				item.package);
+		}
+	}
+
+private:
+	Volume*				fVolume;
+	PackagesDirectory*	fPackagesDirectory;
+	Item*				fItems;
+	int32				fCount;
+	int32				fCapacity;
+	int32				fNextIndex;
+};
+
+
 // #pragma mark - Volume
 
 
@@ -173,6 +308,7 @@ Volume::Volume(fs_volume* fsVolume)
 	fPackagesDirectories(),
 	fPackagesDirectoriesByNodeRef(),
 	fPackageSettings(),
+	fPackagesCache(NULL),
 	fNextNodeID(kRootDirectoryID + 1)
 {
 	rw_lock_init(&fLock, "packagefs volume");
@@ -758,6 +894,14 @@ Volume::_AddInitialPackages()
 	PackagesDirectory* packagesDirectory = fPackagesDirectories.Last();
 	INFORM("Adding packages from \"%s\"\n", packagesDirectory->Path());
 
+	bigtime_t startTime = system_time();
+
+	// Use the contents of the packages cache where possible. Whatever we
+	// have to parse from the package files is added to it.
+	PackagesCache packagesCache;
+	if (packagesCache.Init(fPackagesDirectory->DirectoryFD()) == B_OK)
+		fPackagesCache = &packagesCache;
+
 	// try reading the activation file of the oldest state
 	status_t error = _AddInitialPackagesFromActivationFile(packagesDirectory);
 	if (error != B_OK && packagesDirectory != fPackagesDirectory) {
@@ -793,8 +937,21 @@ Volume::_AddInitialPackages()
 
 		// read the whole directory
 		error = _AddInitialPackagesFromDirectory();
-		if (error != B_OK)
+		if (error != B_OK) {
+			fPackagesCache = NULL;
 			RETURN_ERROR(error);
+		}
+	}
+
+	fPackagesCache = NULL;
+
+	if (packagesCache.NeedsUpdate()) {
+		status_t cacheError = packagesCache.Write(
+			fPackagesDirectory->DirectoryFD());
+		if (cacheError != B_OK) {
+			INFORM("Failed to write packages cache: %s\n",
+				strerror(cacheError));
+		}
 	}
 
 	// add the packages to the node tree
@@ -813,6 +970,10 @@ Volume::_AddInitialPackages()
 		}
 	}
 
+	INFORM("Added %" B_PRIu32 " packages (%" B_PRId32 " from cache) in %"
+		B_PRId64 " ms\n", (uint32)fPackages.CountElements(),
+		packagesCache.CountReplayed(), (system_time() - startTime) / 1000);
+
 	return B_OK;
 }
 
@@ -864,7 +1025,8 @@ Volume::_AddInitialPackagesFromActivationFile(
 	// null-terminate to simplify parsing
 	fileContent[st.st_size] = '\0';
 
-	// parse the file and add the respective packages
+	// parse the file and collect the respective packages
+	InitialPackageLoader loader(this, packagesDirectory);
 	const char* packageName = fileContent;
 	char* const fileContentEnd = fileContent + st.st_size;
 	while (packageName < fileContentEnd) {
@@ -884,15 +1046,14 @@ Volume::_AddInitialPackagesFromActivationFile(
 			RETURN_ERROR(B_BAD_DATA);
 		}
 
-		status_t error = _LoadAndAddInitialPackage(packagesDirectory,
-			packageName);
+		status_t error = loader.AddPackage(packageName);
 		if (error != B_OK)
 			RETURN_ERROR(error);
 
 		packageName = packageNameEnd + 1;
 	}
 
-	return B_OK;
+	return _LoadAndAddInitialPackages(loader, false);
 }
 
 
@@ -913,6 +1074,7 @@ Volume::_AddInitialPackagesFromDirectory()
 		RETURN_ERROR(errno);
 	}
 
+	InitialPackageLoader loader(this, fPackagesDirectory);
 	while (dirent* entry = readdir(dir.Get())) {
 		// skip "." and ".."
 		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
@@ -925,28 +1087,39 @@ Volume::_AddInitialPackagesFromDirectory()
 			continue;
 		}
 
-		_LoadAndAddInitialPackage(fPackagesDirectory, entry->d_name);
+		status_t error = loader.AddPackage(entry->d_name);
+		if (error != B_OK)
+			RETURN_ERROR(error);
 	}
 
-	return B_OK;
+	return _LoadAndAddInitialPackages(loader, true);
 }
 
 
 status_t
-Volume::_LoadAndAddInitialPackage(PackagesDirectory* packagesDirectory,
-	const char* name)
+Volume::_LoadAndAddInitialPackages(InitialPackageLoader& loader,
+	bool ignoreErrors)
 {
-	Package* package;
-	status_t error = _LoadPackage(packagesDirectory, name, package);
-	if (error != B_OK) {
-		ERROR("Failed to load package \"%s\": %s\n", name, strerror(error));
-		RETURN_ERROR(error);
-	}
-	BReference<Package> packageReference(package, true);
+	// Parsing the packages is independent of the volume state, so that can
+	// happen in parallel. Adding them is done here in the original order.
+	loader.LoadPackages();
 
 	VolumeWriteLocker systemVolumeLocker(_SystemVolumeIfNotSelf());
 	VolumeWriteLocker volumeLocker(this);
-	_AddPackage(package);
+
+	int32 count = loader.CountPackages();
+	for (int32 i = 0; i < count; i++) {
+		status_t error = loader.PackageErrorAt(i);
+		if (error != B_OK) {
+			ERROR("Failed to load package \"%s\": %s\n",
+				loader.PackageNameAt(i), strerror(error));
+			if (ignoreErrors)
+				continue;
+			RETURN_ERROR(error);
+		}
+
+		_AddPackage(loader.PackageAt(i));
+	}
 
 	return B_OK;
 }
@@ -1537,7 +1710,7 @@ Volume::_LoadPackage(PackagesDirectory* packagesDirectory, const char* name,
 	if (error != B_OK)
 		return error;
 
-	error = package->Load(fPackageSettings);
+	error = package->Load(fPackageSettings, st, fPackagesCache);
 	if (error != B_OK)
 		return error;
 
@@ -170,6 +170,12 @@ struct Query::QueryPolicy {
 		return index.index != NULL ? B_OK : B_ENTRY_NOT_FOUND;
 	}
 
+	static status_t IndexSetToTrigrams(Index& index, const char* attribute)
+	{
+		// there are no trigram indices
+		return B_ENTRY_NOT_FOUND;
+	}
+
 	static void IndexUnset(Index& index)
 	{
 		index.index = NULL;
@@ -225,6 +231,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* indexIterator)
+	{
+		return indexIterator->entry->GetNode()->GetID();
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* indexIterator)
 	{
 		// Nothing to do.
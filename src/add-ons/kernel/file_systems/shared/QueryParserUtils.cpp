@@ -33,6 +33,42 @@ compare_integral(const Key& a, const Key& b)
 }
 
 
+static inline uint8
+fold_case(uint8 c)
+{
+	if (c >= 'A' && c <= 'Z')
+		return c + 'a' - 'A';
+	return c;
+}
+
+
+static inline uint32
+make_trigram(const uint8* bytes)
+{
+	return ((uint32)bytes[0] << 16) | ((uint32)bytes[1] << 8) | bytes[2];
+}
+
+
+/*!	Adds the trigram to the sorted \a trigrams array, if it isn't already
+	part of it.
+*/
+static void
+add_trigram(uint32 trigram, uint32* trigrams, int32& count, int32 maxCount)
+{
+	int32 index = count;
+	while (index > 0 && trigrams[index - 1] > trigram)
+		index--;
+
+	if ((index > 0 && trigrams[index - 1] == trigram) || count == maxCount)
+		return;
+
+	memmove(&trigrams[index + 1], &trigrams[index],
+		(count - index) * sizeof(uint32));
+	trigrams[index] = trigram;
+	count++;
+}
+
+
 // #pragma mark -
 
 
@@ -322,4 +358,113 @@ matchString(const char* pattern, const char* string)
 }
 
 
+//	#pragma mark -
+
+
+/*!	Fills \a trigrams with the sorted and unique trigrams of the string,
+	that is, every sequence of three bytes in it, with ASCII letters folded
+	to lower case.
+	Returns the number of trigrams; a string shorter than three bytes has
+	none.
+*/
+int32
+getTrigrams(const char* string, size_t length, uint32* trigrams,
+	int32 maxCount)
+{
+	length = strnlen(string, length);
+
+	int32 count = 0;
+	uint8 bytes[3];
+	for (size_t i = 0; i < length; i++) {
+		bytes[0] = bytes[1];
+		bytes[1] = bytes[2];
+		bytes[2] = fold_case(string[i]);
+
+		if (i >= 2)
+			add_trigram(make_trigram(bytes), trigrams, count, maxCount);
+	}
+
+	return count;
+}
+
+
+/*!	Fills \a trigrams with the trigrams every string matching the pattern
+	has to contain (as computed by getTrigrams()). Only literal runs of the
+	pattern count, and sets like "[Hh]" that only differ in case.
+	Returns the number of trigrams; if it is zero, the pattern does not
+	contain enough literal characters to be narrowed down this way.
+*/
+int32
+getPatternTrigrams(const char* pattern, uint32* trigrams, int32 maxCount)
+{
+	int32 count = 0;
+	int32 run = 0;
+	uint8 bytes[3];
+
+	while (pattern[0] != '\0') {
+		int32 c = -1;
+			// the next literal byte, if any
+
+		switch (*pattern++) {
+			case '*':
+			case '?':
+				break;
+
+			case '[':
+			{
+				bool invert = pattern[0] == '^' || pattern[0] == '!';
+				if (invert)
+					pattern++;
+
+				// a set can only be used if all of its characters are the
+				// same after folding
+				bool literal = !invert;
+				while (pattern[0] != ']' && pattern[0] != '\0') {
+					if (pattern[0] == '\\' && pattern[1] != '\0')
+						pattern++;
+
+					uint8 member = fold_case(pattern[0]);
+					if (member >= 0x80 || pattern[1] == '-'
+						|| (c >= 0 && c != member)) {
+						literal = false;
+					}
+					c = member;
+					pattern++;
+				}
+				if (pattern[0] == ']')
+					pattern++;
+
+				if (!literal)
+					c = -1;
+				break;
+			}
+
+			case '\\':
+				if (pattern[0] != '\0')
+					pattern++;
+				c = fold_case(pattern[-1]);
+				break;
+
+			default:
+				c = fold_case(pattern[-1]);
+				break;
+		}
+
+		if (c < 0) {
+			run = 0;
+			continue;
+		}
+
+		bytes[0] = bytes[1];
+		bytes[1] = bytes[2];
+		bytes[2] = (uint8)c;
+
+		if (++run >= 3)
+			add_trigram(make_trigram(bytes), trigrams, count, maxCount);
+	}
+
+	return count;
+}
+
+
 }	// namespace QueryParser
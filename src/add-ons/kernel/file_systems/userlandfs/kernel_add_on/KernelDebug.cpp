@@ -79,6 +79,8 @@ KernelDebug::DebugPort(int argc, char** argv)
 	kprintf("  client port:  %" B_PRId32 "\n", port->fPort.fInfo.client_port);
 	kprintf("  size:         %" B_PRId32 "\n", port->fPort.fInfo.size);
 	kprintf("  capacity:     %" B_PRId32 "\n", port->fPort.fCapacity);
+	kprintf("  shared area:  %" B_PRId32 " (%" B_PRId32 " bytes)\n",
+		port->fPort.fSharedArea, port->fPort.fInfo.shared_area_size);
 	kprintf("  buffer:       %p\n", port->fPort.fBuffer);
 	return 0;
 }
@@ -694,7 +694,7 @@ KernelRequestHandler::_HandleRequest(FileCacheReadRequest* request)
 	reply->bytesRead = size;
 
 	// send the reply
-	if (reply->error == B_OK && reply->bytesRead > 0) {
+	if (reply->error == B_OK && reply->bytesRead > 0 && allocator.HasAreas()) {
 		SingleReplyRequestHandler handler(RECEIPT_ACK_REPLY);
 		return fPort->SendRequest(&allocator, &handler);
 	}
@@ -803,7 +803,7 @@ KernelRequestHandler::_HandleRequest(ReadFromIORequestRequest* request)
 	reply->error = result;
 
 	// send the reply
-	if (reply->error == B_OK) {
+	if (reply->error == B_OK && allocator.HasAreas()) {
 		SingleReplyRequestHandler handler(RECEIPT_ACK_REPLY);
 		return fPort->SendRequest(&allocator, &handler);
 	}
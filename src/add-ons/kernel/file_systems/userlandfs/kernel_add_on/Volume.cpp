@@ -1051,7 +1051,7 @@ Volume::GetVNodeName(void* _node, char* buffer, size_t bufferSize)
 	memcpy(buffer, readBuffer, nameLen);
 	buffer[nameLen] = '\0';
 
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -1454,7 +1454,7 @@ Volume::IOCtl(void* _node, void* cookie, uint32 command, void *buffer,
 		if (writeSize > reply->buffer.GetSize())
 			writeSize = reply->buffer.GetSize();
 		memcpy(buffer, reply->buffer.GetData(), writeSize);
-		_SendReceiptAck(port);
+		_SendReceiptAck(port, reply);
 	}
 	return reply->ioctlError;
 }
@@ -1696,7 +1696,7 @@ Volume::ReadSymlink(void* _node, char* buffer, size_t bufferSize,
 	if (reply->bytesRead > 0)
 		memcpy(buffer, readBuffer, reply->bytesRead);
 	*bytesRead = reply->bytesRead;
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -2185,7 +2185,7 @@ Volume::Read(void* _node, void* cookie, off_t pos, void* buffer,
 	}
 
 	*bytesRead = reply->bytesRead;
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -2467,7 +2467,7 @@ Volume::ReadDir(void* _node, void* cookie, void* buffer, size_t bufferSize,
 			copyBytes = maxBytes;
 		memcpy(buffer, reply->buffer.GetData(), copyBytes);
 	}
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -2653,7 +2653,7 @@ Volume::ReadAttrDir(void* _node, void* cookie, void* buffer,
 			copyBytes = maxBytes;
 		memcpy(buffer, reply->buffer.GetData(), copyBytes);
 	}
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -2887,7 +2887,7 @@ Volume::ReadAttr(void* _node, void* cookie, off_t pos,
 		return B_BAD_ADDRESS;
 	}
 	*bytesRead = reply->bytesRead;
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -3253,7 +3253,7 @@ Volume::ReadIndexDir(void* cookie, void* buffer, size_t bufferSize,
 			copyBytes = maxBytes;
 		memcpy(buffer, reply->buffer.GetData(), copyBytes);
 	}
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -3560,7 +3560,7 @@ Volume::ReadQuery(void* cookie, void* buffer, size_t bufferSize,
 			copyBytes = maxBytes;
 		memcpy(buffer, reply->buffer.GetData(), copyBytes);
 	}
-	_SendReceiptAck(port);
+	_SendReceiptAck(port, reply);
 	return error;
 }
 
@@ -4414,8 +4414,12 @@ Volume::_SendRequest(RequestPort* port, RequestAllocator* allocator,
 
 // _SendReceiptAck
 status_t
-Volume::_SendReceiptAck(RequestPort* port)
+Volume::_SendReceiptAck(RequestPort* port, Request* reply)
 {
+	// data in the port buffer or the shared area don't need to be acknowledged
+	if (!port->NeedsReceipt(reply))
+		return B_OK;
+
 	RequestAllocator allocator(port->GetPort());
 	ReceiptAckReply* request;
 	status_t error = AllocateRequest(allocator, &request);
@@ -267,7 +267,8 @@ private:
 			status_t			_SendRequest(RequestPort* port,
 									RequestAllocator* allocator,
 									RequestHandler* handler, Request** reply);
-			status_t			_SendReceiptAck(RequestPort* port);
+			status_t			_SendReceiptAck(RequestPort* port,
+									Request* reply);
 
 			void				_IncrementVNodeCount(ino_t vnid);
 			void				_DecrementVNodeCount(ino_t vnid);
@@ -6,6 +6,7 @@
 #include <new>
 
 #include <AutoDeleter.h>
+#include <KernelExport.h>
 
 #include "AreaSupport.h"
 #include "Compatibility.h"
@@ -18,16 +19,25 @@ using std::nothrow;
 static const int32 kMinPortSize = 1024;			// 1 kB
 static const int32 kMaxPortSize = 64 * 1024;	// 64 kB
 
+// maximal shared area size
+static const int32 kMaxSharedAreaSize = 16 * 1024 * 1024;	// 16 MB
+
 
 // constructor
-Port::Port(int32 size)
+Port::Port(int32 size, int32 sharedAreaSize)
 	:
 	fBuffer(NULL),
 	fCapacity(0),
 	fReservedSize(0),
+	fSharedArea(-1),
+	fSharedAreaAddress(NULL),
+	fSharedReservedSize(0),
 	fInitStatus(B_NO_INIT),
 	fOwner(true)
 {
+	fInfo.shared_area = -1;
+	fInfo.shared_area_size = 0;
+
 	// adjust size to be within the sane bounds
 	if (size < kMinPortSize)
 		size = kMinPortSize;
@@ -51,6 +61,29 @@ Port::Port(int32 size)
 		fInitStatus = fInfo.client_port;
 		return;
 	}
+	// create the shared area, if requested
+	if (sharedAreaSize > 0) {
+		if (sharedAreaSize > kMaxSharedAreaSize)
+			sharedAreaSize = kMaxSharedAreaSize;
+		sharedAreaSize = (sharedAreaSize + 2 * B_PAGE_SIZE - 1)
+			/ (2 * B_PAGE_SIZE) * (2 * B_PAGE_SIZE);
+		fSharedArea = create_area("port shared area",
+			(void**)&fSharedAreaAddress,
+#ifdef _KERNEL_MODE
+			B_ANY_KERNEL_ADDRESS, sharedAreaSize, B_NO_LOCK,
+			B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA | B_CLONEABLE_AREA
+#else
+			B_ANY_ADDRESS, sharedAreaSize, B_NO_LOCK,
+			B_READ_AREA | B_WRITE_AREA
+#endif
+			);
+		if (fSharedArea < 0) {
+			fInitStatus = fSharedArea;
+			return;
+		}
+		fInfo.shared_area = fSharedArea;
+		fInfo.shared_area_size = sharedAreaSize;
+	}
 	fInfo.size = size;
 	fCapacity = size;
 	fInitStatus = B_OK;
@@ -63,12 +96,21 @@ Port::Port(const Info* info)
 	fBuffer(NULL),
 	fCapacity(0),
 	fReservedSize(0),
+	fSharedArea(-1),
+	fSharedAreaAddress(NULL),
+	fSharedReservedSize(0),
 	fInitStatus(B_NO_INIT),
 	fOwner(false)
 {
+	fInfo.shared_area = -1;
+	fInfo.shared_area_size = 0;
+
 	// check parameters
 	if (!info || info->owner_port < 0 || info->client_port < 0
-		|| info->size < kMinPortSize || info->size > kMaxPortSize) {
+		|| info->size < kMinPortSize || info->size > kMaxPortSize
+		|| info->shared_area_size < 0
+		|| info->shared_area_size > kMaxSharedAreaSize
+		|| info->shared_area_size % (2 * B_PAGE_SIZE) != 0) {
 		return;
 	}
 	// allocate the buffer
@@ -77,6 +119,30 @@ Port::Port(const Info* info)
 		fInitStatus = B_NO_MEMORY;
 		return;
 	}
+	// clone the owner's shared area, if any
+	if (info->shared_area >= 0 && info->shared_area_size > 0) {
+		fSharedArea = clone_area("port shared area",
+			(void**)&fSharedAreaAddress,
+#ifdef _KERNEL_MODE
+			B_ANY_KERNEL_ADDRESS, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA,
+#else
+			B_ANY_ADDRESS, B_READ_AREA | B_WRITE_AREA,
+#endif
+			info->shared_area);
+		if (fSharedArea < 0) {
+			fInitStatus = fSharedArea;
+			return;
+		}
+
+		area_info areaInfo;
+		if (get_area_info(fSharedArea, &areaInfo) != B_OK
+			|| areaInfo.size < (size_t)info->shared_area_size) {
+			fInitStatus = B_BAD_VALUE;
+			return;
+		}
+		fInfo.shared_area = info->shared_area;
+		fInfo.shared_area_size = info->shared_area_size;
+	}
 	// init the info
 	fInfo.owner_port = info->owner_port;
 	fInfo.client_port = info->client_port;
@@ -92,6 +158,8 @@ Port::~Port()
 {
 	Close();
 	delete[] fBuffer;
+	if (fSharedArea >= 0)
+		delete_area(fSharedArea);
 }
 
 
@@ -148,6 +216,40 @@ Port::Unreserve(int32 endOffset)
 }
 
 
+// GetSharedBufferOffset
+int32
+Port::GetSharedBufferOffset() const
+{
+	return fOwner ? 0 : fInfo.shared_area_size / 2;
+}
+
+
+// GetSharedBufferCapacity
+int32
+Port::GetSharedBufferCapacity() const
+{
+	return fSharedAreaAddress != NULL ? fInfo.shared_area_size / 2 : 0;
+}
+
+
+// ReserveShared
+void
+Port::ReserveShared(int32 endOffset)
+{
+	if (endOffset > fSharedReservedSize)
+		fSharedReservedSize = endOffset;
+}
+
+
+// UnreserveShared
+void
+Port::UnreserveShared(int32 endOffset)
+{
+	if (endOffset < fSharedReservedSize)
+		fSharedReservedSize = endOffset;
+}
+
+
 // Send
 status_t
 Port::Send(const void* message, int32 size)
@@ -23,9 +23,11 @@ RequestAllocator::RequestAllocator(Port* port)
 	fRequest(NULL),
 	fRequestSize(0),
 	fPortReservedOffset(0),
+	fSharedReservedOffset(0),
 	fAllocatedAreaCount(0),
 	fDeferredInitInfoCount(0),
-	fRequestInPortBuffer(false)
+	fRequestInPortBuffer(false),
+	fSharedReserved(false)
 {
 	Init(port);
 }
@@ -45,6 +47,7 @@ RequestAllocator::Init(Port* port)
 		fPort = port;
 		fError = fPort->InitCheck();
 		fPortReservedOffset = fPort->ReservedSize();
+		fSharedReservedOffset = fPort->SharedReservedSize();
 	}
 	return fError;
 }
@@ -58,6 +61,9 @@ RequestAllocator::Uninit()
 	else
 		free(fRequest);
 
+	if (fSharedReserved)
+		fPort->UnreserveShared(fSharedReservedOffset);
+
 	for (int32 i = 0; i < fAllocatedAreaCount; i++)
 		delete_area(fAllocatedAreas[i]);
 	fAllocatedAreaCount = 0;
@@ -73,6 +79,9 @@ RequestAllocator::Uninit()
 	fRequest = NULL;
 	fRequestSize = 0;
 	fPortReservedOffset = 0;
+	fSharedReservedOffset = 0;
+	fRequestInPortBuffer = false;
+	fSharedReserved = false;
 }
 
 // Error
@@ -155,7 +164,8 @@ RequestAllocator::ReadRequest(bigtime_t timeout)
 
 	// relocate the request
 	fError = relocate_request(fRequest, fRequestSize, fAllocatedAreas,
-		&fAllocatedAreaCount);
+		&fAllocatedAreaCount, fPort->GetSharedArea(),
+		fPort->GetSharedAreaSize());
 	RETURN_ERROR(fError);
 }
 
@@ -230,6 +240,28 @@ RequestAllocator::AllocateAddress(Address& address, int32 size, int32 align,
 			*data = (uint8*)fRequest + offset;
 			address.SetTo(-1, offset, size);
 		}
+	} else if (size > 0
+		&& (fPort->SharedReservedSize() + 7) / 8 * 8 + size
+			<= fPort->GetSharedBufferCapacity()) {
+		// not enough room in the port's buffer, but in the shared area, which
+		// the other side has mapped already
+		int32 sharedOffset = (fPort->SharedReservedSize() + 7) / 8 * 8;
+		fPort->ReserveShared(sharedOffset + size);
+		fSharedReserved = true;
+		sharedOffset += fPort->GetSharedBufferOffset();
+		*data = (uint8*)fPort->GetSharedArea() + sharedOffset;
+		if (deferredInit) {
+			DeferredInitInfo& info
+				= fDeferredInitInfos[fDeferredInitInfoCount];
+			info.data = NULL;
+			info.area = PORT_SHARED_AREA;
+			info.offset = sharedOffset;
+			info.size = size;
+			info.inPortBuffer = false;
+			info.target = &address;
+			fDeferredInitInfoCount++;
+		} else
+			address.SetTo(PORT_SHARED_AREA, sharedOffset, size);
 	} else {
 		// not enough room in the port's buffer: we need to allocate an area
 		if (fAllocatedAreaCount >= MAX_REQUEST_ADDRESS_COUNT)
@@ -22,8 +22,8 @@ struct RequestPort::AllocatorNode {
 
 
 // constructor
-RequestPort::RequestPort(int32 size)
-	: fPort(size),
+RequestPort::RequestPort(int32 size, int32 sharedAreaSize)
+	: fPort(size, sharedAreaSize),
 	  fCurrentAllocatorNode(NULL)
 {
 }
@@ -196,6 +196,19 @@ RequestPort::ReleaseRequest(Request* request)
 	}
 }
 
+// NeedsReceipt
+//
+// Returns whether the sender of the given received request waits for a
+// receipt-ack. That's only the case, when the request refers to data in areas
+// the sender had to allocate for it.
+bool
+RequestPort::NeedsReceipt(Request* request) const
+{
+	return request && fCurrentAllocatorNode
+		&& request == fCurrentAllocatorNode->allocator.GetRequest()
+		&& fCurrentAllocatorNode->allocator.HasAreas();
+}
+
 // _PopAllocator
 void
 RequestPort::_PopAllocator()
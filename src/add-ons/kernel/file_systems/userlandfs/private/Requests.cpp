@@ -407,10 +407,13 @@ is_error_reply(ReplyRequest* request)
 
 // RequestRelocator
 struct RequestRelocator {
-	RequestRelocator(int32 requestBufferSize, area_id* areas, int32* count)
+	RequestRelocator(int32 requestBufferSize, area_id* areas, int32* count,
+		void* sharedArea, int32 sharedAreaSize)
 		: fRequestBufferSize(requestBufferSize),
 		  fAreas(areas),
-		  fAreaCount(count)
+		  fAreaCount(count),
+		  fSharedArea((uint8*)sharedArea),
+		  fSharedAreaSize(sharedAreaSize)
 	{
 		*fAreaCount = 0;
 	}
@@ -453,7 +456,12 @@ struct RequestRelocator {
 				RETURN_ERROR(B_BAD_DATA);
 			// relocate
 			area_id area = address->GetArea();
-			if (area < 0) {
+			if (area == PORT_SHARED_AREA) {
+				// data in the port's shared area
+				if (fSharedArea == NULL || offset + size > fSharedAreaSize)
+					RETURN_ERROR(B_BAD_DATA);
+				address->SetRelocatedAddress(fSharedArea + offset);
+			} else if (area < 0) {
 				// data in the buffer itself
 				if (offset == 0 && size == 0) {
 //PRINT(("    -> relocated address: NULL\n"));
@@ -503,17 +511,20 @@ private:
 	int32		fRequestBufferSize;
 	area_id*	fAreas;
 	int32*		fAreaCount;
+	uint8*		fSharedArea;
+	int32		fSharedAreaSize;
 	bool		fSuccess;
 };
 
 // relocate_request
 status_t
 UserlandFSUtil::relocate_request(Request* request, int32 requestBufferSize,
-	area_id* areas, int32* count)
+	area_id* areas, int32* count, void* sharedArea, int32 sharedAreaSize)
 {
 	if (!request || !areas || !count)
 		return B_BAD_VALUE;
-	RequestRelocator task(requestBufferSize, areas, count);
+	RequestRelocator task(requestBufferSize, areas, count, sharedArea,
+		sharedAreaSize);
 	return do_for_request(request, task);
 }
 
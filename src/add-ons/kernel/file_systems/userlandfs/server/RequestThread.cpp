@@ -85,7 +85,8 @@ RequestThread::Init(FileSystem* fileSystem)
 	if (!fileSystem)
 		return B_BAD_VALUE;
 	// create the port
-	fPort = new(std::nothrow) RequestPort(kRequestPortSize);
+	fPort = new(std::nothrow) RequestPort(kRequestPortSize,
+		kRequestPortSharedAreaSize);
 	if (!fPort)
 		return B_NO_MEMORY;
 	status_t error = fPort->InitCheck();
@@ -24,11 +24,14 @@ private:
 extern ServerSettings gServerSettings;
 
 static const int32 kRequestPortSize = B_PAGE_SIZE;
+static const int32 kRequestPortSharedAreaSize = 1024 * 1024;
+	// read/write data up to half that size are passed without extra areas
 
 }	// namespace UserlandFS
 
 using UserlandFS::ServerSettings;
 using UserlandFS::gServerSettings;
 using UserlandFS::kRequestPortSize;
+using UserlandFS::kRequestPortSharedAreaSize;
 
 #endif	// USERLAND_FS_SERVER_DEFS_H
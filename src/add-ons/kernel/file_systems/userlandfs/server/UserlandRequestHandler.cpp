@@ -2476,7 +2476,10 @@ status_t
 UserlandRequestHandler::_SendReply(RequestAllocator& allocator,
 	bool expectsReceipt)
 {
-	if (expectsReceipt) {
+	// Only data in areas of our own need to be kept alive until the kernel has
+	// cloned them. The port's shared area won't be touched again before the
+	// kernel sends the next request.
+	if (expectsReceipt && allocator.HasAreas()) {
 		SingleReplyRequestHandler handler(RECEIPT_ACK_REPLY);
 		return fPort->SendRequest(&allocator, &handler);
 	} else
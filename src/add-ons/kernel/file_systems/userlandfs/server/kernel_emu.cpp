@@ -790,10 +790,12 @@ UserlandFS::KernelEmu::file_cache_read(dev_t mountID, ino_t vnodeID,
 		memcpy(bufferBase, reply->buffer.GetData(), reply->buffer.GetSize());
 
 		// send receipt-ack
-		RequestAllocator receiptAckAllocator(port->GetPort());
-		ReceiptAckReply* receiptAck;
-		if (AllocateRequest(receiptAckAllocator, &receiptAck) == B_OK)
-			port->SendRequest(&receiptAckAllocator);
+		if (port->NeedsReceipt(reply)) {
+			RequestAllocator receiptAckAllocator(port->GetPort());
+			ReceiptAckReply* receiptAck;
+			if (AllocateRequest(receiptAckAllocator, &receiptAck) == B_OK)
+				port->SendRequest(&receiptAckAllocator);
+		}
 	}
 
 	*_size = reply->bytesRead;
@@ -931,10 +933,12 @@ UserlandFS::KernelEmu::read_from_io_request(dev_t volumeID, int32 requestID,
 	memcpy(buffer, reply->buffer.GetData(), reply->buffer.GetSize());
 
 	// send receipt-ack
-	RequestAllocator receiptAckAllocator(port->GetPort());
-	ReceiptAckReply* receiptAck;
-	if (AllocateRequest(receiptAckAllocator, &receiptAck) == B_OK)
-		port->SendRequest(&receiptAckAllocator);
+	if (port->NeedsReceipt(reply)) {
+		RequestAllocator receiptAckAllocator(port->GetPort());
+		ReceiptAckReply* receiptAck;
+		if (AllocateRequest(receiptAckAllocator, &receiptAck) == B_OK)
+			port->SendRequest(&receiptAckAllocator);
+	}
 
 	return B_OK;
 }
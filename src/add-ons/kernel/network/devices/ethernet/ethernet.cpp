@@ -34,6 +34,7 @@ struct ethernet_device : net_device, DoublyLinkedListLinkImpl<ethernet_device> {
 	int		fd;
 	uint32	frame_size;
 	bool	supports_net_buffer;
+	bool	supports_net_buffer_batch;
 };
 
 static const bigtime_t kLinkCheckInterval = 1000000;
@@ -193,6 +194,11 @@ ethernet_up(net_device *_device)
 		if (errno == B_BAD_DATA)
 			device->supports_net_buffer = true;
 	}
+	if (device->supports_net_buffer
+		&& ioctl(device->fd, ETHER_RECEIVE_NET_BUFFERS, NULL, 0) != 0
+		&& errno == B_BAD_DATA) {
+		device->supports_net_buffer_batch = true;
+	}
 
 	if (ioctl(device->fd, ETHER_GETFRAMESIZE, &device->frame_size, sizeof(uint32)) < 0) {
 		// this call is obviously optional
@@ -376,6 +382,34 @@ err:
 }
 
 
+status_t
+ethernet_receive_data_batch(net_device *_device, net_buffer **_buffers,
+	uint32 *_count)
+{
+	ethernet_device *device = (ethernet_device *)_device;
+
+	if (device->fd == -1)
+		return B_FILE_ERROR;
+
+	if (!device->supports_net_buffer_batch) {
+		status_t status = ethernet_receive_data(device, &_buffers[0]);
+		if (status == B_OK)
+			*_count = 1;
+		return status;
+	}
+
+	ether_receive_net_buffers_t request;
+	request.buffers = _buffers;
+	request.count = *_count;
+	if (ioctl(device->fd, ETHER_RECEIVE_NET_BUFFERS, &request,
+			sizeof(request)) != 0)
+		return errno;
+
+	*_count = request.count;
+	return B_OK;
+}
+
+
 status_t
 ethernet_set_mtu(net_device *_device, size_t mtu)
 {
@@ -509,6 +543,7 @@ net_device_module_info sEthernetModule = {
 	ethernet_set_media,
 	ethernet_add_multicast,
 	ethernet_remove_multicast,
+	ethernet_receive_data_batch,
 };
 
 module_info *modules[] = {
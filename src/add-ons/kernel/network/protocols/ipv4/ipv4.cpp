@@ -1719,8 +1719,11 @@ ipv4_get_mtu(net_protocol* protocol, const struct sockaddr* address)
 }
 
 
-status_t
-ipv4_receive_data(net_buffer* buffer)
+/*!	Processes a single incoming buffer. If \a deliverRaw is false, raw sockets
+	are known not to exist, and are not looked at.
+*/
+static status_t
+receive_data(net_buffer* buffer, bool deliverRaw)
 {
 	TRACE("ipv4_receive_data(%p [%" B_PRIu32 " bytes])", buffer, buffer->size);
 
@@ -1832,7 +1835,7 @@ ipv4_receive_data(net_buffer* buffer)
 	// this point
 	}
 
-	bool rawDelivered = raw_receive_data(buffer);
+	bool rawDelivered = deliverRaw && raw_receive_data(buffer);
 
 	// Preserve the ipv4 header for ICMP processing
 	gBufferModule->store_header(buffer);
@@ -1864,6 +1867,35 @@ ipv4_receive_data(net_buffer* buffer)
 }
 
 
+status_t
+ipv4_receive_data(net_buffer* buffer)
+{
+	return receive_data(buffer, true);
+}
+
+
+/*!	Processes a batch of incoming buffers, as handed over by the device
+	interface. The raw socket list is only looked at once for the whole batch.
+	All buffers are consumed.
+*/
+status_t
+ipv4_receive_data_batch(net_buffer** buffers, size_t count)
+{
+	bool hasRawSockets;
+	{
+		MutexLocker locker(sRawSocketsLock);
+		hasRawSockets = !sRawSockets.IsEmpty();
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (receive_data(buffers[i], hasRawSockets) != B_OK)
+			gBufferModule->free(buffers[i]);
+	}
+
+	return B_OK;
+}
+
+
 status_t
 ipv4_deliver_data(net_protocol* _protocol, net_buffer* buffer)
 {
@@ -2114,7 +2146,9 @@ net_protocol_module_info gIPv4Module = {
 	NULL,		// process_ancillary_data()
 	ipv4_process_ancillary_data_no_container,
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	NULL,		// read_data_batch()
+	ipv4_receive_data_batch
 };
 
 module_dependency module_dependencies[] = {
@@ -1791,7 +1791,9 @@ net_protocol_module_info gIPv6Module = {
 	NULL,		// process_ancillary_data()
 	ipv6_process_ancillary_data_no_container,
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	NULL,		// read_data_batch()
+	NULL		// receive_data_batch()
 };
 
 module_dependency module_dependencies[] = {
@@ -133,6 +133,11 @@ protected:
 static const uint16 kLastReservedPort = 1023;
 static const uint16 kFirstEphemeralPort = 40000;
 
+static const int32 kMaxSynCacheEntries = 1024;
+static const uint8 kMaxSynCacheRetransmits = 3;
+static const int32 kMaxTimeWaitEntries = 65536;
+static const bigtime_t kCacheTimerInterval = 250000;
+
 
 ConnectionHashDefinition::ConnectionHashDefinition(EndpointManager* manager)
 	:
@@ -214,18 +219,121 @@ EndpointHashDefinition::GetLink(TCPEndpoint* endpoint) const
 //	#pragma mark -
 
 
+size_t
+CompactConnectionHashDefinition::HashKey(const KeyType& key) const
+{
+	return ConstSocketAddress(fManager->AddressModule(),
+		key.first).HashPair(key.second);
+}
+
+
+size_t
+CompactConnectionHashDefinition::Hash(CompactConnection* connection) const
+{
+	return ConstSocketAddress(fManager->AddressModule(),
+		connection->Local()).HashPair(connection->Peer());
+}
+
+
+bool
+CompactConnectionHashDefinition::Compare(const KeyType& key,
+	CompactConnection* connection) const
+{
+	net_address_module_info* addressModule = fManager->AddressModule();
+
+	return ConstSocketAddress(addressModule, connection->Local()).EqualTo(
+			key.first, true)
+		&& ConstSocketAddress(addressModule, connection->Peer()).EqualTo(
+			key.second, true);
+}
+
+
+CompactConnection*&
+CompactConnectionHashDefinition::GetLink(CompactConnection* connection) const
+{
+	return connection->hashLink;
+}
+
+
+//	#pragma mark -
+
+
+size_t
+TimeWaitPortHashDefinition::HashKey(uint16 port) const
+{
+	return port;
+}
+
+
+size_t
+TimeWaitPortHashDefinition::Hash(TimeWaitEntry* entry) const
+{
+	// for IPv4 and IPv6 the port is at the same offset
+	return entry->local.sin6_port;
+}
+
+
+bool
+TimeWaitPortHashDefinition::Compare(uint16 port, TimeWaitEntry* entry) const
+{
+	return entry->local.sin6_port == port;
+}
+
+
+bool
+TimeWaitPortHashDefinition::CompareValues(TimeWaitEntry* first,
+	TimeWaitEntry* second) const
+{
+	return first->local.sin6_port == second->local.sin6_port;
+}
+
+
+TimeWaitEntry*&
+TimeWaitPortHashDefinition::GetLink(TimeWaitEntry* entry) const
+{
+	return entry->portHashLink;
+}
+
+
+//	#pragma mark -
+
+
 EndpointManager::EndpointManager(net_domain* domain)
 	:
 	fDomain(domain),
 	fConnectionHash(this),
-	fLastPort(kFirstEphemeralPort)
+	fLastPort(kFirstEphemeralPort),
+	fTimeWaitHash(this),
+	fTimeWaitCount(0),
+	fSynCacheHash(this),
+	fSynCacheCount(0),
+	fCacheTimerScheduled(0),
+	fShuttingDown(false)
 {
 	rw_lock_init(&fLock, "TCP endpoint manager");
+	mutex_init(&fSynCacheLock, "TCP SYN cache");
+	gStackModule->init_timer(&fCacheTimer, &_CacheTimer, this);
 }
 
 
 EndpointManager::~EndpointManager()
 {
+	// the timer re-arms itself, so it has to be stopped from doing that
+	// before it can be canceled for good
+	{
+		WriteLocker _(fLock);
+		fShuttingDown = true;
+	}
+
+	gStackModule->cancel_timer(&fCacheTimer);
+	gStackModule->wait_for_timer(&fCacheTimer);
+
+	while (CompactConnection* connection = fTimeWaitList.RemoveHead())
+		delete static_cast<TimeWaitEntry*>(connection);
+	while (CompactConnection* connection = fSynCacheList.RemoveHead())
+		delete static_cast<SynCacheEntry*>(connection);
+
+	mutex_destroy(&fSynCacheLock);
 	rw_lock_destroy(&fLock);
 }
 
@@ -236,6 +344,12 @@ EndpointManager::Init()
 	status_t status = fConnectionHash.Init();
 	if (status == B_OK)
 		status = fEndpointHash.Init();
+	if (status == B_OK)
+		status = fTimeWaitHash.Init();
+	if (status == B_OK)
+		status = fTimeWaitPortHash.Init();
+	if (status == B_OK)
+		status = fSynCacheHash.Init();
 
 	return status;
 }
@@ -263,6 +377,11 @@ EndpointManager::SetConnection(TCPEndpoint* endpoint, const sockaddr* _local,
 
 	WriteLocker _(fLock);
 
+	if (endpoint->fReusePortGroup != NULL) {
+		// a listening endpoint is about to connect
+		_LeaveReusePortGroup(endpoint);
+	}
+
 	SocketAddressStorage local(AddressModule());
 	local.SetTo(_local);
 
@@ -277,6 +396,13 @@ EndpointManager::SetConnection(TCPEndpoint* endpoint, const sockaddr* _local,
 	if (_LookupConnection(*local, peer) != NULL)
 		return EADDRINUSE;
 
+	// A pair that is only remembered in TIME_WAIT may be reused right away,
+	// as our initial sequence numbers are always increasing
+	TimeWaitEntry* timeWait = static_cast<TimeWaitEntry*>(
+		fTimeWaitHash.Lookup(std::make_pair(*local, peer)));
+	if (timeWait != NULL)
+		_RemoveTimeWait(timeWait);
+
 	endpoint->LocalAddress().SetTo(*local);
 	endpoint->PeerAddress().SetTo(peer);
 	T(Connect(endpoint));
@@ -319,8 +445,25 @@ EndpointManager::SetPassive(TCPEndpoint* endpoint)
 	SocketAddressStorage passive(AddressModule());
 	passive.SetToEmpty();
 
-	if (_LookupConnection(*endpoint->LocalAddress(), *passive))
-		return EADDRINUSE;
+	TCPEndpoint* listener = _LookupConnection(*endpoint->LocalAddress(),
+		*passive);
+	if (listener != NULL) {
+		// Only listeners of the same user that all asked for SO_REUSEPORT
+		// may share an address
+		if (listener->fReusePortGroup == NULL
+			|| (endpoint->socket->options & SO_REUSEPORT) == 0
+			|| listener->fReusePortGroup->owner != geteuid())
+			return EADDRINUSE;
+
+		endpoint->PeerAddress().SetTo(*passive);
+		return _JoinReusePortGroup(listener, endpoint);
+	}
+
+	if ((endpoint->socket->options & SO_REUSEPORT) != 0) {
+		status_t status = _JoinReusePortGroup(NULL, endpoint);
+		if (status != B_OK)
+			return status;
+	}
 
 	endpoint->PeerAddress().SetTo(*passive);
 	fConnectionHash.Insert(endpoint);
@@ -350,6 +493,7 @@ EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 	if (endpoint != NULL) {
 		TRACE(("TCP: Received packet corresponds to wildcard endpoint %p\n",
 			endpoint));
+		endpoint = _SelectListener(endpoint, local, peer);
 		if (gSocketModule->acquire_socket(endpoint->socket))
 			return endpoint;
 	}
@@ -362,6 +506,7 @@ EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 	if (endpoint != NULL) {
 		TRACE(("TCP: Received packet corresponds to local wildcard endpoint "
 			"%p\n", endpoint));
+		endpoint = _SelectListener(endpoint, local, peer);
 		if (gSocketModule->acquire_socket(endpoint->socket))
 			return endpoint;
 	}
@@ -373,6 +518,83 @@ EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 }
 
 
+/*!	Picks the member of the SO_REUSEPORT group \a endpoint belongs to that
+	should handle the connection (\a local, \a peer). The choice only depends
+	on the flow hash, so that all segments of a connection end up at the same
+	listener.
+	You must hold the manager's lock when calling this method (either read or
+	write).
+*/
+TCPEndpoint*
+EndpointManager::_SelectListener(TCPEndpoint* endpoint, const sockaddr* local,
+	const sockaddr* peer)
+{
+	ReusePortGroup* group = endpoint->fReusePortGroup;
+	if (group == NULL || group->members.Count() < 2)
+		return endpoint;
+
+	int32 count = group->members.Count();
+	size_t hash = ConstSocketAddress(AddressModule(), local).HashPair(peer);
+
+	for (int32 i = 0; i < count; i++) {
+		TCPEndpoint* member = group->members.ElementAt((hash + i) % count);
+
+		// Skip members that have already been closed, but are not gone yet
+		if (member->State() == LISTEN)
+			return member;
+	}
+
+	return endpoint;
+}
+
+
+/*!	Adds \a endpoint to the SO_REUSEPORT group of \a listener, or creates a
+	new group if \a listener is \c NULL.
+	You must have fLock write locked when calling this method.
+*/
+status_t
+EndpointManager::_JoinReusePortGroup(TCPEndpoint* listener,
+	TCPEndpoint* endpoint)
+{
+	ReusePortGroup* group;
+	if (listener == NULL) {
+		group = new(std::nothrow) ReusePortGroup(geteuid());
+		if (group == NULL)
+			return B_NO_MEMORY;
+	} else
+		group = listener->fReusePortGroup;
+
+	status_t status = group->members.PushBack(endpoint);
+	if (status != B_OK) {
+		if (listener == NULL)
+			delete group;
+		return status;
+	}
+
+	endpoint->fReusePortGroup = group;
+	return B_OK;
+}
+
+
+/*! You must have fLock write locked when calling this method. */
+void
+EndpointManager::_LeaveReusePortGroup(TCPEndpoint* endpoint)
+{
+	ReusePortGroup* group = endpoint->fReusePortGroup;
+	endpoint->fReusePortGroup = NULL;
+
+	group->members.Remove(endpoint);
+
+	// If the endpoint represented the group in the connection hash, another
+	// member has to take over
+	if (fConnectionHash.Remove(endpoint) && !group->members.IsEmpty())
+		fConnectionHash.Insert(group->members.ElementAt(0));
+
+	if (group->members.IsEmpty())
+		delete group;
+}
+
+
 //	#pragma mark - endpoints
 
 
@@ -448,6 +670,13 @@ EndpointManager::_BindToAddress(WriteLocker& locker, TCPEndpoint* endpoint,
 					break;
 				}
 
+				// Sockets that both asked for it may share the very same
+				// address; only listening on it is restricted to one user
+				if ((endpoint->socket->options & SO_REUSEPORT) != 0
+					&& (user->socket->options & SO_REUSEPORT) != 0
+					&& address.EqualTo(*user->LocalAddress(), false))
+					continue;
+
 				if ((endpoint->socket->options & SO_REUSEADDR) == 0)
 					return EADDRINUSE;
 
@@ -457,6 +686,10 @@ EndpointManager::_BindToAddress(WriteLocker& locker, TCPEndpoint* endpoint,
 		}
 	} while (retry-- > 0);
 
+	if ((endpoint->socket->options & SO_REUSEADDR) == 0
+		&& _IsAddressInTimeWait(address))
+		return EADDRINUSE;
+
 	return _Bind(endpoint, *address);
 }
 
@@ -483,7 +716,8 @@ EndpointManager::_BindToEphemeral(TCPEndpoint* endpoint,
 			fLastPort = port;
 			port = htons(port);
 
-			if (!fEndpointHash.Lookup(port).HasNext()) {
+			if (!fEndpointHash.Lookup(port).HasNext()
+				&& !_IsPortInTimeWait(port)) {
 				// found a port
 				SocketAddressStorage newAddress(AddressModule());
 				newAddress.SetTo(address);
@@ -506,6 +740,33 @@ EndpointManager::_BindToEphemeral(TCPEndpoint* endpoint,
 }
 
 
+/*! You must hold fLock when calling this method (either read or write). */
+bool
+EndpointManager::_IsPortInTimeWait(uint16 port) const
+{
+	return fTimeWaitPortHash.Lookup(port).HasNext();
+}
+
+
+/*!	Returns whether or not a connection in TIME_WAIT state uses the given
+	local address.
+	You must hold fLock when calling this method (either read or write).
+*/
+bool
+EndpointManager::_IsAddressInTimeWait(const ConstSocketAddress& address) const
+{
+	TimeWaitPortTable::ValueIterator iterator
+		= fTimeWaitPortHash.Lookup(address.Port());
+	while (iterator.HasNext()) {
+		TimeWaitEntry* entry = iterator.Next();
+		if (address.IsEmpty(false) || address.EqualTo(entry->Local(), false))
+			return true;
+	}
+
+	return false;
+}
+
+
 status_t
 EndpointManager::_Bind(TCPEndpoint* endpoint, const sockaddr* address)
 {
@@ -532,8 +793,14 @@ EndpointManager::Unbind(TCPEndpoint* endpoint)
 		return B_BAD_VALUE;
 	}
 
+	// SYN cache entries refer to their listening endpoint
+	PurgeSynCache(endpoint);
+
 	WriteLocker _(fLock);
 
+	if (endpoint->fReusePortGroup != NULL)
+		_LeaveReusePortGroup(endpoint);
+
 	if (!fEndpointHash.Remove(endpoint))
 		panic("bound endpoint %p not in hash!", endpoint);
 
@@ -583,6 +850,419 @@ EndpointManager::ReplyWithReset(tcp_segment_header& segment, net_buffer* buffer)
 }
 
 
+//	#pragma mark - SYN cache
+
+
+/*!	Remembers a connection request received by a listening endpoint, and
+	answers it with a SYN+ACK, unless \a acknowledge is \c false. The full
+	endpoint is only created once the handshake completes, see
+	TCPEndpoint::_SpawnFromSynCache().
+	Returns \c B_BUSY if the listening endpoint already has as many
+	half-open connections as its backlog allows.
+*/
+status_t
+EndpointManager::AddToSynCache(const SynCacheEntry& entry, bool acknowledge)
+{
+	MutexLocker locker(fSynCacheLock);
+
+	SynCacheEntry* cached = static_cast<SynCacheEntry*>(fSynCacheHash.Lookup(
+		std::make_pair(entry.Local(), entry.Peer())));
+	if (cached != NULL) {
+		if (cached->initialReceiveSequence == entry.initialReceiveSequence) {
+			// the peer retransmitted its SYN
+			if (acknowledge)
+				_SendSynAcknowledge(cached);
+			return B_OK;
+		}
+
+		// the peer started over with a new connection request
+		_RemoveFromSynCache(cached);
+	}
+
+	if (entry.listener->fSynCacheCount >= entry.listener->fSynCacheLimit)
+		return B_BUSY;
+
+	if (fSynCacheCount >= kMaxSynCacheEntries) {
+		// make room by dropping the oldest half-open connection
+		_RemoveFromSynCache(
+			static_cast<SynCacheEntry*>(fSynCacheList.Head()));
+	}
+
+	cached = new(std::nothrow) SynCacheEntry(entry);
+	if (cached == NULL)
+		return B_NO_MEMORY;
+
+	cached->timeout = system_time() + TCP_INITIAL_RTT;
+	cached->retransmits = 0;
+
+	fSynCacheHash.Insert(cached);
+	fSynCacheList.Add(cached);
+	fSynCacheCount++;
+	cached->listener->fSynCacheCount++;
+
+	// if sending fails, the cache timer will retransmit the SYN+ACK later
+	if (acknowledge)
+		_SendSynAcknowledge(cached);
+	locker.Unlock();
+
+	_ScheduleCacheTimer();
+	return B_OK;
+}
+
+
+/*!	Copies the SYN cache entry of the (\a local, \a peer) connection into
+	\a _entry, if there is one.
+*/
+bool
+EndpointManager::LookupSynCache(const sockaddr* local, const sockaddr* peer,
+	SynCacheEntry& _entry)
+{
+	MutexLocker _(fSynCacheLock);
+
+	SynCacheEntry* cached = static_cast<SynCacheEntry*>(fSynCacheHash.Lookup(
+		std::make_pair(local, peer)));
+	if (cached == NULL)
+		return false;
+
+	_entry = *cached;
+	return true;
+}
+
+
+/*!	Removes the SYN cache entry of the (\a local, \a peer) connection and
+	copies it into \a _entry, but only if \a acknowledge acknowledges the
+	SYN+ACK that was sent for it.
+*/
+bool
+EndpointManager::TakeFromSynCache(const sockaddr* local, const sockaddr* peer,
+	tcp_sequence acknowledge, SynCacheEntry& _entry)
+{
+	MutexLocker _(fSynCacheLock);
+
+	SynCacheEntry* cached = static_cast<SynCacheEntry*>(fSynCacheHash.Lookup(
+		std::make_pair(local, peer)));
+	if (cached == NULL || acknowledge != cached->initialSendSequence + 1)
+		return false;
+
+	_entry = *cached;
+	_RemoveFromSynCache(cached);
+	return true;
+}
+
+
+void
+EndpointManager::RemoveFromSynCache(const sockaddr* local,
+	const sockaddr* peer)
+{
+	MutexLocker _(fSynCacheLock);
+
+	SynCacheEntry* cached = static_cast<SynCacheEntry*>(fSynCacheHash.Lookup(
+		std::make_pair(local, peer)));
+	if (cached != NULL)
+		_RemoveFromSynCache(cached);
+}
+
+
+/*!	Drops all half-open connections of \a listener; it must be called before
+	a listening endpoint goes away.
+*/
+void
+EndpointManager::PurgeSynCache(TCPEndpoint* listener)
+{
+	MutexLocker _(fSynCacheLock);
+
+	CompactConnectionList::Iterator iterator = fSynCacheList.GetIterator();
+	while (listener->fSynCacheCount > 0 && iterator.HasNext()) {
+		SynCacheEntry* entry = static_cast<SynCacheEntry*>(iterator.Next());
+		if (entry->listener == listener)
+			_RemoveFromSynCache(entry);
+	}
+}
+
+
+/*! You must hold fSynCacheLock when calling this method. */
+void
+EndpointManager::_RemoveFromSynCache(SynCacheEntry* entry)
+{
+	fSynCacheHash.RemoveUnchecked(entry);
+	fSynCacheList.Remove(entry);
+	fSynCacheCount--;
+	entry->listener->fSynCacheCount--;
+
+	delete entry;
+}
+
+
+/*! You must hold fSynCacheLock when calling this method. */
+status_t
+EndpointManager::_SendSynAcknowledge(const SynCacheEntry* entry)
+{
+	net_buffer* reply = gBufferModule->create(512);
+	if (reply == NULL)
+		return B_NO_MEMORY;
+
+	AddressModule()->set_to(reply->source, entry->Local());
+	AddressModule()->set_to(reply->destination, entry->Peer());
+
+	tcp_segment_header segment(TCP_FLAG_SYNCHRONIZE | TCP_FLAG_ACKNOWLEDGE);
+	segment.sequence = entry->initialSendSequence.Number();
+	segment.acknowledge = (entry->initialReceiveSequence + 1).Number();
+	segment.SetAdvertisedWindow(entry->receiveWindow, 0);
+		// the window in a SYN segment is never scaled
+	segment.urgent_offset = 0;
+	segment.max_segment_size = entry->receiveMaxSegmentSize;
+
+	if ((entry->options & TCP_HAS_WINDOW_SCALE) != 0) {
+		segment.options |= TCP_HAS_WINDOW_SCALE;
+		segment.window_shift = entry->receiveWindowShift;
+	}
+	if ((entry->options & TCP_HAS_TIMESTAMPS) != 0) {
+		segment.options |= TCP_HAS_TIMESTAMPS;
+		segment.timestamp_value = tcp_now();
+		segment.timestamp_reply = entry->receivedTimestamp;
+	}
+	if ((entry->options & TCP_SACK_PERMITTED) != 0)
+		segment.options |= TCP_SACK_PERMITTED;
+
+	status_t status = add_tcp_header(AddressModule(), segment, reply);
+	if (status == B_OK)
+		status = Domain()->module->send_data(NULL, reply);
+
+	if (status != B_OK)
+		gBufferModule->free(reply);
+
+	return status;
+}
+
+
+//	#pragma mark - TIME_WAIT
+
+
+/*!	Takes over the TIME_WAIT state of a connection whose socket has been
+	closed, so that its endpoint can be freed right away.
+*/
+status_t
+EndpointManager::AddTimeWait(const TimeWaitEntry& entry)
+{
+	WriteLocker locker(fLock);
+
+	if (fTimeWaitCount >= kMaxTimeWaitEntries)
+		return ENOBUFS;
+
+	TimeWaitEntry* timeWait = static_cast<TimeWaitEntry*>(fTimeWaitHash.Lookup(
+		std::make_pair(entry.Local(), entry.Peer())));
+	if (timeWait != NULL)
+		_RemoveTimeWait(timeWait);
+
+	timeWait = new(std::nothrow) TimeWaitEntry(entry);
+	if (timeWait == NULL)
+		return B_NO_MEMORY;
+
+	timeWait->timeout = system_time() + (TCP_MAX_SEGMENT_LIFETIME << 1);
+
+	fTimeWaitHash.Insert(timeWait);
+	fTimeWaitPortHash.Insert(timeWait);
+	fTimeWaitList.Add(timeWait);
+	atomic_add(&fTimeWaitCount, 1);
+
+	locker.Unlock();
+
+	_ScheduleCacheTimer();
+	return B_OK;
+}
+
+
+/*!	Handles a segment for a connection that is only known in TIME_WAIT
+	anymore. Returns \c false if there is no such connection, or if the
+	segment opens a new connection that may replace the old one.
+*/
+bool
+EndpointManager::TimeWaitSegmentReceived(tcp_segment_header& segment,
+	net_buffer* buffer, int32& _segmentAction)
+{
+	if (atomic_get(&fTimeWaitCount) == 0)
+		return false;
+
+	std::pair<const sockaddr*, const sockaddr*> key(
+		(const sockaddr*)buffer->destination, (const sockaddr*)buffer->source);
+
+	ReadLocker readLocker(fLock);
+
+	TimeWaitEntry* entry = static_cast<TimeWaitEntry*>(
+		fTimeWaitHash.Lookup(key));
+	if (entry == NULL)
+		return false;
+
+	TimeWaitEntry reply = *entry;
+	readLocker.Unlock();
+
+	_segmentAction = DROP;
+
+	// We generally ignore resets in time wait state (see RFC 1337)
+	if ((segment.flags & TCP_FLAG_RESET) != 0)
+		return true;
+
+	bool newer = false;
+	if ((segment.flags & (TCP_FLAG_SYNCHRONIZE | TCP_FLAG_ACKNOWLEDGE))
+			== TCP_FLAG_SYNCHRONIZE) {
+		// A new connection may take over the pair if it starts beyond the
+		// old one (RFC 1122, 4.2.2.13)
+		newer = tcp_sequence(segment.sequence) > reply.receiveNext;
+		if (reply.hasTimestamps
+			&& (segment.options & TCP_HAS_TIMESTAMPS) != 0) {
+			newer = (int32)(segment.timestamp_value
+				- reply.receivedTimestamp) > 0;
+		}
+	}
+
+	if (newer || (segment.flags & TCP_FLAG_FINISH) != 0) {
+		// Only take the write lock when the entry has to be changed; the
+		// entry might have expired in the mean time
+		WriteLocker writeLocker(fLock);
+
+		entry = static_cast<TimeWaitEntry*>(fTimeWaitHash.Lookup(key));
+		if (newer) {
+			if (entry != NULL)
+				_RemoveTimeWait(entry);
+			return false;
+		}
+		if (entry == NULL)
+			return true;
+
+		// our last ACK got lost - restart the 2MSL timeout
+		entry->timeout = system_time() + (TCP_MAX_SEGMENT_LIFETIME << 1);
+		fTimeWaitList.Remove(entry);
+		fTimeWaitList.Add(entry);
+	}
+
+	if ((segment.flags & (TCP_FLAG_FINISH | TCP_FLAG_SYNCHRONIZE)) == 0
+		&& buffer->size == 0) {
+		// don't answer pure acknowledgements
+		return true;
+	}
+
+	_ReplyFromTimeWait(&reply, segment);
+	return true;
+}
+
+
+status_t
+EndpointManager::_ReplyFromTimeWait(const TimeWaitEntry* entry,
+	tcp_segment_header& segment)
+{
+	net_buffer* reply = gBufferModule->create(512);
+	if (reply == NULL)
+		return B_NO_MEMORY;
+
+	AddressModule()->set_to(reply->source, entry->Local());
+	AddressModule()->set_to(reply->destination, entry->Peer());
+
+	tcp_segment_header outSegment(TCP_FLAG_ACKNOWLEDGE);
+	outSegment.sequence = entry->sendNext.Number();
+	outSegment.acknowledge = entry->receiveNext.Number();
+	outSegment.advertised_window = 0;
+	outSegment.urgent_offset = 0;
+
+	if (entry->hasTimestamps) {
+		outSegment.options |= TCP_HAS_TIMESTAMPS;
+		outSegment.timestamp_value = tcp_now();
+		outSegment.timestamp_reply = (segment.options & TCP_HAS_TIMESTAMPS) != 0
+			? segment.timestamp_value : entry->receivedTimestamp;
+	}
+
+	status_t status = add_tcp_header(AddressModule(), outSegment, reply);
+	if (status == B_OK)
+		status = Domain()->module->send_data(NULL, reply);
+
+	if (status != B_OK)
+		gBufferModule->free(reply);
+
+	return status;
+}
+
+
+/*! You must have fLock write locked when calling this method. */
+void
+EndpointManager::_RemoveTimeWait(TimeWaitEntry* entry)
+{
+	fTimeWaitHash.Remove(entry);
+	fTimeWaitPortHash.Remove(entry);
+	fTimeWaitList.Remove(entry);
+	atomic_add(&fTimeWaitCount, -1);
+
+	delete entry;
+}
+
+
+//	#pragma mark - cache timer
+
+
+void
+EndpointManager::_ScheduleCacheTimer()
+{
+	if (atomic_get_and_set(&fCacheTimerScheduled, 1) == 0)
+		gStackModule->set_timer(&fCacheTimer, kCacheTimerInterval);
+}
+
+
+/*!	Retransmits the SYN+ACKs of the SYN cache, and expires its entries as
+	well as those of connections in TIME_WAIT. The timer is only running as
+	long as there are any entries.
+*/
+/*static*/ void
+EndpointManager::_CacheTimer(net_timer* timer, void* _manager)
+{
+	EndpointManager* manager = (EndpointManager*)_manager;
+	bigtime_t now = system_time();
+
+	{
+		MutexLocker locker(manager->fSynCacheLock);
+
+		CompactConnectionList::Iterator iterator
+			= manager->fSynCacheList.GetIterator();
+		while (iterator.HasNext()) {
+			SynCacheEntry* entry = static_cast<SynCacheEntry*>(
+				iterator.Next());
+			if (entry->timeout > now)
+				continue;
+
+			if (entry->retransmits >= kMaxSynCacheRetransmits) {
+				manager->_RemoveFromSynCache(entry);
+				continue;
+			}
+
+			entry->retransmits++;
+			entry->timeout = now + (TCP_INITIAL_RTT << entry->retransmits);
+			manager->_SendSynAcknowledge(entry);
+		}
+	}
+
+	{
+		WriteLocker locker(manager->fLock);
+
+		// the list is sorted by timeout
+		while (CompactConnection* connection
+				= manager->fTimeWaitList.Head()) {
+			if (connection->timeout > now)
+				break;
+
+			manager->_RemoveTimeWait(static_cast<TimeWaitEntry*>(connection));
+		}
+
+		atomic_set(&manager->fCacheTimerScheduled, 0);
+
+		if (!manager->fShuttingDown
+			&& (atomic_get(&manager->fSynCacheCount) > 0
+				|| atomic_get(&manager->fTimeWaitCount) > 0)) {
+			manager->_ScheduleCacheTimer();
+		}
+	}
+}
+
+
+//	#pragma mark -
+
+
 void
 EndpointManager::Dump() const
 {
@@ -602,6 +1282,40 @@ EndpointManager::Dump() const
 		kprintf("%p %21s %21s %8lu %8lu %12s\n", endpoint, localBuf, peerBuf,
 			endpoint->fReceiveQueue.Available(), endpoint->fSendQueue.Used(),
 			name_for_state(endpoint->State()));
+
+		ReusePortGroup* group = endpoint->fReusePortGroup;
+		if (group == NULL)
+			continue;
+
+		for (int32 i = 0; i < group->members.Count(); i++) {
+			TCPEndpoint* member = group->members.ElementAt(i);
+			if (member == endpoint)
+				continue;
+
+			kprintf("%p %21s %21s %8lu %8lu %12s (reuseport)\n", member,
+				localBuf, peerBuf, member->fReceiveQueue.Available(),
+				member->fSendQueue.Used(), name_for_state(member->State()));
+		}
 	}
+
+	CompactConnectionList::ConstIterator timeWaitIterator
+		= fTimeWaitList.GetIterator();
+	while (timeWaitIterator.HasNext()) {
+		const CompactConnection* connection = timeWaitIterator.Next();
+
+		char localBuf[64], peerBuf[64];
+		ConstSocketAddress(AddressModule(), connection->Local()).AsString(
+			localBuf, sizeof(localBuf), true);
+		ConstSocketAddress(AddressModule(), connection->Peer()).AsString(
+			peerBuf, sizeof(peerBuf), true);
+
+		kprintf("%p %21s %21s %8s %8s %12s\n", connection, localBuf, peerBuf,
+			"-", "-", name_for_state(TIME_WAIT));
+	}
+
+	kprintf("%" B_PRId32 " connections in time-wait (%" B_PRIuSIZE
+		" bytes each), %" B_PRId32 " in SYN cache (%" B_PRIuSIZE
+		" bytes each)\n", fTimeWaitCount, sizeof(TimeWaitEntry),
+		fSynCacheCount, sizeof(SynCacheEntry));
 }
 
@@ -19,6 +19,9 @@
 #include <util/DoublyLinkedList.h>
 #include <util/MultiHashTable.h>
 #include <util/OpenHashTable.h>
+#include <util/Vector.h>
+
+#include <netinet6/in6.h>
 
 #include <utility>
 
@@ -66,6 +69,99 @@ public:
 };
 
 
+/*!	The minimal state of a connection that is not backed by a TCPEndpoint.
+	The address storage is large enough for all domains TCP runs on.
+*/
+struct CompactConnection : DoublyLinkedListLinkImpl<CompactConnection> {
+	sockaddr_in6			local;
+	sockaddr_in6			peer;
+	CompactConnection*		hashLink;
+	bigtime_t				timeout;
+
+	const sockaddr*			Local() const { return (const sockaddr*)&local; }
+	const sockaddr*			Peer() const { return (const sockaddr*)&peer; }
+};
+
+
+/*!	A half-open connection that has been answered with a SYN+ACK by a
+	listening endpoint, but for which the final ACK is still missing.
+*/
+struct SynCacheEntry : CompactConnection {
+	TCPEndpoint*			listener;
+	tcp_sequence			initialSendSequence;
+	tcp_sequence			initialReceiveSequence;
+	uint32					receiveWindow;
+	uint32					receivedTimestamp;
+	uint32					options;
+	uint16					sendMaxSegmentSize;
+	uint16					receiveMaxSegmentSize;
+	uint8					sendWindowShift;
+	uint8					receiveWindowShift;
+	uint8					retransmits;
+};
+
+
+/*!	A connection in TIME_WAIT state whose socket has already been closed. */
+struct TimeWaitEntry : CompactConnection {
+	TimeWaitEntry*			portHashLink;
+	tcp_sequence			sendNext;
+	tcp_sequence			receiveNext;
+	uint32					receivedTimestamp;
+	bool					hasTimestamps;
+};
+
+
+class CompactConnectionHashDefinition {
+public:
+	typedef std::pair<const sockaddr*, const sockaddr*> KeyType;
+	typedef CompactConnection ValueType;
+
+							CompactConnectionHashDefinition(
+								EndpointManager* manager)
+								: fManager(manager)
+							{
+							}
+
+			size_t			HashKey(const KeyType& key) const;
+			size_t			Hash(CompactConnection* connection) const;
+			bool			Compare(const KeyType& key,
+								CompactConnection* connection) const;
+			CompactConnection*& GetLink(CompactConnection* connection) const;
+
+private:
+	EndpointManager*		fManager;
+};
+
+
+class TimeWaitPortHashDefinition {
+public:
+	typedef uint16 KeyType;
+	typedef TimeWaitEntry ValueType;
+
+			size_t			HashKey(uint16 port) const;
+			size_t			Hash(TimeWaitEntry* entry) const;
+			bool			Compare(uint16 port, TimeWaitEntry* entry) const;
+			bool			CompareValues(TimeWaitEntry* first,
+								TimeWaitEntry* second) const;
+			TimeWaitEntry*&	GetLink(TimeWaitEntry* entry) const;
+};
+
+
+/*!	A set of listening endpoints that share the same local address by means
+	of SO_REUSEPORT. Only one of them is in the connection hash; incoming
+	connections are distributed over all members by their flow hash.
+*/
+struct ReusePortGroup {
+							ReusePortGroup(uid_t owner)
+								: owner(owner)
+							{
+							}
+
+	uid_t					owner;
+	Vector<TCPEndpoint*>	members;
+};
+
+
 class EndpointManager : public DoublyLinkedListLinkImpl<EndpointManager> {
 public:
 							EndpointManager(net_domain* domain);
@@ -89,6 +185,22 @@ public:
 			status_t		ReplyWithReset(tcp_segment_header& segment,
 								net_buffer* buffer);
 
+			status_t		AddToSynCache(const SynCacheEntry& entry,
+								bool acknowledge = true);
+			bool			LookupSynCache(const sockaddr* local,
+								const sockaddr* peer, SynCacheEntry& _entry);
+			bool			TakeFromSynCache(const sockaddr* local,
+								const sockaddr* peer, tcp_sequence acknowledge,
+								SynCacheEntry& _entry);
+			void			RemoveFromSynCache(const sockaddr* local,
+								const sockaddr* peer);
+			void			PurgeSynCache(TCPEndpoint* listener);
+
+			status_t		AddTimeWait(const TimeWaitEntry& entry);
+			bool			TimeWaitSegmentReceived(
+								tcp_segment_header& segment,
+								net_buffer* buffer, int32& _segmentAction);
+
 			net_domain*		Domain() const { return fDomain; }
 			net_address_module_info* AddressModule() const
 								{ return Domain()->address_module; }
@@ -98,21 +210,59 @@ public:
 private:
 			TCPEndpoint*	_LookupConnection(const sockaddr* local,
 								const sockaddr* peer);
+			TCPEndpoint*	_SelectListener(TCPEndpoint* endpoint,
+								const sockaddr* local, const sockaddr* peer);
+			status_t		_JoinReusePortGroup(TCPEndpoint* listener,
+								TCPEndpoint* endpoint);
+			void			_LeaveReusePortGroup(TCPEndpoint* endpoint);
 			status_t		_Bind(TCPEndpoint* endpoint,
 								const sockaddr* address);
 			status_t		_BindToAddress(WriteLocker& locker,
 								TCPEndpoint* endpoint, const sockaddr* address);
 			status_t		_BindToEphemeral(TCPEndpoint* endpoint,
 								const sockaddr* address);
+			bool			_IsPortInTimeWait(uint16 port) const;
+			bool			_IsAddressInTimeWait(
+								const ConstSocketAddress& address) const;
+
+			status_t		_SendSynAcknowledge(const SynCacheEntry* entry);
+			void			_RemoveFromSynCache(SynCacheEntry* entry);
+			status_t		_ReplyFromTimeWait(const TimeWaitEntry* entry,
+								tcp_segment_header& segment);
+			void			_RemoveTimeWait(TimeWaitEntry* entry);
+			void			_ScheduleCacheTimer();
+
+	static	void			_CacheTimer(net_timer* timer, void* _manager);
 
 	typedef BOpenHashTable<ConnectionHashDefinition> ConnectionTable;
 	typedef MultiHashTable<EndpointHashDefinition> EndpointTable;
+	typedef BOpenHashTable<CompactConnectionHashDefinition>
+		CompactConnectionTable;
+	typedef MultiHashTable<TimeWaitPortHashDefinition> TimeWaitPortTable;
+	typedef DoublyLinkedList<CompactConnection> CompactConnectionList;
 
 	rw_lock					fLock;
 	net_domain*				fDomain;
 	ConnectionTable			fConnectionHash;
 	EndpointTable			fEndpointHash;
 	uint16					fLastPort;
+
+	// connections in TIME_WAIT, protected by fLock
+	CompactConnectionTable	fTimeWaitHash;
+	TimeWaitPortTable		fTimeWaitPortHash;
+	CompactConnectionList	fTimeWaitList;
+	int32					fTimeWaitCount;
+
+	// half-open connections of listening endpoints
+	mutex					fSynCacheLock;
+	CompactConnectionTable	fSynCacheHash;
+	CompactConnectionList	fSynCacheList;
+	int32					fSynCacheCount;
+
+	net_timer				fCacheTimer;
+	int32					fCacheTimerScheduled;
+	bool					fShuttingDown;
+		// protected by fLock, keeps the timer from re-arming itself
 };
 
 #endif	// ENDPOINT_MANAGER_H
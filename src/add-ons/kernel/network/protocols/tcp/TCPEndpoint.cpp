@@ -52,9 +52,8 @@
 //
 // Things this implementation currently doesn't implement:
 //	- Explicit Congestion Notification (ECN), RFC 3168
-//	- SYN-Cache
+//	- SYN cookies
 //	- Forward RTO-Recovery, RFC 4138
-//	- Time-Wait hash instead of keeping sockets alive
 
 #define PrintAddress(address) \
 	AddressString(Domain(), address, true).Data()
@@ -326,10 +325,6 @@ enum {
 };
 
 
-static const int kTimestampFactor = 1000;
-	// conversion factor between usec system time and msec tcp time
-
-
 static inline bigtime_t
 absolute_timeout(bigtime_t timeout)
 {
@@ -390,13 +385,6 @@ is_establishing(tcp_state state)
 }
 
 
-static inline uint32
-tcp_now()
-{
-	return system_time() / kTimestampFactor;
-}
-
-
 static inline uint32
 tcp_diff_timestamp(uint32 base)
 {
@@ -422,6 +410,9 @@ state_needs_finish(int32 state)
 TCPEndpoint::TCPEndpoint(net_socket* socket)
 	:
 	ProtocolSocket(socket),
+	fReusePortGroup(NULL),
+	fSynCacheCount(0),
+	fSynCacheLimit(0),
 	fManager(NULL),
 	fOptions(0),
 	fSendWindowShift(0),
@@ -539,8 +530,10 @@ TCPEndpoint::Close()
 	TRACE("Close()");
 	T(APICall(this, "close"));
 
-	if (fState == LISTEN)
+	if (fState == LISTEN) {
 		delete_sem(fAcceptSemaphore);
+		fManager->PurgeSynCache(this);
+	}
 
 	if (fState == SYNCHRONIZE_SENT || fState == LISTEN) {
 		// TODO: what about linger in case of SYNCHRONIZE_SENT?
@@ -593,6 +586,11 @@ TCPEndpoint::Free()
 
 	fFlags |= FLAG_CLOSED;
 	if ((fFlags & FLAG_DELETE_ON_CLOSE) == 0) {
+		if (fState == TIME_WAIT && _CompactTimeWait()) {
+			// we can go away together with our socket
+			return;
+		}
+
 		// we'll be freed later when the 2MSL timer expires
 		gSocketModule->acquire_socket(socket);
 
@@ -779,6 +777,10 @@ TCPEndpoint::Listen(int count)
 
 	gSocketModule->set_max_backlog(socket, count);
 
+	// the half-open connections in the SYN cache are bounded the same way
+	// as the pending connections of the socket
+	fSynCacheLimit = 3 * min_c(max_c(count, 1), 256) / 2;
+
 	fState = LISTEN;
 	T(State(this));
 	return B_OK;
@@ -1195,6 +1197,36 @@ TCPEndpoint::_UpdateTimeWait()
 }
 
 
+/*!	Hands the TIME_WAIT state of a closed connection over to the endpoint
+	manager, so that the endpoint doesn't have to stay around for 2MSL.
+	Returns \c true if the endpoint may be deleted now.
+*/
+bool
+TCPEndpoint::_CompactTimeWait()
+{
+	// If the timer has already been triggered, it will release the socket
+	if (!gStackModule->cancel_timer(&fTimeWaitTimer))
+		return false;
+
+	TimeWaitEntry entry;
+	LocalAddress().CopyTo((sockaddr*)&entry.local);
+	PeerAddress().CopyTo((sockaddr*)&entry.peer);
+	entry.sendNext = fSendMax;
+	entry.receiveNext = fReceiveNext;
+	entry.receivedTimestamp = fReceivedTimestamp;
+	entry.hasTimestamps = (fFlags & FLAG_OPTION_TIMESTAMP) != 0;
+
+	if (fManager->AddTimeWait(entry) != B_OK) {
+		_UpdateTimeWait();
+		return false;
+	}
+
+	T(TimerSet(this, "time-wait", -1));
+	fFlags |= FLAG_DELETE_ON_CLOSE;
+	return true;
+}
+
+
 void
 TCPEndpoint::_CancelConnectionTimers()
 {
@@ -1543,18 +1575,17 @@ TCPEndpoint::_ShouldReceive() const
 }
 
 
-int32
-TCPEndpoint::_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
-	net_buffer* buffer)
+/*!	Sets up an endpoint that has been spawned by the listening endpoint
+	\a parent for the connection \a buffer was received on.
+*/
+status_t
+TCPEndpoint::_InitChild(TCPEndpoint* parent, net_buffer* buffer)
 {
-	MutexLocker _(fLock);
-
-	TRACE("Spawn()");
-
 	// TODO: proper error handling!
-	if (ProtocolSocket::Open() != B_OK) {
+	status_t status = ProtocolSocket::Open();
+	if (status != B_OK) {
 		T(Error(this, "opening failed", __LINE__));
-		return DROP;
+		return status;
 	}
 
 	fState = SYNCHRONIZE_RECEIVED;
@@ -1562,17 +1593,33 @@ TCPEndpoint::_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
 
 	fManager = parent->fManager;
 
-	if (fManager->BindChild(this, buffer->destination) != B_OK) {
+	status = fManager->BindChild(this, buffer->destination);
+	if (status != B_OK) {
 		T(Error(this, "binding failed", __LINE__));
-		return DROP;
+		return status;
 	}
-	if (_PrepareSendPath(buffer->source) != B_OK) {
+	status = _PrepareSendPath(buffer->source);
+	if (status != B_OK) {
 		T(Error(this, "prepare send faild", __LINE__));
-		return DROP;
+		return status;
 	}
 
 	fOptions = parent->fOptions;
 	fAcceptSemaphore = parent->fAcceptSemaphore;
+	return B_OK;
+}
+
+
+int32
+TCPEndpoint::_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
+	net_buffer* buffer)
+{
+	MutexLocker _(fLock);
+
+	TRACE("Spawn()");
+
+	if (_InitChild(parent, buffer) != B_OK)
+		return DROP;
 
 	_PrepareReceivePath(segment);
 
@@ -1589,31 +1636,173 @@ TCPEndpoint::_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
 }
 
 
+/*!	Creates the endpoint for a connection whose handshake has been completed
+	by \a segment from the state that was kept in the SYN cache.
+*/
 int32
-TCPEndpoint::_ListenReceive(tcp_segment_header& segment, net_buffer* buffer)
+TCPEndpoint::_SpawnFromSynCache(TCPEndpoint* parent,
+	const SynCacheEntry& entry, tcp_segment_header& segment,
+	net_buffer* buffer)
 {
-	TRACE("ListenReceive()");
+	MutexLocker _(fLock);
 
-	// Essentially, we accept only TCP_FLAG_SYNCHRONIZE in this state,
-	// but the error behaviour differs
-	if (segment.flags & TCP_FLAG_RESET)
+	TRACE("SpawnFromSynCache()");
+
+	if (_InitChild(parent, buffer) != B_OK)
 		return DROP;
-	if (segment.flags & TCP_FLAG_ACKNOWLEDGE)
-		return DROP | RESET;
-	if ((segment.flags & TCP_FLAG_SYNCHRONIZE) == 0)
+
+	// Our SYN+ACK has already been sent from the cache
+	_SetInitialSendSequence(entry.initialSendSequence);
+	fSendNext = entry.initialSendSequence + 1;
+	fSendMax = fSendNext;
+
+	// Replay the SYN the cache answered
+	tcp_segment_header synchronize(TCP_FLAG_SYNCHRONIZE);
+	synchronize.sequence = entry.initialReceiveSequence.Number();
+	synchronize.max_segment_size = entry.sendMaxSegmentSize;
+	synchronize.window_shift = entry.sendWindowShift;
+	synchronize.timestamp_value = entry.receivedTimestamp;
+	synchronize.options = entry.options;
+	_PrepareReceivePath(synchronize);
+
+	if ((entry.options & TCP_HAS_WINDOW_SCALE) != 0)
+		fReceiveWindowShift = entry.receiveWindowShift;
+
+	fLastAcknowledgeSent = fReceiveNext;
+	fReceiveMaxAdvertised = fReceiveNext
+		+ min_c(entry.receiveWindow, TCP_MAX_WINDOW);
+
+	int32 action = _Receive(segment, buffer);
+
+	// the acknowledge actions are meant for us, not for our parent
+	if ((action & IMMEDIATE_ACKNOWLEDGE) != 0)
+		_SendAcknowledge(true);
+	else if ((action & ACKNOWLEDGE) != 0)
+		DelayedAcknowledge();
+	if ((action & SEND_QUEUED) != 0)
+		_SendQueued();
+
+	return action & ~(IMMEDIATE_ACKNOWLEDGE | ACKNOWLEDGE | SEND_QUEUED);
+}
+
+
+/*!	Answers a connection request without creating an endpoint for it yet:
+	only the data needed to complete the handshake is kept in the SYN cache
+	of the endpoint manager.
+*/
+int32
+TCPEndpoint::_AddToSynCache(tcp_segment_header& segment, net_buffer* buffer)
+{
+	SynCacheEntry entry;
+	AddressModule()->set_to((sockaddr*)&entry.local, buffer->destination);
+	AddressModule()->set_to((sockaddr*)&entry.peer, buffer->source);
+
+	entry.listener = this;
+	entry.initialSendSequence = system_time() >> 4;
+	entry.initialReceiveSequence = segment.sequence;
+	entry.receiveWindow = socket->receive.buffer_size;
+	entry.receivedTimestamp = 0;
+	entry.options = 0;
+	entry.sendMaxSegmentSize = segment.max_segment_size;
+	entry.receiveMaxSegmentSize = _MaxSegmentSize(buffer->source);
+	entry.sendWindowShift = 0;
+	entry.receiveWindowShift = 0;
+
+	if ((fOptions & TCP_NOOPT) == 0) {
+		entry.options = segment.options
+			& (TCP_HAS_WINDOW_SCALE | TCP_HAS_TIMESTAMPS | TCP_SACK_PERMITTED);
+
+		if ((entry.options & TCP_HAS_WINDOW_SCALE) != 0) {
+			entry.sendWindowShift = segment.window_shift;
+			entry.receiveWindowShift = _ReceiveWindowShift(
+				gDatalinkModule->is_local_address(Domain(), buffer->source,
+					NULL, NULL));
+		}
+		if ((entry.options & TCP_HAS_TIMESTAMPS) != 0)
+			entry.receivedTimestamp = segment.timestamp_value;
+	}
+
+	status_t status = fManager->AddToSynCache(entry);
+	if (status == B_BUSY) {
+		// the backlog is full, the peer will retry
+		T(Error(this, "SYN cache backlog full", __LINE__));
 		return DROP;
+	}
+	if (status == B_NO_MEMORY) {
+		// fall back to creating the endpoint right away
+		net_socket* newSocket;
+		if (gSocketModule->spawn_pending_socket(socket, &newSocket) < B_OK) {
+			T(Error(this, "spawning failed", __LINE__));
+			return DROP;
+		}
 
-	// TODO: drop broadcast/multicast
+		return ((TCPEndpoint *)newSocket->first_protocol)->_Spawn(this,
+			segment, buffer);
+	}
+
+	return DROP;
+}
+
+
+/*!	Handles the final ACK of the three way handshake for a connection in the
+	SYN cache.
+*/
+int32
+TCPEndpoint::_CompleteFromSynCache(tcp_segment_header& segment,
+	net_buffer* buffer)
+{
+	// The entry is only taken out of the cache if the segment acknowledges
+	// our SYN+ACK; checking and removing it at once makes sure that it is
+	// not replaced by a new connection request of the peer in between.
+	SynCacheEntry entry;
+	if (!fManager->TakeFromSynCache(buffer->destination, buffer->source,
+			tcp_sequence(segment.acknowledge), entry))
+		return DROP | RESET;
 
 	// spawn new endpoint for accept()
 	net_socket* newSocket;
 	if (gSocketModule->spawn_pending_socket(socket, &newSocket) < B_OK) {
+		// put the entry back, maybe there is room later
 		T(Error(this, "spawning failed", __LINE__));
+		fManager->AddToSynCache(entry, false);
+		return DROP;
+	}
+
+	return ((TCPEndpoint *)newSocket->first_protocol)->_SpawnFromSynCache(this,
+		entry, segment, buffer);
+}
+
+
+int32
+TCPEndpoint::_ListenReceive(tcp_segment_header& segment, net_buffer* buffer)
+{
+	TRACE("ListenReceive()");
+
+	// Essentially, we accept only TCP_FLAG_SYNCHRONIZE in this state,
+	// but the error behaviour differs
+	if (segment.flags & TCP_FLAG_RESET) {
+		// the peer might abort a connection in the SYN cache
+		SynCacheEntry entry;
+		if (fManager->LookupSynCache(buffer->destination, buffer->source,
+				entry)
+			&& tcp_sequence(segment.sequence)
+				== entry.initialReceiveSequence + 1) {
+			fManager->RemoveFromSynCache(buffer->destination, buffer->source);
+		}
 		return DROP;
 	}
+	if (segment.flags & TCP_FLAG_ACKNOWLEDGE) {
+		if ((segment.flags & TCP_FLAG_SYNCHRONIZE) == 0)
+			return _CompleteFromSynCache(segment, buffer);
 
-	return ((TCPEndpoint *)newSocket->first_protocol)->_Spawn(this,
-		segment, buffer);
+		return DROP | RESET;
+	}
+	if ((segment.flags & TCP_FLAG_SYNCHRONIZE) == 0)
+		return DROP;
+
+	// TODO: drop broadcast/multicast
+
+	return _AddToSynCache(segment, buffer);
 }
 
 
@@ -2015,6 +2204,10 @@ TCPEndpoint::SegmentReceived(tcp_segment_header& segment, net_buffer* buffer)
 	if (segmentAction & SEND_QUEUED)
 		_SendQueued();
 
+	if (fState == TIME_WAIT
+		&& (fFlags & (FLAG_CLOSED | FLAG_DELETE_ON_CLOSE)) == FLAG_CLOSED)
+		_CompactTimeWait();
+
 	if ((fFlags & (FLAG_CLOSED | FLAG_DELETE_ON_CLOSE))
 			== (FLAG_CLOSED | FLAG_DELETE_ON_CLOSE)) {
 
@@ -2397,7 +2590,22 @@ TCPEndpoint::_PrepareSendPath(const sockaddr* peer)
 	if (status < B_OK)
 		return status;
 
-	fInitialSendSequence = system_time() >> 4;
+	_SetInitialSendSequence(system_time() >> 4);
+
+	fReceiveMaxSegmentSize = _MaxSegmentSize(peer);
+
+	// Compute the window shift we advertise to our peer - if it doesn't support
+	// this option, this will be reset to 0 (when its SYN is received)
+	fReceiveWindowShift = _ReceiveWindowShift(IsLocal());
+
+	return B_OK;
+}
+
+
+void
+TCPEndpoint::_SetInitialSendSequence(tcp_sequence sequence)
+{
+	fInitialSendSequence = sequence;
 	fSendNext = fInitialSendSequence;
 	fSendUnacknowledged = fInitialSendSequence;
 	fSendMax = fInitialSendSequence;
@@ -2406,22 +2614,23 @@ TCPEndpoint::_PrepareSendPath(const sockaddr* peer)
 
 	// we are counting the SYN here
 	fSendQueue.SetInitialSequence(fSendNext + 1);
+}
 
-	fReceiveMaxSegmentSize = _MaxSegmentSize(peer);
 
-	// Compute the window shift we advertise to our peer - if it doesn't support
-	// this option, this will be reset to 0 (when its SYN is received)
-	fReceiveWindowShift = 0;
-	while (fReceiveWindowShift < TCP_MAX_WINDOW_SHIFT
-			&& (0xffffUL << fReceiveWindowShift) < socket->receive.buffer_size) {
-		fReceiveWindowShift++;
+uint8
+TCPEndpoint::_ReceiveWindowShift(bool isLocal) const
+{
+	uint8 shift = 0;
+	while (shift < TCP_MAX_WINDOW_SHIFT
+			&& (0xffffUL << shift) < socket->receive.buffer_size) {
+		shift++;
 	}
 
 	// Increase to a default of 8 (window minimum 256 bytes, maximum 15 MB.)
-	if (fReceiveWindowShift < 8 && !IsLocal())
-		fReceiveWindowShift = 8;
+	if (shift < 8 && !isLocal)
+		shift = 8;
 
-	return B_OK;
+	return shift;
 }
 
 
@@ -71,6 +71,7 @@ private:
 			void		_StartPersistTimer();
 			void		_EnterTimeWait();
 			void		_UpdateTimeWait();
+			bool		_CompactTimeWait();
 			void		_Close();
 			void		_CancelConnectionTimers();
 
@@ -88,8 +89,16 @@ private:
 			void		_NotifyReader();
 			bool		_ShouldReceive() const;
 			void		_HandleReset(status_t error);
+			status_t	_InitChild(TCPEndpoint* parent, net_buffer* buffer);
 			int32		_Spawn(TCPEndpoint* parent, tcp_segment_header& segment,
 							net_buffer* buffer);
+			int32		_SpawnFromSynCache(TCPEndpoint* parent,
+							const SynCacheEntry& entry,
+							tcp_segment_header& segment, net_buffer* buffer);
+			int32		_AddToSynCache(tcp_segment_header& segment,
+							net_buffer* buffer);
+			int32		_CompleteFromSynCache(tcp_segment_header& segment,
+							net_buffer* buffer);
 			int32		_ListenReceive(tcp_segment_header& segment,
 							net_buffer* buffer);
 			int32		_SynchronizeSentReceive(tcp_segment_header& segment,
@@ -109,6 +118,8 @@ private:
 			int			_MaxSegmentSize(const struct sockaddr* address) const;
 			void		_PrepareReceivePath(tcp_segment_header& segment);
 			status_t	_PrepareSendPath(const sockaddr* peer);
+			void		_SetInitialSendSequence(tcp_sequence sequence);
+			uint8		_ReceiveWindowShift(bool isLocal) const;
 			void		_Acknowledged(tcp_segment_header& segment);
 			void		_Retransmit();
 			void		_UpdateRoundTripTime(int32 roundTripTime, int32 expectedSamples);
@@ -127,6 +138,10 @@ private:
 private:
 	TCPEndpoint*	fConnectionHashLink;
 	TCPEndpoint*	fEndpointHashLink;
+	ReusePortGroup*	fReusePortGroup;
+	int32			fSynCacheCount;
+		// protected by the SYN cache lock of the EndpointManager
+	int32			fSynCacheLimit;
 	friend class	EndpointManager;
 	friend struct	ConnectionHashDefinition;
 	friend class	EndpointHashDefinition;
@@ -733,7 +733,13 @@ tcp_receive_data(net_buffer* buffer)
 
 	TCPEndpoint* endpoint = endpointManager->FindConnection(
 		buffer->destination, buffer->source);
-	if (endpoint != NULL) {
+	if ((endpoint == NULL || endpoint->State() == LISTEN)
+		&& endpointManager->TimeWaitSegmentReceived(segment, buffer,
+			segmentAction)) {
+		// the segment belongs to a connection that is only known in TIME_WAIT
+		if (endpoint != NULL)
+			gSocketModule->release_socket(endpoint->socket);
+	} else if (endpoint != NULL) {
 		segmentAction = endpoint->SegmentReceived(segment, buffer);
 
 		// There are some states in which the socket could have been deleted
@@ -896,7 +902,9 @@ net_protocol_module_info sTCPModule = {
 	NULL,		// process_ancillary_data()
 	NULL,		// process_ancillary_data_no_container()
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	NULL,		// read_data_batch()
+	NULL		// receive_data_batch()
 };
 
 module_dependency module_dependencies[] = {
@@ -94,6 +94,8 @@ public:
 			ssize_t				BytesAvailable();
 			status_t			FetchData(size_t numBytes, uint32 flags,
 									net_buffer** _buffer);
+			status_t			FetchData(uint32 flags, net_buffer** _buffers,
+									size_t* _count);
 
 			status_t			StoreData(net_buffer* buffer);
 			status_t			DeliverData(net_buffer* buffer);
@@ -1085,6 +1087,19 @@ UdpEndpoint::FetchData(size_t numBytes, uint32 flags, net_buffer **_buffer)
 }
 
 
+status_t
+UdpEndpoint::FetchData(uint32 flags, net_buffer **_buffers, size_t *_count)
+{
+	TRACE_EP("FetchData(0x%" B_PRIx32 ", %" B_PRIuSIZE " buffers)", flags,
+		*_count);
+
+	status_t status = Dequeue(flags, _buffers, _count);
+	TRACE_EP("  FetchData(): returned from fifo status: %s, %" B_PRIuSIZE
+		" buffers", strerror(status), *_count);
+	return status;
+}
+
+
 status_t
 UdpEndpoint::StoreData(net_buffer *buffer)
 {
@@ -1271,6 +1286,14 @@ udp_read_data(net_protocol *protocol, size_t numBytes, uint32 flags,
 }
 
 
+status_t
+udp_read_data_batch(net_protocol *protocol, uint32 flags,
+	net_buffer **_buffers, size_t *_count)
+{
+	return ((UdpEndpoint *)protocol)->FetchData(flags, _buffers, _count);
+}
+
+
 ssize_t
 udp_read_avail(net_protocol *protocol)
 {
@@ -1495,7 +1518,9 @@ net_protocol_module_info sUDPModule = {
 	NULL,		// process_ancillary_data()
 	udp_process_ancillary_data_no_container,
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	udp_read_data_batch,
+	NULL		// receive_data_batch()
 };
 
 module_dependency module_dependencies[] = {
@@ -10,7 +10,9 @@
 #include <AutoDeleter.h>
 
 #include <net_stack.h>
+#include <team.h>
 #include <util/ring_buffer.h>
+#include <vm/vm.h>
 
 #include "unix.h"
 
@@ -344,8 +346,9 @@ UnixFifo::UnixFifo(size_t capacity, UnixFifoType type)
 	fWriters(),
 	fReadRequested(0),
 	fWriteRequested(0),
-	fShutdown(0)
-
+	fShutdown(0),
+	fType(type),
+	fDirectTransfer(NULL)
 {
 	fReadCondition.Init(this, "unix fifo read");
 	fWriteCondition.Init(this, "unix fifo write");
@@ -390,7 +393,7 @@ UnixFifo::Read(const iovec* vecs, size_t vecCount,
 	TRACE("[%" B_PRId32 "] %p->UnixFifo::Read(%p, %ld, %" B_PRIdBIGTIME ")\n",
 		find_thread(NULL), this, vecs, vecCount, timeout);
 
-	if (IsReadShutdown() && fBuffer.Readable() == 0)
+	if (IsReadShutdown() && _ReadableBytes() == 0)
 		RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
 
 	UnixRequest request(vecs, vecCount, NULL, address);
@@ -403,16 +406,18 @@ UnixFifo::Read(const iovec* vecs, size_t vecCount,
 	fReaders.Remove(&request);
 	fReadRequested -= request.TotalSize();
 
-	if (firstInQueue && !fReaders.IsEmpty() && fBuffer.Readable() > 0
+	if (firstInQueue && !fReaders.IsEmpty() && _ReadableBytes() > 0
 			&& !IsReadShutdown()) {
 		// There's more to read, other readers, and we were first in the queue.
 		// So we need to notify the others.
 		fReadCondition.NotifyAll();
 	}
 
-	if (request.BytesTransferred() > 0 && !fWriters.IsEmpty()
-			&& !IsWriteShutdown()) {
-		// We read something and there are writers. Notify them
+	if ((request.BytesTransferred() > 0
+			|| (fDirectTransfer != NULL && fReaders.IsEmpty()))
+		&& !fWriters.IsEmpty() && !IsWriteShutdown()) {
+		// We read something and there are writers, or a direct writer has no
+		// one left to read its data. Notify them
 		fWriteCondition.NotifyAll();
 	}
 
@@ -480,7 +485,7 @@ UnixFifo::Write(const iovec* vecs, size_t vecCount,
 size_t
 UnixFifo::Readable() const
 {
-	size_t readable = fBuffer.Readable();
+	size_t readable = _ReadableBytes();
 	return (off_t)readable > fReadRequested ? readable - fReadRequested : 0;
 }
 
@@ -527,7 +532,7 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 		RETURN_ERROR(B_WOULD_BLOCK);
 
 	while (fReaders.Head() != &request
-		&& !(IsReadShutdown() && fBuffer.Readable() == 0)) {
+		&& !(IsReadShutdown() && _ReadableBytes() == 0)) {
 		ConditionVariableEntry entry;
 		fReadCondition.Add(&entry);
 
@@ -540,7 +545,7 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 			RETURN_ERROR(error);
 	}
 
-	if (fBuffer.Readable() == 0) {
+	if (_ReadableBytes() == 0) {
 		if (IsReadShutdown())
 			RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
 
@@ -553,7 +558,7 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 
 	// wait for any data to become available
 // TODO: Support low water marks!
-	while (fBuffer.Readable() == 0
+	while (_ReadableBytes() == 0
 			&& !IsReadShutdown() && !IsWriteShutdown()) {
 		ConditionVariableEntry entry;
 		fReadCondition.Add(&entry);
@@ -567,17 +572,58 @@ UnixFifo::_Read(UnixRequest& request, bigtime_t timeout)
 			RETURN_ERROR(error);
 	}
 
-	if (fBuffer.Readable() == 0) {
+	if (_ReadableBytes() == 0) {
 		if (IsReadShutdown())
 			RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
 		if (IsWriteShutdown())
 			RETURN_ERROR(0);
 	}
 
+	// A direct transfer is only offered while the ring buffer is empty, so
+	// reading from it does not reorder the stream.
+	if (fBuffer.Readable() == 0 && fDirectTransfer != NULL)
+		RETURN_ERROR(_ReadDirect(request));
+
 	RETURN_ERROR(fBuffer.Read(request));
 }
 
 
+status_t
+UnixFifo::_ReadDirect(UnixRequest& request)
+{
+	DirectTransfer* transfer = fDirectTransfer;
+	bool user = gStackModule->is_syscall();
+
+	void* data;
+	size_t size;
+	while (transfer->transferred < transfer->size
+			&& request.GetCurrentChunk(data, size)) {
+		const physical_entry& vec = transfer->vecs[transfer->vecIndex];
+		size_t vecRemaining = vec.size - transfer->vecOffset;
+		if (size > vecRemaining)
+			size = vecRemaining;
+
+		status_t error = vm_memcpy_from_physical(data,
+			vec.address + transfer->vecOffset, size, user);
+		if (error != B_OK)
+			RETURN_ERROR(error);
+
+		transfer->transferred += size;
+		transfer->vecOffset += size;
+		if (transfer->vecOffset == vec.size) {
+			transfer->vecIndex++;
+			transfer->vecOffset = 0;
+		}
+
+		request.AddBytesTransferred(size);
+	}
+
+	// If the transfer has been consumed, the writer is woken up by Read()
+	// like after any other read.
+	return B_OK;
+}
+
+
 status_t
 UnixFifo::_Write(UnixRequest& request, bigtime_t timeout)
 {
@@ -610,6 +656,12 @@ UnixFifo::_Write(UnixRequest& request, bigtime_t timeout)
 	status_t error = B_OK;
 
 	while (error == B_OK && request.BytesRemaining() > 0) {
+		if (_CanWriteDirect(request)) {
+			// let the waiting reader copy straight out of our pages
+			error = _WriteDirect(request, timeout);
+			continue;
+		}
+
 		// wait for any space to become available
 		while (error == B_OK && fBuffer.Writable() < _MinimumWritableSize(request)
 				&& !IsWriteShutdown() && !IsReadShutdown()) {
@@ -659,6 +711,91 @@ UnixFifo::_WriteNonBlocking(UnixRequest& request)
 }
 
 
+bool
+UnixFifo::_CanWriteDirect(UnixRequest& request) const
+{
+	// Only large userland writes to a stream are worth wiring, and only when a
+	// reader is already waiting and nothing is buffered ahead of the data.
+	// Ancillary data needs to be attached to the buffered stream.
+	if (fType != UnixFifoType::Stream || !gStackModule->is_syscall()
+		|| fReaders.IsEmpty() || fBuffer.Readable() > 0
+		|| request.AncillaryData() != NULL) {
+		return false;
+	}
+
+	void* data;
+	size_t size;
+	return request.GetCurrentChunk(data, size)
+		&& size >= UNIX_FIFO_DIRECT_WRITE_THRESHOLD;
+}
+
+
+status_t
+UnixFifo::_WriteDirect(UnixRequest& request, bigtime_t timeout)
+{
+	void* data;
+	size_t size;
+	if (!request.GetCurrentChunk(data, size))
+		return B_OK;
+	if (size > UNIX_FIFO_MAXIMAL_DIRECT_WRITE)
+		size = UNIX_FIFO_MAXIMAL_DIRECT_WRITE;
+
+	team_id team = team_get_current_team_id();
+	status_t error = lock_memory_etc(team, data, size, 0);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	DirectTransfer transfer;
+	transfer.count = B_COUNT_OF(transfer.vecs);
+	error = get_memory_map_etc(team, data, size, transfer.vecs,
+		&transfer.count);
+	if (error != B_OK) {
+		unlock_memory_etc(team, data, size, 0);
+		RETURN_ERROR(error);
+	}
+
+	transfer.vecIndex = 0;
+	transfer.vecOffset = 0;
+	transfer.size = size;
+	transfer.transferred = 0;
+
+	fDirectTransfer = &transfer;
+	fReadCondition.NotifyAll();
+
+	// Wait until the readers have consumed the pages. If they go away before
+	// that, we take back the rest and let it go through the ring buffer, so
+	// that poll()ing readers are notified as usual.
+	while (transfer.transferred < transfer.size && !fReaders.IsEmpty()
+			&& !IsWriteShutdown() && !IsReadShutdown()) {
+		ConditionVariableEntry entry;
+		fWriteCondition.Add(&entry);
+
+		mutex_unlock(&fLock);
+		error = entry.Wait(B_ABSOLUTE_TIMEOUT | B_CAN_INTERRUPT, timeout);
+		mutex_lock(&fLock);
+
+		if (error != B_OK)
+			break;
+	}
+
+	fDirectTransfer = NULL;
+	unlock_memory_etc(team, data, size, 0);
+
+	request.AddBytesTransferred(transfer.transferred);
+
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	if (IsWriteShutdown())
+		RETURN_ERROR(UNIX_FIFO_SHUTDOWN);
+
+	if (IsReadShutdown())
+		RETURN_ERROR(EPIPE);
+
+	return B_OK;
+}
+
+
 size_t
 UnixFifo::_MinimumWritableSize(const UnixRequest& request) const
 {
@@ -670,3 +807,13 @@ UnixFifo::_MinimumWritableSize(const UnixRequest& request) const
 			return 1;
 	}
 }
+
+
+size_t
+UnixFifo::_ReadableBytes() const
+{
+	size_t readable = fBuffer.Readable();
+	if (fDirectTransfer != NULL)
+		readable += fDirectTransfer->size - fDirectTransfer->transferred;
+	return readable;
+}
@@ -5,6 +5,7 @@
 #ifndef UNIX_FIFO_H
 #define UNIX_FIFO_H
 
+#include <KernelExport.h>
 #include <Referenceable.h>
 
 #include <condition_variable.h>
@@ -24,6 +25,12 @@
 #define UNIX_FIFO_MINIMAL_CAPACITY	1024
 #define UNIX_FIFO_MAXIMAL_CAPACITY	(128 * 1024)
 
+#define UNIX_FIFO_DIRECT_WRITE_THRESHOLD	(32 * 1024)
+	// stream writes of at least this size are handed to a waiting reader
+	// straight from the writer's pages, bypassing the ring buffer
+#define UNIX_FIFO_MAXIMAL_DIRECT_WRITE		(256 * 1024)
+	// the most we wire of the writer's memory at once
+
 
 enum class UnixFifoType {
 	Stream,
@@ -147,11 +154,24 @@ public:
 private:
 	typedef DoublyLinkedList<UnixRequest> RequestList;
 
+	struct DirectTransfer {
+		physical_entry	vecs[UNIX_FIFO_MAXIMAL_DIRECT_WRITE / B_PAGE_SIZE + 1];
+		uint32			count;
+		uint32			vecIndex;
+		size_t			vecOffset;
+		size_t			size;
+		size_t			transferred;
+	};
+
 private:
 	status_t _Read(UnixRequest& request, bigtime_t timeout);
+	status_t _ReadDirect(UnixRequest& request);
 	status_t _Write(UnixRequest& request, bigtime_t timeout);
 	status_t _WriteNonBlocking(UnixRequest& request);
+	bool _CanWriteDirect(UnixRequest& request) const;
+	status_t _WriteDirect(UnixRequest& request, bigtime_t timeout);
 	size_t _MinimumWritableSize(const UnixRequest& request) const;
+	size_t _ReadableBytes() const;
 
 private:
 	mutex				fLock;
@@ -164,6 +184,8 @@ private:
 	ConditionVariable	fWriteCondition;
 	uint32				fShutdown;
 	UnixFifoType		fType;
+	DirectTransfer*		fDirectTransfer;
+		// the writer's pages currently offered to the readers, if any
 };
 
 
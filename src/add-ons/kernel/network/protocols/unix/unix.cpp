@@ -535,7 +535,9 @@ net_protocol_module_info gUnixModule = {
 	unix_process_ancillary_data,
 	NULL,
 	unix_send_data_no_buffer,
-	unix_read_data_no_buffer
+	unix_read_data_no_buffer,
+	NULL,		// read_data_batch()
+	NULL		// receive_data_batch()
 };
 
 module_dependency module_dependencies[] = {
@@ -41,9 +41,26 @@ static DeviceInterfaceList sInterfaces;
 static uint32 sDeviceIndex;
 
 
+static const uint32 kReceiveBatchSize = 32;
+	// number of buffers handed over between the threads at once
+
+
+/*!	The domain's device receive handler - this will inject the net_buffers into
+	the protocol layer (the domain's registered receive handler).
+*/
+static status_t
+domain_receive_adapter(void* cookie, net_device* device, net_buffer* buffer)
+{
+	net_domain_private* domain = (net_domain_private*)cookie;
+
+	return domain->module->receive_data(buffer);
+}
+
+
 /*!	A service thread for each device interface. It just reads as many packets
 	as available, deframes them, and puts them into the receive queue of the
-	device interface.
+	device interface. If the device supports it, the packets are read, and
+	queued in batches.
 */
 static status_t
 device_reader_thread(void* _interface)
@@ -53,30 +70,59 @@ device_reader_thread(void* _interface)
 	status_t status = B_OK;
 
 	while ((device->flags & IFF_UP) != 0) {
-		net_buffer* buffer;
-		status = device->module->receive_data(device, &buffer);
+		net_buffer* buffers[kReceiveBatchSize];
+		uint32 count = 1;
+		if (device->module->receive_data_batch != NULL) {
+			count = kReceiveBatchSize;
+			status = device->module->receive_data_batch(device, buffers,
+				&count);
+		} else
+			status = device->module->receive_data(device, &buffers[0]);
+
 		if (status == B_OK) {
-			// feed device monitors
-			if (atomic_get(&interface->monitor_count) > 0)
-				device_interface_monitor_receive(interface, buffer);
+			size_t ready = 0;
+			size_t bytes = 0;
+			int32 dropped = 0;
 
-			ASSERT(buffer->interface_address == NULL);
+			for (uint32 i = 0; i < count; i++) {
+				net_buffer* buffer = buffers[i];
 
-			if (interface->deframe_func(interface->device, buffer) != B_OK) {
-				gNetBufferModule.free(buffer);
-				atomic_add((int32*)&device->stats.receive.dropped, 1);
-				continue;
+				// feed device monitors
+				if (atomic_get(&interface->monitor_count) > 0)
+					device_interface_monitor_receive(interface, buffer);
+
+				ASSERT(buffer->interface_address == NULL);
+
+				if (interface->deframe_func(interface->device, buffer)
+						!= B_OK) {
+					gNetBufferModule.free(buffer);
+					dropped++;
+					continue;
+				}
+
+				bytes += buffer->size;
+				buffers[ready++] = buffer;
 			}
 
-			const size_t packetSize = buffer->size;
-			status = fifo_enqueue_buffer(&interface->receive_queue, buffer);
-			if (status == B_OK) {
-				atomic_add((int32*)&device->stats.receive.packets, 1);
-				atomic_add64((int64*)&device->stats.receive.bytes, packetSize);
-			} else {
-				gNetBufferModule.free(buffer);
-				atomic_add((int32*)&device->stats.receive.dropped, 1);
+			size_t enqueued = ready;
+			if (ready > 0) {
+				fifo_enqueue_buffers(&interface->receive_queue, buffers,
+					&enqueued);
+			}
+
+			// whatever did not fit into the queue is still ours
+			for (size_t i = enqueued; i < ready; i++) {
+				bytes -= buffers[i]->size;
+				gNetBufferModule.free(buffers[i]);
+				dropped++;
+			}
+
+			if (enqueued > 0) {
+				atomic_add((int32*)&device->stats.receive.packets, enqueued);
+				atomic_add64((int64*)&device->stats.receive.bytes, bytes);
 			}
+			if (dropped > 0)
+				atomic_add((int32*)&device->stats.receive.dropped, dropped);
 		} else if (status == B_DEVICE_NOT_FOUND) {
 			device_removed(device);
 			return status;
@@ -93,74 +139,128 @@ device_reader_thread(void* _interface)
 }
 
 
+/*!	Returns the handler that is responsible for \a buffer, if it is able to
+	receive a whole batch of buffers at once; that is, if it is the first
+	matching handler, and delivers to a domain that supports
+	receive_data_batch(). Such a handler always consumes the buffers.
+	The interface's receive lock must be held.
+*/
+static net_device_handler*
+find_batch_handler(net_device_interface* interface, net_buffer* buffer)
+{
+	if (buffer->interface_address != NULL)
+		return NULL;
+
+	sockaddr_dl& linkAddress = *(sockaddr_dl*)buffer->source;
+	int32 genericType = buffer->type;
+	int32 specificType = B_NET_FRAME_TYPE(linkAddress.sdl_type,
+		ntohs(linkAddress.sdl_e_type));
+
+	DeviceHandlerList::Iterator iterator
+		= interface->receive_funcs.GetIterator();
+	while (net_device_handler* handler = iterator.Next()) {
+		if (handler->type != genericType && handler->type != specificType)
+			continue;
+
+		if (handler->func != &domain_receive_adapter)
+			return NULL;
+
+		net_domain_private* domain = (net_domain_private*)handler->cookie;
+		return domain->module->receive_data_batch != NULL ? handler : NULL;
+	}
+
+	return NULL;
+}
+
+
+/*!	Delivers a single buffer to the first handler that accepts it.
+	The interface's receive lock must be held.
+*/
+static void
+deliver_buffer(net_device_interface* interface, net_buffer* buffer)
+{
+	net_device* device = interface->device;
+
+	if (buffer->interface_address != NULL) {
+		// If the interface is already specified, this buffer was
+		// delivered locally.
+		if (buffer->interface_address->domain->module->receive_data(buffer)
+				== B_OK)
+			buffer = NULL;
+	} else {
+		sockaddr_dl& linkAddress = *(sockaddr_dl*)buffer->source;
+		int32 genericType = buffer->type;
+		int32 specificType = B_NET_FRAME_TYPE(linkAddress.sdl_type,
+			ntohs(linkAddress.sdl_e_type));
+
+		buffer->index = device->index;
+
+		// Find handler for this packet
+
+		DeviceHandlerList::Iterator iterator
+			= interface->receive_funcs.GetIterator();
+		while (buffer != NULL && iterator.HasNext()) {
+			net_device_handler* handler = iterator.Next();
+
+			// If the handler returns B_OK, it consumed the buffer - first
+			// handler wins.
+			if ((handler->type == genericType
+					|| handler->type == specificType)
+				&& handler->func(handler->cookie, device, buffer) == B_OK)
+				buffer = NULL;
+		}
+	}
+
+	if (buffer != NULL)
+		gNetBufferModule.free(buffer);
+}
+
+
 static status_t
 device_consumer_thread(void* _interface)
 {
 	net_device_interface* interface = (net_device_interface*)_interface;
 	net_device* device = interface->device;
-	net_buffer* buffer;
 
 	while (atomic_get(&interface->ref_count) > 0) {
-		ssize_t status = fifo_dequeue_buffer(&interface->receive_queue, 0,
-			B_INFINITE_TIMEOUT, &buffer);
+		net_buffer* buffers[kReceiveBatchSize];
+		size_t count = kReceiveBatchSize;
+		status_t status = fifo_dequeue_buffers(&interface->receive_queue, 0,
+			B_INFINITE_TIMEOUT, buffers, &count);
 		if (status != B_OK) {
 			if (status == B_INTERRUPTED)
 				continue;
 			break;
 		}
 
-		if (buffer->interface_address != NULL) {
-			// If the interface is already specified, this buffer was
-			// delivered locally.
-			if (buffer->interface_address->domain->module->receive_data(buffer)
-					== B_OK)
-				buffer = NULL;
-		} else {
-			sockaddr_dl& linkAddress = *(sockaddr_dl*)buffer->source;
-			int32 genericType = buffer->type;
-			int32 specificType = B_NET_FRAME_TYPE(linkAddress.sdl_type,
-				ntohs(linkAddress.sdl_e_type));
+		RecursiveLocker locker(interface->receive_lock);
 
-			buffer->index = interface->device->index;
-
-			// Find handler for this packet
-
-			RecursiveLocker locker(interface->receive_lock);
+		size_t index = 0;
+		while (index < count) {
+			net_device_handler* handler
+				= find_batch_handler(interface, buffers[index]);
+			if (handler == NULL) {
+				deliver_buffer(interface, buffers[index++]);
+				continue;
+			}
 
-			DeviceHandlerList::Iterator iterator
-				= interface->receive_funcs.GetIterator();
-			while (buffer != NULL && iterator.HasNext()) {
-				net_device_handler* handler = iterator.Next();
+			// pass on all following buffers for the same domain at once
+			size_t end = index;
+			do {
+				buffers[end++]->index = device->index;
+			} while (end < count
+				&& find_batch_handler(interface, buffers[end]) == handler);
 
-				// If the handler returns B_OK, it consumed the buffer - first
-				// handler wins.
-				if ((handler->type == genericType
-						|| handler->type == specificType)
-					&& handler->func(handler->cookie, device, buffer) == B_OK)
-					buffer = NULL;
-			}
+			net_domain_private* domain = (net_domain_private*)handler->cookie;
+			domain->module->receive_data_batch(buffers + index, end - index);
+			index = end;
 		}
-
-		if (buffer != NULL)
-			gNetBufferModule.free(buffer);
 	}
 
 	return B_OK;
 }
 
 
-/*!	The domain's device receive handler - this will inject the net_buffers into
-	the protocol layer (the domain's registered receive handler).
-*/
-static status_t
-domain_receive_adapter(void* cookie, net_device* device, net_buffer* buffer)
-{
-	net_domain_private* domain = (net_domain_private*)cookie;
-
-	return domain->module->receive_data(buffer);
-}
-
-
 static net_device_interface*
 find_device_interface(const char* name)
 {
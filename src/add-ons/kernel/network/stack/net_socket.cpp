@@ -45,6 +45,10 @@
 #endif
 
 
+static const size_t kMaxReceiveBatchSize = 32;
+	// number of buffers dequeued at once by socket_receive_batch()
+
+
 struct net_socket_private;
 typedef DoublyLinkedList<net_socket_private> SocketList;
 
@@ -316,6 +320,96 @@ socket_receive_no_buffer(net_socket* socket, msghdr* header, void* data,
 }
 
 
+/*!	Copies the contents of \a buffer that has been read from the socket's
+	protocol into \a data, and the further vectors and the address of
+	\a header, if given. The buffer is freed.
+*/
+static ssize_t
+socket_receive_buffer(net_socket* socket, net_buffer* buffer, msghdr* header,
+	void* data, size_t length, int originalFlags)
+{
+	status_t status;
+
+	// process ancillary data
+	if (header != NULL) {
+		if (buffer != NULL && header->msg_control != NULL) {
+			ancillary_data_container* container
+				= gNetBufferModule.get_ancillary_data(buffer);
+			if (container != NULL)
+				status = process_ancillary_data(socket, container, header);
+			else
+				status = process_ancillary_data(socket, buffer, header);
+			if (status != B_OK) {
+				gNetBufferModule.free(buffer);
+				return status;
+			}
+		} else
+			header->msg_controllen = 0;
+	}
+
+	// TODO: - returning a NULL buffer when received 0 bytes
+	//         may not make much sense as we still need the address
+
+	size_t nameLen = 0;
+	if (header != NULL) {
+		// TODO: - consider the control buffer options
+		nameLen = header->msg_namelen;
+		header->msg_namelen = 0;
+		header->msg_flags = 0;
+	}
+
+	if (buffer == NULL)
+		return 0;
+
+	const size_t bytesReceived = buffer->size;
+	size_t bytesCopied = 0;
+
+	size_t toRead = min_c(bytesReceived, length);
+	status = gNetBufferModule.read(buffer, 0, data, toRead);
+	if (status != B_OK) {
+		gNetBufferModule.free(buffer);
+
+		if (status == B_BAD_ADDRESS)
+			return status;
+		return ENOBUFS;
+	}
+
+	// if first copy was a success, proceed to following copies as required
+	bytesCopied += toRead;
+
+	if (header != NULL) {
+		// We start at iovec[1] as { data, length } is iovec[0].
+		for (int i = 1; i < header->msg_iovlen && bytesCopied < bytesReceived; i++) {
+			iovec& vec = header->msg_iov[i];
+			toRead = min_c(bytesReceived - bytesCopied, vec.iov_len);
+			if (gNetBufferModule.read(buffer, bytesCopied, vec.iov_base,
+					toRead) < B_OK) {
+				break;
+			}
+
+			bytesCopied += toRead;
+		}
+
+		if (header->msg_name != NULL) {
+			header->msg_namelen = min_c(nameLen, buffer->source->sa_len);
+			memcpy(header->msg_name, buffer->source, header->msg_namelen);
+		}
+	}
+
+	gNetBufferModule.free(buffer);
+
+	if (bytesCopied < bytesReceived) {
+		if (header != NULL)
+			header->msg_flags = MSG_TRUNC;
+
+		if ((originalFlags & MSG_TRUNC) != 0)
+			return bytesReceived;
+	}
+
+	return bytesCopied;
+}
+
+
 #if ENABLE_DEBUGGER_COMMANDS
 
 
@@ -1159,83 +1253,8 @@ socket_receive(net_socket* socket, msghdr* header, void* data, size_t length,
 	if (status != B_OK)
 		return status;
 
-	// process ancillary data
-	if (header != NULL) {
-		if (buffer != NULL && header->msg_control != NULL) {
-			ancillary_data_container* container
-				= gNetBufferModule.get_ancillary_data(buffer);
-			if (container != NULL)
-				status = process_ancillary_data(socket, container, header);
-			else
-				status = process_ancillary_data(socket, buffer, header);
-			if (status != B_OK) {
-				gNetBufferModule.free(buffer);
-				return status;
-			}
-		} else
-			header->msg_controllen = 0;
-	}
-
-	// TODO: - returning a NULL buffer when received 0 bytes
-	//         may not make much sense as we still need the address
-
-	size_t nameLen = 0;
-	if (header != NULL) {
-		// TODO: - consider the control buffer options
-		nameLen = header->msg_namelen;
-		header->msg_namelen = 0;
-		header->msg_flags = 0;
-	}
-
-	if (buffer == NULL)
-		return 0;
-
-	const size_t bytesReceived = buffer->size;
-	size_t bytesCopied = 0;
-
-	size_t toRead = min_c(bytesReceived, length);
-	status = gNetBufferModule.read(buffer, 0, data, toRead);
-	if (status != B_OK) {
-		gNetBufferModule.free(buffer);
-
-		if (status == B_BAD_ADDRESS)
-			return status;
-		return ENOBUFS;
-	}
-
-	// if first copy was a success, proceed to following copies as required
-	bytesCopied += toRead;
-
-	if (header != NULL) {
-		// We start at iovec[1] as { data, length } is iovec[0].
-		for (int i = 1; i < header->msg_iovlen && bytesCopied < bytesReceived; i++) {
-			iovec& vec = header->msg_iov[i];
-			toRead = min_c(bytesReceived - bytesCopied, vec.iov_len);
-			if (gNetBufferModule.read(buffer, bytesCopied, vec.iov_base,
-					toRead) < B_OK) {
-				break;
-			}
-
-			bytesCopied += toRead;
-		}
-
-		if (header->msg_name != NULL) {
-			header->msg_namelen = min_c(nameLen, buffer->source->sa_len);
-			memcpy(header->msg_name, buffer->source, header->msg_namelen);
-		}
-	}
-
-	gNetBufferModule.free(buffer);
-
-	if (bytesCopied < bytesReceived) {
-		if (header != NULL)
-			header->msg_flags = MSG_TRUNC;
-
-		if ((originalFlags & MSG_TRUNC) != 0)
-			return bytesReceived;
-	}
-
-	return bytesCopied;
+	return socket_receive_buffer(socket, buffer, header, data, length,
+		originalFlags);
 }
 
 
@@ -1417,6 +1436,133 @@ socket_send(net_socket* socket, msghdr* header, const void* data, size_t length,
 }
 
 
+/*!	Receives up to \a count messages, and stores the number of bytes received
+	for each of them in its \c msg_len field. If the protocol supports it, the
+	datagrams are dequeued in batches, with a single lock acquisition each.
+	With MSG_WAITFORONE, only the first message is waited for. Once the
+	absolute \a timeout has passed, no further messages are received.
+	Returns the number of messages received, or an error if there were none.
+*/
+ssize_t
+socket_receive_batch(net_socket* socket, mmsghdr* messages, size_t count,
+	int flags, bigtime_t timeout)
+{
+	const bool waitForOne = (flags & MSG_WAITFORONE) != 0;
+	flags &= ~MSG_WAITFORONE;
+
+	const int readFlags = flags & ~(MSG_NOSIGNAL | MSG_TRUNC);
+	status_t status = B_OK;
+	size_t received = 0;
+
+	while (received < count) {
+		int receiveFlags = readFlags;
+		if (received > 0) {
+			if (timeout != B_INFINITE_TIMEOUT && system_time() >= timeout)
+				break;
+			if (waitForOne)
+				receiveFlags |= MSG_DONTWAIT;
+		}
+
+		if (socket->first_info->read_data_batch == NULL) {
+			msghdr& header = messages[received].msg_hdr;
+			void* data = NULL;
+			size_t length = 0;
+			if (header.msg_iovlen > 0) {
+				data = header.msg_iov[0].iov_base;
+				length = header.msg_iov[0].iov_len;
+			}
+
+			ssize_t bytesReceived = socket_receive(socket, &header, data,
+				length, receiveFlags | (flags & MSG_TRUNC));
+			if (bytesReceived < 0) {
+				status = bytesReceived;
+				break;
+			}
+
+			messages[received++].msg_len = bytesReceived;
+			continue;
+		}
+
+		net_buffer* buffers[kMaxReceiveBatchSize];
+		size_t bufferCount = min_c(count - received, kMaxReceiveBatchSize);
+		status = socket->first_info->read_data_batch(socket->first_protocol,
+			receiveFlags, buffers, &bufferCount);
+		if (status != B_OK)
+			break;
+
+		for (size_t i = 0; i < bufferCount; i++) {
+			if (status != B_OK) {
+				// the datagrams after a failed copy are dropped
+				gNetBufferModule.free(buffers[i]);
+				continue;
+			}
+
+			msghdr& header = messages[received].msg_hdr;
+			void* data = NULL;
+			size_t length = 0;
+			if (header.msg_iovlen > 0) {
+				data = header.msg_iov[0].iov_base;
+				length = header.msg_iov[0].iov_len;
+			}
+
+			ssize_t bytesReceived = socket_receive_buffer(socket, buffers[i],
+				&header, data, length, flags);
+			if (bytesReceived < 0) {
+				status = bytesReceived;
+				continue;
+			}
+
+			messages[received++].msg_len = bytesReceived;
+		}
+		if (status != B_OK)
+			break;
+	}
+
+	if (received == 0)
+		return status;
+
+	if (status != B_OK && status != B_WOULD_BLOCK && status != B_TIMED_OUT
+		&& status != B_INTERRUPTED) {
+		// report the error with the next call
+		socket->error = status;
+	}
+
+	return received;
+}
+
+
+/*!	Sends up to \a count messages, and stores the number of bytes sent for
+	each of them in its \c msg_len field.
+	Returns the number of messages sent, or an error if there were none.
+*/
+ssize_t
+socket_send_batch(net_socket* socket, mmsghdr* messages, size_t count,
+	int flags)
+{
+	size_t sent = 0;
+	while (sent < count) {
+		msghdr& header = messages[sent].msg_hdr;
+		void* data = NULL;
+		size_t length = 0;
+		if (header.msg_iovlen > 0) {
+			data = header.msg_iov[0].iov_base;
+			length = header.msg_iov[0].iov_len;
+		}
+
+		ssize_t bytesSent = socket_send(socket, &header, data, length, flags);
+		if (bytesSent < 0) {
+			if (sent == 0)
+				return bytesSent;
+			break;
+		}
+
+		messages[sent++].msg_len = bytesSent;
+	}
+
+	return sent;
+}
+
+
 status_t
 socket_set_option(net_socket* socket, int level, int option, const void* value,
 	int length)
@@ -1701,6 +1847,10 @@ net_socket_module_info gNetSocketModule = {
 	socket_send,
 	socket_setsockopt,
 	socket_shutdown,
-	socket_socketpair
+	socket_socketpair,
+
+	// batched datagram API
+	socket_receive_batch,
+	socket_send_batch
 };
 
@@ -213,6 +213,39 @@ fifo_enqueue_buffer(net_fifo* fifo, net_buffer* buffer)
 }
 
 
+/*!	Enqueues the buffers in the given order with a single lock acquisition,
+	and wakes up as many readers as there are new buffers.
+	Stops at the first buffer that does not fit; \a _count is set to the
+	number of buffers that were enqueued, the rest remain with the caller.
+*/
+status_t
+fifo_enqueue_buffers(net_fifo* fifo, net_buffer** buffers, size_t* _count)
+{
+	MutexLocker locker(fifo->lock);
+
+	size_t count = 0;
+	for (; count < *_count; count++) {
+		net_buffer* buffer = buffers[count];
+		if (fifo->max_bytes > 0
+			&& fifo->current_bytes + buffer->size > fifo->max_bytes)
+			break;
+
+		list_add_item(&fifo->buffers, buffer);
+		fifo->current_bytes += buffer->size;
+	}
+
+	int32 wakeUp = min_c((int32)count, fifo->waiting);
+	if (wakeUp > 0) {
+		fifo->waiting -= wakeUp;
+		release_sem_etc(fifo->notify, wakeUp, B_DO_NOT_RESCHEDULE);
+	}
+
+	status_t status = count == *_count ? B_OK : ENOBUFS;
+	*_count = count;
+	return status;
+}
+
+
 /*!	Gets the first buffer from the FIFO. If there is no buffer, it
 	will wait depending on the \a flags and \a timeout.
 	The following flags are supported:
@@ -280,6 +313,54 @@ fifo_dequeue_buffer(net_fifo* fifo, uint32 flags, bigtime_t timeout,
 }
 
 
+/*!	Like fifo_dequeue_buffer(), but removes up to \a _count buffers at once.
+	Only waits for the first buffer; \a _count is set to the number of
+	buffers returned. MSG_PEEK is not supported.
+*/
+status_t
+fifo_dequeue_buffers(net_fifo* fifo, uint32 flags, bigtime_t timeout,
+	net_buffer** _buffers, size_t* _count)
+{
+	if ((flags & ~MSG_DONTWAIT) != 0)
+		return EOPNOTSUPP;
+	if (*_count == 0)
+		return B_BAD_VALUE;
+
+	MutexLocker locker(fifo->lock);
+	const bool dontWait = (flags & MSG_DONTWAIT) != 0 || timeout == 0;
+
+	while (list_is_empty(&fifo->buffers)) {
+		if (dontWait)
+			return B_WOULD_BLOCK;
+
+		fifo->waiting++;
+		locker.Unlock();
+
+		// we need to wait until a new buffer becomes available
+		status_t status = acquire_sem_etc(fifo->notify, 1,
+			B_CAN_INTERRUPT | B_RELATIVE_TIMEOUT, timeout);
+		if (status < B_OK)
+			return status;
+
+		locker.Lock();
+	}
+
+	size_t count = 0;
+	while (count < *_count) {
+		net_buffer* buffer
+			= (net_buffer*)list_remove_head_item(&fifo->buffers);
+		if (buffer == NULL)
+			break;
+
+		fifo->current_bytes -= buffer->size;
+		_buffers[count++] = buffer;
+	}
+
+	*_count = count;
+	return B_OK;
+}
+
+
 status_t
 clear_fifo(net_fifo* fifo)
 {
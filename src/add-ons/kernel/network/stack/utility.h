@@ -55,8 +55,12 @@ status_t	notify_socket(net_socket* socket, uint8 event, int32 value);
 status_t	init_fifo(net_fifo* fifo, const char *name, size_t maxBytes);
 void		uninit_fifo(net_fifo* fifo);
 status_t	fifo_enqueue_buffer(net_fifo* fifo, struct net_buffer* buffer);
+status_t	fifo_enqueue_buffers(net_fifo* fifo, struct net_buffer** buffers,
+				size_t* _count);
 ssize_t		fifo_dequeue_buffer(net_fifo* fifo, uint32 flags, bigtime_t timeout,
 				struct net_buffer** _buffer);
+status_t	fifo_dequeue_buffers(net_fifo* fifo, uint32 flags, bigtime_t timeout,
+				struct net_buffer** _buffers, size_t* _count);
 status_t	clear_fifo(net_fifo* fifo);
 status_t	fifo_socket_enqueue_buffer(net_fifo* fifo, net_socket* socket,
 				uint8 event, net_buffer* buffer);
@@ -322,6 +322,8 @@ main(int argc, char **argv)
 		dump_block_run("  Log:\t\t\t", disk.Log());
 		printf("\t\t\t%s\n\n", disk.SuperBlock()->flags == SUPER_BLOCK_CLEAN
 			? "cleanly unmounted" : "not unmounted cleanly!");
+		if ((disk.SuperBlock()->features & SUPER_BLOCK_FEATURE_INLINE_DATA) != 0)
+			printf("  Features:\t\tinline file data\n\n");
 		dump_block_run("  Root Directory:\t", disk.Root());
 		putchar('\n');
 	} else if (dumpSuperBlock) {
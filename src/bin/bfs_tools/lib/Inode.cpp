@@ -368,10 +368,12 @@ Inode::GetNextAttribute(char *name, uint32 *type, void **data, size_t *length)
 		else
 			fCurrentSmallData = fCurrentSmallData->Next();
 
-		// skip name attribute
-		if (!fCurrentSmallData->IsLast(fInode)
-			&& fCurrentSmallData->name_size == FILE_NAME_NAME_LENGTH
-			&& *fCurrentSmallData->Name() == FILE_NAME_NAME)
+		// skip name attribute, and inline file data
+		while (!fCurrentSmallData->IsLast(fInode)
+			&& ((fCurrentSmallData->name_size == FILE_NAME_NAME_LENGTH
+					&& *fCurrentSmallData->Name() == FILE_NAME_NAME)
+				|| (fCurrentSmallData->name_size == FILE_DATA_NAME_LENGTH
+					&& *fCurrentSmallData->Name() == FILE_DATA_NAME)))
 			fCurrentSmallData = fCurrentSmallData->Next();
 
 		if (!fCurrentSmallData->IsLast(fInode)) {
@@ -782,6 +784,25 @@ DataStream::ReadAt(off_t pos, void *buffer, size_t size)
 		if (!size)	// there is nothing left to read
 			return 0;
 	}
+
+	if ((fInode->flags & INODE_INLINE_DATA) != 0) {
+		// the file data lives in the small_data section
+		small_data *data = fInode->small_data_start;
+		while (!data->IsLast(fInode)) {
+			if (data->type == FILE_DATA_TYPE
+				&& data->name_size == FILE_DATA_NAME_LENGTH
+				&& *data->Name() == FILE_DATA_NAME)
+				break;
+
+			data = data->Next();
+		}
+		if (data->IsLast(fInode) || pos + (off_t)size > data->data_size)
+			return B_BAD_DATA;
+
+		memcpy(buffer, data->Data() + pos, size);
+		return size;
+	}
+
 	ssize_t read = 0;
 
 	//printf("### read %ld bytes at %lld\n",size,pos);
@@ -58,7 +58,8 @@ struct __attribute__((packed)) disk_super_block
 	int32		magic3;
 	inode_addr	root_dir;
 	inode_addr	indices;
-	int32		pad[8];
+	uint32		features;
+	int32		pad[7];
 };
 
 #define SUPER_BLOCK_FS_LENDIAN		'BIGE'		/* BIGE */
@@ -70,6 +71,8 @@ struct __attribute__((packed)) disk_super_block
 #define SUPER_BLOCK_CLEAN			'CLEN'		/* CLEN */
 #define SUPER_BLOCK_DIRTY			'DIRT'		/* DIRT */
 
+#define SUPER_BLOCK_FEATURE_INLINE_DATA	0x00000001
+
 //**************************************
 
 #define NUM_DIRECT_BLOCKS			12
@@ -107,6 +110,11 @@ struct __attribute__((packed)) small_data
 #define FILE_NAME_NAME			0x13
 #define FILE_NAME_NAME_LENGTH	1
 
+// as is the data of files with the INODE_INLINE_DATA flag
+#define FILE_DATA_TYPE			'RAWT'
+#define FILE_DATA_NAME			0x14
+#define FILE_DATA_NAME_LENGTH	1
+
 // **************************************
 
 #define SHORT_SYMLINK_NAME_LENGTH	144 // length incl. terminating '\0'
@@ -148,6 +156,7 @@ enum inode_flags
 	INODE_DELETED			= 0x00000010,
 	INODE_EMPTY				= 0x00000020,
 	INODE_LONG_SYMLINK		= 0x00000040,	// symlink in data stream
+	INODE_INLINE_DATA		= 0x00000080,	// file data in small_data section
 
 	INODE_PERMANENT_FLAGS	= 0x0000ffff,
 
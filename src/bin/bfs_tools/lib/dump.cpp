@@ -68,6 +68,7 @@ dump_super_block(const disk_super_block *superBlock)
 	Print("  num_ags        = %" B_PRId32 "\n", superBlock->num_ags);
 	Print("  flags          = %#08" B_PRIx32 " (%s)\n", superBlock->flags,
 		get_tupel(superBlock->flags));
+	Print("  features       = %#08" B_PRIx32 "\n", superBlock->features);
 	dump_block_run("  log_blocks     = ", superBlock->log_blocks);
 	Print("  log_start      = %" B_PRIdOFF "\n", superBlock->log_start);
 	Print("  log_end        = %" B_PRIdOFF "\n", superBlock->log_end);
@@ -182,6 +183,10 @@ dump_small_data(Inode *inode)
 			|| item->type == B_STRING_TYPE
 			|| item->type == B_MIME_STRING_TYPE)
 			printf("data = \"%s\", ", item->Data());
+		else if (item->type == FILE_DATA_TYPE
+			&& item->name_size == FILE_DATA_NAME_LENGTH
+			&& *item->Name() == FILE_DATA_NAME)
+			printf("(file data), ");
 
 		printf("%u bytes\n", item->data_size);
 	}
@@ -38,6 +38,7 @@ static const FlagsTypeHandler::FlagInfo kRecvFlagInfos[] = {
 	FLAG_INFO_ENTRY(MSG_MCAST),
 	FLAG_INFO_ENTRY(MSG_EOF),
 	FLAG_INFO_ENTRY(MSG_NOSIGNAL),
+	FLAG_INFO_ENTRY(MSG_WAITFORONE),
 	{ 0, NULL }
 };
 
@@ -119,10 +120,14 @@ patch_network()
 	recvfrom->GetParameter("flags")->SetHandler(new FlagsTypeHandler(kRecvFlags));
 	Syscall *recvmsg = get_syscall("_kern_recvmsg");
 	recvmsg->GetParameter("flags")->SetHandler(new FlagsTypeHandler(kRecvFlags));
+	Syscall *recvmmsg = get_syscall("_kern_recvmmsg");
+	recvmmsg->GetParameter("flags")->SetHandler(new FlagsTypeHandler(kRecvFlags));
 	Syscall *send = get_syscall("_kern_send");
 	send->GetParameter("flags")->SetHandler(new FlagsTypeHandler(kRecvFlags));
 	Syscall *sendmsg = get_syscall("_kern_sendmsg");
 	sendmsg->GetParameter("flags")->SetHandler(new FlagsTypeHandler(kRecvFlags));
+	Syscall *sendmmsg = get_syscall("_kern_sendmmsg");
+	sendmmsg->GetParameter("flags")->SetHandler(new FlagsTypeHandler(kRecvFlags));
 	Syscall *sendto = get_syscall("_kern_sendto");
 	sendto->GetParameter("flags")->SetHandler(new FlagsTypeHandler(kRecvFlags));
 
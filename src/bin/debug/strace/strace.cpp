@@ -672,9 +672,11 @@ main(int argc, const char *const *argv)
 								sSyscallMap["_kern_recv"]->EnableTracing(true);
 								sSyscallMap["_kern_recvfrom"]->EnableTracing(true);
 								sSyscallMap["_kern_recvmsg"]->EnableTracing(true);
+								sSyscallMap["_kern_recvmmsg"]->EnableTracing(true);
 								sSyscallMap["_kern_send"]->EnableTracing(true);
 								sSyscallMap["_kern_sendto"]->EnableTracing(true);
 								sSyscallMap["_kern_sendmsg"]->EnableTracing(true);
+								sSyscallMap["_kern_sendmmsg"]->EnableTracing(true);
 								sSyscallMap["_kern_getsockopt"]->EnableTracing(true);
 								sSyscallMap["_kern_setsockopt"]->EnableTracing(true);
 								sSyscallMap["_kern_getpeername"]->EnableTracing(true);
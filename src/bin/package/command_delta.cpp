@@ -0,0 +1,149 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Entry.h>
+#include <File.h>
+
+#include <package/hpkg/StandardErrorOutput.h>
+
+#include <package/hpkg/PackageDelta.h>
+
+#include "package.h"
+
+
+using BPackageKit::BHPKG::BStandardErrorOutput;
+using BPackageKit::BHPKG::BPrivate::PackageDeltaReader;
+using BPackageKit::BHPKG::BPrivate::PackageDeltaWriter;
+
+
+static bool
+open_file(BFile& file, const char* fileName, uint32 openMode)
+{
+	status_t error = file.SetTo(fileName, openMode);
+	if (error != B_OK) {
+		fprintf(stderr, "Error: Failed to open \"%s\": %s\n", fileName,
+			strerror(error));
+		return false;
+	}
+	return true;
+}
+
+
+int
+command_delta(int argc, const char* const* argv)
+{
+	bool apply = false;
+	bool quiet = false;
+	bool verbose = false;
+
+	while (true) {
+		static struct option sLongOptions[] = {
+			{ "help", no_argument, 0, 'h' },
+			{ "quiet", no_argument, 0, 'q' },
+			{ "verbose", no_argument, 0, 'v' },
+			{ 0, 0, 0, 0 }
+		};
+
+		opterr = 0; // don't print errors
+		int c = getopt_long(argc, (char**)argv, "+ahqv", sLongOptions, NULL);
+		if (c == -1)
+			break;
+
+		switch (c) {
+			case 'a':
+				apply = true;
+				break;
+
+			case 'h':
+				print_usage_and_exit(false);
+				break;
+
+			case 'q':
+				quiet = true;
+				break;
+
+			case 'v':
+				verbose = true;
+				break;
+
+			default:
+				print_usage_and_exit(true);
+				break;
+		}
+	}
+
+	// The remaining arguments are the old package, the new package, and the
+	// delta file, i.e. three more arguments.
+	if (argc - optind != 3)
+		print_usage_and_exit(true);
+
+	const char* oldPackageFileName = argv[optind++];
+	const char* newPackageFileName = argv[optind++];
+	const char* deltaFileName = argv[optind++];
+
+	BStandardErrorOutput errorOutput;
+	BFile oldPackageFile;
+	BFile newPackageFile;
+	BFile deltaFile;
+	if (!open_file(oldPackageFile, oldPackageFileName, B_READ_ONLY))
+		return 1;
+
+	if (apply) {
+		if (!open_file(deltaFile, deltaFileName, B_READ_ONLY)
+			|| !open_file(newPackageFile, newPackageFileName,
+				B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE)) {
+			return 1;
+		}
+
+		PackageDeltaReader deltaReader(&errorOutput);
+		status_t error = deltaReader.Init(&deltaFile);
+		if (error == B_OK)
+			error = deltaReader.Apply(&oldPackageFile, &newPackageFile);
+		if (error != B_OK) {
+			BEntry(newPackageFileName).Remove();
+			return 1;
+		}
+
+		if (verbose) {
+			printf("reconstructed package '%s' (%" B_PRIu64 " bytes)\n",
+				newPackageFileName, deltaReader.NewPackageSize());
+		}
+		return 0;
+	}
+
+	if (!open_file(newPackageFile, newPackageFileName, B_READ_ONLY)
+		|| !open_file(deltaFile, deltaFileName,
+			B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE)) {
+		return 1;
+	}
+
+	PackageDeltaWriter deltaWriter(&errorOutput);
+	status_t error = deltaWriter.WriteDelta(&oldPackageFile, &newPackageFile,
+		&deltaFile);
+	if (error != B_OK) {
+		BEntry(deltaFileName).Remove();
+		return 1;
+	}
+
+	if (!quiet) {
+		off_t deltaSize = 0;
+		deltaFile.GetSize(&deltaSize);
+		uint64 totalSize = deltaWriter.CopiedSize() + deltaWriter.DataSize();
+		printf("wrote delta '%s': %" B_PRIdOFF " bytes, %" B_PRIu64 " of %"
+			B_PRIu64 " package bytes (%.1f%%) reused\n", deltaFileName,
+			deltaSize, deltaWriter.CopiedSize(), totalSize,
+			totalSize > 0 ? deltaWriter.CopiedSize() * 100.0 / totalSize : 0.0);
+	}
+
+	return 0;
+}
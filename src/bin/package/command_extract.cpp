@@ -8,6 +8,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,6 +24,7 @@
 #include <AutoDeleter.h>
 #include <HashString.h>
 
+#include <util/DoublyLinkedList.h>
 #include <util/OpenHashTable.h>
 
 #include <package/hpkg/BlockBufferPoolNoLock.h>
@@ -38,6 +40,8 @@
 #include <package/hpkg/v1/PackageEntryAttribute.h>
 #include <package/hpkg/v1//PackageReader.h>
 
+#include <package/hpkg/PackageFileHeapReader.h>
+
 #include "package.h"
 
 
@@ -48,8 +52,23 @@ using BPackageKit::BHPKG::BBufferPool;
 using BPackageKit::BHPKG::BDataReader;
 using BPackageKit::BHPKG::BErrorOutput;
 using BPackageKit::BHPKG::BFDDataReader;
+using BPackageKit::BHPKG::BPackageData;
 using BPackageKit::BHPKG::BPackageInfoAttributeValue;
 using BPackageKit::BHPKG::BStandardErrorOutput;
+using BPackageKit::BHPKG::BPrivate::PackageFileHeapReader;
+
+
+// maximum number of threads extracting file data in parallel
+static const int32 kMaxExtractThreads = 16;
+
+// number of files that can be queued for extraction per thread
+static const int32 kQueuedFilesPerExtractThread = 4;
+
+// size of the buffer used for copying data
+static const size_t kDataBufferSize = 64 * 1024;
+
+
+class FileDataExtractor;
 
 
 struct VersionPolicyV1 {
@@ -104,6 +123,13 @@ struct VersionPolicyV1 {
 		return BPackageKit::BHPKG::V1::BPackageDataReaderFactory(bufferPool)
 			.CreatePackageDataReader(heapReader, data, _reader);
 	}
+
+	static status_t QueueFileData(FileDataExtractor* extractor, int fd,
+		const PackageData& data, const timespec* times, const BString& path)
+	{
+		// the data of version 1 packages are always extracted serially
+		return B_NOT_SUPPORTED;
+	}
 };
 
 struct VersionPolicyV2 {
@@ -157,9 +183,292 @@ struct VersionPolicyV2 {
 		return BPackageKit::BHPKG::BPackageDataReaderFactory()
 			.CreatePackageDataReader(heapReader, data, _reader);
 	}
+
+	static status_t QueueFileData(FileDataExtractor* extractor, int fd,
+		const PackageData& data, const timespec* times, const BString& path);
+};
+
+
+static status_t
+copy_package_data(BAbstractBufferedDataReader* reader, off_t size,
+	void* buffer, size_t bufferSize, int fd)
+{
+	off_t bytesRemaining = size;
+	off_t offset = 0;
+	while (bytesRemaining > 0) {
+		// read
+		size_t toCopy = std::min((off_t)bufferSize, bytesRemaining);
+		status_t error = reader->ReadData(offset, buffer, toCopy);
+		if (error != B_OK) {
+			fprintf(stderr, "Error: Failed to read data: %s\n",
+				strerror(error));
+			return error;
+		}
+
+		// write
+		ssize_t bytesWritten = write_pos(fd, offset, buffer, toCopy);
+		if (bytesWritten < 0) {
+			fprintf(stderr, "Error: Failed to write data: %s\n",
+				strerror(errno));
+			return errno;
+		}
+		if ((size_t)bytesWritten != toCopy) {
+			fprintf(stderr, "Error: Failed to write all data (%zd of "
+				"%zu)\n", bytesWritten, toCopy);
+			return B_ERROR;
+		}
+
+		offset += toCopy;
+		bytesRemaining -= toCopy;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Extracts the data of regular files on a pool of threads.
+
+	The files are created by the thread parsing the package, so directories
+	are created in order, even though the data of several files are written
+	concurrently. Each thread decompresses the data via its own clone of the
+	heap reader.
+*/
+class FileDataExtractor {
+public:
+	FileDataExtractor()
+		:
+		fHeapReader(NULL),
+		fThreadCount(0),
+		fQueuedJobs(0),
+		fMaxQueuedJobs(0),
+		fFinishing(false),
+		fError(B_OK)
+	{
+		pthread_mutex_init(&fLock, NULL);
+		pthread_cond_init(&fJobAvailableCondition, NULL);
+		pthread_cond_init(&fJobTakenCondition, NULL);
+	}
+
+	~FileDataExtractor()
+	{
+		Finish();
+
+		pthread_cond_destroy(&fJobTakenCondition);
+		pthread_cond_destroy(&fJobAvailableCondition);
+		pthread_mutex_destroy(&fLock);
+	}
+
+	status_t Init(BDataReader* heapReader)
+	{
+		// Only the heap of a version 2 package can be read concurrently.
+		fHeapReader = dynamic_cast<PackageFileHeapReader*>(heapReader);
+		if (fHeapReader == NULL)
+			return B_NOT_SUPPORTED;
+
+		int32 threadCount = std::min((int32)sysconf(_SC_NPROCESSORS_ONLN),
+			kMaxExtractThreads);
+		if (threadCount < 2)
+			return B_NOT_SUPPORTED;
+
+		for (int32 i = 0; i < threadCount; i++) {
+			if (pthread_create(&fThreads[fThreadCount], NULL, &_ThreadEntry,
+					this) == 0) {
+				fThreadCount++;
+			}
+		}
+
+		if (fThreadCount == 0)
+			return B_ERROR;
+
+		fMaxQueuedJobs = fThreadCount * kQueuedFilesPerExtractThread;
+		return B_OK;
+	}
+
+	/*!	Queues writing the given data to the file. The file descriptor is
+		closed when done, even if queuing the data fails. If \a times is not
+		\c NULL, the file's access and modification times are set after the
+		data have been written.
+	*/
+	status_t AddFile(int fd, const BPackageData& data, const timespec* times,
+		const BString& path)
+	{
+		Job* job = new(std::nothrow) Job;
+		if (job == NULL) {
+			close(fd);
+			return B_NO_MEMORY;
+		}
+
+		job->fd = fd;
+		job->data = data;
+		job->setTimes = times != NULL;
+		if (times != NULL) {
+			job->times[0] = times[0];
+			job->times[1] = times[1];
+		}
+		job->path = path;
+
+		pthread_mutex_lock(&fLock);
+
+		while (fQueuedJobs >= fMaxQueuedJobs && fError == B_OK)
+			pthread_cond_wait(&fJobTakenCondition, &fLock);
+
+		status_t error = fError;
+		if (error == B_OK) {
+			fJobs.Add(job);
+			fQueuedJobs++;
+			pthread_cond_signal(&fJobAvailableCondition);
+		}
+
+		pthread_mutex_unlock(&fLock);
+
+		if (error != B_OK) {
+			close(job->fd);
+			delete job;
+		}
+
+		return error;
+	}
+
+	/*!	Waits until the data of all queued files have been written and returns
+		the first error that occurred.
+	*/
+	status_t Finish()
+	{
+		pthread_mutex_lock(&fLock);
+		fFinishing = true;
+		pthread_cond_broadcast(&fJobAvailableCondition);
+		pthread_mutex_unlock(&fLock);
+
+		for (int32 i = 0; i < fThreadCount; i++)
+			pthread_join(fThreads[i], NULL);
+		fThreadCount = 0;
+
+		return fError;
+	}
+
+private:
+	struct Job : DoublyLinkedListLinkImpl<Job> {
+		int				fd;
+		BPackageData	data;
+		timespec		times[2];
+		bool			setTimes;
+		BString			path;
+	};
+
+	typedef DoublyLinkedList<Job> JobList;
+
+private:
+	static void* _ThreadEntry(void* data)
+	{
+		((FileDataExtractor*)data)->_ExtractFiles();
+		return NULL;
+	}
+
+	void _ExtractFiles()
+	{
+		PackageFileHeapReader* heapReader = fHeapReader->Clone();
+		ObjectDeleter<PackageFileHeapReader> heapReaderDeleter(heapReader);
+		void* buffer = malloc(kDataBufferSize);
+		MemoryDeleter bufferDeleter(buffer);
+		if (heapReader == NULL || buffer == NULL) {
+			fprintf(stderr, "Error: Out of memory!\n");
+			_SetError(B_NO_MEMORY);
+		}
+
+		while (Job* job = _NextJob()) {
+			// After an error the remaining jobs are only discarded.
+			if (heapReader != NULL && buffer != NULL && _Error() == B_OK) {
+				status_t error = _ExtractFile(job, heapReader, buffer);
+				if (error != B_OK)
+					_SetError(error);
+			}
+
+			close(job->fd);
+			delete job;
+		}
+	}
+
+	status_t _ExtractFile(Job* job, PackageFileHeapReader* heapReader,
+		void* buffer)
+	{
+		BAbstractBufferedDataReader* reader;
+		status_t error = BPackageKit::BHPKG::BPackageDataReaderFactory()
+			.CreatePackageDataReader(heapReader, job->data, reader);
+		if (error != B_OK) {
+			fprintf(stderr, "Error: Failed to create data reader for \"%s\": "
+				"%s\n", job->path.String(), strerror(error));
+			return error;
+		}
+		ObjectDeleter<BAbstractBufferedDataReader> readerDeleter(reader);
+
+		error = copy_package_data(reader, job->data.Size(), buffer,
+			kDataBufferSize, job->fd);
+		if (error != B_OK)
+			return error;
+
+		if (job->setTimes)
+			futimens(job->fd, job->times);
+
+		return B_OK;
+	}
+
+	Job* _NextJob()
+	{
+		pthread_mutex_lock(&fLock);
+
+		while (fJobs.IsEmpty() && !fFinishing)
+			pthread_cond_wait(&fJobAvailableCondition, &fLock);
+
+		Job* job = fJobs.RemoveHead();
+		if (job != NULL) {
+			fQueuedJobs--;
+			pthread_cond_signal(&fJobTakenCondition);
+		}
+
+		pthread_mutex_unlock(&fLock);
+		return job;
+	}
+
+	status_t _Error()
+	{
+		pthread_mutex_lock(&fLock);
+		status_t error = fError;
+		pthread_mutex_unlock(&fLock);
+		return error;
+	}
+
+	void _SetError(status_t error)
+	{
+		pthread_mutex_lock(&fLock);
+		if (fError == B_OK)
+			fError = error;
+		pthread_cond_broadcast(&fJobTakenCondition);
+		pthread_mutex_unlock(&fLock);
+	}
+
+private:
+	PackageFileHeapReader*	fHeapReader;
+	pthread_t				fThreads[kMaxExtractThreads];
+	int32					fThreadCount;
+	pthread_mutex_t			fLock;
+	pthread_cond_t			fJobAvailableCondition;
+	pthread_cond_t			fJobTakenCondition;
+	JobList					fJobs;
+	int32					fQueuedJobs;
+	int32					fMaxQueuedJobs;
+	bool					fFinishing;
+	status_t				fError;
 };
 
 
+/*static*/ status_t
+VersionPolicyV2::QueueFileData(FileDataExtractor* extractor, int fd,
+	const PackageData& data, const timespec* times, const BString& path)
+{
+	return extractor->AddFile(fd, data, times, path);
+}
+
+
 struct Entry {
 	Entry(Entry* parent, char* name, bool implicit)
 		:
@@ -316,6 +625,7 @@ struct PackageContentExtractHandler : VersionPolicy::PackageContentHandler {
 		fRootFilterEntry(NULL, NULL, true),
 		fBaseDirectory(AT_FDCWD),
 		fInfoFileName(NULL),
+		fFileDataExtractor(NULL),
 		fErrorOccurred(false)
 	{
 	}
@@ -331,7 +641,7 @@ struct PackageContentExtractHandler : VersionPolicy::PackageContentHandler {
 		if (error != B_OK)
 			return error;
 
-		fDataBufferSize = 64 * 1024;
+		fDataBufferSize = kDataBufferSize;
 		fDataBuffer = malloc(fDataBufferSize);
 		if (fDataBuffer == NULL)
 			return B_NO_MEMORY;
@@ -349,6 +659,11 @@ struct PackageContentExtractHandler : VersionPolicy::PackageContentHandler {
 		fInfoFileName = infoFileName;
 	}
 
+	void SetFileDataExtractor(FileDataExtractor* extractor)
+	{
+		fFileDataExtractor = extractor;
+	}
+
 	void SetExtractAll()
 	{
 		fRootFilterEntry.SetExplicit();
@@ -490,6 +805,7 @@ struct PackageContentExtractHandler : VersionPolicy::PackageContentHandler {
 
 		// create the entry
 		int fd = -1;
+		bool dataQueued = false;
 		if (S_ISREG(entry->Mode())) {
 			if (implicit) {
 				fprintf(stderr, "Error: File \"%s\" was specified as a "
@@ -509,11 +825,29 @@ struct PackageContentExtractHandler : VersionPolicy::PackageContentHandler {
 				return errno;
 			}
 
-			// write data
-			status_t error = _ExtractFileData(fPackageFileReader, entry->Data(),
-				fd);
-			if (error != B_OK)
-				return error;
+			off_t size = VersionPolicy::PackageDataUncompressedSize(
+				entry->Data());
+
+			// write data -- let the extractor do that, if there's one, which
+			// also sets the file times afterwards
+			int dataFD = fFileDataExtractor != NULL && size > 0 ? dup(fd) : -1;
+			if (dataFD >= 0) {
+				timespec times[2] = {entry->AccessTime(),
+					entry->ModifiedTime()};
+				status_t error = VersionPolicy::QueueFileData(
+					fFileDataExtractor, dataFD, entry->Data(), times,
+					_EntryPath(entry));
+				if (error != B_OK) {
+					close(fd);
+					return error;
+				}
+				dataQueued = true;
+			} else {
+				status_t error = _ExtractFileData(fPackageFileReader,
+					entry->Data(), fd);
+				if (error != B_OK)
+					return error;
+			}
 		} else if (S_ISLNK(entry->Mode())) {
 			if (implicit) {
 				fprintf(stderr, "Error: Symlink \"%s\" was specified as a "
@@ -559,7 +893,7 @@ struct PackageContentExtractHandler : VersionPolicy::PackageContentHandler {
 		token->fd = fd;
 
 		// set the file times
-		if (!entryExists && !implicit) {
+		if (!entryExists && !implicit && !dataQueued) {
 			timespec times[2] = {entry->AccessTime(), entry->ModifiedTime()};
 			futimens(fd, times);
 
@@ -582,6 +916,29 @@ struct PackageContentExtractHandler : VersionPolicy::PackageContentHandler {
 
 		int entryFD = token->fd;
 
+		// Small attributes -- i.e. almost all of them -- are read completely
+		// and written with a single call.
+		off_t size = VersionPolicy::PackageDataUncompressedSize(
+			attribute->Data());
+		if (size <= (off_t)fDataBufferSize) {
+			status_t error = _ReadData(fPackageFileReader, attribute->Data(),
+				fDataBuffer, size);
+			if (error != B_OK)
+				return error;
+
+			ssize_t bytesWritten = fs_write_attr(entryFD, attribute->Name(),
+				attribute->Type(), 0, fDataBuffer, size);
+			if (bytesWritten != size) {
+				error = bytesWritten < 0 ? errno : B_ERROR;
+				fprintf(stderr, "Error: Failed to write attribute \"%s\" of "
+					"file \"%s\": %s\n", attribute->Name(),
+					_EntryPath(entry).String(), strerror(error));
+				return error;
+			}
+
+			return B_OK;
+		}
+
 		// create the attribute
 		int fd = fs_fopen_attr(entryFD, attribute->Name(), attribute->Type(),
 			O_WRONLY | O_CREAT | O_TRUNC);
@@ -718,36 +1075,30 @@ private:
 		ObjectDeleter<BAbstractBufferedDataReader> readerDeleter(reader);
 
 		// write the data
-		off_t bytesRemaining = VersionPolicy::PackageDataUncompressedSize(data);
-		off_t offset = 0;
-		while (bytesRemaining > 0) {
-			// read
-			size_t toCopy = std::min((off_t)fDataBufferSize, bytesRemaining);
-			error = reader->ReadData(offset, fDataBuffer, toCopy);
-			if (error != B_OK) {
-				fprintf(stderr, "Error: Failed to read data: %s\n",
-					strerror(error));
-				return error;
-			}
+		return copy_package_data(reader,
+			VersionPolicy::PackageDataUncompressedSize(data), fDataBuffer,
+			fDataBufferSize, fd);
+	}
 
-			// write
-			ssize_t bytesWritten = write_pos(fd, offset, fDataBuffer, toCopy);
-			if (bytesWritten < 0) {
-				fprintf(stderr, "Error: Failed to write data: %s\n",
-					strerror(errno));
-				return errno;
-			}
-			if ((size_t)bytesWritten != toCopy) {
-				fprintf(stderr, "Error: Failed to write all data (%zd of "
-					"%zu)\n", bytesWritten, toCopy);
-				return B_ERROR;
-			}
+	status_t _ReadData(typename VersionPolicy::HeapReaderBase* dataReader,
+		const typename VersionPolicy::PackageData& data, void* buffer,
+		size_t size)
+	{
+		// create a PackageDataReader
+		BAbstractBufferedDataReader* reader;
+		status_t error = VersionPolicy::CreatePackageDataReader(fBufferPool,
+			dataReader, data, reader);
+		if (error != B_OK)
+			return error;
+		ObjectDeleter<BAbstractBufferedDataReader> readerDeleter(reader);
 
-			offset += toCopy;
-			bytesRemaining -= toCopy;
+		error = reader->ReadData(0, buffer, size);
+		if (error != B_OK) {
+			fprintf(stderr, "Error: Failed to read data: %s\n",
+				strerror(error));
 		}
 
-		return B_OK;
+		return error;
 	}
 
 private:
@@ -758,6 +1109,7 @@ private:
 	Entry									fRootFilterEntry;
 	int										fBaseDirectory;
 	const char*								fInfoFileName;
+	FileDataExtractor*						fFileDataExtractor;
 	bool									fErrorOccurred;
 };
 
@@ -835,9 +1187,15 @@ do_extract(const char* packageFileName, const char* changeToDirectory,
 	if (packageInfoFileName != NULL)
 		handler.SetPackageInfoFile(packageInfoFileName);
 
+	// extract the file data in parallel, if possible
+	FileDataExtractor fileDataExtractor;
+	if (fileDataExtractor.Init(heapReader) == B_OK)
+		handler.SetFileDataExtractor(&fileDataExtractor);
+
 	// extract
 	error = packageReader.ParseContent(&handler);
-	if (error != B_OK)
+	status_t extractError = fileDataExtractor.Finish();
+	if (error != B_OK || extractError != B_OK)
 		exit(1);
 
 	// check whether all explicitly specified entries have been extracted
@@ -67,6 +67,16 @@ static const char* kUsage =
 	"        -q         - Be quiet (don't show any output except for errors).\n"
 	"        -v         - Be verbose (show more info about created package).\n"
 	"\n"
+	"    delta [ <options> ] <old package> <new package> <delta file>\n"
+	"        Creates the delta file <delta file>, which allows reconstructing\n"
+	"        package file <new package> from package file <old package>.\n"
+	"\n"
+	"        -a         - Apply the delta instead, i.e. write <new package>\n"
+	"                     reconstructed from <old package> and <delta file>.\n"
+	"        -q         - Be quiet (don't show any output except for errors).\n"
+	"        -v         - Be verbose (show more info about reconstructed\n"
+	"                     package).\n"
+	"\n"
 	"    dump [ <options> ] <package>\n"
 	"        Dumps the TOC section of package file <package>. For debugging only.\n"
 	"\n"
@@ -165,6 +175,9 @@ main(int argc, const char* const* argv)
 	if (strcmp(command, "create") == 0)
 		return command_create(argc - 1, argv + 1);
 
+	if (strcmp(command, "delta") == 0)
+		return command_delta(argc - 1, argv + 1);
+
 	if (strcmp(command, "dump") == 0)
 		return command_dump(argc - 1, argv + 1);
 
@@ -14,6 +14,7 @@ int32	parse_compression_argument(const char* arg);
 int		command_add(int argc, const char* const* argv);
 int		command_checksum(int argc, const char* const* argv);
 int		command_create(int argc, const char* const* argv);
+int		command_delta(int argc, const char* const* argv);
 int		command_dump(int argc, const char* const* argv);
 int		command_extract(int argc, const char* const* argv);
 int		command_info(int argc, const char* const* argv);
@@ -7,10 +7,13 @@
 #include <dirent.h>
 #include <errno.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <map>
 
 #include <Entry.h>
@@ -24,6 +27,7 @@
 #include <package/hpkg/RepositoryReader.h>
 #include <package/hpkg/RepositoryWriter.h>
 #include <package/hpkg/StandardErrorOutput.h>
+#include <package/ChecksumAccessors.h>
 #include <package/PackageInfo.h>
 #include <package/PackageInfoContentHandler.h>
 #include <package/RepositoryInfo.h>
@@ -33,10 +37,14 @@
 
 using BPackageKit::BHPKG::BRepositoryWriterListener;
 using BPackageKit::BHPKG::BRepositoryWriter;
+using BPackageKit::BPrivate::GeneralFileChecksumAccessor;
 using namespace BPackageKit::BHPKG;
 using namespace BPackageKit;
 
 
+// maximum number of threads reading package files in parallel
+static const int32 kMaxPackageReaderThreads = 16;
+
 static bool sTrustFilenames = false;
 
 
@@ -151,6 +159,150 @@ private:
 };
 
 
+/*!	Determines what to do with one of the listed package files: Either its
+	package info can be taken over from the source repository, or it is read
+	from the file, including its checksum. The latter is what makes updating
+	a big repository slow, so this is done for all packages in parallel.
+*/
+struct PackageJob {
+	PackageJob(const BString& fileName)
+		:
+		fileName(fileName),
+		packageInfo(),
+		knownInfo(NULL),
+		readByWriter(false),
+		result(B_OK),
+		failedAction(NULL)
+	{
+	}
+
+	void Run(const PackageInfos& packageInfos)
+	{
+		if (sTrustFilenames) {
+			packageInfo.SetFileName(fileName);
+			knownInfo = _Find(packageInfos);
+			if (knownInfo != NULL)
+				return;
+		}
+
+		result = packageInfo.ReadFromPackageFile(fileName.String());
+		if (result != B_OK) {
+			failedAction = "read package-info from";
+			return;
+		}
+
+		if (!sTrustFilenames) {
+			knownInfo = _Find(packageInfos);
+			if (knownInfo != NULL)
+				return;
+		}
+
+		// License files of packages requiring approval of their license must
+		// be added to the repository info, which the repository writer does
+		// when reading the package itself.
+		if ((packageInfo.Flags() & B_PACKAGE_FLAG_APPROVE_LICENSE) != 0) {
+			readByWriter = true;
+			return;
+		}
+
+		BString checksum;
+		result = GeneralFileChecksumAccessor(BEntry(fileName.String()))
+			.GetChecksum(checksum);
+		if (result != B_OK) {
+			failedAction = "compute checksum of";
+			return;
+		}
+		packageInfo.SetChecksum(checksum);
+	}
+
+private:
+	const BPackageInfo* _Find(const PackageInfos& packageInfos) const
+	{
+		PackageInfos::const_iterator it = packageInfos.find(packageInfo);
+		return it != packageInfos.end() ? &it->first : NULL;
+	}
+
+public:
+	BString				fileName;
+	BPackageInfo		packageInfo;
+	const BPackageInfo*	knownInfo;
+		// the package info in the source repository, if unchanged
+	bool				readByWriter;
+	status_t			result;
+	const char*			failedAction;
+};
+
+
+struct PackageJobRunner {
+	PackageJobRunner(BObjectList<PackageJob, true>& jobs,
+		const PackageInfos& packageInfos)
+		:
+		fJobs(jobs),
+		fPackageInfos(packageInfos),
+		fNextJob(0)
+	{
+		pthread_mutex_init(&fLock, NULL);
+	}
+
+	~PackageJobRunner()
+	{
+		pthread_mutex_destroy(&fLock);
+	}
+
+	void Run()
+	{
+		int32 threadCount = std::min(fJobs.CountItems(),
+			std::min((int32)sysconf(_SC_NPROCESSORS_ONLN),
+				kMaxPackageReaderThreads));
+
+		// The current thread runs jobs as well, so it's fine, if creating
+		// any of the additional threads fails.
+		pthread_t threads[kMaxPackageReaderThreads];
+		int32 startedThreads = 0;
+		for (int32 i = 1; i < threadCount; i++) {
+			if (pthread_create(&threads[startedThreads], NULL, &_ThreadEntry,
+					this) == 0) {
+				startedThreads++;
+			}
+		}
+
+		_RunJobs();
+
+		for (int32 i = 0; i < startedThreads; i++)
+			pthread_join(threads[i], NULL);
+	}
+
+private:
+	static void* _ThreadEntry(void* data)
+	{
+		((PackageJobRunner*)data)->_RunJobs();
+		return NULL;
+	}
+
+	void _RunJobs()
+	{
+		while (true) {
+			pthread_mutex_lock(&fLock);
+			PackageJob* job = fJobs.ItemAt(fNextJob);
+			if (job != NULL)
+				fNextJob++;
+			pthread_mutex_unlock(&fLock);
+
+			if (job == NULL)
+				return;
+
+			job->Run(fPackageInfos);
+		}
+	}
+
+private:
+	BObjectList<PackageJob, true>&	fJobs;
+	const PackageInfos&				fPackageInfos;
+	pthread_mutex_t					fLock;
+	int32							fNextJob;
+};
+
+
 class RepositoryWriterListener	: public BRepositoryWriterListener {
 public:
 	RepositoryWriterListener(bool verbose, bool quiet)
@@ -353,40 +505,50 @@ command_update(int argc, const char* const* argv)
 		}
 	}
 
-	// add all given package files
+	// read the package infos of all given package files that aren't in the
+	// source repository
+	BObjectList<PackageJob, true> jobs(packageNames.CountItems());
 	for (int i = 0; i < packageNames.CountItems(); ++i) {
-		BPackageInfo packageInfo;
-
-		if (sTrustFilenames)
-			packageInfo.SetFileName(*packageNames.ItemAt(i));
-		else {
-			if ((result = packageInfo.ReadFromPackageFile(
-					packageNames.ItemAt(i)->String())) != B_OK) {
-				listener.PrintError(
-					"Error: Failed to read package-info from \"%s\": %s\n",
-					packageNames.ItemAt(i)->String(), strerror(result));
-				return 1;
-			}
+		PackageJob* job = new(std::nothrow) PackageJob(
+			*packageNames.ItemAt(i));
+		if (job == NULL || !jobs.AddItem(job)) {
+			delete job;
+			listener.PrintError("Error: Out of memory!\n");
+			return 1;
+		}
+	}
+
+	PackageJobRunner(jobs, packageInfos).Run();
+
+	// add all given package files
+	for (int i = 0; i < jobs.CountItems(); ++i) {
+		PackageJob* job = jobs.ItemAt(i);
+		if (job->result != B_OK) {
+			listener.PrintError("Error: Failed to %s \"%s\": %s\n",
+				job->failedAction, job->fileName.String(),
+				strerror(job->result));
+			return 1;
 		}
 
-		PackageInfos::iterator infoIter = packageInfos.find(packageInfo);
-		if (infoIter != packageInfos.end()) {
-			infoIter->second = true;
-			if ((result = repositoryWriter.AddPackageInfo(infoIter->first))
+		if (job->knownInfo != NULL) {
+			packageInfos[*job->knownInfo] = true;
+			if ((result = repositoryWriter.AddPackageInfo(*job->knownInfo))
 					!= B_OK)
 				return 1;
 			if (verbose) {
-				printf("keeping '%s-%s'\n", infoIter->first.Name().String(),
-					infoIter->first.Version().ToString().String());
+				printf("keeping '%s-%s'\n", job->knownInfo->Name().String(),
+					job->knownInfo->Version().ToString().String());
 			}
 		} else {
-			BEntry entry(packageNames.ItemAt(i)->String());
-			if ((result = repositoryWriter.AddPackage(entry)) != B_OK)
+			if (job->readByWriter) {
+				BEntry entry(job->fileName.String());
+				result = repositoryWriter.AddPackage(entry);
+			} else
+				result = repositoryWriter.AddPackageInfo(job->packageInfo);
+			if (result != B_OK)
 				return 1;
-			if (!quiet) {
-				printf("added '%s' ...\n",
-					packageNames.ItemAt(i)->String());
-			}
+			if (!quiet)
+				printf("added '%s' ...\n", job->fileName.String());
 		}
 	}
 
@@ -42,6 +42,10 @@ static const char* const kLongUsage =
 	"  -H, --home\n"
 	"    Update the packages in the user's home directory. Default is to\n"
 	"    update in the system directory.\n"
+	"  -P, --prefetch\n"
+	"    Download all packages concurrently before applying any changes.\n"
+	"    Downloaded packages are kept in a cache, so an interrupted update\n"
+	"    doesn't need to download them again.\n"
 	"  -y\n"
 	"    Non-interactive mode. Automatically confirm changes, but fail when\n"
 	"    encountering problems.\n"
@@ -58,17 +62,19 @@ UpdateCommand::Execute(int argc, const char* const* argv)
 	BPackageInstallationLocation location
 		= B_PACKAGE_INSTALLATION_LOCATION_SYSTEM;
 	bool interactive = true;
+	bool prefetch = false;
 
 	while (true) {
 		static struct option sLongOptions[] = {
 			{ "debug", required_argument, 0, OPTION_DEBUG },
 			{ "help", no_argument, 0, 'h' },
 			{ "home", no_argument, 0, 'H' },
+			{ "prefetch", no_argument, 0, 'P' },
 			{ 0, 0, 0, 0 }
 		};
 
 		opterr = 0; // don't print errors
-		int c = getopt_long(argc, (char**)argv, "hHy", sLongOptions, NULL);
+		int c = getopt_long(argc, (char**)argv, "hHPy", sLongOptions, NULL);
 		if (c == -1)
 			break;
 
@@ -84,6 +90,10 @@ UpdateCommand::Execute(int argc, const char* const* argv)
 				location = B_PACKAGE_INSTALLATION_LOCATION_HOME;
 				break;
 
+			case 'P':
+				prefetch = true;
+				break;
+
 			case 'y':
 				interactive = false;
 				break;
@@ -101,6 +111,7 @@ UpdateCommand::Execute(int argc, const char* const* argv)
 	// perform the update
 	PackageManager packageManager(location, interactive);
 	packageManager.SetDebugLevel(fCommonOptions.DebugLevel());
+	packageManager.SetPrefetchDownloads(prefetch);
 	packageManager.Update(packages, packageCount);
 
 	return 0;
@@ -13,11 +13,17 @@
 #include "FetchFileJob.h"
 
 #include <stdio.h>
+#include <strings.h>
 #include <sys/wait.h>
 
+#include <algorithm>
+
 #include <Path.h>
 
 #ifdef HAIKU_TARGET_PLATFORM_HAIKU
+#	include <AutoDeleter.h>
+#	include <AutoLocker.h>
+#	include <DataIO.h>
 #	include <HttpRequest.h>
 #	include <UrlRequest.h>
 #	include <UrlProtocolRoster.h>
@@ -34,6 +40,145 @@ namespace BPrivate {
 
 #ifdef HAIKU_TARGET_PLATFORM_HAIKU
 
+
+// Files with at least this many bytes left to download are fetched in several
+// ranges in parallel, if the server supports range requests. That helps when
+// the throughput of a single connection is limited, e.g. by latency.
+static const off_t kMinParallelDownloadSize = 4 * 1024 * 1024;
+static const off_t kMinDownloadRangeSize = 1024 * 1024;
+static const int32 kMaxDownloadRanges = 4;
+
+
+/*!	Downloads a range of the file and writes it to its place in the target
+	file.
+*/
+class FetchFileJob::RangeFetcher : public BDataIO, public BUrlProtocolListener {
+public:
+	RangeFetcher(FetchFileJob* job, BPositionIO* file, off_t start, off_t size)
+		:
+		fJob(job),
+		fFile(file),
+		fStart(start),
+		fSize(size),
+		fBytesWritten(0),
+		fRequest(NULL),
+		fThread(-1),
+		fStatus(B_ERROR),
+		fPartialContent(false)
+	{
+	}
+
+	~RangeFetcher()
+	{
+		delete fRequest;
+	}
+
+	status_t Run(const BString& url)
+	{
+		fRequest = BUrlProtocolRoster::MakeRequest(url.String(), this, this);
+		BHttpRequest* http = dynamic_cast<BHttpRequest*>(fRequest);
+		if (http == NULL)
+			return B_NOT_SUPPORTED;
+
+		http->SetRangeStart(fStart);
+		http->SetRangeEnd(fStart + fSize - 1);
+
+		fThread = fRequest->Run();
+		return fThread >= 0 ? B_OK : fThread;
+	}
+
+	void Wait()
+	{
+		if (fThread >= 0)
+			wait_for_thread(fThread, NULL);
+		fThread = -1;
+	}
+
+	bool Succeeded() const
+	{
+		return fStatus == B_OK && BytesWritten() == fSize;
+	}
+
+	off_t Start() const
+	{
+		return fStart;
+	}
+
+	off_t BytesWritten() const
+	{
+		return atomic_get64(&fBytesWritten);
+	}
+
+	// BDataIO
+	virtual ssize_t Write(const void* buffer, size_t size)
+	{
+		// Only the requested range may end up in the file; anything else,
+		// like an error page, or the whole file from a server ignoring the
+		// range, must not overwrite the other ranges.
+		if (!fPartialContent)
+			return B_BAD_DATA;
+
+		off_t bytesWritten = BytesWritten();
+		if ((off_t)size > fSize - bytesWritten)
+			return B_BAD_DATA;
+
+		ssize_t written = fFile->WriteAt(fStart + bytesWritten, buffer, size);
+		if (written > 0)
+			atomic_add64(&fBytesWritten, written);
+		return written;
+	}
+
+	// BUrlProtocolListener
+	virtual void HeadersReceived(BUrlRequest* request)
+	{
+		// the body is only written once we know it is the requested range
+		const BHttpResult* httpResult
+			= dynamic_cast<const BHttpResult*>(&request->Result());
+		if (httpResult == NULL
+			|| httpResult->StatusCode() != B_HTTP_STATUS_PARTIAL_CONTENT)
+			return;
+
+		off_t start = -1;
+		const char* range = httpResult->Headers()["Content-Range"];
+		if (range != NULL)
+			sscanf(range, "bytes %" B_SCNdOFF "-", &start);
+
+		fPartialContent = start == fStart;
+	}
+
+	virtual void DownloadProgress(BUrlRequest*, off_t bytesReceived,
+		off_t bytesTotal)
+	{
+		fJob->_RangeProgress();
+	}
+
+	virtual void RequestCompleted(BUrlRequest* request, bool success)
+	{
+		fStatus = request->Status();
+		if (fStatus != B_OK)
+			return;
+
+		const BHttpResult* httpResult
+			= dynamic_cast<const BHttpResult*>(&request->Result());
+		if (!success || !fPartialContent || httpResult == NULL
+			|| httpResult->StatusCode() != B_HTTP_STATUS_PARTIAL_CONTENT) {
+			fStatus = B_IO_ERROR;
+		}
+	}
+
+private:
+	FetchFileJob*	fJob;
+	BPositionIO*	fFile;
+	off_t			fStart;
+	off_t			fSize;
+	mutable int64	fBytesWritten;
+	BUrlRequest*	fRequest;
+	thread_id		fThread;
+	status_t		fStatus;
+	bool			fPartialContent;
+};
+
+
 FetchFileJob::FetchFileJob(const BContext& context, const BString& title,
 	const BString& fileURL, const BEntry& targetEntry)
 	:
@@ -42,7 +187,12 @@ FetchFileJob::FetchFileJob(const BContext& context, const BString& title,
 	fTargetEntry(targetEntry),
 	fTargetFile(&targetEntry, B_CREATE_FILE | B_WRITE_ONLY),
 	fError(B_ERROR),
-	fDownloadProgress(0.0)
+	fDownloadProgress(0.0),
+	fBytes(0),
+	fTotalBytes(0),
+	fProgressLock("fetch file job progress"),
+	fRangeFetchers(NULL),
+	fRangesOffset(0)
 {
 }
 
@@ -94,14 +244,29 @@ FetchFileJob::Execute()
 	if (result != B_OK)
 		return result;
 
-	result = FetchUtils::SetFileType(fTargetFile,
-		"application/x-vnd.haiku-package");
-	if (result != B_OK) {
-		fprintf(stderr, "failed to set file type for '%s': %s\n",
-			DownloadFileName(), strerror(result));
+	// Not everything fetched is a package, e.g. package deltas aren't.
+	if (BString(DownloadFileName()).EndsWith(".hpkg")) {
+		result = FetchUtils::SetFileType(fTargetFile,
+			"application/x-vnd.haiku-package");
+		if (result != B_OK) {
+			fprintf(stderr, "failed to set file type for '%s': %s\n",
+				DownloadFileName(), strerror(result));
+		}
+	}
+
+	// If fetching ranges in parallel was interrupted, the file might have
+	// holes, so the download can't be resumed.
+	BNode targetNode(&fTargetEntry);
+	if (FetchUtils::AreDownloadRangesPending(targetNode)) {
+		fTargetFile.SetSize(0);
+		FetchUtils::SetDownloadRangesPending(targetNode, false);
 	}
 
-	do {
+	// Whatever could not be fetched in parallel ranges is fetched by the
+	// sequential download, which resumes where the ranges left off.
+	fError = _FetchRanges() == B_OK ? B_OK : B_IO_ERROR;
+
+	while (fError == B_IO_ERROR || fError == B_DEV_TIMEOUT) {
 		BUrlRequest* request = BUrlProtocolRoster::MakeRequest(fFileURL.String(),
 			&fTargetFile, this);
 		if (request == NULL)
@@ -125,7 +290,7 @@ FetchFileJob::Execute()
 			// returned by the server was probably not part of the file.
 			fTargetFile.SetSize(currentPosition);
 		}
-	} while (fError == B_IO_ERROR || fError == B_DEV_TIMEOUT);
+	}
 
 	if (fError == B_OK) {
 		result = FetchUtils::MarkDownloadComplete(fTargetFile);
@@ -221,6 +386,136 @@ FetchFileJob::Cleanup(status_t jobResult)
 }
 
 
+status_t
+FetchFileJob::_GetRemoteFileSize(off_t& _size)
+{
+	BMallocIO output;
+	BUrlRequest* request = BUrlProtocolRoster::MakeRequest(fFileURL.String(),
+		&output);
+	ObjectDeleter<BUrlRequest> requestDeleter(request);
+	BHttpRequest* http = dynamic_cast<BHttpRequest*>(request);
+	if (http == NULL)
+		return B_NOT_SUPPORTED;
+
+	http->SetMethod(B_HTTP_HEAD);
+
+	thread_id thread = request->Run();
+	if (thread < 0)
+		return thread;
+	wait_for_thread(thread, NULL);
+
+	if (request->Status() != B_OK)
+		return request->Status();
+
+	const BHttpResult& result = dynamic_cast<const BHttpResult&>(
+		request->Result());
+	if (result.StatusCode() != B_HTTP_STATUS_OK)
+		return B_ERROR;
+
+	const char* acceptRanges = result.Headers()["Accept-Ranges"];
+	if (acceptRanges == NULL || strcasecmp(acceptRanges, "bytes") != 0)
+		return B_NOT_SUPPORTED;
+
+	_size = result.Length();
+	return _size > 0 ? B_OK : B_NOT_SUPPORTED;
+}
+
+
+/*!	Fetches the rest of the file in several ranges in parallel.
+	Returns \c B_OK, if the file is complete. Otherwise the file contains the
+	data up to the first range that failed, and the download can be resumed
+	from there.
+*/
+status_t
+FetchFileJob::_FetchRanges()
+{
+	off_t currentPosition;
+	status_t error = fTargetFile.GetSize(&currentPosition);
+	if (error != B_OK)
+		return error;
+
+	off_t fileSize;
+	error = _GetRemoteFileSize(fileSize);
+	if (error != B_OK)
+		return error;
+
+	off_t remainingSize = fileSize - currentPosition;
+	if (remainingSize < kMinParallelDownloadSize)
+		return B_NOT_SUPPORTED;
+
+	int32 rangeCount = std::min((off_t)kMaxDownloadRanges,
+		remainingSize / kMinDownloadRangeSize);
+	off_t rangeSize = (remainingSize + rangeCount - 1) / rangeCount;
+
+	RangeFetcherList fetchers(rangeCount);
+	for (int32 i = 0; i < rangeCount; i++) {
+		off_t start = currentPosition + i * rangeSize;
+		RangeFetcher* fetcher = new(std::nothrow) RangeFetcher(this,
+			&fTargetFile, start, std::min(rangeSize, fileSize - start));
+		if (fetcher == NULL || !fetchers.AddItem(fetcher)) {
+			delete fetcher;
+			return B_NO_MEMORY;
+		}
+	}
+
+	// Until all ranges are complete, the file may have holes.
+	BNode targetNode(&fTargetEntry);
+	error = FetchUtils::SetDownloadRangesPending(targetNode, true);
+	if (error != B_OK)
+		return error;
+
+	fProgressLock.Lock();
+	fRangeFetchers = &fetchers;
+	fRangesOffset = currentPosition;
+	fTotalBytes = fileSize;
+	fProgressLock.Unlock();
+
+	for (int32 i = 0; RangeFetcher* fetcher = fetchers.ItemAt(i); i++)
+		fetcher->Run(fFileURL);
+	for (int32 i = 0; RangeFetcher* fetcher = fetchers.ItemAt(i); i++)
+		fetcher->Wait();
+
+	fProgressLock.Lock();
+	fRangeFetchers = NULL;
+	fProgressLock.Unlock();
+
+	// Keep the data up to the first range that is incomplete, including the
+	// part of that range that has been fetched.
+	off_t validSize = fileSize;
+	for (int32 i = 0; RangeFetcher* fetcher = fetchers.ItemAt(i); i++) {
+		if (!fetcher->Succeeded()) {
+			validSize = fetcher->Start() + fetcher->BytesWritten();
+			break;
+		}
+	}
+
+	error = fTargetFile.SetSize(validSize);
+	if (error == B_OK)
+		error = FetchUtils::SetDownloadRangesPending(targetNode, false);
+	if (error != B_OK)
+		return error;
+
+	return validSize == fileSize ? B_OK : B_PARTIAL_READ;
+}
+
+
+void
+FetchFileJob::_RangeProgress()
+{
+	AutoLocker<BLocker> locker(fProgressLock);
+	if (fRangeFetchers == NULL)
+		return;
+
+	off_t bytes = fRangesOffset;
+	for (int32 i = 0; RangeFetcher* fetcher = fRangeFetchers->ItemAt(i); i++)
+		bytes += fetcher->BytesWritten();
+
+	fBytes = bytes;
+	fDownloadProgress = (float)bytes / fTotalBytes;
+	NotifyStateListeners();
+}
+
+
 #else // HAIKU_TARGET_PLATFORM_HAIKU
 
 
@@ -13,6 +13,8 @@
 #include <String.h>
 
 #ifdef HAIKU_TARGET_PLATFORM_HAIKU
+#	include <Locker.h>
+#	include <ObjectList.h>
 #	include <UrlProtocolListener.h>
 #endif
 
@@ -61,6 +63,17 @@ protected:
 	virtual	status_t			Execute();
 	virtual	void				Cleanup(status_t jobResult);
 
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+private:
+			class RangeFetcher;
+			typedef BObjectList<RangeFetcher, true> RangeFetcherList;
+
+private:
+			status_t			_GetRemoteFileSize(off_t& _size);
+			status_t			_FetchRanges();
+			void				_RangeProgress();
+#endif
+
 private:
 			BString				fFileURL;
 			BEntry				fTargetEntry;
@@ -69,6 +82,11 @@ private:
 			float				fDownloadProgress;
 			off_t				fBytes;
 			off_t				fTotalBytes;
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+			BLocker				fProgressLock;
+			RangeFetcherList*	fRangeFetchers;
+			off_t				fRangesOffset;
+#endif
 };
 
 
@@ -20,6 +20,7 @@ namespace BPrivate {
 
 
 #define DL_COMPLETE_ATTR "Meta:DownloadCompleted"
+#define DL_RANGES_PENDING_ATTR "Meta:DownloadRangesPending"
 
 
 /*static*/ bool
@@ -64,6 +65,28 @@ FetchUtils::SetFileType(BNode& node, const char* type)
         B_MIME_STRING_TYPE, type, strlen(type) + 1);
 }
 
+/*static*/ bool
+FetchUtils::AreDownloadRangesPending(const BNode& node)
+{
+	bool pending;
+	return _GetAttribute(node, DL_RANGES_PENDING_ATTR, B_BOOL_TYPE, &pending,
+		sizeof(pending)) == B_OK && pending;
+}
+
+
+/*static*/ status_t
+FetchUtils::SetDownloadRangesPending(BNode& node, bool pending)
+{
+	if (!pending) {
+		status_t error = node.RemoveAttr(DL_RANGES_PENDING_ATTR);
+		return error == B_ENTRY_NOT_FOUND ? B_OK : error;
+	}
+
+	return _SetAttribute(node, DL_RANGES_PENDING_ATTR,
+		B_BOOL_TYPE, &pending, sizeof(pending));
+}
+
+
 status_t
 FetchUtils::_SetAttribute(BNode& node, const char* attrName,
     type_code type, const void* data, size_t size)
@@ -24,6 +24,10 @@ public:
 
 	static	status_t			SetFileType(BNode& node, const char* type);
 
+	static	bool				AreDownloadRangesPending(const BNode& node);
+	static	status_t			SetDownloadRangesPending(BNode& node,
+									bool pending);
+
 private:
 	static	status_t			_SetAttribute(BNode& node,
 									const char* attrName,
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/hpkg/DecompressedChunkCache.h>
+
+#include <stdlib.h>
+
+#include <new>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+// default number of chunks kept in the cache (64 KiB each)
+static const size_t kDefaultMaxChunks = 64;
+
+static DecompressedChunkCache* sDefaultCache = NULL;
+static pthread_once_t sDefaultCacheInitOnce = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t sHeapIDLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64 sNextHeapID = 1;
+
+
+static void
+init_default_cache()
+{
+	sDefaultCache = new(std::nothrow) DecompressedChunkCache(kDefaultMaxChunks);
+}
+
+
+struct DecompressedChunkCache::ChunkHashDefinition {
+	struct KeyType {
+		uint64	heapID;
+		size_t	index;
+	};
+	typedef Chunk ValueType;
+
+	size_t HashKey(const KeyType& key) const
+	{
+		return size_t(key.heapID * 31 + key.index);
+	}
+
+	size_t Hash(const Chunk* value) const
+	{
+		return size_t(value->fHeapID * 31 + value->fIndex);
+	}
+
+	bool Compare(const KeyType& key, const Chunk* value) const
+	{
+		return value->fHeapID == key.heapID && value->fIndex == key.index;
+	}
+
+	Chunk*& GetLink(Chunk* value) const
+	{
+		return value->fHashNext;
+	}
+};
+
+
+DecompressedChunkCache::DecompressedChunkCache(size_t maxChunks)
+	:
+	fChunks(NULL),
+	fUnusedChunks(),
+	fChunkCount(0),
+	fMaxChunks(maxChunks),
+	fHits(0),
+	fMisses(0)
+{
+	pthread_mutex_init(&fLock, NULL);
+
+	fChunks = new(std::nothrow) ChunkTable;
+	if (fChunks == NULL || fChunks->Init() != B_OK) {
+		// run without caching anything
+		delete fChunks;
+		fChunks = NULL;
+		fMaxChunks = 0;
+	}
+}
+
+
+DecompressedChunkCache::~DecompressedChunkCache()
+{
+	fMaxChunks = 0;
+	_Evict();
+	delete fChunks;
+	pthread_mutex_destroy(&fLock);
+}
+
+
+/*static*/ DecompressedChunkCache*
+DecompressedChunkCache::Default()
+{
+	pthread_once(&sDefaultCacheInitOnce, &init_default_cache);
+	return sDefaultCache;
+}
+
+
+/*static*/ uint64
+DecompressedChunkCache::AllocateHeapID()
+{
+	pthread_mutex_lock(&sHeapIDLock);
+	uint64 heapID = sNextHeapID++;
+	pthread_mutex_unlock(&sHeapIDLock);
+	return heapID;
+}
+
+
+DecompressedChunkCache::Chunk*
+DecompressedChunkCache::Get(uint64 heapID, size_t chunkIndex)
+{
+	pthread_mutex_lock(&fLock);
+
+	ChunkHashDefinition::KeyType key = { heapID, chunkIndex };
+	Chunk* chunk = fChunks != NULL ? fChunks->Lookup(key) : NULL;
+	if (chunk != NULL) {
+		if (chunk->fReferenceCount++ == 0)
+			fUnusedChunks.Remove(chunk);
+		fHits++;
+	} else
+		fMisses++;
+
+	pthread_mutex_unlock(&fLock);
+	return chunk;
+}
+
+
+DecompressedChunkCache::Chunk*
+DecompressedChunkCache::Create(size_t size)
+{
+	pthread_mutex_lock(&fLock);
+
+	if (fMaxChunks == 0) {
+		pthread_mutex_unlock(&fLock);
+		return NULL;
+	}
+
+	// Reuse the least recently used chunk, if the cache is full.
+	Chunk* chunk = NULL;
+	if (fChunkCount >= fMaxChunks)
+		chunk = fUnusedChunks.RemoveHead();
+	if (chunk != NULL) {
+		fChunks->RemoveUnchecked(chunk);
+		fChunkCount--;
+		chunk->fCached = false;
+		chunk->fReferenceCount = 1;
+	}
+
+	pthread_mutex_unlock(&fLock);
+
+	if (chunk != NULL && chunk->fSize < size) {
+		_Delete(chunk);
+		chunk = NULL;
+	}
+
+	if (chunk == NULL) {
+		chunk = new(std::nothrow) Chunk;
+		if (chunk == NULL)
+			return NULL;
+
+		chunk->fData = malloc(size);
+		if (chunk->fData == NULL) {
+			delete chunk;
+			return NULL;
+		}
+
+		chunk->fReferenceCount = 1;
+		chunk->fCached = false;
+	}
+
+	chunk->fSize = size;
+	return chunk;
+}
+
+
+void
+DecompressedChunkCache::Add(uint64 heapID, size_t chunkIndex, Chunk* chunk)
+{
+	pthread_mutex_lock(&fLock);
+
+	// Another thread might have been faster.
+	ChunkHashDefinition::KeyType key = { heapID, chunkIndex };
+	if (fMaxChunks > 0 && fChunks->Lookup(key) == NULL) {
+		chunk->fHeapID = heapID;
+		chunk->fIndex = chunkIndex;
+		chunk->fCached = true;
+		fChunks->InsertUnchecked(chunk);
+		fChunkCount++;
+	}
+
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+DecompressedChunkCache::Put(Chunk* chunk)
+{
+	pthread_mutex_lock(&fLock);
+
+	if (--chunk->fReferenceCount > 0) {
+		pthread_mutex_unlock(&fLock);
+		return;
+	}
+
+	if (!chunk->fCached) {
+		pthread_mutex_unlock(&fLock);
+		_Delete(chunk);
+		return;
+	}
+
+	fUnusedChunks.Add(chunk);
+
+	pthread_mutex_unlock(&fLock);
+
+	// Chunks still in use when the cache was full may have made it exceed its
+	// size.
+	_Evict();
+}
+
+
+void
+DecompressedChunkCache::SetMaxChunks(size_t maxChunks)
+{
+	pthread_mutex_lock(&fLock);
+	if (fChunks != NULL)
+		fMaxChunks = maxChunks;
+	pthread_mutex_unlock(&fLock);
+
+	_Evict();
+}
+
+
+void
+DecompressedChunkCache::GetStatistics(uint64& _hits, uint64& _misses) const
+{
+	pthread_mutex_lock(&fLock);
+	_hits = fHits;
+	_misses = fMisses;
+	pthread_mutex_unlock(&fLock);
+}
+
+
+void
+DecompressedChunkCache::_Evict()
+{
+	ChunkList chunksToDelete;
+
+	pthread_mutex_lock(&fLock);
+
+	while (fChunkCount > fMaxChunks) {
+		Chunk* chunk = fUnusedChunks.RemoveHead();
+		if (chunk == NULL)
+			break;
+
+		fChunks->RemoveUnchecked(chunk);
+		fChunkCount--;
+		chunksToDelete.Add(chunk);
+	}
+
+	pthread_mutex_unlock(&fLock);
+
+	while (Chunk* chunk = chunksToDelete.RemoveHead())
+		_Delete(chunk);
+}
+
+
+void
+DecompressedChunkCache::_Delete(Chunk* chunk)
+{
+	free(chunk->fData);
+	delete chunk;
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
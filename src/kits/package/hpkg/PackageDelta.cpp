@@ -0,0 +1,536 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/hpkg/PackageDelta.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <new>
+
+#include <ByteOrder.h>
+#include <DataIO.h>
+#include <package/hpkg/ErrorOutput.h>
+
+#include <AutoDeleter.h>
+#include <package/hpkg/PackageFileHeapReader.h>
+#include <package/hpkg/PackageReaderImpl.h>
+#include <SHA256.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+static const size_t kBufferSize = PackageFileHeapAccessorBase::kChunkSize;
+
+
+struct ChunkLocation {
+	off_t	offset;
+	size_t	size;
+};
+
+typedef std::map<uint64, ChunkLocation> ChunkMap;
+
+
+static uint64
+hash_chunk(const void* data, size_t size)
+{
+	// FNV-1a
+	const uint8* bytes = (const uint8*)data;
+	uint64 hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+static size_t
+chunk_count(PackageFileHeapReader* heapReader)
+{
+	return (heapReader->UncompressedHeapSize() + heapReader->ChunkSize() - 1)
+		/ heapReader->ChunkSize();
+}
+
+
+static ChunkLocation
+chunk_location(PackageFileHeapReader* heapReader, size_t index)
+{
+	// compressed heap size doesn't include the chunk size table
+	uint64 offset = heapReader->Offsets()[index];
+	uint64 endOffset = index + 1 < chunk_count(heapReader)
+		? heapReader->Offsets()[index + 1]
+		: (uint64)heapReader->CompressedHeapSize();
+
+	ChunkLocation location;
+	location.offset = heapReader->HeapOffset() + offset;
+	location.size = endOffset - offset;
+	return location;
+}
+
+
+static status_t
+compute_checksum(BPositionIO* file, uint64 size, void* buffer, uint8* checksum)
+{
+	SHA256 sha;
+	for (uint64 offset = 0; offset < size;) {
+		size_t toRead = std::min((uint64)kBufferSize, size - offset);
+		status_t error = file->ReadAtExactly(offset, buffer, toRead);
+		if (error != B_OK)
+			return error;
+		sha.Update(buffer, toRead);
+		offset += toRead;
+	}
+
+	memcpy(checksum, sha.Digest(), SHA_DIGEST_LENGTH);
+	return B_OK;
+}
+
+
+// #pragma mark - PackageDeltaWriter
+
+
+PackageDeltaWriter::PackageDeltaWriter(BErrorOutput* errorOutput)
+	:
+	fErrorOutput(errorOutput),
+	fNewPackageFile(NULL),
+	fDeltaFile(NULL),
+	fDeltaOffset(0),
+	fCommandCount(0),
+	fCopiedSize(0),
+	fDataSize(0)
+{
+	fPendingCommand.type = 0;
+}
+
+
+PackageDeltaWriter::~PackageDeltaWriter()
+{
+}
+
+
+status_t
+PackageDeltaWriter::WriteDelta(BPositionIO* oldPackageFile,
+	BPositionIO* newPackageFile, BPositionIO* deltaFile)
+{
+	fNewPackageFile = newPackageFile;
+	fDeltaFile = deltaFile;
+	fDeltaOffset = sizeof(hpkg_delta_header);
+	fCommandCount = 0;
+	fPendingCommand.type = 0;
+	fCopiedSize = 0;
+	fDataSize = 0;
+
+	// open the packages
+	PackageReaderImpl oldPackageReader(fErrorOutput);
+	status_t error = oldPackageReader.Init(oldPackageFile, false, 0);
+	if (error != B_OK)
+		return error;
+
+	PackageReaderImpl newPackageReader(fErrorOutput);
+	error = newPackageReader.Init(newPackageFile, false, 0);
+	if (error != B_OK)
+		return error;
+
+	off_t oldPackageSize;
+	off_t newPackageSize;
+	if ((error = oldPackageFile->GetSize(&oldPackageSize)) != B_OK
+		|| (error = newPackageFile->GetSize(&newPackageSize)) != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to get package file size: "
+			"%s\n", strerror(error));
+		return error;
+	}
+
+	uint8* buffer = (uint8*)malloc(2 * kBufferSize);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter bufferDeleter(buffer);
+	uint8* oldBuffer = buffer + kBufferSize;
+
+	// index the chunks of the old package's heap
+	PackageFileHeapReader* oldHeapReader = oldPackageReader.RawHeapReader();
+	ChunkMap oldChunks;
+	size_t oldChunkCount = chunk_count(oldHeapReader);
+	for (size_t i = 0; i < oldChunkCount; i++) {
+		ChunkLocation location = chunk_location(oldHeapReader, i);
+		error = oldPackageFile->ReadAtExactly(location.offset, buffer,
+			location.size);
+		if (error != B_OK) {
+			fErrorOutput->PrintError("Error: Failed to read old package: %s\n",
+				strerror(error));
+			return error;
+		}
+
+		try {
+			oldChunks.insert(std::make_pair(
+				hash_chunk(buffer, location.size), location));
+		} catch (std::bad_alloc&) {
+			return B_NO_MEMORY;
+		}
+	}
+
+	// The package header is always new. Copy the new package's chunks from
+	// the old package, if it contains them.
+	PackageFileHeapReader* newHeapReader = newPackageReader.RawHeapReader();
+	error = _AddCommand(B_HPKG_DELTA_COMMAND_DATA, 0,
+		newHeapReader->HeapOffset());
+
+	size_t newChunkCount = chunk_count(newHeapReader);
+	for (size_t i = 0; error == B_OK && i < newChunkCount; i++) {
+		ChunkLocation location = chunk_location(newHeapReader, i);
+		error = newPackageFile->ReadAtExactly(location.offset, buffer,
+			location.size);
+		if (error != B_OK) {
+			fErrorOutput->PrintError("Error: Failed to read new package: %s\n",
+				strerror(error));
+			return error;
+		}
+
+		ChunkMap::iterator it = oldChunks.find(
+			hash_chunk(buffer, location.size));
+		if (it != oldChunks.end() && it->second.size == location.size) {
+			error = oldPackageFile->ReadAtExactly(it->second.offset, oldBuffer,
+				location.size);
+			if (error != B_OK)
+				return error;
+
+			if (memcmp(buffer, oldBuffer, location.size) == 0) {
+				error = _AddCommand(B_HPKG_DELTA_COMMAND_COPY,
+					it->second.offset, location.size);
+				continue;
+			}
+		}
+
+		error = _AddCommand(B_HPKG_DELTA_COMMAND_DATA, location.offset,
+			location.size);
+	}
+
+	// the chunk size table follows the chunks
+	off_t chunksEnd = newHeapReader->HeapOffset()
+		+ newHeapReader->CompressedHeapSize();
+	if (error == B_OK && newPackageSize > chunksEnd) {
+		error = _AddCommand(B_HPKG_DELTA_COMMAND_DATA, chunksEnd,
+			newPackageSize - chunksEnd);
+	}
+
+	if (error == B_OK)
+		error = _FlushCommand();
+	if (error != B_OK)
+		return error;
+
+	// write the header
+	hpkg_delta_header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = B_HOST_TO_BENDIAN_INT32(B_HPKG_DELTA_MAGIC);
+	header.header_size = B_HOST_TO_BENDIAN_INT16(sizeof(hpkg_delta_header));
+	header.version = B_HOST_TO_BENDIAN_INT16(B_HPKG_DELTA_VERSION);
+	header.command_count = B_HOST_TO_BENDIAN_INT64(fCommandCount);
+	header.old_package_size = B_HOST_TO_BENDIAN_INT64(oldPackageSize);
+	header.new_package_size = B_HOST_TO_BENDIAN_INT64(newPackageSize);
+
+	error = compute_checksum(oldPackageFile, oldPackageSize, buffer,
+		header.old_package_checksum);
+	if (error == B_OK) {
+		error = compute_checksum(newPackageFile, newPackageSize, buffer,
+			header.new_package_checksum);
+	}
+	if (error != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to compute package checksum: "
+			"%s\n", strerror(error));
+		return error;
+	}
+
+	error = fDeltaFile->WriteAtExactly(0, &header, sizeof(header));
+	if (error != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to write delta file: %s\n",
+			strerror(error));
+	}
+
+	return error;
+}
+
+
+status_t
+PackageDeltaWriter::_AddCommand(uint32 type, uint64 offset, uint64 size)
+{
+	if (size == 0)
+		return B_OK;
+
+	if (fPendingCommand.type == type
+		&& fPendingCommand.offset + fPendingCommand.size == offset) {
+		fPendingCommand.size += size;
+		return B_OK;
+	}
+
+	status_t error = _FlushCommand();
+	if (error != B_OK)
+		return error;
+
+	fPendingCommand.type = type;
+	fPendingCommand.reserved = 0;
+	fPendingCommand.offset = offset;
+	fPendingCommand.size = size;
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaWriter::_FlushCommand()
+{
+	if (fPendingCommand.type == 0)
+		return B_OK;
+
+	bool isData = fPendingCommand.type == B_HPKG_DELTA_COMMAND_DATA;
+
+	hpkg_delta_command command;
+	command.type = B_HOST_TO_BENDIAN_INT32(fPendingCommand.type);
+	command.reserved = 0;
+	command.offset = isData
+		? 0 : B_HOST_TO_BENDIAN_INT64(fPendingCommand.offset);
+	command.size = B_HOST_TO_BENDIAN_INT64(fPendingCommand.size);
+
+	status_t error = fDeltaFile->WriteAtExactly(fDeltaOffset, &command,
+		sizeof(command));
+	if (error != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to write delta file: %s\n",
+			strerror(error));
+		return error;
+	}
+	fDeltaOffset += sizeof(command);
+	fCommandCount++;
+
+	if (!isData) {
+		fCopiedSize += fPendingCommand.size;
+		fPendingCommand.type = 0;
+		return B_OK;
+	}
+
+	// append the data
+	uint8 buffer[4096];
+	uint64 offset = fPendingCommand.offset;
+	uint64 remaining = fPendingCommand.size;
+	while (remaining > 0) {
+		size_t toCopy = std::min((uint64)sizeof(buffer), remaining);
+		error = fNewPackageFile->ReadAtExactly(offset, buffer, toCopy);
+		if (error == B_OK)
+			error = fDeltaFile->WriteAtExactly(fDeltaOffset, buffer, toCopy);
+		if (error != B_OK) {
+			fErrorOutput->PrintError("Error: Failed to copy data to delta "
+				"file: %s\n", strerror(error));
+			return error;
+		}
+
+		offset += toCopy;
+		fDeltaOffset += toCopy;
+		remaining -= toCopy;
+	}
+
+	fDataSize += fPendingCommand.size;
+	fPendingCommand.type = 0;
+	return B_OK;
+}
+
+
+// #pragma mark - PackageDeltaReader
+
+
+PackageDeltaReader::PackageDeltaReader(BErrorOutput* errorOutput)
+	:
+	fErrorOutput(errorOutput),
+	fDeltaFile(NULL)
+{
+	memset(&fHeader, 0, sizeof(fHeader));
+}
+
+
+PackageDeltaReader::~PackageDeltaReader()
+{
+}
+
+
+status_t
+PackageDeltaReader::Init(BPositionIO* deltaFile)
+{
+	fDeltaFile = deltaFile;
+
+	status_t error = fDeltaFile->ReadAtExactly(0, &fHeader, sizeof(fHeader));
+	if (error != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to read delta file header: "
+			"%s\n", strerror(error));
+		return error;
+	}
+
+	fHeader.magic = B_BENDIAN_TO_HOST_INT32(fHeader.magic);
+	fHeader.header_size = B_BENDIAN_TO_HOST_INT16(fHeader.header_size);
+	fHeader.version = B_BENDIAN_TO_HOST_INT16(fHeader.version);
+	fHeader.command_count = B_BENDIAN_TO_HOST_INT64(fHeader.command_count);
+	fHeader.old_package_size
+		= B_BENDIAN_TO_HOST_INT64(fHeader.old_package_size);
+	fHeader.new_package_size
+		= B_BENDIAN_TO_HOST_INT64(fHeader.new_package_size);
+
+	if (fHeader.magic != B_HPKG_DELTA_MAGIC) {
+		fErrorOutput->PrintError("Error: Invalid delta file: Invalid "
+			"magic\n");
+		return B_BAD_DATA;
+	}
+
+	if (fHeader.version != B_HPKG_DELTA_VERSION) {
+		fErrorOutput->PrintError("Error: Invalid/unsupported delta file "
+			"version (%d)\n", fHeader.version);
+		return B_MISMATCHED_VALUES;
+	}
+
+	if (fHeader.header_size < sizeof(hpkg_delta_header)) {
+		fErrorOutput->PrintError("Error: Invalid delta file: Invalid header "
+			"size (%d)\n", fHeader.header_size);
+		return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaReader::Apply(BPositionIO* oldPackageFile,
+	BPositionIO* newPackageFile)
+{
+	status_t error = _CheckOldPackage(oldPackageFile);
+	if (error != B_OK)
+		return error;
+
+	uint8* buffer = (uint8*)malloc(kBufferSize);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter bufferDeleter(buffer);
+
+	SHA256 sha;
+	off_t deltaOffset = fHeader.header_size;
+	uint64 newPackageOffset = 0;
+
+	for (uint64 i = 0; i < fHeader.command_count; i++) {
+		hpkg_delta_command command;
+		error = fDeltaFile->ReadAtExactly(deltaOffset, &command,
+			sizeof(command));
+		if (error != B_OK) {
+			fErrorOutput->PrintError("Error: Failed to read delta file: %s\n",
+				strerror(error));
+			return error;
+		}
+		deltaOffset += sizeof(command);
+
+		uint32 type = B_BENDIAN_TO_HOST_INT32(command.type);
+		uint64 offset = B_BENDIAN_TO_HOST_INT64(command.offset);
+		uint64 size = B_BENDIAN_TO_HOST_INT64(command.size);
+
+		BPositionIO* source;
+		if (type == B_HPKG_DELTA_COMMAND_COPY) {
+			if (offset > fHeader.old_package_size
+				|| size > fHeader.old_package_size - offset) {
+				fErrorOutput->PrintError("Error: Invalid delta file: Copy "
+					"command exceeds the old package\n");
+				return B_BAD_DATA;
+			}
+			source = oldPackageFile;
+		} else if (type == B_HPKG_DELTA_COMMAND_DATA) {
+			source = fDeltaFile;
+			offset = deltaOffset;
+			deltaOffset += size;
+		} else {
+			fErrorOutput->PrintError("Error: Invalid delta file: Unknown "
+				"command type %" B_PRIu32 "\n", type);
+			return B_BAD_DATA;
+		}
+
+		if (size > fHeader.new_package_size - newPackageOffset) {
+			fErrorOutput->PrintError("Error: Invalid delta file: Commands "
+				"exceed the new package size\n");
+			return B_BAD_DATA;
+		}
+
+		while (size > 0) {
+			size_t toCopy = std::min((uint64)kBufferSize, size);
+			error = source->ReadAtExactly(offset, buffer, toCopy);
+			if (error == B_OK) {
+				error = newPackageFile->WriteAtExactly(newPackageOffset,
+					buffer, toCopy);
+			}
+			if (error != B_OK) {
+				fErrorOutput->PrintError("Error: Failed to write package "
+					"data: %s\n", strerror(error));
+				return error;
+			}
+
+			sha.Update(buffer, toCopy);
+			offset += toCopy;
+			newPackageOffset += toCopy;
+			size -= toCopy;
+		}
+	}
+
+	if (newPackageOffset != fHeader.new_package_size
+		|| memcmp(sha.Digest(), fHeader.new_package_checksum,
+			SHA_DIGEST_LENGTH) != 0) {
+		fErrorOutput->PrintError("Error: The reconstructed package doesn't "
+			"match the expected one\n");
+		return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaReader::_CheckOldPackage(BPositionIO* oldPackageFile)
+{
+	off_t size;
+	status_t error = oldPackageFile->GetSize(&size);
+	if (error != B_OK)
+		return error;
+
+	if ((uint64)size != fHeader.old_package_size) {
+		fErrorOutput->PrintError("Error: The delta doesn't apply to the old "
+			"package: Size mismatch\n");
+		return B_MISMATCHED_VALUES;
+	}
+
+	uint8* buffer = (uint8*)malloc(kBufferSize);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter bufferDeleter(buffer);
+
+	uint8 checksum[SHA_DIGEST_LENGTH];
+	error = compute_checksum(oldPackageFile, size, buffer, checksum);
+	if (error != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to read old package: %s\n",
+			strerror(error));
+		return error;
+	}
+
+	if (memcmp(checksum, fHeader.old_package_checksum, SHA_DIGEST_LENGTH)
+			!= 0) {
+		fErrorOutput->PrintError("Error: The delta doesn't apply to the old "
+			"package: Checksum mismatch\n");
+		return B_MISMATCHED_VALUES;
+	}
+
+	return B_OK;
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
@@ -9,11 +9,15 @@
 #include <algorithm>
 #include <new>
 
+#include <DataIO.h>
 #include <package/hpkg/ErrorOutput.h>
 #include <package/hpkg/HPKGDefs.h>
 
 #include <AutoDeleter.h>
 #include <package/hpkg/PoolBuffer.h>
+#ifndef _KERNEL_MODE
+#include <package/hpkg/DecompressedChunkCache.h>
+#endif
 
 
 namespace BPackageKit {
@@ -34,6 +38,9 @@ PackageFileHeapReader::PackageFileHeapReader(BErrorOutput* errorOutput,
 {
 	fCompressedHeapSize = compressedHeapSize;
 	fUncompressedHeapSize = uncompressedHeapSize;
+#ifndef _KERNEL_MODE
+	fHeapID = DecompressedChunkCache::AllocateHeapID();
+#endif
 }
 
 
@@ -147,10 +154,96 @@ PackageFileHeapReader::Clone() const
 		return NULL;
 	}
 
+#ifndef _KERNEL_MODE
+	clone->fHeapID = fHeapID;
+#endif
+
 	return clone;
 }
 
 
+#ifndef _KERNEL_MODE
+
+
+status_t
+PackageFileHeapReader::ReadDataToOutput(off_t offset, size_t size,
+	BDataIO* output)
+{
+	// Small reads of the same chunk -- attributes, small files -- are common,
+	// so we keep the decompressed chunks in the team-wide chunk cache. Reading
+	// an uncompressed heap is cheap enough as is.
+	DecompressedChunkCache* cache = DecompressedChunkCache::Default();
+	if (cache == NULL || fDecompressionAlgorithm == NULL) {
+		return PackageFileHeapAccessorBase::ReadDataToOutput(offset, size,
+			output);
+	}
+
+	if (size == 0)
+		return B_OK;
+
+	if (offset < 0 || (uint64)offset > fUncompressedHeapSize
+		|| size > fUncompressedHeapSize - offset) {
+		return B_BAD_VALUE;
+	}
+
+	void* compressedDataBuffer = NULL;
+	MemoryDeleter compressedDataBufferDeleter;
+
+	size_t chunkIndex = size_t(offset / kChunkSize);
+	size_t inChunkOffset = (uint64)offset - (uint64)chunkIndex * kChunkSize;
+	size_t remainingBytes = size;
+
+	while (remainingBytes > 0) {
+		DecompressedChunkCache::Chunk* chunk = cache->Get(fHeapID, chunkIndex);
+		if (chunk == NULL) {
+			chunk = cache->Create(kChunkSize);
+			if (chunk == NULL) {
+				// The cache is disabled or we're out of memory.
+				return PackageFileHeapAccessorBase::ReadDataToOutput(
+					(off_t)chunkIndex * kChunkSize + inChunkOffset,
+					remainingBytes, output);
+			}
+
+			if (compressedDataBuffer == NULL) {
+				compressedDataBuffer = malloc(kChunkSize);
+				compressedDataBufferDeleter.SetTo(compressedDataBuffer);
+			}
+
+			status_t error = compressedDataBuffer != NULL
+				? ReadAndDecompressChunk(chunkIndex, compressedDataBuffer,
+					chunk->Data())
+				: B_NO_MEMORY;
+			if (error != B_OK) {
+				cache->Put(chunk);
+				return error;
+			}
+
+			cache->Add(fHeapID, chunkIndex, chunk);
+		}
+
+		size_t toWrite = std::min((size_t)kChunkSize - inChunkOffset,
+			remainingBytes);
+			// The last chunk may be shorter than kChunkSize, but since
+			// size (and thus remainingSize) had been clamped, that doesn't
+			// harm.
+		status_t error = output->WriteExactly(
+			(uint8*)chunk->Data() + inChunkOffset, toWrite);
+		cache->Put(chunk);
+		if (error != B_OK)
+			return error;
+
+		remainingBytes -= toWrite;
+		chunkIndex++;
+		inChunkOffset = 0;
+	}
+
+	return B_OK;
+}
+
+
+#endif	// !_KERNEL_MODE
+
+
 status_t
 PackageFileHeapReader::ReadAndDecompressChunk(size_t chunkIndex,
 	void* compressedDataBuffer, void* uncompressedDataBuffer,
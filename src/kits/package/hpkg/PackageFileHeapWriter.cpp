@@ -6,6 +6,9 @@
 
 #include <package/hpkg/PackageFileHeapWriter.h>
 
+#include <pthread.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <new>
 
@@ -24,6 +27,12 @@
 // minimum length of data we require before trying to compress them
 static const size_t kCompressionSizeThreshold = 64;
 
+// maximum number of threads compressing chunks in parallel
+static const int32 kMaxCompressionThreads = 16;
+
+// number of chunks that can be queued for compression per thread
+static const int32 kQueuedChunksPerCompressionThread = 2;
+
 
 namespace BPackageKit {
 
@@ -194,6 +203,196 @@ private:
 };
 
 
+struct PackageFileHeapWriter::CompressionJob {
+	void*		data;
+	void*		compressedData;
+	size_t		size;
+	size_t		compressedSize;
+	status_t	status;
+	bool		done;
+};
+
+
+/*!	A pool of threads compressing chunks in parallel.
+
+	The writer queues full chunks and writes them out in the order they were
+	queued, once their compression is done. The number of queued chunks is
+	bounded, so is the memory used. Only the writer's thread queues and
+	retrieves jobs.
+*/
+class PackageFileHeapWriter::CompressionPool {
+public:
+	CompressionPool(CompressionAlgorithmOwner* compressionAlgorithm)
+		:
+		fCompressionAlgorithm(compressionAlgorithm),
+		fJobs(NULL),
+		fJobCount(0),
+		fThreads(NULL),
+		fThreadCount(0),
+		fOldestJob(0),
+		fNextJobToCompress(0),
+		fNextFreeJob(0),
+		fQuit(false)
+	{
+		pthread_mutex_init(&fLock, NULL);
+		pthread_cond_init(&fJobQueuedCondition, NULL);
+		pthread_cond_init(&fJobDoneCondition, NULL);
+	}
+
+	~CompressionPool()
+	{
+		pthread_mutex_lock(&fLock);
+		fQuit = true;
+		pthread_cond_broadcast(&fJobQueuedCondition);
+		pthread_mutex_unlock(&fLock);
+
+		for (int32 i = 0; i < fThreadCount; i++)
+			pthread_join(fThreads[i], NULL);
+		delete[] fThreads;
+
+		for (int32 i = 0; i < fJobCount; i++) {
+			free(fJobs[i].data);
+			free(fJobs[i].compressedData);
+		}
+		delete[] fJobs;
+
+		pthread_cond_destroy(&fJobDoneCondition);
+		pthread_cond_destroy(&fJobQueuedCondition);
+		pthread_mutex_destroy(&fLock);
+	}
+
+	status_t Init(int32 threadCount)
+	{
+		fJobCount = threadCount * kQueuedChunksPerCompressionThread;
+		fJobs = new(std::nothrow) CompressionJob[fJobCount];
+		if (fJobs == NULL) {
+			fJobCount = 0;
+			return B_NO_MEMORY;
+		}
+
+		for (int32 i = 0; i < fJobCount; i++) {
+			fJobs[i].compressedData = NULL;
+			fJobs[i].data = malloc(kChunkSize);
+		}
+		for (int32 i = 0; i < fJobCount; i++) {
+			fJobs[i].compressedData = malloc(kChunkSize);
+			if (fJobs[i].data == NULL || fJobs[i].compressedData == NULL)
+				return B_NO_MEMORY;
+		}
+
+		fThreads = new(std::nothrow) pthread_t[threadCount];
+		if (fThreads == NULL)
+			return B_NO_MEMORY;
+
+		for (; fThreadCount < threadCount; fThreadCount++) {
+			if (pthread_create(&fThreads[fThreadCount], NULL, &_ThreadEntry,
+					this) != 0) {
+				return B_NO_MORE_THREADS;
+			}
+		}
+
+		return B_OK;
+	}
+
+	int32 CountQueuedJobs() const
+	{
+		return int32(fNextFreeJob - fOldestJob);
+	}
+
+	bool IsFull() const
+	{
+		return CountQueuedJobs() == fJobCount;
+	}
+
+	CompressionJob& NextFreeJob()
+	{
+		return fJobs[fNextFreeJob % fJobCount];
+	}
+
+	void QueueJob(size_t size)
+	{
+		CompressionJob& job = NextFreeJob();
+		job.size = size;
+		job.compressedSize = 0;
+		job.status = B_OK;
+		job.done = false;
+
+		pthread_mutex_lock(&fLock);
+		fNextFreeJob++;
+		pthread_cond_signal(&fJobQueuedCondition);
+		pthread_mutex_unlock(&fLock);
+	}
+
+	CompressionJob& WaitForOldestJob()
+	{
+		CompressionJob& job = fJobs[fOldestJob % fJobCount];
+
+		pthread_mutex_lock(&fLock);
+		while (!job.done)
+			pthread_cond_wait(&fJobDoneCondition, &fLock);
+		pthread_mutex_unlock(&fLock);
+
+		return job;
+	}
+
+	void OldestJobWritten()
+	{
+		fOldestJob++;
+	}
+
+private:
+	static void* _ThreadEntry(void* data)
+	{
+		((CompressionPool*)data)->_Work();
+		return NULL;
+	}
+
+	void _Work()
+	{
+		pthread_mutex_lock(&fLock);
+		while (true) {
+			while (!fQuit && fNextJobToCompress == fNextFreeJob)
+				pthread_cond_wait(&fJobQueuedCondition, &fLock);
+			if (fQuit)
+				break;
+
+			CompressionJob& job = fJobs[fNextJobToCompress++ % fJobCount];
+			pthread_mutex_unlock(&fLock);
+
+			const iovec uncompressed = { job.data, job.size };
+			iovec compressed = { job.compressedData, job.size };
+			status_t error = fCompressionAlgorithm->algorithm->CompressBuffer(
+				uncompressed, compressed, fCompressionAlgorithm->parameters);
+
+			// only use compressed data when we've actually saved space
+			if (error == B_OK && compressed.iov_len == job.size)
+				error = B_BUFFER_OVERFLOW;
+
+			pthread_mutex_lock(&fLock);
+			job.compressedSize = compressed.iov_len;
+			job.status = error;
+			job.done = true;
+			pthread_cond_broadcast(&fJobDoneCondition);
+		}
+		pthread_mutex_unlock(&fLock);
+	}
+
+private:
+	CompressionAlgorithmOwner* fCompressionAlgorithm;
+	CompressionJob*			fJobs;
+	int32					fJobCount;
+	pthread_t*				fThreads;
+	int32					fThreadCount;
+	pthread_mutex_t			fLock;
+	pthread_cond_t			fJobQueuedCondition;
+	pthread_cond_t			fJobDoneCondition;
+	int64					fOldestJob;
+	int64					fNextJobToCompress;
+	int64					fNextFreeJob;
+	bool					fQuit;
+};
+
+
 PackageFileHeapWriter::PackageFileHeapWriter(BErrorOutput* errorOutput,
 	BPositionIO* file, off_t heapOffset,
 	CompressionAlgorithmOwner* compressionAlgorithm,
@@ -205,7 +404,9 @@ PackageFileHeapWriter::PackageFileHeapWriter(BErrorOutput* errorOutput,
 	fCompressedDataBuffer(NULL),
 	fPendingDataSize(0),
 	fOffsets(),
-	fCompressionAlgorithm(compressionAlgorithm)
+	fCompressionAlgorithm(compressionAlgorithm),
+	fCompressionPool(NULL),
+	fCompressionThreadCount(1)
 {
 	if (fCompressionAlgorithm != NULL)
 		fCompressionAlgorithm->AcquireReference();
@@ -222,13 +423,20 @@ PackageFileHeapWriter::~PackageFileHeapWriter()
 
 
 void
-PackageFileHeapWriter::Init()
+PackageFileHeapWriter::Init(int32 compressionThreadCount)
 {
 	// allocate data buffers
 	fPendingDataBuffer = malloc(kChunkSize);
 	fCompressedDataBuffer = malloc(kChunkSize);
 	if (fPendingDataBuffer == NULL || fCompressedDataBuffer == NULL)
 		throw std::bad_alloc();
+
+	// The compression threads are only started once the first full chunk is
+	// written, so small heaps don't pay for them.
+	if (compressionThreadCount < 0)
+		compressionThreadCount = sysconf(_SC_NPROCESSORS_ONLN);
+	fCompressionThreadCount = std::max((int32)1,
+		std::min(compressionThreadCount, kMaxCompressionThreads));
 }
 
 
@@ -318,6 +526,8 @@ PackageFileHeapWriter::RemoveDataRanges(
 	// Before we begin flush any pending data, so we don't need any special
 	// handling and also can use the pending data buffer.
 	status_t status = _FlushPendingData();
+	if (status == B_OK)
+		status = _WriteQueuedChunks();
 	if (status != B_OK)
 		throw status_t(status);
 
@@ -423,6 +633,12 @@ PackageFileHeapWriter::RemoveDataRanges(
 		AddDataThrows((uint8*)uncompressedData + segment.toKeepOffset,
 			segment.toKeepSize);
 
+		// The read ahead above relies on the compressed heap size being up to
+		// date, so don't leave any chunk in the compression queue.
+		status_t error = _WriteQueuedChunks();
+		if (error != B_OK)
+			throw error;
+
 		chunkBuffer.CurrentSegmentDone();
 	}
 
@@ -440,6 +656,8 @@ PackageFileHeapWriter::Finish()
 {
 	// flush pending data, if any
 	status_t error = _FlushPendingData();
+	if (error == B_OK)
+		error = _WriteQueuedChunks();
 	if (error != B_OK)
 		return error;
 
@@ -491,6 +709,13 @@ PackageFileHeapWriter::ReadAndDecompressChunk(size_t chunkIndex,
 		return B_OK;
 	}
 
+	if (chunkIndex >= (size_t)fOffsets.Count()) {
+		// The chunk is still queued for compression.
+		status_t error = _WriteQueuedChunks();
+		if (error != B_OK)
+			return error;
+	}
+
 	uint64 offset = fOffsets[chunkIndex];
 	size_t compressedSize = chunkIndex + 1 == (size_t)fOffsets.Count()
 		? fCompressedHeapSize - offset
@@ -504,6 +729,9 @@ PackageFileHeapWriter::ReadAndDecompressChunk(size_t chunkIndex,
 void
 PackageFileHeapWriter::_Uninit()
 {
+	delete fCompressionPool;
+	fCompressionPool = NULL;
+
 	free(fPendingDataBuffer);
 	free(fCompressedDataBuffer);
 	fPendingDataBuffer = NULL;
@@ -517,6 +745,13 @@ PackageFileHeapWriter::_FlushPendingData()
 	if (fPendingDataSize == 0)
 		return B_OK;
 
+	// Only full chunks are compressed in parallel, the last partial one may
+	// still be read back or extended.
+	if (fPendingDataSize == kChunkSize && fCompressionAlgorithm != NULL
+		&& fCompressionThreadCount > 1) {
+		return _QueuePendingData();
+	}
+
 	status_t error = _WriteChunk(fPendingDataBuffer, fPendingDataSize, true);
 	if (error == B_OK)
 		fPendingDataSize = 0;
@@ -525,10 +760,89 @@ PackageFileHeapWriter::_FlushPendingData()
 }
 
 
+status_t
+PackageFileHeapWriter::_QueuePendingData()
+{
+	if (fCompressionPool == NULL) {
+		fCompressionPool = new(std::nothrow) CompressionPool(
+			fCompressionAlgorithm);
+		status_t error = fCompressionPool != NULL
+			? fCompressionPool->Init(fCompressionThreadCount) : B_NO_MEMORY;
+		if (error != B_OK) {
+			// fall back to compressing on this thread
+			delete fCompressionPool;
+			fCompressionPool = NULL;
+			fCompressionThreadCount = 1;
+			return _FlushPendingData();
+		}
+	}
+
+	// make room in the queue
+	if (fCompressionPool->IsFull()) {
+		status_t error = _WriteQueuedChunks(
+			fCompressionPool->CountQueuedJobs() - 1);
+		if (error != B_OK)
+			return error;
+	}
+
+	// Hand the pending data buffer over to the job and take its buffer in
+	// exchange, so the data don't need to be copied.
+	CompressionJob& job = fCompressionPool->NextFreeJob();
+	std::swap(job.data, fPendingDataBuffer);
+	fCompressionPool->QueueJob(fPendingDataSize);
+	fPendingDataSize = 0;
+
+	return B_OK;
+}
+
+
+status_t
+PackageFileHeapWriter::_WriteQueuedChunks(int32 maxQueued)
+{
+	if (fCompressionPool == NULL)
+		return B_OK;
+
+	while (fCompressionPool->CountQueuedJobs() > maxQueued) {
+		CompressionJob& job = fCompressionPool->WaitForOldestJob();
+
+		if (!fOffsets.Add(fCompressedHeapSize)) {
+			fErrorOutput->PrintError("Out of memory!\n");
+			return B_NO_MEMORY;
+		}
+
+		status_t error;
+		if (job.status == B_OK) {
+			error = _WriteDataUncompressed(job.compressedData,
+				job.compressedSize);
+		} else if (job.status == B_BUFFER_OVERFLOW) {
+			error = _WriteDataUncompressed(job.data, job.size);
+		} else {
+			fErrorOutput->PrintError("Failed to compress chunk data: %s\n",
+				strerror(job.status));
+			error = job.status;
+		}
+
+		if (error != B_OK) {
+			fOffsets.Remove(fOffsets.Count() - 1);
+			return error;
+		}
+
+		fCompressionPool->OldestJobWritten();
+	}
+
+	return B_OK;
+}
+
+
 status_t
 PackageFileHeapWriter::_WriteChunk(const void* data, size_t size,
 	bool mayCompress)
 {
+	// queued chunks go first
+	status_t error = _WriteQueuedChunks();
+	if (error != B_OK)
+		return error;
+
 	// add offset
 	if (!fOffsets.Add(fCompressedHeapSize)) {
 		fErrorOutput->PrintError("Out of memory!\n");
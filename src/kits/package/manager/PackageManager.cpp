@@ -10,10 +10,23 @@
 
 #include <package/manager/PackageManager.h>
 
+#include <ctype.h>
 #include <glob.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <map>
 
 #include <Catalog.h>
 #include <Directory.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <Locker.h>
+#include <ObjectList.h>
+#include <Path.h>
 #include <package/CommitTransactionResult.h>
 #include <package/DownloadFileRequest.h>
 #include <package/PackageRoster.h>
@@ -26,9 +39,13 @@
 #include <package/solver/SolverProblemSolution.h>
 #include <package/solver/SolverResult.h>
 
+#include <AutoDeleter.h>
+#include <AutoLocker.h>
 #include <CopyEngine.h>
 #include <package/ActivationTransaction.h>
 #include <package/DaemonClient.h>
+#include <package/hpkg/PackageDelta.h>
+#include <package/hpkg/StandardErrorOutput.h>
 #include <package/manager/RepositoryBuilder.h>
 #include <package/ValidateChecksumJob.h>
 
@@ -41,6 +58,8 @@ using BPackageKit::BPrivate::FetchUtils;
 #define B_TRANSLATION_CONTEXT "PackageManagerKit"
 
 
+using BPackageKit::BHPKG::BStandardErrorOutput;
+using BPackageKit::BHPKG::BPrivate::PackageDeltaReader;
 using BPackageKit::BPrivate::FetchFileJob;
 using BPackageKit::BPrivate::ValidateChecksumJob;
 
@@ -52,6 +71,145 @@ namespace BManager {
 namespace BPrivate {
 
 
+// Downloaded packages are kept in this subdirectory of the system cache
+// directory, named after their checksums, so that an interrupted or failed
+// transaction doesn't require downloading them again.
+static const char* const kDownloadCacheDirectoryName = "package-downloads";
+
+// the cache is pruned to this size after applying the changes, least recently
+// used packages first
+static const off_t kMaxDownloadCacheSize = 1024 * 1024 * 1024;
+
+// number of packages downloaded concurrently when prefetching
+static const int32 kPrefetchThreadCount = 4;
+
+// A file with this suffix next to a repository's cache records that the
+// repository had no delta index when its cache was last fetched.
+static const char* const kNoDeltasSuffix = ".nodeltas";
+
+
+struct PackageDownload {
+	BString	fileName;
+	BString	url;
+	BString	checksum;
+	BEntry	entry;
+};
+
+
+struct PackageDownloadQueue {
+	BObjectList<PackageDownload, true>	downloads;
+	int32								nextDownload;
+	BLocker								lock;
+
+	PackageDownloadQueue()
+		:
+		downloads(20),
+		nextDownload(0),
+		lock("package download queue")
+	{
+	}
+};
+
+
+static status_t
+prefetch_packages(void* data)
+{
+	PackageDownloadQueue* queue = (PackageDownloadQueue*)data;
+
+	// The jobs' progress isn't reported, since the user interaction handler
+	// isn't prepared to be called from several threads at the same time.
+	BDecisionProvider decisionProvider;
+	BSupportKit::BJobStateListener jobStateListener;
+	BContext context(decisionProvider, jobStateListener);
+
+	while (true) {
+		PackageDownload* download;
+		{
+			AutoLocker<BLocker> locker(queue->lock);
+			download = queue->downloads.ItemAt(queue->nextDownload);
+			if (download == NULL)
+				return B_OK;
+			queue->nextDownload++;
+		}
+
+		status_t error = DownloadFileRequest(context, download->url,
+			download->entry, download->checksum).Process();
+
+		// B_BAD_DATA is returned when there is a checksum mismatch. Make sure
+		// the download is not re-used. Other errors are ignored; the package
+		// is downloaded again when preparing the transaction, which will
+		// report them.
+		if (error == B_BAD_DATA || error == ERANGE)
+			download->entry.Remove();
+
+		AutoLocker<BLocker> locker(queue->lock);
+		if (error == B_OK)
+			printf("Downloaded '%s'\n", download->fileName.String());
+		else {
+			printf("Failed to download '%s': %s\n",
+				download->fileName.String(), strerror(error));
+		}
+	}
+}
+
+
+static status_t
+get_no_deltas_path(const BString& repositoryName, BPath& _path)
+{
+	BPath path;
+	status_t error = BPackageRoster().GetUserRepositoryCachePath(&path, true);
+	if (error != B_OK)
+		return error;
+
+	BString fileName(repositoryName);
+	fileName << kNoDeltasSuffix;
+	return _path.SetTo(path.Path(), fileName);
+}
+
+
+/*!	Returns whether the repository is known not to provide deltas, i.e. its
+	delta index was missing and its cache hasn't changed since.
+*/
+static bool
+repository_has_no_deltas(const BString& repositoryName)
+{
+	BPath path;
+	struct stat markerStat;
+	if (get_no_deltas_path(repositoryName, path) != B_OK
+		|| stat(path.Path(), &markerStat) != 0) {
+		return false;
+	}
+
+	// the user repository cache takes precedence, like in
+	// BPackageRoster::GetRepositoryCache()
+	BPackageRoster roster;
+	struct stat cacheStat;
+	if ((roster.GetUserRepositoryCachePath(&path) != B_OK
+			|| path.Append(repositoryName) != B_OK
+			|| stat(path.Path(), &cacheStat) != 0)
+		&& (roster.GetCommonRepositoryCachePath(&path) != B_OK
+			|| path.Append(repositoryName) != B_OK
+			|| stat(path.Path(), &cacheStat) != 0)) {
+		return false;
+	}
+
+	return markerStat.st_mtime >= cacheStat.st_mtime;
+}
+
+
+static void
+set_repository_has_no_deltas(const BString& repositoryName)
+{
+	BPath path;
+	if (get_no_deltas_path(repositoryName, path) != B_OK)
+		return;
+
+	BFile file(path.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	if (file.InitCheck() == B_OK)
+		file.SetModificationTime(time(NULL));
+}
+
+
 // #pragma mark - BPackageManager
 
 
@@ -70,6 +228,7 @@ BPackageManager::BPackageManager(BPackageInstallationLocation location,
 	fOtherRepositories(10),
 	fLocalRepository(new (std::nothrow) MiscLocalRepository),
 	fTransactions(5),
+	fPrefetchDownloads(false),
 	fInstallationInterface(installationInterface),
 	fUserInteractionHandler(userInteractionHandler)
 {
@@ -156,6 +315,13 @@ BPackageManager::SetDebugLevel(int32 level)
 }
 
 
+void
+BPackageManager::SetPrefetchDownloads(bool prefetch)
+{
+	fPrefetchDownloads = prefetch;
+}
+
+
 void
 BPackageManager::Install(const char* const* packages, int packageCount)
 {
@@ -508,6 +674,9 @@ BPackageManager::_ConfirmChanges(bool fromMostSpecific)
 void
 BPackageManager::_ApplyPackageChanges(bool fromMostSpecific)
 {
+	if (fPrefetchDownloads)
+		_PrefetchPackages();
+
 	int32 count = fInstalledRepositories.CountItems();
 	if (fromMostSpecific) {
 		for (int32 i = count - 1; i >= 0; i--)
@@ -520,6 +689,8 @@ BPackageManager::_ApplyPackageChanges(bool fromMostSpecific)
 	for (int32 i = 0; Transaction* transaction = fTransactions.ItemAt(i); i++)
 		_CommitPackageChanges(*transaction);
 
+	_PruneDownloadCache();
+
 // TODO: Clean up the transaction directories on error!
 }
 
@@ -564,13 +735,30 @@ BPackageManager::_PreparePackageChanges(
 		RemoteRepository* remoteRepository
 			= dynamic_cast<RemoteRepository*>(package->Repository());
 		if (remoteRepository != NULL) {
+			// Download the package into the download cache, if possible, and
+			// copy it into the transaction directory from there.
+			BEntry cacheEntry;
+			bool usingCache = _GetDownloadCacheEntry(package->Info(),
+				cacheEntry) == B_OK;
+			BEntry& downloadEntry = usingCache ? cacheEntry : entry;
+			BPath downloadPath(&downloadEntry);
+
 			bool reusingDownload = false;
+			if (usingCache) {
+				reusingDownload = cacheEntry.Exists();
+				if (reusingDownload) {
+					printf("Re-using download '%s' from the download cache%s\n",
+						downloadPath.Path(),
+						FetchUtils::IsDownloadCompleted(BNode(&cacheEntry))
+							? "" : " (partial)");
+				}
+			}
 
 			// Check for matching files in already existing transaction
 			// directories
 			BPath path(&transaction->TransactionDirectory());
 			BPath parent;
-			if (path.GetParent(&parent) == B_OK) {
+			if (!usingCache && path.GetParent(&parent) == B_OK) {
 				BString globPath = parent.Path();
 				globPath << "/*/" << fileName;
 				glob_t globbuf;
@@ -603,33 +791,62 @@ BPackageManager::_PreparePackageChanges(
 				}
 			}
 
+			// If the package replaces an installed one, the repository might
+			// provide a delta, which is a lot smaller than the package.
+			bool usingDelta = !reusingDownload
+				&& _ReconstructPackageFromDelta(remoteRepository,
+					installationRepository, package,
+					transaction->TransactionDirectory(), downloadEntry);
+
 			// download the package (this will resume the download if the
-			// file already exists)
+			// file already exists, and only validate the checksum, if it has
+			// been reconstructed from a delta)
 			BString url = remoteRepository->Config().PackagesURL();
 			url << '/' << fileName;
 
 			status_t error;
 retryDownload:
-			error = DownloadPackage(url, entry,
+			error = DownloadPackage(url, downloadEntry,
 				package->Info().Checksum());
 			if (error != B_OK) {
 				if (error == B_BAD_DATA || error == ERANGE) {
 					// B_BAD_DATA is returned when there is a checksum
 					// mismatch. Make sure this download is not re-used.
-					entry.Remove();
+					downloadEntry.Remove();
 
 					if (reusingDownload) {
 						// Maybe the download we reused had some problem.
 						// Try again, this time without reusing the download.
 						printf("\nPrevious download '%s' was invalid. Redownloading.\n",
-							path.Path());
+							downloadPath.Path());
 						reusingDownload = false;
 						goto retryDownload;
 					}
+
+					if (usingDelta) {
+						printf("\nPackage '%s' reconstructed from delta was "
+							"invalid. Downloading it.\n", fileName.String());
+						usingDelta = false;
+						goto retryDownload;
+					}
 				}
 				DIE(error, "Failed to download package %s",
 					package->Info().Name().String());
 			}
+
+			if (usingCache) {
+				BPath targetPath(&entry);
+				error = BCopyEngine().CopyEntry(downloadPath.Path(),
+					targetPath.Path());
+				if (error != B_OK) {
+					DIE(error, "Failed to copy package %s from the download "
+						"cache", package->Info().Name().String());
+				}
+
+				// the modification time serves as the last use time when
+				// pruning the cache
+				cacheEntry.SetModificationTime(time(NULL));
+			}
 		} else if (package->Repository() != &installationRepository) {
 			// clone the existing package
 			LocalRepository* localRepository
@@ -692,6 +909,236 @@ BPackageManager::_CommitPackageChanges(Transaction& transaction)
 }
 
 
+void
+BPackageManager::_PrefetchPackages()
+{
+	// collect the packages that still need to be downloaded
+	PackageDownloadQueue queue;
+	for (int32 i = 0;
+		InstalledRepository* repository = fInstalledRepositories.ItemAt(i);
+		i++) {
+		if (!repository->HasChanges())
+			continue;
+
+		PackageList& packagesToActivate = repository->PackagesToActivate();
+		for (int32 k = 0; BSolverPackage* package = packagesToActivate.ItemAt(k);
+			k++) {
+			RemoteRepository* remoteRepository
+				= dynamic_cast<RemoteRepository*>(package->Repository());
+			if (remoteRepository == NULL)
+				continue;
+
+			PackageDownload* download = new PackageDownload;
+			ObjectDeleter<PackageDownload> downloadDeleter(download);
+			if (_GetDownloadCacheEntry(package->Info(), download->entry)
+					!= B_OK
+				|| FetchUtils::IsDownloadCompleted(BNode(&download->entry))) {
+				continue;
+			}
+
+			download->fileName = package->Info().FileName();
+			download->url = remoteRepository->Config().PackagesURL();
+			download->url << '/' << download->fileName;
+			download->checksum = package->Info().Checksum();
+
+			if (!queue.downloads.AddItem(download))
+				throw std::bad_alloc();
+			downloadDeleter.Detach();
+		}
+	}
+
+	int32 downloadCount = queue.downloads.CountItems();
+	if (downloadCount == 0)
+		return;
+
+	printf("Downloading %" B_PRId32 " package(s) ...\n", downloadCount);
+
+	int32 threadCount = std::min(kPrefetchThreadCount, downloadCount);
+	thread_id threads[kPrefetchThreadCount];
+	for (int32 i = 0; i < threadCount; i++) {
+		threads[i] = spawn_thread(&prefetch_packages, "package prefetcher",
+			B_NORMAL_PRIORITY, &queue);
+		if (threads[i] >= 0)
+			resume_thread(threads[i]);
+	}
+
+	for (int32 i = 0; i < threadCount; i++) {
+		if (threads[i] >= 0)
+			wait_for_thread(threads[i], NULL);
+	}
+}
+
+
+status_t
+BPackageManager::_GetDownloadCacheEntry(const BPackageInfo& info,
+	BEntry& _entry)
+{
+	// The checksum is used as file name, so make sure it is a sane one.
+	const BString& checksum = info.Checksum();
+	if (checksum.IsEmpty())
+		return B_BAD_VALUE;
+	for (int32 i = 0; i < checksum.Length(); i++) {
+		if (!isxdigit(checksum[i]))
+			return B_BAD_VALUE;
+	}
+
+	BPath path;
+	status_t error = find_directory(B_SYSTEM_CACHE_DIRECTORY, &path);
+	if (error == B_OK)
+		error = path.Append(kDownloadCacheDirectoryName);
+	if (error == B_OK)
+		error = create_directory(path.Path(), 0755);
+	if (error == B_OK)
+		error = path.Append(BString(checksum) << ".hpkg");
+	if (error == B_OK)
+		error = _entry.SetTo(path.Path());
+	return error;
+}
+
+
+void
+BPackageManager::_PruneDownloadCache()
+{
+	BPath path;
+	if (find_directory(B_SYSTEM_CACHE_DIRECTORY, &path) != B_OK
+		|| path.Append(kDownloadCacheDirectoryName) != B_OK) {
+		return;
+	}
+
+	BDirectory directory;
+	if (directory.SetTo(path.Path()) != B_OK)
+		return;
+
+	// sort the files by modification time, i.e. last use
+	typedef std::multimap<time_t, std::pair<BString, off_t> > FileMap;
+	FileMap files;
+	off_t totalSize = 0;
+
+	BEntry entry;
+	while (directory.GetNextEntry(&entry) == B_OK) {
+		struct stat st;
+		if (entry.GetStat(&st) != B_OK || !S_ISREG(st.st_mode))
+			continue;
+
+		files.insert(std::make_pair(st.st_mtime,
+			std::make_pair(BString(entry.Name()), st.st_size)));
+		totalSize += st.st_size;
+	}
+
+	for (FileMap::iterator it = files.begin();
+		it != files.end() && totalSize > kMaxDownloadCacheSize; ++it) {
+		if (entry.SetTo(&directory, it->second.first) == B_OK
+			&& entry.Remove() == B_OK) {
+			totalSize -= it->second.second;
+		}
+	}
+}
+
+
+bool
+BPackageManager::_ReconstructPackageFromDelta(RemoteRepository* repository,
+	InstalledRepository& installationRepository, BSolverPackage* package,
+	BDirectory& directory, const BEntry& entry)
+{
+	if (repository->Config().BaseURL().IsEmpty())
+		return false;
+
+	// find the installed package the new one replaces
+	BSolverPackage* oldPackage = NULL;
+	PackageList& packagesToDeactivate
+		= installationRepository.PackagesToDeactivate();
+	for (int32 i = 0; BSolverPackage* candidate = packagesToDeactivate.ItemAt(i);
+		i++) {
+		if (candidate->Name() == package->Name()) {
+			oldPackage = candidate;
+			break;
+		}
+	}
+	if (oldPackage == NULL)
+		return false;
+
+	BString deltasURL = repository->Config().BaseURL();
+	deltasURL << "/deltas/";
+
+	// get the repository's delta index, unless done already. Most
+	// repositories don't provide deltas, so a missing index is remembered
+	// until the repository changes, rather than asked for on every update.
+	if (!repository->IsDeltaIndexLoaded()) {
+		BString indexFileName(repository->Name());
+		indexFileName << "-deltas";
+		BEntry indexEntry;
+		if (!repository_has_no_deltas(repository->Name())
+			&& indexEntry.SetTo(&directory, indexFileName) == B_OK) {
+			status_t error = DownloadPackage(BString(deltasURL) << "index",
+				indexEntry, BString());
+			if (error != B_OK) {
+				// don't mistake whatever was written for the index
+				indexEntry.Remove();
+				if (error == B_NAME_NOT_FOUND)
+					set_repository_has_no_deltas(repository->Name());
+			}
+		}
+
+		repository->LoadDeltaIndex(indexEntry);
+		indexEntry.Remove();
+	}
+
+	BString deltaFileName = repository->DeltaFileName(
+		oldPackage->Info().FileName(), package->Info().FileName());
+	if (deltaFileName.IsEmpty())
+		return false;
+
+	BPath oldPackagePath;
+	installationRepository.GetPackagePath(oldPackage, oldPackagePath);
+	BFile oldPackageFile(oldPackagePath.Path(), B_READ_ONLY);
+	if (oldPackageFile.InitCheck() != B_OK)
+		return false;
+
+	// download and apply the delta
+	BString deltaEntryName(package->Info().FileName());
+	deltaEntryName << ".delta";
+	BEntry deltaEntry;
+	status_t error = deltaEntry.SetTo(&directory, deltaEntryName);
+	if (error == B_OK) {
+		error = DownloadPackage(deltasURL << deltaFileName, deltaEntry,
+			BString());
+	}
+
+	if (error == B_OK) {
+		printf("Reconstructing package '%s' from installed '%s'\n",
+			package->Info().FileName().String(),
+			oldPackage->Info().FileName().String());
+
+		BFile deltaFile(&deltaEntry, B_READ_ONLY);
+		BFile packageFile(&entry, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+		BStandardErrorOutput errorOutput;
+		PackageDeltaReader deltaReader(&errorOutput);
+		if ((error = deltaFile.InitCheck()) == B_OK
+			&& (error = packageFile.InitCheck()) == B_OK
+			&& (error = deltaReader.Init(&deltaFile)) == B_OK
+			&& (error = deltaReader.Apply(&oldPackageFile, &packageFile))
+				== B_OK) {
+			FetchUtils::SetFileType(packageFile,
+				"application/x-vnd.haiku-package");
+			error = FetchUtils::MarkDownloadComplete(packageFile);
+		}
+	}
+
+	deltaEntry.Remove();
+
+	if (error != B_OK) {
+		BEntry(entry).Remove();
+		fUserInteractionHandler->Warn(error,
+			B_TRANSLATE("Failed to reconstruct package %s from delta, "
+				"downloading it completely"),
+			package->Info().Name().String());
+		return false;
+	}
+
+	return true;
+}
+
+
 void
 BPackageManager::_ClonePackageFile(LocalRepository* repository,
 	BSolverPackage* package, const BEntry& entry)
@@ -900,7 +1347,9 @@ BPackageManager::RemoteRepository::RemoteRepository(
 	const BRepositoryConfig& config)
 	:
 	BSolverRepository(),
-	fConfig(config)
+	fConfig(config),
+	fDeltaFileNames(),
+	fDeltaIndexLoaded(false)
 {
 }
 
@@ -912,6 +1361,50 @@ BPackageManager::RemoteRepository::Config() const
 }
 
 
+void
+BPackageManager::RemoteRepository::LoadDeltaIndex(const BEntry& entry)
+{
+	// Each line of the index lists the file names of an old and a new package
+	// and of the delta between them (in the repository's "deltas" directory),
+	// separated by white space. A missing index means there are no deltas.
+	fDeltaIndexLoaded = true;
+
+	BPath path;
+	if (entry.GetPath(&path) != B_OK)
+		return;
+
+	FILE* file = fopen(path.Path(), "r");
+	if (file == NULL)
+		return;
+
+	char line[4 * B_FILE_NAME_LENGTH];
+	char oldFileName[B_FILE_NAME_LENGTH];
+	char newFileName[B_FILE_NAME_LENGTH];
+	char deltaFileName[B_FILE_NAME_LENGTH];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (sscanf(line, "%255s %255s %255s", oldFileName, newFileName,
+				deltaFileName) == 3) {
+			fDeltaFileNames[std::string(oldFileName) + '/' + newFileName]
+				= deltaFileName;
+		}
+	}
+
+	fclose(file);
+}
+
+
+BString
+BPackageManager::RemoteRepository::DeltaFileName(const BString& oldFileName,
+	const BString& newFileName) const
+{
+	DeltaFileNameMap::const_iterator it = fDeltaFileNames.find(
+		std::string(oldFileName.String()) + '/' + newFileName.String());
+	if (it == fDeltaFileNames.end())
+		return BString();
+	return BString(it->second.c_str());
+}
+
+
 // #pragma mark - LocalRepository
 
 
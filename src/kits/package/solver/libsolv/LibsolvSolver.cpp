@@ -10,7 +10,12 @@
 #include "LibsolvSolver.h"
 
 #include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 
 #include <new>
 
@@ -18,10 +23,15 @@
 #include <solv/poolarch.h>
 #include <solv/repo.h>
 #include <solv/repo_haiku.h>
+#include <solv/repo_solv.h>
+#include <solv/repo_write.h>
 #include <solv/selection.h>
 #include <solv/solverdebug.h>
 
+#include <FindDirectory.h>
+#include <Path.h>
 #include <package/PackageResolvableExpression.h>
+#include <package/PackageRoster.h>
 #include <package/RepositoryCache.h>
 #include <package/solver/SolverPackage.h>
 #include <package/solver/SolverPackageSpecifier.h>
@@ -31,6 +41,7 @@
 #include <package/solver/SolverResult.h>
 
 #include <AutoDeleter.h>
+#include <AutoDeleterPosix.h>
 #include <ObjectList.h>
 
 
@@ -38,6 +49,21 @@
 // abort()s. Obviously that isn't good behavior for a library.
 
 
+static const uint32 kSolvCacheMagic = 'hslv';
+static const uint32 kSolvCacheVersion = 2;
+
+
+// Precedes the libsolv data in a repository's solv cache file. The file is
+// only used on the machine that wrote it, so host endianess is fine.
+struct solv_cache_header {
+	uint32	magic;
+	uint32	version;
+	uint64	key;
+	int32	packageCount;
+	uint32	reserved;
+};
+
+
 BSolver*
 BPackageKit::create_solver()
 {
@@ -45,6 +71,115 @@ BPackageKit::create_solver()
 }
 
 
+static uint64
+hash_string(uint64 hash, const char* string)
+{
+	// FNV-1a, including the terminating null
+	do {
+		hash ^= (uint8)*string;
+		hash *= 0x100000001b3ULL;
+	} while (*string++ != '\0');
+
+	return hash;
+}
+
+
+static uint64
+hash_value(uint64 hash, uint64 value)
+{
+	for (int i = 0; i < 8; i++, value >>= 8) {
+		hash ^= (uint8)value;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+
+/*!	Hashes the size and modification time of the file at \a path. If there
+	is no such file, the hash just records that.
+*/
+static uint64
+hash_file(uint64 hash, const char* path)
+{
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return hash_value(hash, 0);
+
+	hash = hash_value(hash, 1);
+	hash = hash_value(hash, st.st_size);
+	hash = hash_value(hash, st.st_mtim.tv_sec);
+	return hash_value(hash, st.st_mtim.tv_nsec);
+}
+
+
+/*!	Computes the key identifying the contents of a repository's solv cache.
+	Computing it has to be a lot cheaper than converting the repository, so
+	instead of the package infos it covers the files they were read from:
+	the repository cache file for remote repositories, and the package files
+	for the installed one. Since a repository doesn't need to have been set
+	up from those files, the package file names are included as well.
+*/
+static uint64
+repository_cache_key(BSolverRepository* repository)
+{
+	uint64 hash = 0xcbf29ce484222325ULL;
+
+	BPath systemPackages;
+	BPath userPackages;
+	if (repository->IsInstalled()) {
+		find_directory(B_SYSTEM_PACKAGES_DIRECTORY, &systemPackages);
+		find_directory(B_USER_PACKAGES_DIRECTORY, &userPackages);
+	} else {
+		// the user repository cache takes precedence, like in
+		// BPackageRoster::GetRepositoryCache()
+		BPackageRoster roster;
+		BPath path;
+		if (roster.GetUserRepositoryCachePath(&path) == B_OK
+			&& path.Append(repository->Name()) == B_OK) {
+			hash = hash_file(hash, path.Path());
+		}
+		if (roster.GetCommonRepositoryCachePath(&path) == B_OK
+			&& path.Append(repository->Name()) == B_OK) {
+			hash = hash_file(hash, path.Path());
+		}
+	}
+
+	int32 packageCount = repository->CountPackages();
+	hash = hash_value(hash, packageCount);
+	for (int32 i = 0; i < packageCount; i++) {
+		BString fileName = repository->PackageAt(i)->Info().FileName();
+		hash = hash_string(hash, fileName);
+
+		if (repository->IsInstalled()) {
+			BPath path(systemPackages.Path(), fileName);
+			hash = hash_file(hash, path.Path());
+			path.SetTo(userPackages.Path(), fileName);
+			hash = hash_file(hash, path.Path());
+		}
+	}
+
+	return hash;
+}
+
+
+static status_t
+get_solv_cache_path(BSolverRepository* repository, BPath& _path)
+{
+	BString fileName(repository->Name());
+	if (fileName.IsEmpty() || fileName.FindFirst('/') >= 0)
+		return B_BAD_VALUE;
+	fileName << (repository->IsInstalled() ? ".installed.solv" : ".solv");
+
+	BPath path;
+	status_t error = BPackageRoster().GetUserRepositoryCachePath(&path, true);
+	if (error != B_OK)
+		return error;
+
+	return _path.SetTo(path.Path(), fileName);
+}
+
+
 struct LibsolvSolver::SolvQueue : Queue {
 	SolvQueue()
 	{
@@ -77,7 +212,8 @@ struct LibsolvSolver::RepositoryInfo {
 		:
 		fRepository(repository),
 		fSolvRepo(NULL),
-		fChangeCount(repository->ChangeCount())
+		fChangeCount(repository->ChangeCount()),
+		fUpdateCache(true)
 	{
 	}
 
@@ -106,10 +242,21 @@ struct LibsolvSolver::RepositoryInfo {
 		fChangeCount = fRepository->ChangeCount();
 	}
 
+	bool UpdateCache() const
+	{
+		return fUpdateCache;
+	}
+
+	void SetUpdateCache(bool updateCache)
+	{
+		fUpdateCache = updateCache;
+	}
+
 private:
 	BSolverRepository*	fRepository;
 	Repo*				fSolvRepo;
 	uint64				fChangeCount;
+	bool				fUpdateCache;
 };
 
 
@@ -748,21 +895,47 @@ LibsolvSolver::_AddRepositories()
 		repo->priority = -1 - repository->Priority();
 		repo->appdata = (void*)repositoryInfo;
 
-		int32 packageCount = repository->CountPackages();
-		for (int32 k = 0; k < packageCount; k++) {
-			BSolverPackage* package = repository->PackageAt(k);
-			Id solvableId = repo_add_haiku_package_info(repo, package->Info(),
-				REPO_REUSE_REPODATA | REPO_NO_INTERNALIZE);
+		// Converting the package infos is expensive for big repositories, so
+		// load the repository from its solv cache, if that is up to date.
+		BPath cachePath;
+		uint64 cacheKey = 0;
+		bool useCache = get_solv_cache_path(repository, cachePath) == B_OK;
+		if (useCache)
+			cacheKey = repository_cache_key(repository);
+
+		bool loaded = false;
+		if (useCache) {
+			error = _LoadRepositoryCache(repositoryInfo, cachePath.Path(),
+				cacheKey, loaded);
+			if (error != B_OK)
+				return error;
+		}
 
-			try {
-				fSolvablePackages[solvableId] = package;
-				fPackageSolvables[package] = solvableId;
-			} catch (std::bad_alloc&) {
-				return B_NO_MEMORY;
+		if (!loaded) {
+			int32 packageCount = repository->CountPackages();
+			for (int32 k = 0; k < packageCount; k++) {
+				BSolverPackage* package = repository->PackageAt(k);
+				Id solvableId = repo_add_haiku_package_info(repo,
+					package->Info(), REPO_REUSE_REPODATA | REPO_NO_INTERNALIZE);
+
+				try {
+					fSolvablePackages[solvableId] = package;
+					fPackageSolvables[package] = solvableId;
+				} catch (std::bad_alloc&) {
+					return B_NO_MEMORY;
+				}
 			}
+
+			repo_internalize(repo);
+
+			// Only update the cache for the repository as it was initially
+			// added. Later changes are usually temporary ones made while
+			// computing a transaction.
+			if (useCache && repositoryInfo->UpdateCache())
+				_StoreRepositoryCache(repositoryInfo, cachePath.Path(), cacheKey);
 		}
 
-		repo_internalize(repo);
+		repositoryInfo->SetUpdateCache(false);
 
 		if (repository->IsInstalled()) {
 			fInstalledRepository = repositoryInfo;
@@ -779,6 +952,108 @@ LibsolvSolver::_AddRepositories()
 }
 
 
+status_t
+LibsolvSolver::_LoadRepositoryCache(RepositoryInfo* repositoryInfo,
+	const char* path, uint64 key, bool& _loaded)
+{
+	_loaded = false;
+
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+		return B_OK;
+	FileCloser fileCloser(file);
+
+	BSolverRepository* repository = repositoryInfo->Repository();
+	int32 packageCount = repository->CountPackages();
+
+	solv_cache_header header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+		|| header.magic != kSolvCacheMagic
+		|| header.version != kSolvCacheVersion || header.key != key
+		|| header.packageCount != packageCount) {
+		return B_OK;
+	}
+
+	Repo* repo = repositoryInfo->SolvRepo();
+	if (repo_add_solv(repo, file, 0) != 0) {
+		repo_empty(repo, 1);
+		return B_OK;
+	}
+
+	// The solvables are in the order the packages were added in. Verify that
+	// the names match before relying on that.
+	int32 index = 0;
+	Id solvableId;
+	Solvable* solvable;
+	FOR_REPO_SOLVABLES(repo, solvableId, solvable) {
+		BSolverPackage* package = repository->PackageAt(index++);
+		const char* name = pool_id2str(fPool, solvable->name);
+		if (package == NULL || strncmp(name, "pkg:", 4) != 0
+			|| package->Name() != name + 4) {
+			index = -1;
+			break;
+		}
+	}
+
+	if (index != packageCount) {
+		repo_empty(repo, 1);
+		return B_OK;
+	}
+
+	index = 0;
+	FOR_REPO_SOLVABLES(repo, solvableId, solvable) {
+		BSolverPackage* package = repository->PackageAt(index++);
+		try {
+			fSolvablePackages[solvableId] = package;
+			fPackageSolvables[package] = solvableId;
+		} catch (std::bad_alloc&) {
+			return B_NO_MEMORY;
+		}
+	}
+
+	_loaded = true;
+	return B_OK;
+}
+
+
+void
+LibsolvSolver::_StoreRepositoryCache(RepositoryInfo* repositoryInfo,
+	const char* path, uint64 key)
+{
+	// Write to a temporary file first, so concurrent readers never see a
+	// partially written cache. Its name is unique, as other solvers might
+	// store the same cache at the same time.
+	BString tempPath(path);
+	tempPath << ".XXXXXX";
+
+	int fd = mkstemp(tempPath.LockBuffer(0));
+	tempPath.UnlockBuffer();
+	if (fd < 0)
+		return;
+
+	FILE* file = fdopen(fd, "w");
+	if (file == NULL) {
+		close(fd);
+		unlink(tempPath.String());
+		return;
+	}
+
+	solv_cache_header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = kSolvCacheMagic;
+	header.version = kSolvCacheVersion;
+	header.key = key;
+	header.packageCount = repositoryInfo->Repository()->CountPackages();
+
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1
+		&& repo_write(repositoryInfo->SolvRepo(), file) == 0;
+	success = fclose(file) == 0 && success;
+
+	if (!success || rename(tempPath.String(), path) != 0)
+		unlink(tempPath.String());
+}
+
+
 LibsolvSolver::RepositoryInfo*
 LibsolvSolver::_InstalledRepository() const
 {
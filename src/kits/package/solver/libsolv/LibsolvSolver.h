@@ -95,6 +95,13 @@ private:
 
 			bool				_HaveRepositoriesChanged() const;
 			status_t			_AddRepositories();
+			status_t			_LoadRepositoryCache(
+									RepositoryInfo* repositoryInfo,
+									const char* path, uint64 key,
+									bool& _loaded);
+			void				_StoreRepositoryCache(
+									RepositoryInfo* repositoryInfo,
+									const char* path, uint64 key);
 			RepositoryInfo*		_InstalledRepository() const;
 			RepositoryInfo*		_GetRepositoryInfo(
 									BSolverRepository* repository) const;
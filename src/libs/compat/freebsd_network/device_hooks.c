@@ -109,31 +109,9 @@ compat_free(void *cookie)
 
 
 static status_t
-compat_receive(void *cookie, net_buffer **_buffer)
+mbuf_to_net_buffer(struct mbuf *mb, net_buffer **_buffer)
 {
-	struct ifnet *ifp = cookie;
-	uint32 semFlags = B_CAN_INTERRUPT;
-	status_t status;
-	struct mbuf *mb;
-
-	//if_printf(ifp, "compat_receive(%p)\n", _buffer);
-
-	if ((ifp->flags & DEVICE_CLOSED) != 0)
-		return B_INTERRUPTED;
-
-	if (ifp->flags & DEVICE_NON_BLOCK)
-		semFlags |= B_RELATIVE_TIMEOUT;
-
-	do {
-		status = acquire_sem_etc(ifp->receive_sem, 1, semFlags, 0);
-		if ((ifp->flags & DEVICE_CLOSED) != 0)
-			return B_INTERRUPTED;
-
-		if (status != B_OK)
-			return status;
-
-		IF_DEQUEUE(&ifp->receive_queue, mb);
-	} while (mb == NULL);
+	status_t status = B_OK;
 
 	net_buffer *buffer = gBufferModule->create(0);
 	if (buffer == NULL) {
@@ -163,6 +141,95 @@ compat_receive(void *cookie, net_buffer **_buffer)
 }
 
 
+/*!	Receives up to \a _count packets, but only waits for the first one. All
+	packets that are available are taken from the receive queue with a single
+	lock acquisition.
+*/
+static status_t
+compat_receive_batch(void *cookie, net_buffer **_buffers, uint32 *_count)
+{
+	struct ifnet *ifp = cookie;
+	uint32 semFlags = B_CAN_INTERRUPT;
+	status_t status;
+	struct mbuf *head = NULL;
+	struct mbuf *tail = NULL;
+	uint32 count = 0;
+
+	//if_printf(ifp, "compat_receive_batch(%p, %" B_PRIu32 ")\n", _buffers,
+	//	*_count);
+
+	if (*_count == 0)
+		return B_BAD_VALUE;
+
+	if ((ifp->flags & DEVICE_CLOSED) != 0)
+		return B_INTERRUPTED;
+
+	if (ifp->flags & DEVICE_NON_BLOCK)
+		semFlags |= B_RELATIVE_TIMEOUT;
+
+	do {
+		int32 wanted = 1;
+		int32 available = 0;
+
+		status = acquire_sem_etc(ifp->receive_sem, 1, semFlags, 0);
+		if ((ifp->flags & DEVICE_CLOSED) != 0)
+			return B_INTERRUPTED;
+
+		if (status != B_OK)
+			return status;
+
+		// also take whatever else is already there
+		get_sem_count(ifp->receive_sem, &available);
+		if (available > 0 && *_count > 1) {
+			int32 more = min_c((uint32)available, *_count - 1);
+			if (acquire_sem_etc(ifp->receive_sem, more, B_RELATIVE_TIMEOUT,
+					0) == B_OK) {
+				wanted += more;
+			}
+		}
+
+		IF_LOCK(&ifp->receive_queue);
+		for (; wanted > 0; wanted--) {
+			struct mbuf *mb;
+			_IF_DEQUEUE(&ifp->receive_queue, mb);
+			if (mb == NULL)
+				break;
+
+			if (tail == NULL)
+				head = mb;
+			else
+				tail->m_nextpkt = mb;
+			tail = mb;
+		}
+		IF_UNLOCK(&ifp->receive_queue);
+	} while (head == NULL);
+
+	while (head != NULL) {
+		struct mbuf *mb = head;
+		head = mb->m_nextpkt;
+		mb->m_nextpkt = NULL;
+
+		status = mbuf_to_net_buffer(mb, &_buffers[count]);
+		if (status == B_OK)
+			count++;
+	}
+
+	if (count == 0)
+		return status;
+
+	*_count = count;
+	return B_OK;
+}
+
+
+static status_t
+compat_receive(void *cookie, net_buffer **_buffer)
+{
+	uint32 count = 1;
+	return compat_receive_batch(cookie, _buffer, &count);
+}
+
+
 static status_t
 compat_send(void *cookie, net_buffer *buffer)
 {
@@ -346,6 +413,17 @@ compat_control(void *cookie, uint32 op, void *arg, size_t length)
 				return B_BAD_ADDRESS;
 			return compat_receive(cookie, (net_buffer**)arg);
 
+		case ETHER_RECEIVE_NET_BUFFERS:
+		{
+			ether_receive_net_buffers_t *request = arg;
+			if (arg == NULL || length != sizeof(ether_receive_net_buffers_t))
+				return B_BAD_DATA;
+			if (!IS_KERNEL_ADDRESS(arg) || !IS_KERNEL_ADDRESS(request->buffers))
+				return B_BAD_ADDRESS;
+			return compat_receive_batch(cookie, request->buffers,
+				&request->count);
+		}
+
 		case SIOCGIFSTATS:
 		{
 			struct ifreq_stats stats;
@@ -56,10 +56,12 @@
 #include "BitmapPainter.h"
 #include "DrawingMode.h"
 #include "GlobalSubpixelSettings.h"
+#include "ParallelRenderer.h"
 #include "PatternHandler.h"
 #include "RenderingBuffer.h"
 #include "ServerBitmap.h"
 #include "ServerFont.h"
+#include "SpanKernels.h"
 #include "SystemPalette.h"
 
 #include "AppServer.h"
@@ -106,9 +108,21 @@ using std::nothrow;
 #define fCurve					fInternal.fCurve
 
 
-static uint32 detect_simd();
+static uint32 init_simd();
 
-uint32 gSIMDFlags = detect_simd();
+uint32 gSIMDFlags = init_simd();
+
+
+#ifdef __x86_64__
+static inline uint64
+read_xcr0()
+{
+	uint32 low;
+	uint32 high;
+	asm volatile("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+	return ((uint64)high << 32) | low;
+}
+#endif
 
 
 /*!	Detect SIMD flags for use in AppServer. Checks all CPUs in the system
@@ -117,7 +131,7 @@ uint32 gSIMDFlags = detect_simd();
 static uint32
 detect_simd()
 {
-#if __i386__
+#if defined(__i386__) || defined(__x86_64__)
 	// Only scan CPUs for which we are certain the SIMD flags are properly
 	// defined.
 	const char* vendorNames[] = {
@@ -162,6 +176,18 @@ detect_simd()
 				cpuSIMD |= APPSERVER_SIMD_MMX;
 			if (edx & (1 << 25))
 				cpuSIMD |= APPSERVER_SIMD_SSE;
+			if (edx & (1 << 26))
+				cpuSIMD |= APPSERVER_SIMD_SSE2;
+#ifdef __x86_64__
+			// AVX2 also needs the OS to save the YMM registers
+			uint32 ecx = cpuInfo.regs.ecx;
+			if (maxStdFunc >= 7 && (ecx & (1 << 27)) != 0
+				&& (ecx & (1 << 28)) != 0 && (read_xcr0() & 0x6) == 0x6) {
+				get_cpuid(&cpuInfo, 7, 0);
+				if (cpuInfo.regs.ebx & (1 << 5))
+					cpuSIMD |= APPSERVER_SIMD_AVX2;
+			}
+#endif
 		} else {
 			// no flags can be identified
 			cpuSIMD = 0;
@@ -169,12 +195,26 @@ detect_simd()
 		systemSIMD &= cpuSIMD;
 	}
 	return systemSIMD;
-#else	// !__i386__
+#else	// !__i386__ && !__x86_64__
 	return 0;
 #endif
 }
 
 
+/*!	Detects the SIMD flags, and selects the span kernels that fit them.
+*/
+static uint32
+init_simd()
+{
+	uint32 flags = detect_simd();
+#ifdef __x86_64__
+	if ((flags & APPSERVER_SIMD_AVX2) != 0)
+		gSpanKernels = gAVX2SpanKernels;
+#endif
+	return flags;
+}
+
+
 // Gradients and strings don't use patterns, but we want the special handling
 // we have for solid patterns in certain modes to get the expected results for
 // border antialiasing.
@@ -199,6 +239,58 @@ private:
 };
 
 
+// The rows of the fast rectangle fills are rendered via the ParallelRenderer.
+struct FillRowsCookie {
+	uint8*			offset;
+		// start of the rectangle in the first row of the buffer
+	uint32			bytesPerRow;
+	int32			width;
+	uint32			color;
+	const uint32*	colors;
+		// per row colors (vertical gradient), indexed from row colorsTop
+	int32			colorsTop;
+	rgb_color		blendColor;
+};
+
+
+static void
+fill_rows32(void* _cookie, int32 top, int32 bottom)
+{
+	FillRowsCookie* cookie = (FillRowsCookie*)_cookie;
+	uint8* offset = cookie->offset + top * cookie->bytesPerRow;
+	for (int32 y = top; y <= bottom; y++) {
+		gfxset32(offset, cookie->color, cookie->width * 4);
+		offset += cookie->bytesPerRow;
+	}
+}
+
+
+static void
+fill_rows_vertical_gradient32(void* _cookie, int32 top, int32 bottom)
+{
+	FillRowsCookie* cookie = (FillRowsCookie*)_cookie;
+	uint8* offset = cookie->offset + top * cookie->bytesPerRow;
+	for (int32 y = top; y <= bottom; y++) {
+		gfxset32(offset, cookie->colors[y - cookie->colorsTop],
+			cookie->width * 4);
+		offset += cookie->bytesPerRow;
+	}
+}
+
+
+static void
+blend_rows32(void* _cookie, int32 top, int32 bottom)
+{
+	FillRowsCookie* cookie = (FillRowsCookie*)_cookie;
+	const rgb_color& c = cookie->blendColor;
+	uint8* offset = cookie->offset + top * cookie->bytesPerRow;
+	for (int32 y = top; y <= bottom; y++) {
+		blend_line32(offset, cookie->width, c.red, c.green, c.blue, c.alpha);
+		offset += cookie->bytesPerRow;
+	}
+}
+
+
 // #pragma mark -
 
 
@@ -1007,6 +1099,9 @@ Painter::FillRect(const BRect& r, const rgb_color& c) const
 	color.data8[1] = c.green;
 	color.data8[2] = c.red;
 	color.data8[3] = c.alpha;
+	FillRowsCookie cookie;
+	cookie.bytesPerRow = bpr;
+	cookie.color = color.data32;
 	// fill rects, iterate over clipping boxes
 	fBaseRenderer.first_clip_box();
 	do {
@@ -1015,14 +1110,10 @@ Painter::FillRect(const BRect& r, const rgb_color& c) const
 		if (x1 <= x2) {
 			int32 y1 = max_c(fBaseRenderer.ymin(), top);
 			int32 y2 = min_c(fBaseRenderer.ymax(), bottom);
-			uint8* offset = dst + x1 * 4;
-			for (; y1 <= y2; y1++) {
-//					uint32* handle = (uint32*)(offset + y1 * bpr);
-//					for (int32 x = x1; x <= x2; x++) {
-//						*handle++ = color.data32;
-//					}
-				gfxset32(offset + y1 * bpr, color.data32, (x2 - x1 + 1) * 4);
-			}
+			cookie.offset = dst + x1 * 4;
+			cookie.width = x2 - x1 + 1;
+			ParallelRenderer::RenderRows(y1, y2, cookie.width, &fill_rows32,
+				&cookie);
 		}
 	} while (fBaseRenderer.next_clip_box());
 }
@@ -1059,6 +1150,10 @@ Painter::FillRectVerticalGradient(BRect r,
 	int32 top = (int32)r.top;
 	int32 right = (int32)r.right;
 	int32 bottom = (int32)r.bottom;
+	FillRowsCookie cookie;
+	cookie.bytesPerRow = bpr;
+	cookie.colors = gradientArray;
+	cookie.colorsTop = top;
 	// fill rects, iterate over clipping boxes
 	fBaseRenderer.first_clip_box();
 	do {
@@ -1067,15 +1162,10 @@ Painter::FillRectVerticalGradient(BRect r,
 		if (x1 <= x2) {
 			int32 y1 = max_c(fBaseRenderer.ymin(), top);
 			int32 y2 = min_c(fBaseRenderer.ymax(), bottom);
-			uint8* offset = dst + x1 * 4;
-			for (; y1 <= y2; y1++) {
-//					uint32* handle = (uint32*)(offset + y1 * bpr);
-//					for (int32 x = x1; x <= x2; x++) {
-//						*handle++ = gradientArray[y1 - top];
-//					}
-				gfxset32(offset + y1 * bpr, gradientArray[y1 - top],
-					(x2 - x1 + 1) * 4);
-			}
+			cookie.offset = dst + x1 * 4;
+			cookie.width = x2 - x1 + 1;
+			ParallelRenderer::RenderRows(y1, y2, cookie.width,
+				&fill_rows_vertical_gradient32, &cookie);
 		}
 	} while (fBaseRenderer.next_clip_box());
 }
@@ -1730,6 +1820,10 @@ Painter::_BlendRect32(const BRect& r, const rgb_color& c) const
 	int32 right = (int32)r.right;
 	int32 bottom = (int32)r.bottom;
 
+	FillRowsCookie cookie;
+	cookie.bytesPerRow = bpr;
+	cookie.blendColor = c;
+
 	// fill rects, iterate over clipping boxes
 	fBaseRenderer.first_clip_box();
 	do {
@@ -1739,12 +1833,10 @@ Painter::_BlendRect32(const BRect& r, const rgb_color& c) const
 			int32 y1 = max_c(fBaseRenderer.ymin(), top);
 			int32 y2 = min_c(fBaseRenderer.ymax(), bottom);
 
-			uint8* offset = dst + x1 * 4 + y1 * bpr;
-			for (; y1 <= y2; y1++) {
-				blend_line32(offset, x2 - x1 + 1, c.red, c.green, c.blue,
-					c.alpha);
-				offset += bpr;
-			}
+			cookie.offset = dst + x1 * 4;
+			cookie.width = x2 - x1 + 1;
+			ParallelRenderer::RenderRows(y1, y2, cookie.width, &blend_rows32,
+				&cookie);
 		}
 	} while (fBaseRenderer.next_clip_box());
 }
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "ParallelRenderer.h"
+
+#include <pthread.h>
+
+#include <new>
+
+
+// Operations covering fewer pixels than this are not worth the overhead of
+// waking up the workers (about a 512x512 rectangle).
+static const int64 kMinParallelPixelCount = 256 * 1024;
+static const int32 kMinBandHeight = 16;
+static const int32 kBandsPerThread = 4;
+
+static ParallelRenderer* sDefaultRenderer = NULL;
+static pthread_once_t sDefaultRendererInitOnce = PTHREAD_ONCE_INIT;
+
+
+ParallelRenderer::ParallelRenderer()
+	:
+	fLock("parallel renderer"),
+	fWorkSemaphore(-1),
+	fDoneSemaphore(-1),
+	fWorkerCount(0),
+	fFunction(NULL),
+	fCookie(NULL),
+	fTop(0),
+	fBottom(-1),
+	fBandHeight(0),
+	fBandCount(0),
+	fNextBand(0)
+{
+}
+
+
+/*static*/ void
+ParallelRenderer::RenderRows(int32 top, int32 bottom, int32 width,
+	render_rows_func function, void* cookie)
+{
+	if (top > bottom)
+		return;
+
+	int32 height = bottom - top + 1;
+	if ((int64)height * width < kMinParallelPixelCount
+		|| height < 2 * kMinBandHeight) {
+		function(cookie, top, bottom);
+		return;
+	}
+
+	pthread_once(&sDefaultRendererInitOnce, &_Init);
+	if (sDefaultRenderer == NULL || sDefaultRenderer->fWorkerCount == 0
+		|| sDefaultRenderer->fLock.LockWithTimeout(0) != B_OK) {
+		// no workers, or another thread is using them
+		function(cookie, top, bottom);
+		return;
+	}
+
+	sDefaultRenderer->_RenderRows(top, bottom, function, cookie);
+	sDefaultRenderer->fLock.Unlock();
+}
+
+
+/*static*/ void
+ParallelRenderer::_Init()
+{
+	system_info info;
+	if (get_system_info(&info) != B_OK || info.cpu_count < 2)
+		return;
+
+	ParallelRenderer* renderer = new(std::nothrow) ParallelRenderer;
+	if (renderer == NULL)
+		return;
+
+	renderer->fWorkSemaphore = create_sem(0, "parallel renderer work");
+	renderer->fDoneSemaphore = create_sem(0, "parallel renderer done");
+	if (renderer->fLock.InitCheck() != B_OK || renderer->fWorkSemaphore < 0
+		|| renderer->fDoneSemaphore < 0) {
+		delete_sem(renderer->fWorkSemaphore);
+		delete_sem(renderer->fDoneSemaphore);
+		delete renderer;
+		return;
+	}
+
+	int32 workerCount = min_c((int32)info.cpu_count - 1,
+		(int32)kMaxWorkerThreads);
+	for (int32 i = 0; i < workerCount; i++) {
+		thread_id thread = spawn_thread(&_WorkerThreadEntry,
+			"parallel renderer", B_DISPLAY_PRIORITY, renderer);
+		if (thread < 0 || resume_thread(thread) != B_OK)
+			break;
+		renderer->fWorkerCount++;
+	}
+
+	sDefaultRenderer = renderer;
+}
+
+
+void
+ParallelRenderer::_RenderRows(int32 top, int32 bottom,
+	render_rows_func function, void* cookie)
+{
+	int32 height = bottom - top + 1;
+	int32 bandCount = min_c(height / kMinBandHeight,
+		(fWorkerCount + 1) * kBandsPerThread);
+
+	fFunction = function;
+	fCookie = cookie;
+	fTop = top;
+	fBottom = bottom;
+	fBandHeight = (height + bandCount - 1) / bandCount;
+	fBandCount = (height + fBandHeight - 1) / fBandHeight;
+	fNextBand = 0;
+
+	// the calling thread renders bands, too
+	int32 workerCount = min_c(fWorkerCount, fBandCount - 1);
+	release_sem_etc(fWorkSemaphore, workerCount, B_DO_NOT_RESCHEDULE);
+
+	_RenderBands();
+
+	while (acquire_sem_etc(fDoneSemaphore, workerCount, 0, 0) == B_INTERRUPTED)
+		;
+}
+
+
+/*static*/ status_t
+ParallelRenderer::_WorkerThreadEntry(void* data)
+{
+	ParallelRenderer* renderer = (ParallelRenderer*)data;
+
+	while (true) {
+		status_t error = acquire_sem(renderer->fWorkSemaphore);
+		if (error == B_INTERRUPTED)
+			continue;
+		if (error != B_OK)
+			return error;
+
+		renderer->_RenderBands();
+		release_sem(renderer->fDoneSemaphore);
+	}
+}
+
+
+void
+ParallelRenderer::_RenderBands()
+{
+	while (true) {
+		int32 band = atomic_add(&fNextBand, 1);
+		if (band >= fBandCount)
+			return;
+
+		int32 top = fTop + band * fBandHeight;
+		int32 bottom = min_c(top + fBandHeight - 1, fBottom);
+		fFunction(fCookie, top, bottom);
+	}
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PARALLEL_RENDERER_H
+#define PARALLEL_RENDERER_H
+
+#include <Locker.h>
+#include <OS.h>
+
+
+// Splits large drawing operations into horizontal bands of rows, which are
+// rendered by a pool of worker threads and the calling thread together. The
+// rows must be independent of each other, i.e. the bands must not write the
+// same pixels. Operations covering fewer pixels than the threshold, and
+// operations issued while another thread is using the workers, are simply
+// rendered by the calling thread.
+class ParallelRenderer {
+public:
+	typedef void (*render_rows_func)(void* cookie, int32 top, int32 bottom);
+
+	static	void				RenderRows(int32 top, int32 bottom,
+									int32 width, render_rows_func function,
+									void* cookie);
+									// calls function() for the rows top to
+									// bottom (inclusive), returns when all
+									// rows have been rendered
+
+private:
+								ParallelRenderer();
+
+	static	void				_Init();
+			void				_RenderRows(int32 top, int32 bottom,
+									render_rows_func function, void* cookie);
+	static	status_t			_WorkerThreadEntry(void* data);
+			void				_RenderBands();
+
+private:
+			enum {
+				kMaxWorkerThreads = 7
+			};
+
+			BLocker				fLock;
+			sem_id				fWorkSemaphore;
+			sem_id				fDoneSemaphore;
+			int32				fWorkerCount;
+
+			// the operation currently being rendered
+			render_rows_func	fFunction;
+			void*				fCookie;
+			int32				fTop;
+			int32				fBottom;
+			int32				fBandHeight;
+			int32				fBandCount;
+			int32				fNextBand;
+};
+
+
+#endif	// PARALLEL_RENDERER_H
@@ -0,0 +1,411 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "SpanKernels.h"
+
+#include <string.h>
+
+#include "DrawingMode.h"
+
+#ifdef __x86_64__
+#	include <emmintrin.h>
+#	include "SpanKernelsSIMD.h"
+#endif
+
+
+// #pragma mark - scalar versions
+
+
+/*!	These are the loops of the drawing mode functions, the SIMD versions
+	have to produce exactly the same results.
+*/
+static void
+blend_solid_span(uint8* dst, uint32 count, uint32 color, const uint8* covers)
+{
+	const uint8* c = (const uint8*)&color;
+	while (count--) {
+		if (*covers) {
+			if (*covers == 255) {
+				dst[0] = c[0];
+				dst[1] = c[1];
+				dst[2] = c[2];
+				dst[3] = 255;
+			} else {
+				BLEND(dst, c[2], c[1], c[0], *covers);
+			}
+		}
+		covers++;
+		dst += 4;
+	}
+}
+
+
+static inline void
+blend_color_span(uint8* dst, uint32 count, const uint8* colors,
+	const uint8* covers, uint8 cover, bool skipTransparent)
+{
+	if (covers) {
+		// non-solid opacity
+		while (count--) {
+			if (*covers && (!skipTransparent || colors[3] > 0)) {
+				if (*covers == 255) {
+					dst[0] = colors[2];
+					dst[1] = colors[1];
+					dst[2] = colors[0];
+					dst[3] = 255;
+				} else {
+					BLEND(dst, colors[0], colors[1], colors[2], *covers);
+				}
+			}
+			covers++;
+			dst += 4;
+			colors += 4;
+		}
+	} else if (cover == 255) {
+		// solid full opacity
+		while (count--) {
+			if (!skipTransparent || colors[3] > 0) {
+				dst[0] = colors[2];
+				dst[1] = colors[1];
+				dst[2] = colors[0];
+				dst[3] = 255;
+			}
+			dst += 4;
+			colors += 4;
+		}
+	} else if (cover) {
+		// solid partial opacity
+		while (count--) {
+			if (!skipTransparent || colors[3] > 0)
+				BLEND(dst, colors[0], colors[1], colors[2], cover);
+			dst += 4;
+			colors += 4;
+		}
+	}
+}
+
+
+static void
+blend_color_span_copy(uint8* dst, uint32 count, const uint8* colors,
+	const uint8* covers, uint8 cover)
+{
+	blend_color_span(dst, count, colors, covers, cover, false);
+}
+
+
+static void
+blend_color_span_over(uint8* dst, uint32 count, const uint8* colors,
+	const uint8* covers, uint8 cover)
+{
+	blend_color_span(dst, count, colors, covers, cover, true);
+}
+
+
+static void
+blend_solid_span_alpha_co(uint8* dst, uint32 count, uint32 color,
+	uint8 hAlpha, const uint8* covers)
+{
+	const uint8* c = (const uint8*)&color;
+	while (count--) {
+		uint16 alpha = hAlpha * *covers;
+		if (alpha) {
+			if (alpha == 255 * 255) {
+				dst[0] = c[0];
+				dst[1] = c[1];
+				dst[2] = c[2];
+				dst[3] = 255;
+			} else {
+				BLEND16(dst, c[2], c[1], c[0], alpha);
+			}
+		}
+		covers++;
+		dst += 4;
+	}
+}
+
+
+static void
+blend_solid_span_alpha_cc(uint8* dst, uint32 count, uint32 color,
+	uint8 hAlpha, const uint8* covers)
+{
+	const uint8* c = (const uint8*)&color;
+	while (count--) {
+		uint16 alpha = hAlpha * *covers;
+		if (alpha) {
+			if (alpha == 255 * 255) {
+				dst[0] = c[0];
+				dst[1] = c[1];
+				dst[2] = c[2];
+				dst[3] = 255;
+			} else {
+				BLEND_COMPOSITE16(dst, c[2], c[1], c[0], alpha);
+			}
+		}
+		covers++;
+		dst += 4;
+	}
+}
+
+
+static void
+blend_row_alpha(uint8* dst, const uint8* src, uint32 count)
+{
+	while (count--) {
+		if (src[3] == 255) {
+			*(uint32*)dst = *(uint32*)src;
+		} else {
+			dst[0] = ((src[0] - dst[0]) * src[3] + (dst[0] << 8)) >> 8;
+			dst[1] = ((src[1] - dst[1]) * src[3] + (dst[1] << 8)) >> 8;
+			dst[2] = ((src[2] - dst[2]) * src[3] + (dst[2] << 8)) >> 8;
+		}
+		dst += 4;
+		src += 4;
+	}
+}
+
+
+static void
+scale_row_nearest(uint8* dst, const uint8* srcRow, const uint16* xIndices,
+	uint32 count)
+{
+	uint32* d = (uint32*)dst;
+	while (count--)
+		*d++ = *(const uint32*)(srcRow + *xIndices++);
+}
+
+
+static void
+scale_row_bilinear(uint8* dst, const uint8* srcRow, uint32 srcBytesPerRow,
+	const uint16* xWeights, uint32 count, uint16 wTop)
+{
+	const uint16 wBottom = 255 - wTop;
+	while (count--) {
+		const uint8* s = srcRow + xWeights[0];
+		const uint16 wLeft = xWeights[1];
+		const uint16 wRight = 255 - wLeft;
+
+		// left and right of top row
+		uint32 t0 = (s[0] * wLeft + s[4] * wRight) * wTop;
+		uint32 t1 = (s[1] * wLeft + s[5] * wRight) * wTop;
+		uint32 t2 = (s[2] * wLeft + s[6] * wRight) * wTop;
+
+		// left and right of bottom row
+		s += srcBytesPerRow;
+		t0 += (s[0] * wLeft + s[4] * wRight) * wBottom;
+		t1 += (s[1] * wLeft + s[5] * wRight) * wBottom;
+		t2 += (s[2] * wLeft + s[6] * wRight) * wBottom;
+
+		dst[0] = t0 >> 16;
+		dst[1] = t1 >> 16;
+		dst[2] = t2 >> 16;
+
+		xWeights += 2;
+		dst += 4;
+	}
+}
+
+
+const SpanKernels gScalarSpanKernels = {
+	&blend_solid_span,
+	&blend_color_span_copy,
+	&blend_color_span_over,
+	&blend_solid_span_alpha_co,
+	&blend_solid_span_alpha_cc,
+	&blend_row_alpha,
+	&scale_row_nearest,
+	&scale_row_bilinear
+};
+
+
+#ifdef __x86_64__
+
+
+// #pragma mark - SSE2 versions
+
+
+namespace {
+
+
+struct SSE2Vector {
+	typedef __m128i Type;
+
+	enum {
+		kPixels = 4
+	};
+
+	static inline __m128i Load(const uint8* p)
+		{ return _mm_loadu_si128((const __m128i*)p); }
+	static inline void Store(uint8* p, __m128i value)
+		{ _mm_storeu_si128((__m128i*)p, value); }
+
+	static inline __m128i Zero()
+		{ return _mm_setzero_si128(); }
+	static inline __m128i Set8(uint8 value)
+		{ return _mm_set1_epi8(value); }
+	static inline __m128i Set16(uint16 value)
+		{ return _mm_set1_epi16(value); }
+	static inline __m128i Set32(uint32 value)
+		{ return _mm_set1_epi32(value); }
+
+	//! Returns the cover of each pixel in all four of its channels.
+	static inline __m128i LoadCovers(const uint8* covers)
+	{
+		uint32 fourCovers;
+		memcpy(&fourCovers, covers, sizeof(fourCovers));
+		__m128i value = _mm_cvtsi32_si128(fourCovers);
+		value = _mm_unpacklo_epi8(value, value);
+		return _mm_unpacklo_epi16(value, value);
+	}
+
+	static inline __m128i UnpackLow(__m128i value)
+		{ return _mm_unpacklo_epi8(value, _mm_setzero_si128()); }
+	static inline __m128i UnpackHigh(__m128i value)
+		{ return _mm_unpackhi_epi8(value, _mm_setzero_si128()); }
+	static inline __m128i Pack(__m128i low, __m128i high)
+		{ return _mm_packus_epi16(low, high); }
+
+	static inline __m128i Add16(__m128i a, __m128i b)
+		{ return _mm_add_epi16(a, b); }
+	static inline __m128i AddSaturate16(__m128i a, __m128i b)
+		{ return _mm_adds_epu16(a, b); }
+	static inline __m128i Subtract16(__m128i a, __m128i b)
+		{ return _mm_sub_epi16(a, b); }
+	static inline __m128i MultiplyLow16(__m128i a, __m128i b)
+		{ return _mm_mullo_epi16(a, b); }
+	static inline __m128i MultiplyHigh16(__m128i a, __m128i b)
+		{ return _mm_mulhi_epu16(a, b); }
+	static inline __m128i ShiftRight7(__m128i value)
+		{ return _mm_srli_epi16(value, 7); }
+	static inline __m128i ShiftRight8(__m128i value)
+		{ return _mm_srli_epi16(value, 8); }
+
+	static inline __m128i And(__m128i a, __m128i b)
+		{ return _mm_and_si128(a, b); }
+	static inline __m128i AndNot(__m128i mask, __m128i value)
+		{ return _mm_andnot_si128(mask, value); }
+	static inline __m128i Or(__m128i a, __m128i b)
+		{ return _mm_or_si128(a, b); }
+
+	static inline __m128i CompareEqual8(__m128i a, __m128i b)
+		{ return _mm_cmpeq_epi8(a, b); }
+	static inline __m128i CompareEqual16(__m128i a, __m128i b)
+		{ return _mm_cmpeq_epi16(a, b); }
+	static inline __m128i CompareEqual32(__m128i a, __m128i b)
+		{ return _mm_cmpeq_epi32(a, b); }
+	static inline bool AllSet(__m128i mask)
+		{ return _mm_movemask_epi8(mask) == 0xffff; }
+
+	//! Copies the alpha of each unpacked pixel into all of its channels.
+	static inline __m128i ShuffleAlpha16(__m128i value)
+	{
+		value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(3, 3, 3, 3));
+		return _mm_shufflehi_epi16(value, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	//! Turns RGBA pixels into BGRA ones, and vice versa.
+	static inline __m128i SwapRedBlue(__m128i value)
+	{
+		__m128i low = UnpackLow(value);
+		__m128i high = UnpackHigh(value);
+		low = _mm_shufflelo_epi16(low, _MM_SHUFFLE(3, 0, 1, 2));
+		low = _mm_shufflehi_epi16(low, _MM_SHUFFLE(3, 0, 1, 2));
+		high = _mm_shufflelo_epi16(high, _MM_SHUFFLE(3, 0, 1, 2));
+		high = _mm_shufflehi_epi16(high, _MM_SHUFFLE(3, 0, 1, 2));
+		return _mm_packus_epi16(low, high);
+	}
+};
+
+
+}	// namespace
+
+
+/*!	Two pixels per iteration. The left and right source pixels of both are
+	arranged so that they can be unpacked to the left pixels of both and the
+	right pixels of both.
+*/
+static void
+scale_row_bilinear_sse2(uint8* dst, const uint8* srcRow,
+	uint32 srcBytesPerRow, const uint16* xWeights, uint32 count, uint16 wTop)
+{
+	typedef SIMDSpanKernels<SSE2Vector> Kernels;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i w255 = _mm_set1_epi16(255);
+	const __m128i wTopVector = _mm_set1_epi16(wTop);
+	const __m128i wBottomVector = _mm_set1_epi16(255 - wTop);
+	const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+
+	for (; count >= 2; count -= 2) {
+		const uint8* s0 = srcRow + xWeights[0];
+		const uint8* s1 = srcRow + xWeights[2];
+		__m128i top = _mm_unpacklo_epi32(
+			_mm_loadl_epi64((const __m128i*)s0),
+			_mm_loadl_epi64((const __m128i*)s1));
+		__m128i bottom = _mm_unpacklo_epi32(
+			_mm_loadl_epi64((const __m128i*)(s0 + srcBytesPerRow)),
+			_mm_loadl_epi64((const __m128i*)(s1 + srcBytesPerRow)));
+
+		__m128i wLeft = _mm_set_epi16(xWeights[3], xWeights[3], xWeights[3],
+			xWeights[3], xWeights[1], xWeights[1], xWeights[1], xWeights[1]);
+		__m128i wRight = _mm_sub_epi16(w255, wLeft);
+
+		__m128i sumTop = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(top, zero), wLeft),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(top, zero), wRight));
+		__m128i sumBottom = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(bottom, zero), wLeft),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(bottom, zero), wRight));
+
+		__m128i result = Kernels::MulAddHigh(sumTop, wTopVector, sumBottom,
+			wBottomVector);
+		result = _mm_packus_epi16(result, result);
+
+		// keep the destination alpha
+		__m128i destination = _mm_loadl_epi64((const __m128i*)dst);
+		result = _mm_or_si128(_mm_and_si128(alphaMask, destination),
+			_mm_andnot_si128(alphaMask, result));
+		_mm_storel_epi64((__m128i*)dst, result);
+
+		xWeights += 4;
+		dst += 8;
+	}
+
+	if (count > 0) {
+		scale_row_bilinear(dst, srcRow, srcBytesPerRow, xWeights, count,
+			wTop);
+	}
+}
+
+
+// There are no gather instructions in SSE2, nearest neighbor scaling would
+// not be any faster.
+const SpanKernels gSSE2SpanKernels
+	= SPAN_KERNELS_SIMD_TABLE(SSE2Vector, &scale_row_nearest,
+		&scale_row_bilinear_sse2);
+
+// SSE2 is always available on x86_64, Painter switches to the AVX2 versions
+// if the CPU supports them
+SpanKernels gSpanKernels
+	= SPAN_KERNELS_SIMD_TABLE(SSE2Vector, &scale_row_nearest,
+		&scale_row_bilinear_sse2);
+
+
+#else	// !__x86_64__
+
+
+SpanKernels gSpanKernels = {
+	&blend_solid_span,
+	&blend_color_span_copy,
+	&blend_color_span_over,
+	&blend_solid_span_alpha_co,
+	&blend_solid_span_alpha_cc,
+	&blend_row_alpha,
+	&scale_row_nearest,
+	&scale_row_bilinear
+};
+
+
+#endif	// !__x86_64__
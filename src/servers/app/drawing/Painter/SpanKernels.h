@@ -0,0 +1,77 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SPAN_KERNELS_H
+#define SPAN_KERNELS_H
+
+#include <SupportDefs.h>
+
+
+// The inner loops of the most used drawing modes and of the bitmap scaling
+// code, working on spans of B_RGB32 pixels. Colors are passed as they are
+// stored in a B_RGB32 pixel (see span_color()).
+//
+// On x86_64 there are SSE2 and AVX2 versions of the loops, Painter selects
+// the best one for the CPU at startup. They produce exactly the same pixels
+// as the scalar versions.
+struct SpanKernels {
+	// B_OP_COPY and B_OP_OVER with a solid pattern: the color is blended
+	// with the coverage of each pixel, pixels without coverage are not
+	// touched
+	void	(*blendSolidSpan)(uint8* dst, uint32 count, uint32 color,
+				const uint8* covers);
+
+	// B_OP_COPY with a color per pixel (in the byte order of agg::rgba8),
+	// and a single cover for all pixels if covers is NULL. The B_OP_OVER
+	// version does not touch pixels with a fully transparent color.
+	void	(*blendColorSpan)(uint8* dst, uint32 count, const uint8* colors,
+				const uint8* covers, uint8 cover);
+	void	(*blendColorSpanOver)(uint8* dst, uint32 count,
+				const uint8* colors, const uint8* covers, uint8 cover);
+
+	// B_OP_ALPHA with B_CONSTANT_ALPHA and a solid pattern, in
+	// B_ALPHA_OVERLAY and B_ALPHA_COMPOSITE mode
+	void	(*blendSolidSpanAlphaCO)(uint8* dst, uint32 count, uint32 color,
+				uint8 alpha, const uint8* covers);
+	void	(*blendSolidSpanAlphaCC)(uint8* dst, uint32 count, uint32 color,
+				uint8 alpha, const uint8* covers);
+
+	// B_OP_ALPHA with B_PIXEL_ALPHA in B_ALPHA_OVERLAY mode, for unscaled
+	// B_RGBA32 bitmaps
+	void	(*blendRowAlpha)(uint8* dst, const uint8* src, uint32 count);
+
+	// Bitmap scaling: xIndices are byte offsets into the source row,
+	// xWeights are pairs of byte offset and weight of the left pixel, as
+	// in the FilterInfo array of the bilinear filter.
+	void	(*scaleRowNearest)(uint8* dst, const uint8* srcRow,
+				const uint16* xIndices, uint32 count);
+	void	(*scaleRowBilinear)(uint8* dst, const uint8* srcRow,
+				uint32 srcBytesPerRow, const uint16* xWeights, uint32 count,
+				uint16 wTop);
+};
+
+
+extern SpanKernels gSpanKernels;
+
+extern const SpanKernels gScalarSpanKernels;
+#ifdef __x86_64__
+extern const SpanKernels gSSE2SpanKernels;
+extern const SpanKernels gAVX2SpanKernels;
+#endif
+
+
+static inline uint32
+span_color(uint8 red, uint8 green, uint8 blue)
+{
+	uint32 color;
+	uint8* p8 = (uint8*)&color;
+	p8[0] = blue;
+	p8[1] = green;
+	p8[2] = red;
+	p8[3] = 255;
+	return color;
+}
+
+
+#endif // SPAN_KERNELS_H
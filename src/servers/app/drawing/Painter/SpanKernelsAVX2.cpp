@@ -0,0 +1,198 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	The AVX2 versions of the span kernels, this file is built with -mavx2.
+
+
+#include "SpanKernels.h"
+
+#include <immintrin.h>
+
+#include "SpanKernelsSIMD.h"
+
+
+namespace {
+
+
+struct AVX2Vector {
+	typedef __m256i Type;
+
+	enum {
+		kPixels = 8
+	};
+
+	static inline __m256i Load(const uint8* p)
+		{ return _mm256_loadu_si256((const __m256i*)p); }
+	static inline void Store(uint8* p, __m256i value)
+		{ _mm256_storeu_si256((__m256i*)p, value); }
+
+	static inline __m256i Zero()
+		{ return _mm256_setzero_si256(); }
+	static inline __m256i Set8(uint8 value)
+		{ return _mm256_set1_epi8(value); }
+	static inline __m256i Set16(uint16 value)
+		{ return _mm256_set1_epi16(value); }
+	static inline __m256i Set32(uint32 value)
+		{ return _mm256_set1_epi32(value); }
+
+	//! Returns the cover of each pixel in all four of its channels.
+	static inline __m256i LoadCovers(const uint8* covers)
+	{
+		const __m256i spread = _mm256_setr_epi8(
+			0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12,
+			0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12);
+		__m256i value = _mm256_cvtepu8_epi32(
+			_mm_loadl_epi64((const __m128i*)covers));
+		return _mm256_shuffle_epi8(value, spread);
+	}
+
+	static inline __m256i UnpackLow(__m256i value)
+		{ return _mm256_unpacklo_epi8(value, _mm256_setzero_si256()); }
+	static inline __m256i UnpackHigh(__m256i value)
+		{ return _mm256_unpackhi_epi8(value, _mm256_setzero_si256()); }
+	static inline __m256i Pack(__m256i low, __m256i high)
+		{ return _mm256_packus_epi16(low, high); }
+
+	static inline __m256i Add16(__m256i a, __m256i b)
+		{ return _mm256_add_epi16(a, b); }
+	static inline __m256i AddSaturate16(__m256i a, __m256i b)
+		{ return _mm256_adds_epu16(a, b); }
+	static inline __m256i Subtract16(__m256i a, __m256i b)
+		{ return _mm256_sub_epi16(a, b); }
+	static inline __m256i MultiplyLow16(__m256i a, __m256i b)
+		{ return _mm256_mullo_epi16(a, b); }
+	static inline __m256i MultiplyHigh16(__m256i a, __m256i b)
+		{ return _mm256_mulhi_epu16(a, b); }
+	static inline __m256i ShiftRight7(__m256i value)
+		{ return _mm256_srli_epi16(value, 7); }
+	static inline __m256i ShiftRight8(__m256i value)
+		{ return _mm256_srli_epi16(value, 8); }
+
+	static inline __m256i And(__m256i a, __m256i b)
+		{ return _mm256_and_si256(a, b); }
+	static inline __m256i AndNot(__m256i mask, __m256i value)
+		{ return _mm256_andnot_si256(mask, value); }
+	static inline __m256i Or(__m256i a, __m256i b)
+		{ return _mm256_or_si256(a, b); }
+
+	static inline __m256i CompareEqual8(__m256i a, __m256i b)
+		{ return _mm256_cmpeq_epi8(a, b); }
+	static inline __m256i CompareEqual16(__m256i a, __m256i b)
+		{ return _mm256_cmpeq_epi16(a, b); }
+	static inline __m256i CompareEqual32(__m256i a, __m256i b)
+		{ return _mm256_cmpeq_epi32(a, b); }
+	static inline bool AllSet(__m256i mask)
+		{ return _mm256_movemask_epi8(mask) == -1; }
+
+	//! Copies the alpha of each unpacked pixel into all of its channels.
+	static inline __m256i ShuffleAlpha16(__m256i value)
+	{
+		value = _mm256_shufflelo_epi16(value, _MM_SHUFFLE(3, 3, 3, 3));
+		return _mm256_shufflehi_epi16(value, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	//! Turns RGBA pixels into BGRA ones, and vice versa.
+	static inline __m256i SwapRedBlue(__m256i value)
+	{
+		const __m256i swap = _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		return _mm256_shuffle_epi8(value, swap);
+	}
+};
+
+
+}	// namespace
+
+
+typedef SIMDSpanKernels<AVX2Vector> AVX2Kernels;
+
+
+static void
+scale_row_nearest_avx2(uint8* dst, const uint8* srcRow,
+	const uint16* xIndices, uint32 count)
+{
+	for (; count >= 8; count -= 8) {
+		__m256i indices = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128((const __m128i*)xIndices));
+		_mm256_storeu_si256((__m256i*)dst,
+			_mm256_i32gather_epi32((const int*)srcRow, indices, 1));
+
+		xIndices += 8;
+		dst += 32;
+	}
+
+	if (count > 0)
+		gScalarSpanKernels.scaleRowNearest(dst, srcRow, xIndices, count);
+}
+
+
+/*!	Four pixels per iteration. Each gathered 64 bit value contains the left
+	and the right source pixel, they are reordered so that the unpacked low
+	half of each 128 bit lane contains the left pixels of two destination
+	pixels, and the high half the right ones.
+*/
+static void
+scale_row_bilinear_avx2(uint8* dst, const uint8* srcRow,
+	uint32 srcBytesPerRow, const uint16* xWeights, uint32 count, uint16 wTop)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i w255 = _mm256_set1_epi16(255);
+	const __m256i wTopVector = _mm256_set1_epi16(wTop);
+	const __m256i wBottomVector = _mm256_set1_epi16(255 - wTop);
+	const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+	const uint8* srcBottomRow = srcRow + srcBytesPerRow;
+
+	for (; count >= 4; count -= 4) {
+		// index and weight pairs of four pixels
+		__m128i pairs = _mm_loadu_si128((const __m128i*)xWeights);
+		__m128i indices = _mm_and_si128(pairs, _mm_set1_epi32(0xffff));
+
+		__m256i top = _mm256_i32gather_epi64((const long long*)srcRow,
+			indices, 1);
+		__m256i bottom = _mm256_i32gather_epi64(
+			(const long long*)srcBottomRow, indices, 1);
+		top = _mm256_shuffle_epi32(top, _MM_SHUFFLE(3, 1, 2, 0));
+		bottom = _mm256_shuffle_epi32(bottom, _MM_SHUFFLE(3, 1, 2, 0));
+
+		__m256i wLeft = _mm256_cvtepu32_epi64(_mm_srli_epi32(pairs, 16));
+		wLeft = _mm256_shufflelo_epi16(wLeft, _MM_SHUFFLE(0, 0, 0, 0));
+		wLeft = _mm256_shufflehi_epi16(wLeft, _MM_SHUFFLE(0, 0, 0, 0));
+		__m256i wRight = _mm256_sub_epi16(w255, wLeft);
+
+		__m256i sumTop = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(top, zero), wLeft),
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(top, zero), wRight));
+		__m256i sumBottom = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(bottom, zero), wLeft),
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(bottom, zero), wRight));
+
+		__m256i result = AVX2Kernels::MulAddHigh(sumTop, wTopVector,
+			sumBottom, wBottomVector);
+		result = _mm256_packus_epi16(result, result);
+		__m128i pixels = _mm256_castsi256_si128(
+			_mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0)));
+
+		// keep the destination alpha
+		__m128i destination = _mm_loadu_si128((const __m128i*)dst);
+		pixels = _mm_or_si128(_mm_and_si128(alphaMask, destination),
+			_mm_andnot_si128(alphaMask, pixels));
+		_mm_storeu_si128((__m128i*)dst, pixels);
+
+		xWeights += 8;
+		dst += 16;
+	}
+
+	if (count > 0) {
+		gScalarSpanKernels.scaleRowBilinear(dst, srcRow, srcBytesPerRow,
+			xWeights, count, wTop);
+	}
+}
+
+
+const SpanKernels gAVX2SpanKernels
+	= SPAN_KERNELS_SIMD_TABLE(AVX2Vector, &scale_row_nearest_avx2,
+		&scale_row_bilinear_avx2);
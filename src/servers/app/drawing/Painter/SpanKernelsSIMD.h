@@ -0,0 +1,320 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SPAN_KERNELS_SIMD_H
+#define SPAN_KERNELS_SIMD_H
+
+
+#include "SpanKernels.h"
+
+
+/*!	The span blending loops, written once for the SSE2 and the AVX2 versions.
+	The Vector class wraps the intrinsics of the instruction set; it has to
+	be local to the translation unit that is compiled for that instruction
+	set, so that the instantiations do not get mixed up by the linker.
+
+	All channels are computed in 16 bit lanes. Note that the AVX2 unpack and
+	pack instructions work within 128 bit lanes, but since pixels are always
+	unpacked and packed again in the same way, this does not matter here.
+	What the scalar versions compute with 32 bit intermediate values is
+	computed from the low and high halves of the 16 bit products, see
+	MulAddHigh().
+*/
+template<class Vector>
+struct SIMDSpanKernels {
+	typedef typename Vector::Type Type;
+
+	enum {
+		kPixels = Vector::kPixels
+	};
+
+	static void
+	BlendSolidSpan(uint8* dst, uint32 count, uint32 color,
+		const uint8* covers)
+	{
+		const Type alphaMask = Vector::Set32(0xff000000);
+		const Type solid = Vector::Or(Vector::Set32(color), alphaMask);
+		const Type solid16 = Vector::UnpackLow(solid);
+		const Type full = Vector::Set32(0xffffffff);
+
+		for (; count >= kPixels; count -= kPixels) {
+			Type cover = Vector::LoadCovers(covers);
+			Type none = Vector::CompareEqual8(cover, Vector::Zero());
+			if (!Vector::AllSet(none)) {
+				Type all = Vector::CompareEqual8(cover, full);
+				if (Vector::AllSet(all)) {
+					Vector::Store(dst, solid);
+				} else {
+					Type destination = Vector::Load(dst);
+					Type result = Vector::Or(Vector::Pack(
+						Blend(solid16, Vector::UnpackLow(destination),
+							Vector::UnpackLow(cover)),
+						Blend(solid16, Vector::UnpackHigh(destination),
+							Vector::UnpackHigh(cover))), alphaMask);
+					result = Select(all, solid, result);
+					Vector::Store(dst, Select(none, destination, result));
+				}
+			}
+
+			dst += kPixels * 4;
+			covers += kPixels;
+		}
+
+		if (count > 0)
+			gScalarSpanKernels.blendSolidSpan(dst, count, color, covers);
+	}
+
+	template<bool kSkipTransparent>
+	static void
+	BlendColorSpan(uint8* dst, uint32 count, const uint8* colors,
+		const uint8* covers, uint8 cover)
+	{
+		if (covers == NULL && cover == 0)
+			return;
+
+		const Type alphaMask = Vector::Set32(0xff000000);
+		const Type full = Vector::Set32(0xffffffff);
+		const Type constantCover = Vector::Set8(cover);
+
+		for (; count >= kPixels; count -= kPixels) {
+			Type source = Vector::SwapRedBlue(Vector::Load(colors));
+			Type pixelCover = covers != NULL
+				? Vector::LoadCovers(covers) : constantCover;
+
+			Type none = Vector::CompareEqual8(pixelCover, Vector::Zero());
+			if (kSkipTransparent) {
+				none = Vector::Or(none, Vector::CompareEqual32(
+					Vector::And(source, alphaMask), Vector::Zero()));
+			}
+
+			if (!Vector::AllSet(none)) {
+				Type destination = Vector::Load(dst);
+				Type all = Vector::CompareEqual8(pixelCover, full);
+				Type result = Vector::Or(Vector::Pack(
+					Blend(Vector::UnpackLow(source),
+						Vector::UnpackLow(destination),
+						Vector::UnpackLow(pixelCover)),
+					Blend(Vector::UnpackHigh(source),
+						Vector::UnpackHigh(destination),
+						Vector::UnpackHigh(pixelCover))), alphaMask);
+				result = Select(all, Vector::Or(source, alphaMask), result);
+				Vector::Store(dst, Select(none, destination, result));
+			}
+
+			dst += kPixels * 4;
+			colors += kPixels * 4;
+			if (covers != NULL)
+				covers += kPixels;
+		}
+
+		if (count > 0) {
+			if (kSkipTransparent) {
+				gScalarSpanKernels.blendColorSpanOver(dst, count, colors,
+					covers, cover);
+			} else {
+				gScalarSpanKernels.blendColorSpan(dst, count, colors, covers,
+					cover);
+			}
+		}
+	}
+
+	static void
+	BlendSolidSpanAlphaCO(uint8* dst, uint32 count, uint32 color,
+		uint8 alpha, const uint8* covers)
+	{
+		if (alpha == 0)
+			return;
+
+		const Type alphaMask = Vector::Set32(0xff000000);
+		const Type solid = Vector::Or(Vector::Set32(color), alphaMask);
+		const Type solid16 = Vector::UnpackLow(solid);
+		const Type alpha16 = Vector::Set16(alpha);
+		// the color is only assigned if both alpha and cover are 255
+		const Type full = Vector::Set32(0xffffffff);
+		const Type assign = alpha == 255 ? full : Vector::Zero();
+
+		for (; count >= kPixels; count -= kPixels) {
+			Type cover = Vector::LoadCovers(covers);
+			Type none = Vector::CompareEqual8(cover, Vector::Zero());
+			if (!Vector::AllSet(none)) {
+				Type destination = Vector::Load(dst);
+				Type all = Vector::And(Vector::CompareEqual8(cover, full),
+					assign);
+				Type result = Vector::Or(Vector::Pack(
+					Blend16(solid16, Vector::UnpackLow(destination),
+						Vector::MultiplyLow16(Vector::UnpackLow(cover),
+							alpha16)),
+					Blend16(solid16, Vector::UnpackHigh(destination),
+						Vector::MultiplyLow16(Vector::UnpackHigh(cover),
+							alpha16))), alphaMask);
+				result = Select(all, solid, result);
+				Vector::Store(dst, Select(none, destination, result));
+			}
+
+			dst += kPixels * 4;
+			covers += kPixels;
+		}
+
+		if (count > 0) {
+			gScalarSpanKernels.blendSolidSpanAlphaCO(dst, count, color, alpha,
+				covers);
+		}
+	}
+
+	static void
+	BlendSolidSpanAlphaCC(uint8* dst, uint32 count, uint32 color,
+		uint8 alpha, const uint8* covers)
+	{
+		if (alpha == 0)
+			return;
+
+		const Type alphaMask = Vector::Set32(0xff000000);
+		const Type solid = Vector::Or(Vector::Set32(color), alphaMask);
+		const Type solid16 = Vector::UnpackLow(solid);
+		const Type alpha16 = Vector::Set16(alpha);
+		const Type full = Vector::Set32(0xffffffff);
+		const Type assign = alpha == 255 ? full : Vector::Zero();
+
+		for (; count >= kPixels; count -= kPixels) {
+			Type cover = Vector::LoadCovers(covers);
+			Type none = Vector::CompareEqual8(cover, Vector::Zero());
+			if (!Vector::AllSet(none)) {
+				Type destination = Vector::Load(dst);
+				if (!Vector::AllSet(Vector::CompareEqual32(
+						Vector::And(destination, alphaMask), alphaMask))) {
+					// Only on an opaque destination the composite is a
+					// simple blend, leave the rest to the scalar version.
+					gScalarSpanKernels.blendSolidSpanAlphaCC(dst, kPixels,
+						color, alpha, covers);
+				} else {
+					Type all = Vector::And(
+						Vector::CompareEqual8(cover, full), assign);
+					Type result = Vector::Or(Vector::Pack(
+						Blend(solid16, Vector::UnpackLow(destination),
+							DivideBy255(Vector::MultiplyLow16(
+								Vector::UnpackLow(cover), alpha16))),
+						Blend(solid16, Vector::UnpackHigh(destination),
+							DivideBy255(Vector::MultiplyLow16(
+								Vector::UnpackHigh(cover), alpha16)))),
+						alphaMask);
+					result = Select(all, solid, result);
+					Vector::Store(dst, Select(none, destination, result));
+				}
+			}
+
+			dst += kPixels * 4;
+			covers += kPixels;
+		}
+
+		if (count > 0) {
+			gScalarSpanKernels.blendSolidSpanAlphaCC(dst, count, color, alpha,
+				covers);
+		}
+	}
+
+	static void
+	BlendRowAlpha(uint8* dst, const uint8* src, uint32 count)
+	{
+		const Type alphaMask = Vector::Set32(0xff000000);
+
+		for (; count >= kPixels; count -= kPixels) {
+			Type source = Vector::Load(src);
+			Type destination = Vector::Load(dst);
+
+			Type sourceLow = Vector::UnpackLow(source);
+			Type sourceHigh = Vector::UnpackHigh(source);
+			Type result = Vector::Pack(
+				Blend(sourceLow, Vector::UnpackLow(destination),
+					Vector::ShuffleAlpha16(sourceLow)),
+				Blend(sourceHigh, Vector::UnpackHigh(destination),
+					Vector::ShuffleAlpha16(sourceHigh)));
+
+			// the destination alpha is kept, unless the source is opaque
+			result = Select(alphaMask, destination, result);
+			Type opaque = Vector::CompareEqual32(
+				Vector::And(source, alphaMask), alphaMask);
+			Vector::Store(dst, Select(opaque, source, result));
+
+			dst += kPixels * 4;
+			src += kPixels * 4;
+		}
+
+		if (count > 0)
+			gScalarSpanKernels.blendRowAlpha(dst, src, count);
+	}
+
+	// #pragma mark - helpers
+
+
+	//! (source * alpha + destination * (256 - alpha)) >> 8, alpha in [0, 255]
+	static inline Type
+	Blend(Type source, Type destination, Type alpha)
+	{
+		return Vector::ShiftRight8(Vector::Add16(
+			Vector::MultiplyLow16(source, alpha),
+			Vector::MultiplyLow16(destination,
+				Vector::Subtract16(Vector::Set16(256), alpha))));
+	}
+
+	/*!	(source * alpha + destination * (65536 - alpha)) >> 16, alpha in
+		[1, 65535]
+	*/
+	static inline Type
+	Blend16(Type source, Type destination, Type alpha)
+	{
+		return MulAddHigh(source, alpha, destination,
+			Vector::Subtract16(Vector::Zero(), alpha));
+	}
+
+	/*!	(a * b + c * d) >> 16 for unsigned 16 bit values, as long as the
+		result fits into 16 bits. The low halves of the products are added
+		separately, and the carry is added to the sum of the high halves: there
+		is a carry when the saturated sum differs from the wrapped one.
+	*/
+	static inline Type
+	MulAddHigh(Type a, Type b, Type c, Type d)
+	{
+		Type low1 = Vector::MultiplyLow16(a, b);
+		Type low2 = Vector::MultiplyLow16(c, d);
+		Type noCarry = Vector::CompareEqual16(
+			Vector::AddSaturate16(low1, low2), Vector::Add16(low1, low2));
+			// 0xffff, i.e. -1, if there is no carry
+
+		return Vector::Add16(
+			Vector::Add16(Vector::MultiplyHigh16(a, b),
+				Vector::MultiplyHigh16(c, d)),
+			Vector::Add16(noCarry, Vector::Set16(1)));
+	}
+
+	//! value / 255 for unsigned 16 bit values
+	static inline Type
+	DivideBy255(Type value)
+	{
+		return Vector::ShiftRight7(
+			Vector::MultiplyHigh16(value, Vector::Set16(0x8081)));
+	}
+
+	static inline Type
+	Select(Type mask, Type ifSet, Type ifClear)
+	{
+		return Vector::Or(Vector::And(mask, ifSet),
+			Vector::AndNot(mask, ifClear));
+	}
+};
+
+
+#define SPAN_KERNELS_SIMD_TABLE(Vector, scaleRowNearest, scaleRowBilinear) \
+	{ \
+		&SIMDSpanKernels<Vector>::BlendSolidSpan, \
+		&SIMDSpanKernels<Vector>::BlendColorSpan<false>, \
+		&SIMDSpanKernels<Vector>::BlendColorSpan<true>, \
+		&SIMDSpanKernels<Vector>::BlendSolidSpanAlphaCO, \
+		&SIMDSpanKernels<Vector>::BlendSolidSpanAlphaCC, \
+		&SIMDSpanKernels<Vector>::BlendRowAlpha, \
+		scaleRowNearest, \
+		scaleRowBilinear \
+	}
+
+
+#endif // SPAN_KERNELS_SIMD_H
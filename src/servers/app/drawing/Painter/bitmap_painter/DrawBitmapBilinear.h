@@ -9,6 +9,8 @@
 #define DRAW_BITMAP_BILINEAR_H
 
 #include "Painter.h"
+#include "ParallelRenderer.h"
+#include "SpanKernels.h"
 
 #include <typeinfo>
 
@@ -72,25 +74,49 @@ struct DrawBitmapBilinearOptimized {
 			if (y1 > y2)
 				continue;
 
-			// buffer offset into destination
-			fDestination = aggInterface.fBuffer.row_ptr(y1) + x1 * 4;
-
 			// x and y are needed as indices into the weight arrays, so the
 			// offset into the target buffer needs to be compensated
-			const int32 xIndexL = x1 - left - filterData.fIndexOffsetX;
-			const int32 xIndexR = x2 - left - filterData.fIndexOffsetX;
-			y1 -= top + filterData.fIndexOffsetY;
-			y2 -= top + filterData.fIndexOffsetY;
-
-			//printf("x: %ld - %ld\n", xIndexL, xIndexR);
-			//printf("y: %ld - %ld\n", y1, y2);
-
-			static_cast<OptimizedVersion*>(this)->DrawToClipRect(
-				xIndexL, xIndexR, y1, y2);
+			ClipRect clipRect;
+			clipRect.painter = static_cast<OptimizedVersion*>(this);
+			clipRect.destination = aggInterface.fBuffer.row_ptr(y1) + x1 * 4;
+			clipRect.xIndexL = x1 - left - filterData.fIndexOffsetX;
+			clipRect.xIndexR = x2 - left - filterData.fIndexOffsetX;
+			clipRect.top = y1 - top - filterData.fIndexOffsetY;
+			clipRect.bottom = y2 - top - filterData.fIndexOffsetY;
+
+			//printf("x: %ld - %ld\n", clipRect.xIndexL, clipRect.xIndexR);
+			//printf("y: %ld - %ld\n", clipRect.top, clipRect.bottom);
+
+			// large clipping rects are split into bands of rows, which are
+			// drawn in parallel
+			ParallelRenderer::RenderRows(clipRect.top, clipRect.bottom,
+				x2 - x1 + 1, &_DrawRows, &clipRect);
 
 		} while (baseRenderer.next_clip_box());
 	}
 
+private:
+	struct ClipRect {
+		OptimizedVersion*	painter;
+		uint8*				destination;
+		int32				xIndexL;
+		int32				xIndexR;
+		int32				top;
+		int32				bottom;
+	};
+
+	static void _DrawRows(void* cookie, int32 y1, int32 y2)
+	{
+		const ClipRect* clipRect = (const ClipRect*)cookie;
+
+		// every band needs its own destination pointer
+		OptimizedVersion painter(*clipRect->painter);
+		painter.fDestination = clipRect->destination
+			+ (y1 - clipRect->top) * painter.fDestinationBytesPerRow;
+		painter.DrawToClipRect(clipRect->xIndexL, clipRect->xIndexR, y1, y2,
+			y2 == clipRect->bottom);
+	}
+
 protected:
 	agg::rendering_buffer*	fSource;
 	uint32					fSourceBytesPerRow;
@@ -229,16 +255,18 @@ template<class ColorType, class DrawMode>
 struct BilinearDefault :
 	DrawBitmapBilinearOptimized<BilinearDefault<ColorType, DrawMode> > {
 
-	void DrawToClipRect(int32 xIndexL, int32 xIndexR, int32 y1, int32 y2)
+	void DrawToClipRect(int32 xIndexL, int32 xIndexR, int32 y1, int32 y2,
+		bool lastRows)
 	{
 		// In this mode we anticipate many pixels wich need filtering,
 		// there are no special cases for direct hit pixels except for
 		// the last column/row and the right/bottom corner pixel.
 
 		// The last column/row handling does not need to be performed
-		// for all clipping rects!
+		// for all clipping rects! Neither for the bands of rows above the
+		// last one, whose last row is not the last row of the clipping rect.
 		int32 yMax = y2;
-		if (this->fWeightsY[yMax].weight == 255)
+		if (lastRows && this->fWeightsY[yMax].weight == 255)
 			yMax--;
 		int32 xIndexMax = xIndexR;
 		if (this->fWeightsX[xIndexMax].weight == 255)
@@ -318,7 +346,8 @@ struct BilinearDefault :
 
 struct BilinearLowFilterRatio :
 	DrawBitmapBilinearOptimized<BilinearLowFilterRatio> {
-	void DrawToClipRect(int32 xIndexL, int32 xIndexR, int32 y1, int32 y2)
+	void DrawToClipRect(int32 xIndexL, int32 xIndexR, int32 y1, int32 y2,
+		bool lastRows)
 	{
 		// In this mode, we anticipate to hit many destination pixels
 		// that map directly to a source pixel, we have more branches
@@ -405,18 +434,20 @@ struct BilinearLowFilterRatio :
 };
 
 
-#ifdef __i386__
+#if defined(__i386__) || defined(__x86_64__)
 
 struct BilinearSimd : DrawBitmapBilinearOptimized<BilinearSimd> {
-	void DrawToClipRect(int32 xIndexL, int32 xIndexR, int32 y1, int32 y2)
+	void DrawToClipRect(int32 xIndexL, int32 xIndexR, int32 y1, int32 y2,
+		bool lastRows)
 	{
 		// Basically the same as the "standard" mode, but we use SIMD
 		// routines for the processing of the single display lines.
 
 		// The last column/row handling does not need to be performed
-		// for all clipping rects!
+		// for all clipping rects! Neither for the bands of rows above the
+		// last one, whose last row is not the last row of the clipping rect.
 		int32 yMax = y2;
-		if (fWeightsY[yMax].weight == 255)
+		if (lastRows && fWeightsY[yMax].weight == 255)
 			yMax--;
 		int32 xIndexMax = xIndexR;
 		if (fWeightsX[xIndexMax].weight == 255)
@@ -432,8 +463,14 @@ struct BilinearSimd : DrawBitmapBilinearOptimized<BilinearSimd> {
 			// buffer handle for destination to be incremented per
 			// pixel
 			uint8* d = fDestination;
+#ifdef __x86_64__
+			gSpanKernels.scaleRowBilinear(fDestination, src,
+				fSourceBytesPerRow, (const uint16*)&fWeightsX[xIndexL],
+				xIndexMax - xIndexL + 1, wTop);
+#else
 			bilinear_scale_xloop_mmxsse(src, fDestination, fWeightsX, xIndexL,
 				xIndexMax, wTop, fSourceBytesPerRow);
+#endif
 			// increase pointer by processed pixels
 			d += (xIndexMax - xIndexL + 1) * 4;
 
@@ -475,7 +512,7 @@ struct BilinearSimd : DrawBitmapBilinearOptimized<BilinearSimd> {
 	}
 };
 
-#endif	// __i386__
+#endif	// __i386__ || __x86_64__
 
 
 template<class ColorType, class DrawMode>
@@ -598,10 +635,17 @@ struct DrawBitmapBilinear {
 
 		if (typeid(ColorType) == typeid(ColorTypeRgb)
 			&& typeid(DrawMode) == typeid(DrawModeCopy)) {
+#ifdef __x86_64__
+			uint32 neededSIMDFlags = APPSERVER_SIMD_SSE2;
+#else
 			uint32 neededSIMDFlags = APPSERVER_SIMD_MMX | APPSERVER_SIMD_SSE;
-			if ((gSIMDFlags & neededSIMDFlags) == neededSIMDFlags)
+#endif
+			// The SIMD version always interpolates with the row below, which
+			// a bitmap with a single row does not have.
+			if ((gSIMDFlags & neededSIMDFlags) == neededSIMDFlags
+				&& bitmap.height() > 1) {
 				codeSelect = kUseSIMDVersion;
-			else {
+			} else {
 				if (scaleX == scaleY && (scaleX == 1.5 || scaleX == 2.0
 					|| scaleX == 2.5 || scaleX == 3.0)) {
 					codeSelect = kOptimizeForLowFilterRatio;
@@ -626,7 +670,7 @@ struct DrawBitmapBilinear {
 				break;
 			}
 
-#ifdef __i386__
+#if defined(__i386__) || defined(__x86_64__)
 			case kUseSIMDVersion:
 			{
 				BilinearSimd bilinearPainter;
@@ -634,7 +678,7 @@ struct DrawBitmapBilinear {
 					filterData);
 				break;
 			}
-#endif	// __i386__
+#endif	// __i386__ || __x86_64__
 		}
 
 #ifdef FILTER_INFOS_ON_HEAP
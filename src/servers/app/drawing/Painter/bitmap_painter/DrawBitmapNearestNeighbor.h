@@ -9,9 +9,41 @@
 #define DRAW_BITMAP_NEAREST_NEIGHBOR_H
 
 #include "Painter.h"
+#include "ParallelRenderer.h"
+#include "SpanKernels.h"
 
 
 struct DrawBitmapNearestNeighborCopy {
+	struct ClipRect {
+		const agg::rendering_buffer*	bitmap;
+		const uint16*					xIndices;
+		const uint16*					yIndices;
+		uint8*							destination;
+		uint32							destinationBytesPerRow;
+		int32							xIndexL;
+		int32							xIndexR;
+		int32							top;
+	};
+
+	static void
+	DrawRows(void* cookie, int32 y1, int32 y2)
+	{
+		const ClipRect* clipRect = (const ClipRect*)cookie;
+
+		uint8* dst = clipRect->destination
+			+ (y1 - clipRect->top) * clipRect->destinationBytesPerRow;
+		for (; y1 <= y2; y1++) {
+			// buffer offset into source (top row)
+			const uint8* src
+				= clipRect->bitmap->row_ptr(clipRect->yIndices[y1]);
+
+			gSpanKernels.scaleRowNearest(dst, src,
+				clipRect->xIndices + clipRect->xIndexL,
+				clipRect->xIndexR - clipRect->xIndexL + 1);
+			dst += clipRect->destinationBytesPerRow;
+		}
+	}
+
 	static void
 	Draw(const Painter* painter, PainterAggInterface& aggInterface,
 		agg::rendering_buffer& bitmap, BPoint offset,
@@ -106,31 +138,27 @@ struct DrawBitmapNearestNeighborCopy {
 			if (y1 > y2)
 				continue;
 
+			ClipRect clipRect;
+			clipRect.bitmap = &bitmap;
+			clipRect.xIndices = xIndices;
+			clipRect.yIndices = yIndices;
 			// buffer offset into destination
-			uint8* dst = aggInterface.fBuffer.row_ptr(y1) + x1 * 4;
+			clipRect.destination = aggInterface.fBuffer.row_ptr(y1) + x1 * 4;
+			clipRect.destinationBytesPerRow = dstBPR;
 
 			// x and y are needed as indeces into the wheight arrays, so the
 			// offset into the target buffer needs to be compensated
-			const int32 xIndexL = x1 - left - filterWeightXIndexOffset;
-			const int32 xIndexR = x2 - left - filterWeightXIndexOffset;
+			clipRect.xIndexL = x1 - left - filterWeightXIndexOffset;
+			clipRect.xIndexR = x2 - left - filterWeightXIndexOffset;
 			y1 -= top + filterWeightYIndexOffset;
 			y2 -= top + filterWeightYIndexOffset;
+			clipRect.top = y1;
 
-		//printf("x: %ld - %ld\n", xIndexL, xIndexR);
+		//printf("x: %ld - %ld\n", clipRect.xIndexL, clipRect.xIndexR);
 		//printf("y: %ld - %ld\n", y1, y2);
 
-			for (; y1 <= y2; y1++) {
-				// buffer offset into source (top row)
-				const uint8* src = bitmap.row_ptr(yIndices[y1]);
-				// buffer handle for destination to be incremented per pixel
-				uint32* d = (uint32*)dst;
-
-				for (int32 x = xIndexL; x <= xIndexR; x++) {
-					*d = *(uint32*)(src + xIndices[x]);
-					d++;
-				}
-				dst += dstBPR;
-			}
+			ParallelRenderer::RenderRows(y1, y2, x2 - x1 + 1, &DrawRows,
+				&clipRect);
 		} while (baseRenderer.next_clip_box());
 
 		//printf("draw bitmap %.5fx%.5f: %lld\n", xScale, yScale,
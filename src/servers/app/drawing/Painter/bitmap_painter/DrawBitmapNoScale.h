@@ -11,6 +11,7 @@
 #include "IntPoint.h"
 #include "IntRect.h"
 #include "Painter.h"
+#include "SpanKernels.h"
 #include "SystemPalette.h"
 
 
@@ -150,24 +151,7 @@ struct Bgr32Alpha : public DrawBitmapNoScale<Bgr32Alpha>
 {
 	void BlendRow(uint8* dst, const uint8* src, int32 numPixels)
 	{
-		uint32* d = (uint32*)dst;
-		int32 bytes = numPixels * 4;
-		uint8 buffer[bytes];
-		uint8* b = buffer;
-		while (numPixels--) {
-			if (src[3] == 255) {
-				*(uint32*)b = *(uint32*)src;
-			} else {
-				*(uint32*)b = *d;
-				b[0] = ((src[0] - b[0]) * src[3] + (b[0] << 8)) >> 8;
-				b[1] = ((src[1] - b[1]) * src[3] + (b[1] << 8)) >> 8;
-				b[2] = ((src[2] - b[2]) * src[3] + (b[2] << 8)) >> 8;
-			}
-			d++;
-			b += 4;
-			src += 4;
-		}
-		memcpy(dst, buffer, bytes);
+		gSpanKernels.blendRowAlpha(dst, src, numPixels);
 	}
 };
 
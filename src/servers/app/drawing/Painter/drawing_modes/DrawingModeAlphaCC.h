@@ -95,6 +95,13 @@ blend_solid_hspan_alpha_cc(int x, int y, unsigned len,
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
 	uint8 hAlpha = pattern->HighColor().alpha;
+	if (pattern->IsSolid()) {
+		rgb_color color = pattern->ColorAt(x, y);
+		gSpanKernels.blendSolidSpanAlphaCC(p, len,
+			span_color(color.red, color.green, color.blue), hAlpha, covers);
+		return;
+	}
+
 	do {
 		rgb_color color = pattern->ColorAt(x, y);
 		uint16 alpha = hAlpha * *covers;
@@ -70,19 +70,8 @@ blend_solid_hspan_alpha_co_solid(int x, int y, unsigned len,
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
 	uint8 hAlpha = pattern->HighColor().alpha;
-	do {
-		uint16 alpha = hAlpha * *covers;
-		if (alpha) {
-			if (alpha == 255 * 255) {
-				ASSIGN_ALPHA_CO(p, c.r, c.g, c.b);
-			} else {
-				BLEND_ALPHA_CO(p, c.r, c.g, c.b, alpha);
-			}
-		}
-		covers++;
-		p += 4;
-		x++;
-	} while(--len);
+	gSpanKernels.blendSolidSpanAlphaCO(p, len, span_color(c.r, c.g, c.b),
+		hAlpha, covers);
 }
 
 
@@ -61,18 +61,7 @@ blend_solid_hspan_copy_solid(int x, int y, unsigned len,
 							 const PatternHandler* pattern)
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
-	do {
-		if (*covers) {
-			if (*covers == 255) {
-				ASSIGN_OVER(p, c.r, c.g, c.b);
-			} else {
-				BLEND_OVER(p, c.r, c.g, c.b, *covers);
-			}
-		}
-		covers++;
-		p += 4;
-		x++;
-	} while(--len);
+	gSpanKernels.blendSolidSpan(p, len, span_color(c.r, c.g, c.b), covers);
 }
 
 
@@ -109,37 +98,7 @@ blend_color_hspan_copy_solid(int x, int y, unsigned len,
 							 const PatternHandler* pattern)
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
-	if (covers) {
-		// non-solid opacity
-		do {
-				if (*covers) {
-				if (*covers == 255) {
-					ASSIGN_OVER(p, colors->r, colors->g, colors->b);
-				} else {
-					BLEND_OVER(p, colors->r, colors->g, colors->b, *covers);
-				}
-			}
-			covers++;
-			p += 4;
-			++colors;
-		} while(--len);
-	} else {
-		// solid full opcacity
-		if (cover == 255) {
-			do {
-				ASSIGN_OVER(p, colors->r, colors->g, colors->b);
-				p += 4;
-				++colors;
-			} while(--len);
-		// solid partial opacity
-		} else if (cover) {
-			do {
-				BLEND_OVER(p, colors->r, colors->g, colors->b, cover);
-				p += 4;
-				++colors;
-			} while(--len);
-		}
-	}
+	gSpanKernels.blendColorSpan(p, len, (const uint8*)colors, covers, cover);
 }
 
 #endif // DRAWING_MODE_COPY_SOLID_H
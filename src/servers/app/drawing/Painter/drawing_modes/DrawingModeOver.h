@@ -134,42 +134,10 @@ blend_color_hspan_over(int x, int y, unsigned len,
 					   const uint8* covers, uint8 cover,
 					   agg_buffer* buffer, const PatternHandler* pattern)
 {
+	// colors that are fully transparent are skipped
 	uint8* p = buffer->row_ptr(y) + (x << 2);
-	if (covers) {
-		// non-solid opacity
-		do {
-			if (*covers && colors->a > 0) {
-				if (*covers == 255) {
-					ASSIGN_OVER(p, colors->r, colors->g, colors->b);
-				} else {
-					BLEND_OVER(p, colors->r, colors->g, colors->b, *covers);
-				}
-			}
-			covers++;
-			p += 4;
-			++colors;
-		} while(--len);
-	} else {
-		// solid full opcacity
-		if (cover == 255) {
-			do {
-				if (colors->a > 0) {
-					ASSIGN_OVER(p, colors->r, colors->g, colors->b);
-				}
-				p += 4;
-				++colors;
-			} while(--len);
-		// solid partial opacity
-		} else if (cover) {
-			do {
-				if (colors->a > 0) {
-					BLEND_OVER(p, colors->r, colors->g, colors->b, cover);
-				}
-				p += 4;
-				++colors;
-			} while(--len);
-		}
-	}
+	gSpanKernels.blendColorSpanOver(p, len, (const uint8*)colors, covers,
+		cover);
 }
 
 #endif // DRAWING_MODE_OVER_H
@@ -415,6 +415,8 @@ CommitTransactionHandler::_ApplyChanges()
 {
 	if (!fFirstBootProcessing)
 	{
+		bigtime_t startTime = system_time();
+
 		// create an old state directory
 		_CreateOldStateDirectory();
 
@@ -424,11 +426,22 @@ CommitTransactionHandler::_ApplyChanges()
 		// move packages to activate to packages directory
 		_AddPackagesToActivate();
 
+		bigtime_t moveTime = system_time();
+
 		// run pre-uninstall scripts, before their packages vanish.
 		_RunPreUninstallScripts();
 
+		bigtime_t scriptTime = system_time();
+
 		// activate/deactivate packages and create users, groups, settings files.
 		_ChangePackageActivation(fAddedPackages, fRemovedPackages);
+
+		INFORM("CommitTransactionHandler::_ApplyChanges(): moving %zu "
+			"packages: %" B_PRIdBIGTIME " us, pre-uninstall scripts: %"
+			B_PRIdBIGTIME " us, activation: %" B_PRIdBIGTIME " us\n",
+			fAddedPackages.size() + fRemovedPackages.size(),
+			moveTime - startTime, scriptTime - moveTime,
+			system_time() - scriptTime);
 	} else // FirstBootProcessing, skip several steps and just do package setup.
 		_PrepareFirstBootPackages();
 
@@ -539,6 +552,18 @@ CommitTransactionHandler::_RemovePackagesToDeactivate()
 	if (fPackagesToDeactivate.empty())
 		return;
 
+	// Open the packages directory only once, rather than resolving each
+	// package's entry ref separately.
+	BDirectory packagesDirectory;
+	status_t error
+		= packagesDirectory.SetTo(&fVolume->PackagesDirectoryRef());
+	if (error != B_OK) {
+		ERROR("Failed to open packages directory: %s\n", strerror(error));
+		throw Exception(B_TRANSACTION_FAILED_TO_OPEN_DIRECTORY)
+			.SetPath1("<packages>")
+			.SetSystemError(error);
+	}
+
 	for (PackageSet::const_iterator it = fPackagesToDeactivate.begin();
 		it != fPackagesToDeactivate.end(); ++it) {
 		Package* package = *it;
@@ -557,7 +582,10 @@ CommitTransactionHandler::_RemovePackagesToDeactivate()
 		NotOwningEntryRef entryRef(package->EntryRef());
 
 		BEntry entry;
-		status_t error = entry.SetTo(&entryRef);
+		if (package->File()->DirectoryRef() == fVolume->PackagesDirectoryRef())
+			error = entry.SetTo(&packagesDirectory, package->FileName());
+		else
+			error = entry.SetTo(&entryRef);
 		if (error != B_OK) {
 			ERROR("Failed to get package entry for %s: %s\n",
 				package->FileName().String(), strerror(error));
@@ -608,6 +636,17 @@ CommitTransactionHandler::_AddPackagesToActivate()
 			.SetSystemError(error);
 	}
 
+	// open the transaction directory
+	BDirectory transactionDirectory;
+	error = transactionDirectory.SetTo(&fTransactionDirectoryRef);
+	if (error != B_OK) {
+		ERROR("Failed to open transaction directory: %s\n", strerror(error));
+		throw Exception(B_TRANSACTION_FAILED_TO_OPEN_DIRECTORY)
+			.SetPath1(_GetPath(FSUtils::Entry(fTransactionDirectoryRef),
+				"<transaction>"))
+			.SetSystemError(error);
+	}
+
 	int32 count = fPackagesToActivate.CountItems();
 	for (int32 i = 0; i < count; i++) {
 		Package* package = fPackagesToActivate.ItemAt(i);
@@ -622,7 +661,7 @@ CommitTransactionHandler::_AddPackagesToActivate()
 		NotOwningEntryRef entryRef(fTransactionDirectoryRef,
 			package->FileName());
 		BEntry entry;
-		error = entry.SetTo(&entryRef);
+		error = entry.SetTo(&transactionDirectory, package->FileName());
 		if (error != B_OK) {
 			ERROR("Failed to get package entry for %s: %s\n",
 				package->FileName().String(), strerror(error));
@@ -1686,7 +1725,7 @@ void
 CommitTransactionHandler::_WriteActivationFile(
 	const RelativePath& directoryPath, const char* fileName,
 	const PackageSet& toActivate, const PackageSet& toDeactivate,
-	BEntry& _entry)
+	BEntry& _entry, bool sync)
 {
 	// create the content
 	BString activationFileContent;
@@ -1695,7 +1734,7 @@ CommitTransactionHandler::_WriteActivationFile(
 
 	// write the file
 	status_t error = _WriteTextFile(directoryPath, fileName,
-		activationFileContent, _entry);
+		activationFileContent, _entry, sync);
 	if (error != B_OK) {
 		BString filePath = directoryPath.ToString() << '/' << fileName;
 		throw Exception(B_TRANSACTION_FAILED_TO_WRITE_ACTIVATION_FILE)
@@ -1744,7 +1783,7 @@ CommitTransactionHandler::_CreateActivationFileContent(
 
 status_t
 CommitTransactionHandler::_WriteTextFile(const RelativePath& directoryPath,
-	const char* fileName, const BString& content, BEntry& _entry)
+	const char* fileName, const BString& content, BEntry& _entry, bool sync)
 {
 	BFile file;
 	status_t error = _OpenPackagesFile(directoryPath,
@@ -1765,6 +1804,16 @@ CommitTransactionHandler::_WriteTextFile(const RelativePath& directoryPath,
 		return bytesWritten;
 	}
 
+	if (sync) {
+		error = file.Sync();
+		if (error != B_OK) {
+			ERROR("CommitTransactionHandler::_WriteTextFile(): failed to sync "
+				"file \"%s/%s\": %s\n", directoryPath.ToString().String(),
+				fileName, strerror(error));
+			return error;
+		}
+	}
+
 	return B_OK;
 }
 
@@ -1778,11 +1827,14 @@ CommitTransactionHandler::_ChangePackageActivation(
 		"%zu, deactivating %zu packages\n", packagesToActivate.size(),
 		packagesToDeactivate.size());
 
-	// write the temporary package activation file
+	// Write the temporary package activation file. None of the previous steps
+	// has been synced, so syncing the file is the single point at which the
+	// moved packages, the old state directory, and the new activation file
+	// are written to disk -- at least the file system's journal is flushed.
 	BEntry activationFileEntry;
 	_WriteActivationFile(RelativePath(kAdminDirectoryName),
 		kTemporaryActivationFileName, packagesToActivate, packagesToDeactivate,
-		activationFileEntry);
+		activationFileEntry, true);
 
 	// notify packagefs
 	if (fVolumeStateIsActive) {
@@ -1811,6 +1863,13 @@ CommitTransactionHandler::_ChangePackageActivation(
 // and things would be in an inconsistent state after rebooting.
 	}
 
+	// make the rename persistent, too
+	BDirectory adminDirectory;
+	if (_OpenPackagesSubDirectory(RelativePath(kAdminDirectoryName), false,
+			adminDirectory) == B_OK) {
+		adminDirectory.Sync();
+	}
+
 	// Update our state, i.e. remove deactivated packages and mark activated
 	// packages accordingly.
 	fVolumeState->ActivationChanged(packagesToActivate, packagesToDeactivate);
@@ -2025,14 +2084,18 @@ CommitTransactionHandler::_AssertEntriesAreEqual(const BEntry& entry,
 	if (aSize != bSize)
 		return B_FILE_EXISTS;
 
-	const size_t bufferSize = 4096;
-	uint8 aBuffer[bufferSize];
-	uint8 bBuffer[bufferSize];
+	// packages are usually large, so compare them in big pieces
+	const size_t bufferSize = 64 * 1024;
+	uint8* aBuffer = (uint8*)malloc(2 * bufferSize);
+	if (aBuffer == NULL)
+		return B_NO_MEMORY;
+	MemoryDeleter bufferDeleter(aBuffer);
+	uint8* bBuffer = aBuffer + bufferSize;
 
 	while (aSize > 0) {
 		ssize_t aRead = a.Read(aBuffer, bufferSize);
 		ssize_t bRead = b.Read(bBuffer, bufferSize);
-		if (aRead < 0 || aRead != bRead)
+		if (aRead <= 0 || aRead != bRead)
 			return B_FILE_EXISTS;
 		if (memcmp(aBuffer, bBuffer, aRead) != 0)
 			return B_FILE_EXISTS;
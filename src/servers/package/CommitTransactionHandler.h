@@ -122,7 +122,7 @@ private:
 									const char* fileName,
 									const PackageSet& toActivate,
 									const PackageSet& toDeactivate,
-									BEntry& _entry);
+									BEntry& _entry, bool sync = false);
 			void				_CreateActivationFileContent(
 									const PackageSet& toActivate,
 									const PackageSet& toDeactivate,
@@ -130,7 +130,8 @@ private:
 			status_t			_WriteTextFile(
 									const RelativePath& directoryPath,
 									const char* fileName,
-									const BString& content, BEntry& _entry);
+									const BString& content, BEntry& _entry,
+									bool sync = false);
 			void				_ChangePackageActivation(
 									const PackageSet& packagesToActivate,
 									const PackageSet& packagesToDeactivate);
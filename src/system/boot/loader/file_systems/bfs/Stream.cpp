@@ -309,6 +309,11 @@ Stream::ReadAt(off_t pos, uint8* buffer, size_t* _length)
 	if (pos + (off_t)length > data.Size())
 		length = data.Size() - pos;
 
+	if ((Flags() & INODE_INLINE_DATA) != 0) {
+		*_length = length;
+		return _ReadInlineData(pos, buffer, _length);
+	}
+
 	block_run run;
 	off_t offset;
 	if (FindBlockRun(pos, run, offset) < B_OK) {
@@ -415,6 +420,44 @@ Stream::ReadAt(off_t pos, uint8* buffer, size_t* _length)
 }
 
 
+/*!	Reads the data of a file that is stored in the small_data section of
+	its inode. Since we only keep the bfs_inode structure itself in memory,
+	the whole inode block is read for this.
+*/
+status_t
+Stream::_ReadInlineData(off_t pos, uint8* buffer, size_t* _length)
+{
+	CachedBlock cached(fVolume, inode_num);
+	const bfs_inode* node = (const bfs_inode*)cached.Block();
+	if (node == NULL) {
+		*_length = 0;
+		return B_IO_ERROR;
+	}
+
+	const small_data* smallData = node->small_data_start;
+	while (!smallData->IsLast(node)) {
+		if (smallData->NameSize() == FILE_DATA_NAME_LENGTH
+			&& *smallData->Name() == FILE_DATA_NAME) {
+			if (pos >= smallData->DataSize()) {
+				*_length = 0;
+				return B_OK;
+			}
+
+			size_t length = min_c(*_length,
+				(size_t)(smallData->DataSize() - pos));
+			memcpy(buffer, smallData->Data() + pos, length);
+			*_length = length;
+			return B_OK;
+		}
+
+		smallData = smallData->Next();
+	}
+
+	*_length = 0;
+	return B_BAD_DATA;
+}
+
+
 Node*
 Stream::NodeFactory(Volume& volume, off_t id)
 {
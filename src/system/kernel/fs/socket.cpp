@@ -195,6 +195,199 @@ prepare_userland_msghdr(const msghdr* userMessage, msghdr& message,
 }
 
 
+/*!	Kernel copy of a userland mmsghdr vector, as used by recvmmsg() and
+	sendmmsg(). Each message is prepared like prepare_userland_msghdr() does,
+	but the headers, the addresses, the I/O vectors, and the ancillary data of
+	all messages share a single allocation each.
+*/
+class UserlandMessageVector {
+public:
+	UserlandMessageVector(bool send)
+		:
+		fSend(send),
+		fUserMessages(NULL),
+		fMessages(NULL),
+		fUserPointers(NULL),
+		fAddresses(NULL)
+	{
+	}
+
+	status_t Init(mmsghdr* userMessages, size_t count)
+	{
+		if (userMessages == NULL)
+			return B_BAD_VALUE;
+		if (!IS_USER_ADDRESS(userMessages))
+			return B_BAD_ADDRESS;
+
+		uint8* block = (uint8*)malloc(count * (sizeof(mmsghdr)
+			+ sizeof(user_pointers) + MAX_SOCKET_ADDRESS_LENGTH));
+		if (block == NULL)
+			return B_NO_MEMORY;
+		fBlockDeleter.SetTo(block);
+
+		fUserMessages = userMessages;
+		fMessages = (mmsghdr*)block;
+		fUserPointers = (user_pointers*)(fMessages + count);
+		fAddresses = (char*)(fUserPointers + count);
+
+		// copy the message headers from userland in one go
+		if (user_memcpy(fMessages, userMessages, count * sizeof(mmsghdr))
+				!= B_OK) {
+			return B_BAD_ADDRESS;
+		}
+
+		// check them, and compute the space for vectors and ancillary data
+		size_t vecCount = 0;
+		size_t ancillarySize = 0;
+		for (size_t i = 0; i < count; i++) {
+			msghdr& message = fMessages[i].msg_hdr;
+			if (message.msg_iovlen < 0 || message.msg_iovlen > IOV_MAX)
+				return EMSGSIZE;
+			if (message.msg_iov == NULL || message.msg_iovlen == 0) {
+				message.msg_iov = NULL;
+				message.msg_iovlen = 0;
+			}
+			vecCount += message.msg_iovlen;
+
+			if (message.msg_name != NULL) {
+				if (!IS_USER_ADDRESS(message.msg_name))
+					return B_BAD_ADDRESS;
+				if (message.msg_namelen > MAX_SOCKET_ADDRESS_LENGTH)
+					message.msg_namelen = MAX_SOCKET_ADDRESS_LENGTH;
+			}
+
+			if (message.msg_control != NULL) {
+				if (!IS_USER_ADDRESS(message.msg_control))
+					return B_BAD_ADDRESS;
+				if (message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH) {
+					if (fSend)
+						return B_BAD_VALUE;
+					message.msg_controllen = MAX_ANCILLARY_DATA_LENGTH;
+				}
+				ancillarySize += CMSG_ALIGN(message.msg_controllen);
+			}
+		}
+
+		iovec* vecs = NULL;
+		if (vecCount > 0) {
+			vecs = (iovec*)malloc(vecCount * sizeof(iovec));
+			if (vecs == NULL)
+				return B_NO_MEMORY;
+			fVecsDeleter.SetTo(vecs);
+		}
+
+		uint8* ancillary = NULL;
+		if (ancillarySize > 0) {
+			ancillary = (uint8*)malloc(ancillarySize);
+			if (ancillary == NULL)
+				return B_NO_MEMORY;
+			fAncillaryDeleter.SetTo(ancillary);
+		}
+
+		// replace the userland pointers with kernel buffers
+		for (size_t i = 0; i < count; i++) {
+			msghdr& message = fMessages[i].msg_hdr;
+			user_pointers& user = fUserPointers[i];
+			user.vecs = message.msg_iov;
+			user.address = message.msg_name;
+			user.ancillary = message.msg_control;
+
+			if (message.msg_iovlen > 0) {
+				status_t error = get_iovecs_from_user(user.vecs,
+					message.msg_iovlen, vecs);
+				if (error != B_OK)
+					return error;
+
+				message.msg_iov = vecs;
+				vecs += message.msg_iovlen;
+			}
+
+			if (message.msg_name != NULL) {
+				message.msg_name = fAddresses + i * MAX_SOCKET_ADDRESS_LENGTH;
+				if (fSend && user_memcpy(message.msg_name, user.address,
+						message.msg_namelen) != B_OK) {
+					return B_BAD_ADDRESS;
+				}
+			}
+
+			if (message.msg_control != NULL) {
+				message.msg_control = ancillary;
+				if (fSend && user_memcpy(message.msg_control, user.ancillary,
+						message.msg_controllen) != B_OK) {
+					return B_BAD_ADDRESS;
+				}
+				ancillary += CMSG_ALIGN(message.msg_controllen);
+			}
+
+			fMessages[i].msg_len = 0;
+		}
+
+		return B_OK;
+	}
+
+	mmsghdr* Messages() const
+	{
+		return fMessages;
+	}
+
+	/*!	Copies the results of the first \a count messages back to userland:
+		the number of bytes transferred, and for received messages also the
+		addresses, the ancillary data, and the header fields recvmsg()
+		updates. The userland pointers in the headers are left alone.
+	*/
+	status_t CopyBack(size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			mmsghdr& message = fMessages[i];
+			mmsghdr* userMessage = fUserMessages + i;
+
+			if (user_memcpy(&userMessage->msg_len, &message.msg_len,
+					sizeof(message.msg_len)) != B_OK) {
+				return B_BAD_ADDRESS;
+			}
+			if (fSend)
+				continue;
+
+			const msghdr& header = message.msg_hdr;
+			msghdr* userHeader = &userMessage->msg_hdr;
+			const user_pointers& user = fUserPointers[i];
+
+			if ((user.address != NULL && user_memcpy(user.address,
+						header.msg_name, header.msg_namelen) != B_OK)
+				|| (user.ancillary != NULL && user_memcpy(user.ancillary,
+						header.msg_control, header.msg_controllen) != B_OK)
+				|| user_memcpy(&userHeader->msg_namelen, &header.msg_namelen,
+						sizeof(header.msg_namelen)) != B_OK
+				|| user_memcpy(&userHeader->msg_controllen,
+						&header.msg_controllen, sizeof(header.msg_controllen))
+					!= B_OK
+				|| user_memcpy(&userHeader->msg_flags, &header.msg_flags,
+						sizeof(header.msg_flags)) != B_OK) {
+				return B_BAD_ADDRESS;
+			}
+		}
+
+		return B_OK;
+	}
+
+private:
+	struct user_pointers {
+		iovec*	vecs;
+		void*	address;
+		void*	ancillary;
+	};
+
+	bool			fSend;
+	mmsghdr*		fUserMessages;
+	mmsghdr*		fMessages;
+	user_pointers*	fUserPointers;
+	char*			fAddresses;
+	MemoryDeleter	fBlockDeleter;
+	MemoryDeleter	fVecsDeleter;
+	MemoryDeleter	fAncillaryDeleter;
+};
+
+
 // #pragma mark - socket file descriptor
 
 
@@ -545,6 +738,19 @@ common_recvmsg(int fd, struct msghdr *message, int flags, bool kernel)
 }
 
 
+static ssize_t
+common_recvmmsg(int fd, struct mmsghdr *messages, size_t count, int flags,
+	bigtime_t timeout, bool kernel)
+{
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
+	FileDescriptorPutter _(descriptor);
+
+	return sStackInterface->recvmmsg(FD_SOCKET(descriptor), messages, count,
+		flags, timeout);
+}
+
+
 static ssize_t
 common_send(int fd, const void *data, size_t length, int flags, bool kernel)
 {
@@ -580,6 +786,19 @@ common_sendmsg(int fd, const struct msghdr *message, int flags, bool kernel)
 }
 
 
+static ssize_t
+common_sendmmsg(int fd, struct mmsghdr *messages, size_t count, int flags,
+	bool kernel)
+{
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor);
+	FileDescriptorPutter _(descriptor);
+
+	return sStackInterface->sendmmsg(FD_SOCKET(descriptor), messages, count,
+		flags);
+}
+
+
 static status_t
 common_getsockopt(int fd, int level, int option, void *value,
 	socklen_t *_length, bool kernel)
@@ -776,6 +995,27 @@ recvmsg(int socket, struct msghdr *message, int flags)
 }
 
 
+int
+recvmmsg(int socket, struct mmsghdr *messages, unsigned int count, int flags,
+	struct timespec *timeout)
+{
+	SyscallFlagUnsetter _;
+
+	bigtime_t deadline = B_INFINITE_TIMEOUT;
+	if (timeout != NULL) {
+		if (timeout->tv_sec < 0 || timeout->tv_nsec < 0
+			|| timeout->tv_nsec >= 1000000000) {
+			RETURN_AND_SET_ERRNO(B_BAD_VALUE);
+		}
+		deadline = system_time() + (bigtime_t)timeout->tv_sec * 1000000
+			+ timeout->tv_nsec / 1000;
+	}
+
+	RETURN_AND_SET_ERRNO(common_recvmmsg(socket, messages, count, flags,
+		deadline, true));
+}
+
+
 ssize_t
 send(int socket, const void *data, size_t length, int flags)
 {
@@ -802,6 +1042,14 @@ sendmsg(int socket, const struct msghdr *message, int flags)
 }
 
 
+int
+sendmmsg(int socket, struct mmsghdr *messages, unsigned int count, int flags)
+{
+	SyscallFlagUnsetter _;
+	RETURN_AND_SET_ERRNO(common_sendmmsg(socket, messages, count, flags, true));
+}
+
+
 int
 getsockopt(int socket, int level, int option, void *value, socklen_t *_length)
 {
@@ -1065,6 +1313,40 @@ _user_recvmsg(int socket, struct msghdr *userMessage, int flags)
 }
 
 
+ssize_t
+_user_recvmmsg(int socket, struct mmsghdr *userMessages, size_t count,
+	int flags, bigtime_t timeout)
+{
+	if (count == 0)
+		return 0;
+	if (count > IOV_MAX)
+		count = IOV_MAX;
+	if (timeout < 0)
+		return B_BAD_VALUE;
+	if (timeout != B_INFINITE_TIMEOUT)
+		timeout += system_time();
+
+	UserlandMessageVector messages(false);
+	status_t error = messages.Init(userMessages, count);
+	if (error != B_OK)
+		return error;
+
+	// recvmmsg()
+	SyscallRestartWrapper<ssize_t> result;
+
+	result = common_recvmmsg(socket, messages.Messages(), count, flags,
+		timeout, false);
+	if (result <= 0)
+		return result;
+
+	// copy the message headers, addresses, and ancillary data back
+	if (messages.CopyBack(result) != B_OK)
+		return B_BAD_ADDRESS;
+
+	return result;
+}
+
+
 ssize_t
 _user_send(int socket, const void *data, size_t length, int flags)
 {
@@ -1157,6 +1439,35 @@ _user_sendmsg(int socket, const struct msghdr *userMessage, int flags)
 }
 
 
+ssize_t
+_user_sendmmsg(int socket, struct mmsghdr *userMessages, size_t count,
+	int flags)
+{
+	if (count == 0)
+		return 0;
+	if (count > IOV_MAX)
+		count = IOV_MAX;
+
+	UserlandMessageVector messages(true);
+	status_t error = messages.Init(userMessages, count);
+	if (error != B_OK)
+		return error;
+
+	// sendmmsg()
+	SyscallRestartWrapper<ssize_t> result;
+
+	result = common_sendmmsg(socket, messages.Messages(), count, flags, false);
+	if (result <= 0)
+		return result;
+
+	// copy the number of bytes sent per message back
+	if (messages.CopyBack(result) != B_OK)
+		return B_BAD_ADDRESS;
+
+	return result;
+}
+
+
 status_t
 _user_getsockopt(int socket, int level, int option, void *userValue,
 	socklen_t *_length)
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures the rate of metadata operations (create, setattr, unlink) with
+//!	several threads working in parallel, optionally syncing regularly.
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <fs_attr.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <TypeConstants.h>
+
+
+static const int kMaxThreads = 64;
+
+enum phase {
+	PHASE_CREATE,
+	PHASE_SETATTR,
+	PHASE_UNLINK,
+	PHASE_COUNT
+};
+
+static const char* kPhaseNames[PHASE_COUNT] = {
+	"create", "setattr", "unlink"
+};
+
+static const char* sDirectory = ".";
+static int sThreads = 4;
+static int sFiles = 5000;
+static int sSyncInterval = 0;
+static bool sSharedDirectory = false;
+
+static pthread_barrier_t sBarrier;
+
+struct thread_info {
+	pthread_t	thread;
+	int			index;
+	long		failed;
+};
+
+static thread_info sThreadInfos[kMaxThreads];
+
+
+static double
+current_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+static void
+file_path(char* path, size_t size, int thread, int file)
+{
+	if (sSharedDirectory) {
+		snprintf(path, size, "%s/metadata_bench/t%d-file%d", sDirectory,
+			thread, file);
+	} else {
+		snprintf(path, size, "%s/metadata_bench/%d/file%d", sDirectory,
+			thread, file);
+	}
+}
+
+
+static bool
+run_operation(int phase, int thread, int file)
+{
+	char path[PATH_MAX];
+	file_path(path, sizeof(path), thread, file);
+
+	switch (phase) {
+		case PHASE_CREATE:
+		{
+			int fd = open(path, O_CREAT | O_EXCL | O_WRONLY, 0644);
+			if (fd < 0)
+				return false;
+			close(fd);
+			return true;
+		}
+
+		case PHASE_SETATTR:
+		{
+			int fd = open(path, O_WRONLY);
+			if (fd < 0)
+				return false;
+
+			char value[64];
+			int length = snprintf(value, sizeof(value),
+				"user%d@host%d.example.com", file, thread) + 1;
+			ssize_t written = fs_write_attr(fd, "MAIL:from", B_STRING_TYPE, 0,
+				value, length);
+			close(fd);
+			return written == length;
+		}
+
+		case PHASE_UNLINK:
+			return unlink(path) == 0;
+	}
+
+	return false;
+}
+
+
+static void*
+worker_thread(void* _info)
+{
+	thread_info* info = (thread_info*)_info;
+
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		pthread_barrier_wait(&sBarrier);
+
+		for (int i = 0; i < sFiles; i++) {
+			if (!run_operation(phase, info->index, i))
+				info->failed++;
+
+			if (sSyncInterval > 0 && (i + 1) % sSyncInterval == 0)
+				sync();
+		}
+
+		pthread_barrier_wait(&sBarrier);
+	}
+
+	return NULL;
+}
+
+
+static void
+create_directory(const char* path)
+{
+	if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "Could not create %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+}
+
+
+static void
+usage()
+{
+	fprintf(stderr, "usage: bfs_metadata_bench [-t <threads>] "
+		"[-n <files per thread>] [-y <ops between syncs>] [-s] "
+		"[<directory>]\n"
+		"  -s  let all threads share a single directory\n");
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "t:n:y:sh")) != -1) {
+		switch (option) {
+			case 't':
+				sThreads = atoi(optarg);
+				break;
+			case 'n':
+				sFiles = atoi(optarg);
+				break;
+			case 'y':
+				sSyncInterval = atoi(optarg);
+				break;
+			case 's':
+				sSharedDirectory = true;
+				break;
+			default:
+				usage();
+		}
+	}
+
+	if (optind < argc)
+		sDirectory = argv[optind++];
+	if (optind < argc || sThreads < 1 || sThreads > kMaxThreads || sFiles < 1
+		|| sSyncInterval < 0)
+		usage();
+
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/metadata_bench", sDirectory);
+	create_directory(path);
+	if (!sSharedDirectory) {
+		for (int i = 0; i < sThreads; i++) {
+			snprintf(path, sizeof(path), "%s/metadata_bench/%d", sDirectory, i);
+			create_directory(path);
+		}
+	}
+	sync();
+
+	pthread_barrier_init(&sBarrier, NULL, sThreads + 1);
+
+	for (int i = 0; i < sThreads; i++) {
+		sThreadInfos[i].index = i;
+		sThreadInfos[i].failed = 0;
+		pthread_create(&sThreadInfos[i].thread, NULL, &worker_thread,
+			&sThreadInfos[i]);
+	}
+
+	printf("%d threads, %d files each, %s directory", sThreads, sFiles,
+		sSharedDirectory ? "shared" : "one");
+	if (sSyncInterval > 0)
+		printf(", sync every %d operations", sSyncInterval);
+	printf("\n");
+
+	double total = 0;
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		pthread_barrier_wait(&sBarrier);
+		double start = current_time();
+		pthread_barrier_wait(&sBarrier);
+
+		// include writing back the metadata in the measurement
+		sync();
+		double elapsed = current_time() - start;
+		total += elapsed;
+
+		printf("  %-8s %10.0f ops/s  (%.2f s)\n", kPhaseNames[phase],
+			(double)sThreads * sFiles / elapsed, elapsed);
+	}
+
+	long failed = 0;
+	for (int i = 0; i < sThreads; i++) {
+		pthread_join(sThreadInfos[i].thread, NULL);
+		failed += sThreadInfos[i].failed;
+	}
+
+	printf("  %-8s %10.0f ops/s  (%.2f s)\n", "total",
+		(double)PHASE_COUNT * sThreads * sFiles / total, total);
+	if (failed > 0)
+		printf("%ld operations failed!\n", failed);
+
+	pthread_barrier_destroy(&sBarrier);
+
+	if (!sSharedDirectory) {
+		for (int i = 0; i < sThreads; i++) {
+			snprintf(path, sizeof(path), "%s/metadata_bench/%d", sDirectory, i);
+			rmdir(path);
+		}
+	}
+	snprintf(path, sizeof(path), "%s/metadata_bench", sDirectory);
+	rmdir(path);
+
+	return failed > 0 ? 1 : 0;
+}
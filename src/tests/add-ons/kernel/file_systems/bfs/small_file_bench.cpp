@@ -0,0 +1,189 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures how fast many small files can be written, and read back
+//!	completely, as "cat" would do it.
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+static const int kMaxFileSize = 65536;
+
+static const char* sDirectory = ".";
+static int sFiles = 10000;
+static int sFileSize = 512;
+static bool sKeepFiles = false;
+
+
+static double
+current_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+static void
+file_path(char* path, size_t size, int file)
+{
+	snprintf(path, size, "%s/small_file_bench/file%d", sDirectory, file);
+}
+
+
+static long
+write_files(const char* buffer)
+{
+	long failed = 0;
+	char path[PATH_MAX];
+
+	for (int i = 0; i < sFiles; i++) {
+		file_path(path, sizeof(path), i);
+
+		int fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+		if (fd < 0) {
+			failed++;
+			continue;
+		}
+		if (write(fd, buffer, sFileSize) != sFileSize)
+			failed++;
+		close(fd);
+	}
+
+	return failed;
+}
+
+
+static long
+read_files(char* buffer)
+{
+	long failed = 0;
+	char path[PATH_MAX];
+
+	for (int i = 0; i < sFiles; i++) {
+		file_path(path, sizeof(path), i);
+
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			failed++;
+			continue;
+		}
+
+		// read until EOF, like cat does
+		ssize_t total = 0;
+		while (true) {
+			ssize_t bytesRead = read(fd, buffer, kMaxFileSize);
+			if (bytesRead <= 0) {
+				if (bytesRead < 0)
+					failed++;
+				break;
+			}
+			total += bytesRead;
+		}
+		if (total != sFileSize)
+			failed++;
+
+		close(fd);
+	}
+
+	return failed;
+}
+
+
+static void
+print_result(const char* name, double elapsed)
+{
+	printf("  %-6s %10.0f files/s  %8.2f MB/s  (%.2f s)\n", name,
+		sFiles / elapsed, (double)sFiles * sFileSize / elapsed / 1048576.0,
+		elapsed);
+}
+
+
+static void
+usage()
+{
+	fprintf(stderr, "usage: bfs_small_file_bench [-n <files>] "
+		"[-s <file size>] [-k] [<directory>]\n"
+		"  -k  keep the files around after the run\n");
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "n:s:kh")) != -1) {
+		switch (option) {
+			case 'n':
+				sFiles = atoi(optarg);
+				break;
+			case 's':
+				sFileSize = atoi(optarg);
+				break;
+			case 'k':
+				sKeepFiles = true;
+				break;
+			default:
+				usage();
+		}
+	}
+
+	if (optind < argc)
+		sDirectory = argv[optind++];
+	if (optind < argc || sFiles < 1 || sFileSize < 0
+		|| sFileSize > kMaxFileSize)
+		usage();
+
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/small_file_bench", sDirectory);
+	if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "Could not create %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	char* buffer = (char*)malloc(kMaxFileSize);
+	if (buffer == NULL)
+		return 1;
+	memset(buffer, 'x', kMaxFileSize);
+
+	printf("%d files, %d bytes each\n", sFiles, sFileSize);
+
+	double start = current_time();
+	long failed = write_files(buffer);
+	sync();
+	print_result("write", current_time() - start);
+
+	// the data is likely still cached, so this mostly measures the cost of
+	// the open/read/close path itself
+	start = current_time();
+	failed += read_files(buffer);
+	print_result("read", current_time() - start);
+
+	if (failed > 0)
+		printf("%ld operations failed!\n", failed);
+
+	if (!sKeepFiles) {
+		for (int i = 0; i < sFiles; i++) {
+			file_path(path, sizeof(path), i);
+			unlink(path);
+		}
+		snprintf(path, sizeof(path), "%s/small_file_bench", sDirectory);
+		rmdir(path);
+	}
+
+	free(buffer);
+	return failed > 0 ? 1 : 0;
+}
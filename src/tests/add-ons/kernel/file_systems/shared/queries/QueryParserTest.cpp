@@ -95,6 +95,11 @@ struct Query::QueryPolicy {
 		return B_ERROR;
 	}
 
+	static status_t IndexSetToTrigrams(Index& index, const char* attribute)
+	{
+		return B_ENTRY_NOT_FOUND;
+	}
+
 	static void IndexUnset(Index& index)
 	{
 	}
@@ -145,6 +150,11 @@ struct Query::QueryPolicy {
 		return B_OK;
 	}
 
+	static ino_t IndexIteratorGetNodeID(IndexIterator* indexIterator)
+	{
+		return -1;
+	}
+
 	static void IndexIteratorSkipDuplicates(IndexIterator* indexIterator)
 	{
 	}
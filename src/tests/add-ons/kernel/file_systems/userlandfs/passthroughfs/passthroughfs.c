@@ -0,0 +1,303 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	A FUSE file system that simply passes all operations through to a
+	directory of another file system. It does no work of its own, so comparing
+	it with the underlying directory shows the overhead of the userlandfs
+	request transport.
+
+	Usage:
+		mount -t userlandfs -p "passthroughfs <directory>" <mount point>
+*/
+
+
+#define FUSE_USE_VERSION 26
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <fuse.h>
+
+
+static char sSourceDirectory[PATH_MAX];
+
+
+static int
+source_path(char* buffer, const char* path)
+{
+	if ((size_t)snprintf(buffer, PATH_MAX, "%s%s", sSourceDirectory, path)
+			>= PATH_MAX) {
+		return -ENAMETOOLONG;
+	}
+	return 0;
+}
+
+
+#define GET_SOURCE_PATH(buffer, path)			\
+	char buffer[PATH_MAX];						\
+	{											\
+		int pathError = source_path(buffer, path);	\
+		if (pathError != 0)						\
+			return pathError;					\
+	}
+
+
+static int
+passthrough_getattr(const char* path, struct stat* st)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return lstat(sourcePath, st) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_fgetattr(const char* path, struct stat* st,
+	struct fuse_file_info* info)
+{
+	return fstat(info->fh, st) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_access(const char* path, int mode)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return access(sourcePath, mode) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_readlink(const char* path, char* buffer, size_t size)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	ssize_t length = readlink(sourcePath, buffer, size - 1);
+	if (length < 0)
+		return -errno;
+	buffer[length] = '\0';
+	return 0;
+}
+
+
+static int
+passthrough_readdir(const char* path, void* buffer, fuse_fill_dir_t filler,
+	off_t offset, struct fuse_file_info* info)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	DIR* dir = opendir(sourcePath);
+	if (dir == NULL)
+		return -errno;
+
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (filler(buffer, entry->d_name, NULL, 0) != 0)
+			break;
+	}
+
+	closedir(dir);
+	return 0;
+}
+
+
+static int
+passthrough_mkdir(const char* path, mode_t mode)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return mkdir(sourcePath, mode) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_unlink(const char* path)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return unlink(sourcePath) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_rmdir(const char* path)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return rmdir(sourcePath) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_symlink(const char* target, const char* path)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return symlink(target, sourcePath) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_rename(const char* from, const char* to)
+{
+	GET_SOURCE_PATH(sourceFrom, from);
+	GET_SOURCE_PATH(sourceTo, to);
+	return rename(sourceFrom, sourceTo) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_chmod(const char* path, mode_t mode)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return chmod(sourcePath, mode) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_truncate(const char* path, off_t size)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return truncate(sourcePath, size) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_utimens(const char* path, const struct timespec times[2])
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return utimensat(AT_FDCWD, sourcePath, times, AT_SYMLINK_NOFOLLOW) == 0
+		? 0 : -errno;
+}
+
+
+static int
+passthrough_create(const char* path, mode_t mode, struct fuse_file_info* info)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	int fd = open(sourcePath, info->flags | O_CREAT, mode);
+	if (fd < 0)
+		return -errno;
+
+	info->fh = fd;
+	return 0;
+}
+
+
+static int
+passthrough_open(const char* path, struct fuse_file_info* info)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	int fd = open(sourcePath, info->flags);
+	if (fd < 0)
+		return -errno;
+
+	info->fh = fd;
+	return 0;
+}
+
+
+static int
+passthrough_read(const char* path, char* buffer, size_t size, off_t offset,
+	struct fuse_file_info* info)
+{
+	ssize_t bytesRead = pread(info->fh, buffer, size, offset);
+	return bytesRead >= 0 ? bytesRead : -errno;
+}
+
+
+static int
+passthrough_write(const char* path, const char* buffer, size_t size,
+	off_t offset, struct fuse_file_info* info)
+{
+	ssize_t bytesWritten = pwrite(info->fh, buffer, size, offset);
+	return bytesWritten >= 0 ? bytesWritten : -errno;
+}
+
+
+static int
+passthrough_statfs(const char* path, struct statvfs* st)
+{
+	GET_SOURCE_PATH(sourcePath, path);
+	return statvfs(sourcePath, st) == 0 ? 0 : -errno;
+}
+
+
+static int
+passthrough_release(const char* path, struct fuse_file_info* info)
+{
+	close(info->fh);
+	return 0;
+}
+
+
+static int
+passthrough_fsync(const char* path, int dataOnly, struct fuse_file_info* info)
+{
+	return fsync(info->fh) == 0 ? 0 : -errno;
+}
+
+
+static struct fuse_operations sOperations = {
+	.getattr	= passthrough_getattr,
+	.fgetattr	= passthrough_fgetattr,
+	.access		= passthrough_access,
+	.readlink	= passthrough_readlink,
+	.readdir	= passthrough_readdir,
+	.mkdir		= passthrough_mkdir,
+	.unlink		= passthrough_unlink,
+	.rmdir		= passthrough_rmdir,
+	.symlink	= passthrough_symlink,
+	.rename		= passthrough_rename,
+	.chmod		= passthrough_chmod,
+	.truncate	= passthrough_truncate,
+	.utimens	= passthrough_utimens,
+	.create		= passthrough_create,
+	.open		= passthrough_open,
+	.read		= passthrough_read,
+	.write		= passthrough_write,
+	.statfs		= passthrough_statfs,
+	.release	= passthrough_release,
+	.fsync		= passthrough_fsync,
+};
+
+
+int
+main(int argc, char* argv[])
+{
+	// The first non-option argument is the directory to pass through to, the
+	// rest is for FUSE.
+	int sourceIndex = -1;
+	for (int i = 1; i < argc; i++) {
+		if (argv[i][0] != '-') {
+			sourceIndex = i;
+			break;
+		}
+		if (strcmp(argv[i], "-o") == 0)
+			i++;
+	}
+
+	if (sourceIndex < 0) {
+		fprintf(stderr, "usage: %s <directory> [options]\n", argv[0]);
+		return 1;
+	}
+
+	if (realpath(argv[sourceIndex], sSourceDirectory) == NULL) {
+		fprintf(stderr, "%s: invalid directory \"%s\": %s\n", argv[0],
+			argv[sourceIndex], strerror(errno));
+		return 1;
+	}
+	if (strcmp(sSourceDirectory, "/") == 0)
+		sSourceDirectory[0] = '\0';
+
+	for (int i = sourceIndex; i < argc - 1; i++)
+		argv[i] = argv[i + 1];
+	argc--;
+
+	return fuse_main(argc, argv, &sOperations, NULL);
+}
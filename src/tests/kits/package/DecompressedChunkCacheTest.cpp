@@ -0,0 +1,198 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Writes a compressed heap, and reads random ranges of it back through
+	heap readers and their clones, which share the decompressed chunk cache.
+	The data read has to match the data written, with the cache enabled,
+	with a cache too small for the working set, and with the cache disabled.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <DataIO.h>
+
+#include <CompressionAlgorithm.h>
+#include <ZlibCompressionAlgorithm.h>
+#include <package/hpkg/DataReader.h>
+#include <package/hpkg/DecompressedChunkCache.h>
+#include <package/hpkg/PackageFileHeapReader.h>
+#include <package/hpkg/PackageFileHeapWriter.h>
+#include <package/hpkg/StandardErrorOutput.h>
+
+#include "TestData.h"
+
+
+using namespace BPackageKit::BHPKG;
+using namespace BPackageKit::BHPKG::BPrivate;
+
+
+static const size_t kHeapSize = 4 * 1024 * 1024 + 12345;
+static const int32 kReadCount = 4000;
+
+
+class BufferDataReader : public BDataReader {
+public:
+	BufferDataReader(const uint8* data)
+		:
+		fData(data)
+	{
+	}
+
+	virtual status_t ReadData(off_t offset, void* buffer, size_t size)
+	{
+		memcpy(buffer, fData + offset, size);
+		return B_OK;
+	}
+
+private:
+	const uint8*	fData;
+};
+
+
+/*!	Reads random ranges, mostly small ones within a few hot chunks, like
+	package tools reading attributes and small files, alternating between
+	the reader and its clone.
+*/
+static bool
+read_randomly(PackageFileHeapReader* reader, PackageFileHeapReader* clone,
+	const uint8* data, uint8* buffer)
+{
+	srand(7);
+	for (int32 i = 0; i < kReadCount; i++) {
+		off_t offset;
+		size_t size;
+		if (rand() % 4 != 0) {
+			offset = (rand() % 8) * reader->ChunkSize() + rand() % 60000;
+			size = 1 + rand() % 8192;
+		} else {
+			offset = rand() % kHeapSize;
+			size = 1 + rand() % (3 * reader->ChunkSize());
+		}
+		size = std::min(size, kHeapSize - (size_t)offset);
+
+		PackageFileHeapReader* target = i % 2 == 0 ? reader : clone;
+		status_t error = target->ReadData(offset, buffer, size);
+		if (error != B_OK) {
+			fprintf(stderr, "reading %" B_PRIuSIZE " bytes at %" B_PRIdOFF
+				" failed: %s\n", size, offset, strerror(error));
+			return false;
+		}
+		if (memcmp(buffer, data + offset, size) != 0) {
+			fprintf(stderr, "data mismatch in range %" B_PRIdOFF " - %"
+				B_PRIdOFF "\n", offset, offset + (off_t)size);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static bool
+run_test(const char* name, size_t maxChunks, const uint8* data,
+	BPositionIO* file, off_t compressedSize,
+	DecompressionAlgorithmOwner* decompressionAlgorithm)
+{
+	DecompressedChunkCache* cache = DecompressedChunkCache::Default();
+	cache->SetMaxChunks(maxChunks);
+
+	uint64 oldHits;
+	uint64 oldMisses;
+	cache->GetStatistics(oldHits, oldMisses);
+
+	BStandardErrorOutput errorOutput;
+	PackageFileHeapReader reader(&errorOutput, file, 0, compressedSize,
+		kHeapSize, decompressionAlgorithm);
+	bool passed = reader.Init() == B_OK;
+
+	PackageFileHeapReader* clone = passed ? reader.Clone() : NULL;
+	uint8* buffer = (uint8*)malloc(3 * reader.ChunkSize());
+	passed = passed && clone != NULL && buffer != NULL
+		&& read_randomly(&reader, clone, data, buffer);
+
+	delete clone;
+	free(buffer);
+
+	uint64 hits;
+	uint64 misses;
+	cache->GetStatistics(hits, misses);
+	hits -= oldHits;
+	misses -= oldMisses;
+
+	// a cache large enough for the hot chunks has to serve most reads
+	if (maxChunks >= 16 && hits < misses)
+		passed = false;
+	if (maxChunks == 0 && hits != 0)
+		passed = false;
+
+	printf("%-24s %s: %" B_PRIu64 " hits, %" B_PRIu64 " misses\n", name,
+		passed ? "passed" : "FAILED", hits, misses);
+	return passed;
+}
+
+
+int
+main()
+{
+	uint8* data = (uint8*)malloc(kHeapSize);
+	if (data == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	fill_test_text(data, kHeapSize, 42);
+
+	CompressionAlgorithmOwner* compressionAlgorithm
+		= CompressionAlgorithmOwner::Create(
+			new(std::nothrow) BZlibCompressionAlgorithm,
+			new(std::nothrow) BZlibCompressionParameters(6));
+	DecompressionAlgorithmOwner* decompressionAlgorithm
+		= DecompressionAlgorithmOwner::Create(
+			new(std::nothrow) BZlibCompressionAlgorithm,
+			new(std::nothrow) BZlibDecompressionParameters);
+	if (compressionAlgorithm == NULL || decompressionAlgorithm == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	BReference<CompressionAlgorithmOwner> compressionReference(
+		compressionAlgorithm, true);
+	BReference<DecompressionAlgorithmOwner> decompressionReference(
+		decompressionAlgorithm, true);
+
+	// write the heap
+	BStandardErrorOutput errorOutput;
+	BMallocIO file;
+	PackageFileHeapWriter heapWriter(&errorOutput, &file, 0,
+		compressionAlgorithm, decompressionAlgorithm);
+	heapWriter.Init();
+
+	BufferDataReader dataReader(data);
+	uint64 heapOffset;
+	status_t error = heapWriter.AddData(dataReader, kHeapSize, heapOffset);
+	if (error == B_OK)
+		error = heapWriter.Finish();
+	if (error != B_OK) {
+		fprintf(stderr, "writing the heap failed: %s\n", strerror(error));
+		return 1;
+	}
+
+	off_t compressedSize = heapWriter.CompressedHeapSize();
+
+	int failed = 0;
+	failed += !run_test("cache enabled", 64, data, &file, compressedSize,
+		decompressionAlgorithm);
+	failed += !run_test("cache too small", 2, data, &file, compressedSize,
+		decompressionAlgorithm);
+	failed += !run_test("cache disabled", 0, data, &file, compressedSize,
+		decompressionAlgorithm);
+
+	free(data);
+	return failed == 0 ? 0 : 1;
+}
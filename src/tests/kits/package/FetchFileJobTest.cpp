@@ -0,0 +1,352 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Downloads a file from a minimal local HTTP server via DownloadFileRequest
+	and compares the result with the served data.
+
+	The server can be told not to support range requests, to delay each chunk
+	it sends -- simulating a connection whose throughput is limited by latency
+	-- and to drop connections in the middle of a response, so that both the
+	parallel range download and resuming the download are exercised.
+*/
+
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <Entry.h>
+#include <File.h>
+#include <Job.h>
+#include <OS.h>
+#include <String.h>
+
+#include <package/Context.h>
+#include <package/DownloadFileRequest.h>
+
+
+using namespace BPackageKit;
+
+
+static const size_t kFileSize = 16 * 1024 * 1024;
+static const size_t kSendChunkSize = 64 * 1024;
+
+
+struct ServerConfig {
+	bool	supportRanges;
+	bigtime_t chunkDelay;
+	size_t	dropAfter;
+		// bytes after which a connection is dropped
+	int32	dropCount;
+		// number of connections that are dropped
+};
+
+
+class TestServer {
+public:
+	TestServer(const uint8* data, size_t size)
+		:
+		fData(data),
+		fSize(size),
+		fSocket(-1),
+		fPort(0),
+		fThread(0)
+	{
+	}
+
+	~TestServer()
+	{
+		if (fSocket >= 0) {
+			shutdown(fSocket, SHUT_RDWR);
+			close(fSocket);
+			pthread_join(fThread, NULL);
+		}
+	}
+
+	bool Start()
+	{
+		fSocket = socket(AF_INET, SOCK_STREAM, 0);
+		if (fSocket < 0)
+			return false;
+
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = 0;
+		socklen_t addressLength = sizeof(address);
+		if (bind(fSocket, (sockaddr*)&address, sizeof(address)) != 0
+			|| listen(fSocket, 16) != 0
+			|| getsockname(fSocket, (sockaddr*)&address, &addressLength) != 0) {
+			return false;
+		}
+
+		fPort = ntohs(address.sin_port);
+		return pthread_create(&fThread, NULL, &_AcceptThread, this) == 0;
+	}
+
+	void SetConfig(const ServerConfig& config)
+	{
+		fConfig = config;
+		fRequestCount = 0;
+		fRangeRequestCount = 0;
+	}
+
+	BString URL() const
+	{
+		BString url;
+		url.SetToFormat("http://127.0.0.1:%u/test.hpkg", fPort);
+		return url;
+	}
+
+	int32 RequestCount() const
+	{
+		return atomic_get((int32*)&fRequestCount);
+	}
+
+	int32 RangeRequestCount() const
+	{
+		return atomic_get((int32*)&fRangeRequestCount);
+	}
+
+private:
+	struct Connection {
+		TestServer*	server;
+		int			socket;
+	};
+
+	static void* _AcceptThread(void* data)
+	{
+		TestServer* server = (TestServer*)data;
+		while (true) {
+			int socket = accept(server->fSocket, NULL, NULL);
+			if (socket < 0)
+				return NULL;
+
+			Connection* connection = new Connection;
+			connection->server = server;
+			connection->socket = socket;
+
+			pthread_t thread;
+			if (pthread_create(&thread, NULL, &_ConnectionThread, connection)
+					!= 0) {
+				close(socket);
+				delete connection;
+				continue;
+			}
+			pthread_detach(thread);
+		}
+	}
+
+	static void* _ConnectionThread(void* data)
+	{
+		Connection* connection = (Connection*)data;
+		connection->server->_HandleConnection(connection->socket);
+		close(connection->socket);
+		delete connection;
+		return NULL;
+	}
+
+	void _HandleConnection(int socket)
+	{
+		// read the request header
+		BString request;
+		char buffer[1024];
+		while (request.FindFirst("\r\n\r\n") < 0) {
+			ssize_t bytesRead = recv(socket, buffer, sizeof(buffer), 0);
+			if (bytesRead <= 0)
+				return;
+			request.Append(buffer, bytesRead);
+		}
+
+		bool head = request.StartsWith("HEAD ");
+		if (!head)
+			atomic_add(&fRequestCount, 1);
+
+		size_t start = 0;
+		size_t end = fSize - 1;
+		bool range = false;
+		int32 rangeIndex = request.IFindFirst("\r\nRange: bytes=");
+		if (rangeIndex >= 0 && fConfig.supportRanges) {
+			const char* rangeString = request.String() + rangeIndex
+				+ strlen("\r\nRange: bytes=");
+			char* rangeEnd;
+			start = strtoul(rangeString, &rangeEnd, 10);
+			if (*rangeEnd == '-' && isdigit(rangeEnd[1]))
+				end = std::min(strtoul(rangeEnd + 1, NULL, 10), fSize - 1);
+			range = true;
+			if (!head)
+				atomic_add(&fRangeRequestCount, 1);
+		}
+
+		if (start >= fSize) {
+			_Send(socket, "HTTP/1.1 416 Range Not Satisfiable\r\n"
+				"Content-Length: 0\r\nConnection: close\r\n\r\n");
+			return;
+		}
+
+		BString header;
+		header << "HTTP/1.1 " << (range ? "206 Partial Content" : "200 OK")
+			<< "\r\n";
+		header << "Content-Length: " << (uint64)(end - start + 1) << "\r\n";
+		if (range) {
+			header << "Content-Range: bytes " << (uint64)start << "-"
+				<< (uint64)end << "/" << (uint64)fSize << "\r\n";
+		}
+		if (fConfig.supportRanges)
+			header << "Accept-Ranges: bytes\r\n";
+		header << "Connection: close\r\n\r\n";
+		if (!_Send(socket, header) || head)
+			return;
+
+		bool drop = !head && atomic_add(&fConfig.dropCount, -1) > 0;
+
+		size_t sent = 0;
+		size_t toSend = end - start + 1;
+		while (sent < toSend) {
+			if (drop && sent >= fConfig.dropAfter)
+				return;
+
+			if (fConfig.chunkDelay > 0)
+				snooze(fConfig.chunkDelay);
+
+			size_t size = std::min(kSendChunkSize, toSend - sent);
+			ssize_t bytesSent = send(socket, fData + start + sent, size, 0);
+			if (bytesSent <= 0)
+				return;
+			sent += bytesSent;
+		}
+	}
+
+	bool _Send(int socket, const BString& string)
+	{
+		return send(socket, string.String(), string.Length(), 0)
+			== string.Length();
+	}
+
+private:
+	const uint8*	fData;
+	size_t			fSize;
+	int				fSocket;
+	uint16			fPort;
+	pthread_t		fThread;
+	ServerConfig	fConfig;
+	int32			fRequestCount;
+	int32			fRangeRequestCount;
+};
+
+
+static bool
+check_file(const char* path, const uint8* data, size_t size)
+{
+	BFile file(path, B_READ_ONLY);
+	off_t fileSize;
+	if (file.InitCheck() != B_OK || file.GetSize(&fileSize) != B_OK
+		|| fileSize != (off_t)size) {
+		return false;
+	}
+
+	uint8* buffer = (uint8*)malloc(size);
+	if (buffer == NULL)
+		return false;
+
+	bool equal = file.ReadAt(0, buffer, size) == (ssize_t)size
+		&& memcmp(buffer, data, size) == 0;
+	free(buffer);
+	return equal;
+}
+
+
+static bool
+run_test(TestServer& server, const char* name, const ServerConfig& config,
+	const uint8* data, size_t size, size_t existingSize = 0)
+{
+	const char* path = "/tmp/fetch_file_job_test.hpkg";
+	unlink(path);
+
+	// simulate an interrupted earlier download
+	if (existingSize > 0) {
+		BFile file(path, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+		file.WriteAt(0, data, existingSize);
+	}
+
+	server.SetConfig(config);
+
+	BDecisionProvider decisionProvider;
+	BSupportKit::BJobStateListener jobStateListener;
+	BContext context(decisionProvider, jobStateListener);
+
+	bigtime_t startTime = system_time();
+	status_t error = DownloadFileRequest(context, server.URL(),
+		BEntry(path), BString()).Process();
+	bigtime_t time = system_time() - startTime;
+
+	bool passed = error == B_OK && check_file(path, data, size);
+	printf("%-28s %s: %6.2f s, %" B_PRId32 " request(s), %" B_PRId32
+		" with range\n", name, passed ? "passed" : "FAILED",
+		time / 1000000.0, server.RequestCount(), server.RangeRequestCount());
+	if (error != B_OK)
+		printf("  error: %s\n", strerror(error));
+
+	unlink(path);
+	return passed;
+}
+
+
+int
+main()
+{
+	uint8* data = (uint8*)malloc(kFileSize);
+	if (data == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	srand(42);
+	for (size_t i = 0; i < kFileSize; i++)
+		data[i] = (uint8)rand();
+
+	TestServer server(data, kFileSize);
+	if (!server.Start()) {
+		fprintf(stderr, "Failed to start the HTTP server: %s\n",
+			strerror(errno));
+		return 1;
+	}
+
+	// 64 KiB every 10 ms is about 6 MiB/s per connection
+	const bigtime_t delay = 10000;
+
+	int failed = 0;
+	ServerConfig config = { false, delay, 0, 0 };
+	failed += !run_test(server, "no range support", config, data, kFileSize);
+
+	config.supportRanges = true;
+	failed += !run_test(server, "parallel ranges", config, data, kFileSize);
+
+	config.dropAfter = 1024 * 1024;
+	config.dropCount = 2;
+	failed += !run_test(server, "dropped connections", config, data,
+		kFileSize);
+
+	config.dropCount = 0;
+	failed += !run_test(server, "resume, parallel ranges", config, data,
+		kFileSize, 3 * 1024 * 1024);
+	failed += !run_test(server, "resume, small rest", config, data,
+		kFileSize, kFileSize - 1024 * 1024);
+
+	free(data);
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Builds pairs of packages that differ in some of their contents, writes a
+	delta between them, and checks that applying the delta to the old package
+	reconstructs the new one byte by byte. Applying a delta to a package it
+	was not made for has to fail.
+*/
+
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <File.h>
+#include <String.h>
+
+#include <package/hpkg/HPKGDefs.h>
+#include <package/hpkg/PackageDelta.h>
+#include <package/hpkg/PackageWriter.h>
+#include <package/hpkg/StandardErrorOutput.h>
+
+#include "TestData.h"
+
+
+using namespace BPackageKit::BHPKG;
+using namespace BPackageKit::BHPKG::BPrivate;
+
+
+// a multiple of the heap chunk size, so that unchanged files stay in chunks
+// of their own
+static const size_t kFileSize = 256 * 1024;
+static const int32 kFileCount = 4;
+
+static const char* const kPackageInfo =
+	"name			delta_test\n"
+	"version			%s\n"
+	"architecture	any\n"
+	"summary			\"Package delta test\"\n"
+	"description	\"A package to test package deltas with.\"\n"
+	"packager		\"PackageDeltaTest\"\n"
+	"vendor			\"Haiku Project\"\n"
+	"copyrights		\"2026 Haiku, Inc.\"\n"
+	"licenses		MIT\n"
+	"provides {\n"
+	"	delta_test=%s\n"
+	"}\n";
+
+
+class WriterListener : public BPackageWriterListener {
+public:
+	virtual void PrintErrorVarArgs(const char* format, va_list args)
+	{
+		vfprintf(stderr, format, args);
+	}
+
+	virtual void OnEntryAdded(const char* path)
+	{
+	}
+
+	virtual void OnTOCSizeInfo(uint64 uncompressedStringsSize,
+		uint64 uncompressedMainSize, uint64 uncompressedTOCSize)
+	{
+	}
+
+	virtual void OnPackageAttributesSizeInfo(uint32 stringCount,
+		uint32 uncompressedSize)
+	{
+	}
+
+	virtual void OnPackageSizeInfo(uint32 headerSize, uint64 heapSize,
+		uint64 tocSize, uint32 packageAttributesSize, uint64 totalSize)
+	{
+	}
+};
+
+
+static bool
+write_file(const char* path, const void* data, size_t size)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	bool success = fwrite(data, 1, size, file) == size;
+	return fclose(file) == 0 && success;
+}
+
+
+/*!	Creates a package from the files in \a directory, which must contain a
+	.PackageInfo file.
+*/
+static bool
+create_package(const char* directory, const char* packagePath)
+{
+	char cwd[B_PATH_NAME_LENGTH];
+	if (getcwd(cwd, sizeof(cwd)) == NULL || chdir(directory) != 0)
+		return false;
+
+	WriterListener listener;
+	BPackageWriter writer(&listener);
+	status_t error = writer.Init(packagePath);
+	writer.SetCheckLicenses(false);
+	if (error == B_OK) {
+		for (int32 i = 0; error == B_OK && i < kFileCount; i++) {
+			BString name;
+			name.SetToFormat("file%" B_PRId32, i);
+			error = writer.AddEntry(name);
+		}
+	}
+	if (error == B_OK)
+		error = writer.AddEntry(B_HPKG_PACKAGE_INFO_FILE_NAME);
+	if (error == B_OK)
+		error = writer.Finish();
+
+	if (chdir(cwd) != 0)
+		return false;
+	if (error != B_OK) {
+		fprintf(stderr, "Failed to create package %s: %s\n", packagePath,
+			strerror(error));
+	}
+	return error == B_OK;
+}
+
+
+/*!	Writes the package contents to \a directory: kFileCount files, with the
+	data of \a changedFile (if any) replaced, and the given version.
+*/
+static bool
+write_contents(const char* directory, const char* version, int32 changedFile)
+{
+	uint8* data = (uint8*)malloc(kFileSize);
+	if (data == NULL)
+		return false;
+
+	bool success = true;
+	for (int32 i = 0; success && i < kFileCount; i++) {
+		fill_test_text(data, kFileSize, i == changedFile ? 100 + i : i);
+
+		BString path;
+		path.SetToFormat("%s/file%" B_PRId32, directory, i);
+		success = write_file(path, data, kFileSize);
+	}
+	free(data);
+
+	BString packageInfo;
+	packageInfo.SetToFormat(kPackageInfo, version, version);
+	BString path;
+	path.SetToFormat("%s/%s", directory, B_HPKG_PACKAGE_INFO_FILE_NAME);
+	return success
+		&& write_file(path, packageInfo.String(), packageInfo.Length());
+}
+
+
+static bool
+compare_files(const char* path1, const char* path2)
+{
+	BFile file1(path1, B_READ_ONLY);
+	BFile file2(path2, B_READ_ONLY);
+	off_t size1;
+	off_t size2;
+	if (file1.GetSize(&size1) != B_OK || file2.GetSize(&size2) != B_OK
+		|| size1 != size2) {
+		return false;
+	}
+
+	uint8 buffer1[4096];
+	uint8 buffer2[4096];
+	for (off_t offset = 0; offset < size1; offset += sizeof(buffer1)) {
+		size_t size = std::min((off_t)sizeof(buffer1), size1 - offset);
+		if (file1.ReadAtExactly(offset, buffer1, size) != B_OK
+			|| file2.ReadAtExactly(offset, buffer2, size) != B_OK
+			|| memcmp(buffer1, buffer2, size) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static status_t
+apply_delta(const char* oldPackagePath, const char* deltaPath,
+	const char* resultPath)
+{
+	BStandardErrorOutput errorOutput;
+	BFile oldPackage(oldPackagePath, B_READ_ONLY);
+	BFile delta(deltaPath, B_READ_ONLY);
+	BFile result(resultPath, B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE);
+
+	PackageDeltaReader reader(&errorOutput);
+	status_t error = reader.Init(&delta);
+	if (error == B_OK)
+		error = reader.Apply(&oldPackage, &result);
+	return error;
+}
+
+
+static bool
+run_test(const char* directory, const char* name, const char* newVersion,
+	int32 changedFile)
+{
+	BString contents(directory);
+	contents << "/contents";
+	BString oldPackagePath(directory);
+	oldPackagePath << "/old.hpkg";
+	BString newPackagePath(directory);
+	newPackagePath << "/new.hpkg";
+	BString deltaPath(directory);
+	deltaPath << "/delta";
+	BString resultPath(directory);
+	resultPath << "/result.hpkg";
+
+	if (mkdir(contents, 0755) != 0 && errno != EEXIST)
+		return false;
+
+	bool passed = write_contents(contents, "1.0-1", -1)
+		&& create_package(contents, oldPackagePath)
+		&& write_contents(contents, newVersion, changedFile)
+		&& create_package(contents, newPackagePath);
+
+	// write the delta
+	BStandardErrorOutput errorOutput;
+	PackageDeltaWriter writer(&errorOutput);
+	status_t error = B_ERROR;
+	if (passed) {
+		BFile oldPackage(oldPackagePath, B_READ_ONLY);
+		BFile newPackage(newPackagePath, B_READ_ONLY);
+		BFile delta(deltaPath, B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE);
+		error = writer.WriteDelta(&oldPackage, &newPackage, &delta);
+	}
+
+	// reconstruct the new package
+	if (error == B_OK)
+		error = apply_delta(oldPackagePath, deltaPath, resultPath);
+
+	passed = passed && error == B_OK
+		&& compare_files(newPackagePath, resultPath)
+		&& writer.CopiedSize() > 0;
+
+	// the delta must not apply to the new package
+	if (passed && apply_delta(newPackagePath, deltaPath, resultPath) == B_OK)
+		passed = false;
+
+	printf("%-28s %s: %" B_PRIu64 " bytes copied, %" B_PRIu64 " bytes of "
+		"data\n", name, passed ? "passed" : "FAILED", writer.CopiedSize(),
+		writer.DataSize());
+	if (error != B_OK)
+		printf("  error: %s\n", strerror(error));
+
+	unlink(oldPackagePath);
+	unlink(newPackagePath);
+	unlink(deltaPath);
+	unlink(resultPath);
+	return passed;
+}
+
+
+int
+main()
+{
+	char directory[] = "/tmp/package_delta_test.XXXXXX";
+	if (mkdtemp(directory) == NULL) {
+		fprintf(stderr, "Failed to create a temporary directory: %s\n",
+			strerror(errno));
+		return 1;
+	}
+
+	int failed = 0;
+	failed += !run_test(directory, "version change only", "1.0-2", -1);
+	failed += !run_test(directory, "first file changed", "1.1-1", 0);
+	failed += !run_test(directory, "middle file changed", "1.1-1", 2);
+
+	BString contents(directory);
+	contents << "/contents";
+	for (int32 i = 0; i < kFileCount; i++) {
+		BString path;
+		path.SetToFormat("%s/file%" B_PRId32, contents.String(), i);
+		unlink(path);
+	}
+	BString path;
+	path.SetToFormat("%s/%s", contents.String(), B_HPKG_PACKAGE_INFO_FILE_NAME);
+	unlink(path);
+	rmdir(contents);
+	rmdir(directory);
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the throughput of PackageFileHeapWriter for different numbers of
+	compression threads and compression levels.
+
+	The heap is filled with synthetic data that compresses roughly like the
+	contents of a typical development package (a mix of text and binary
+	data). Every written heap is read back and compared with the input.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <DataIO.h>
+#include <OS.h>
+
+#include <CompressionAlgorithm.h>
+#include <ZlibCompressionAlgorithm.h>
+#include <ZstdCompressionAlgorithm.h>
+#include <package/hpkg/DataReader.h>
+#include <package/hpkg/PackageFileHeapWriter.h>
+#include <package/hpkg/StandardErrorOutput.h>
+
+#include "TestData.h"
+
+
+using namespace BPackageKit::BHPKG;
+using namespace BPackageKit::BHPKG::BPrivate;
+
+
+static const size_t kPatternSize = 1024 * 1024;
+
+class PatternDataReader : public BDataReader {
+public:
+	PatternDataReader(const uint8* pattern, off_t baseOffset = 0)
+		:
+		fPattern(pattern),
+		fBaseOffset(baseOffset)
+	{
+	}
+
+	virtual status_t ReadData(off_t offset, void* buffer, size_t size)
+	{
+		offset += fBaseOffset;
+		uint8* target = (uint8*)buffer;
+		while (size > 0) {
+			size_t patternOffset = offset % kPatternSize;
+			size_t toCopy = std::min(size, kPatternSize - patternOffset);
+			memcpy(target, fPattern + patternOffset, toCopy);
+			target += toCopy;
+			offset += toCopy;
+			size -= toCopy;
+		}
+		return B_OK;
+	}
+
+private:
+	const uint8*	fPattern;
+	off_t			fBaseOffset;
+};
+
+
+static CompressionAlgorithmOwner*
+create_compression_algorithm(const char* name, int32 level)
+{
+	if (strcmp(name, "zlib") == 0) {
+		return CompressionAlgorithmOwner::Create(
+			new(std::nothrow) BZlibCompressionAlgorithm,
+			new(std::nothrow) BZlibCompressionParameters(level));
+	}
+	if (strcmp(name, "zstd") == 0) {
+		return CompressionAlgorithmOwner::Create(
+			new(std::nothrow) BZstdCompressionAlgorithm,
+			new(std::nothrow) BZstdCompressionParameters(level));
+	}
+	return NULL;
+}
+
+
+static DecompressionAlgorithmOwner*
+create_decompression_algorithm(const char* name)
+{
+	if (strcmp(name, "zlib") == 0) {
+		return DecompressionAlgorithmOwner::Create(
+			new(std::nothrow) BZlibCompressionAlgorithm,
+			new(std::nothrow) BZlibDecompressionParameters);
+	}
+	if (strcmp(name, "zstd") == 0) {
+		return DecompressionAlgorithmOwner::Create(
+			new(std::nothrow) BZstdCompressionAlgorithm,
+			new(std::nothrow) BZstdDecompressionParameters);
+	}
+	return NULL;
+}
+
+
+static status_t
+verify_heap(PackageFileHeapWriter& heapWriter, const uint8* pattern,
+	off_t heapSize)
+{
+	PatternDataReader patternReader(pattern);
+	size_t bufferSize = 256 * 1024;
+	uint8* buffer = (uint8*)malloc(bufferSize);
+	uint8* expected = (uint8*)malloc(bufferSize);
+	status_t error = buffer != NULL && expected != NULL ? B_OK : B_NO_MEMORY;
+
+	for (off_t offset = 0; error == B_OK && offset < heapSize;
+			offset += bufferSize) {
+		size_t toRead = std::min((off_t)bufferSize, heapSize - offset);
+		error = heapWriter.ReadData(offset, buffer, toRead);
+		if (error == B_OK)
+			error = patternReader.ReadData(offset, expected, toRead);
+		if (error == B_OK && memcmp(buffer, expected, toRead) != 0) {
+			fprintf(stderr, "data mismatch in range %" B_PRIdOFF " - %"
+				B_PRIdOFF "\n", offset, offset + (off_t)toRead);
+			error = B_BAD_DATA;
+		}
+	}
+
+	free(buffer);
+	free(expected);
+	return error;
+}
+
+
+static status_t
+run(const char* algorithm, int32 level, int32 threads, const uint8* pattern,
+	off_t heapSize)
+{
+	CompressionAlgorithmOwner* compressionAlgorithm
+		= create_compression_algorithm(algorithm, level);
+	DecompressionAlgorithmOwner* decompressionAlgorithm
+		= create_decompression_algorithm(algorithm);
+	if (compressionAlgorithm == NULL || decompressionAlgorithm == NULL)
+		return B_NO_MEMORY;
+	BReference<CompressionAlgorithmOwner> compressionReference(
+		compressionAlgorithm, true);
+	BReference<DecompressionAlgorithmOwner> decompressionReference(
+		decompressionAlgorithm, true);
+
+	BStandardErrorOutput errorOutput;
+	BMallocIO file;
+	PackageFileHeapWriter heapWriter(&errorOutput, &file, 0,
+		compressionAlgorithm, decompressionAlgorithm);
+	heapWriter.Init(threads);
+
+	bigtime_t startTime = system_time();
+
+	// add the data in pieces of varying size, as for files in a package
+	off_t offset = 0;
+	while (offset < heapSize) {
+		off_t size = std::min(heapSize - offset,
+			off_t(1 + (offset * 7919) % (3 * 1024 * 1024)));
+		PatternDataReader patternReader(pattern, offset);
+		uint64 heapOffset;
+		status_t error = heapWriter.AddData(patternReader, size, heapOffset);
+		if (error != B_OK)
+			return error;
+		offset += size;
+	}
+
+	status_t error = heapWriter.Finish();
+	if (error != B_OK)
+		return error;
+
+	bigtime_t time = system_time() - startTime;
+
+	printf("%-6s %6" B_PRId32 " %8" B_PRId32 " %10.1f %8.1f%%\n", algorithm,
+		level, threads, heapSize / 1048576.0 / (time / 1000000.0),
+		heapWriter.CompressedHeapSize() * 100.0 / heapSize);
+
+	return verify_heap(heapWriter, pattern, heapSize);
+}
+
+
+int
+main(int argc, const char* const* argv)
+{
+	if (argc < 2 || argc > 5) {
+		fprintf(stderr, "usage: %s <zlib|zstd> [<size in MB> [<levels> "
+			"[<thread counts>]]]\n"
+			"  e.g. %s zstd 512 1,9,19 1,2,4,8,16\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	const char* algorithm = argv[1];
+	off_t heapSize = (argc > 2 ? atoll(argv[2]) : 256) * 1024 * 1024;
+	const char* levels = argc > 3 ? argv[3]
+		: strcmp(algorithm, "zlib") == 0 ? "1,6,9" : "1,9,19";
+	const char* threadCounts = argc > 4 ? argv[4] : "1,2,4,8,16";
+
+	uint8* pattern = (uint8*)malloc(kPatternSize);
+	if (pattern == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	fill_test_mixed(pattern, kPatternSize, 42);
+
+	printf("algo    level  threads       MB/s    ratio\n");
+
+	for (const char* level = levels; level != NULL;) {
+		for (const char* threads = threadCounts; threads != NULL;) {
+			status_t error = run(algorithm, atoi(level), atoi(threads),
+				pattern, heapSize);
+			if (error != B_OK) {
+				fprintf(stderr, "%s level %d with %d threads failed: %s\n",
+					algorithm, atoi(level), atoi(threads), strerror(error));
+				return 1;
+			}
+
+			threads = strchr(threads, ',');
+			if (threads != NULL)
+				threads++;
+		}
+
+		level = strchr(level, ',');
+		if (level != NULL)
+			level++;
+	}
+
+	free(pattern);
+	return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PACKAGE_TEST_DATA_H
+#define PACKAGE_TEST_DATA_H
+
+
+//!	Synthetic package contents for the package kit tests and benchmarks.
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <SupportDefs.h>
+
+
+static const char* const kTestDataWords[] = {
+	"package", "attribute", "directory", "library", "version", "#include",
+	"status_t", "return", "error", "const", "struct", "static", "void", "int32",
+	"B_OK", "compression", "heap", "chunk", "offset", "size", "buffer", "\n",
+	"\t", " = ", "();", "{\n", "}\n", "if (", "for (", "else"
+};
+static const size_t kTestDataWordCount
+	= sizeof(kTestDataWords) / sizeof(kTestDataWords[0]);
+
+
+//!	Fills \a data from \a offset up to \a end with random words.
+static inline void
+fill_test_words(uint8* data, size_t offset, size_t end)
+{
+	while (offset < end) {
+		const char* word = kTestDataWords[rand() % kTestDataWordCount];
+		size_t length = std::min(strlen(word), end - offset);
+		memcpy(data + offset, word, length);
+		offset += length;
+	}
+}
+
+
+//!	Fills \a data with text that compresses about as well as source code.
+static inline void
+fill_test_text(uint8* data, size_t size, unsigned seed)
+{
+	srand(seed);
+	fill_test_words(data, 0, size);
+}
+
+
+/*!	Fills \a data with alternating text-like and binary-like blocks, which
+	compress roughly like the contents of a typical development package.
+*/
+static inline void
+fill_test_mixed(uint8* data, size_t size, unsigned seed)
+{
+	srand(seed);
+
+	size_t offset = 0;
+	while (offset < size) {
+		size_t blockEnd = offset
+			+ std::min(size - offset, size_t(4096 + rand() % 16384));
+
+		if (rand() % 3 == 0) {
+			while (offset < blockEnd) {
+				// mostly small values, as in machine code and tables
+				int value = rand();
+				data[offset++] = value % 4 == 0 ? value >> 8 : value % 16;
+			}
+		} else {
+			fill_test_words(data, offset, blockEnd);
+			offset = blockEnd;
+		}
+	}
+}
+
+
+#endif	// PACKAGE_TEST_DATA_H
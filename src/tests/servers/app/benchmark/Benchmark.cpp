@@ -15,7 +15,9 @@
 #include "TestWindow.h"
 
 // tests
+#include "DrawingModeTest.h"
 #include "HorizontalLineTest.h"
+#include "LargeFillTest.h"
 #include "RandomLineTest.h"
 #include "StringTest.h"
 #include "VerticalLineTest.h"
@@ -27,7 +29,9 @@ struct test_info {
 };
 
 const test_info kTestInfos[] = {
+	{ "DrawingModes",		DrawingModeTest::CreateTest },
 	{ "HorizontalLines",	HorizontalLineTest::CreateTest },
+	{ "LargeFills",			LargeFillTest::CreateTest },
 	{ "RandomLines",		RandomLineTest::CreateTest },
 	{ "Strings",			StringTest::CreateTest },
 	{ "VerticalLines",		VerticalLineTest::CreateTest },
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "DrawingModeTest.h"
+
+#include <stdio.h>
+
+#include <Bitmap.h>
+#include <GradientLinear.h>
+#include <View.h>
+
+
+static const char* const kOperationNames[] = {
+	"B_OP_COPY",
+	"B_OP_OVER",
+	"B_OP_OVER, gradient",
+	"B_OP_ALPHA, overlay",
+	"B_OP_ALPHA, composite",
+	"B_OP_ALPHA, pixel alpha"
+};
+
+
+DrawingModeTest::DrawingModeTest()
+	: Test(),
+	  fOffscreenBitmap(NULL),
+	  fOffscreenView(NULL),
+	  fAlphaBitmap(NULL),
+	  fBounds(0, 0, 3839, 2159),
+
+	  fIterations(0),
+	  fMaxIterations(50)
+{
+	for (int32 i = 0; i < kOperationCount; i++)
+		fDurations[i] = 0;
+}
+
+
+DrawingModeTest::~DrawingModeTest()
+{
+	delete fOffscreenBitmap;
+	delete fAlphaBitmap;
+}
+
+
+void
+DrawingModeTest::Prepare(BView* view)
+{
+	fOffscreenBitmap = new BBitmap(fBounds, B_RGB32, true);
+	fOffscreenView = new BView(fBounds, "offscreen", B_FOLLOW_NONE,
+		B_WILL_DRAW);
+	fOffscreenBitmap->AddChild(fOffscreenView);
+
+	// the composite alpha function is fastest on an opaque background
+	if (fOffscreenBitmap->Lock()) {
+		fOffscreenView->SetHighColor(255, 255, 255);
+		fOffscreenView->FillRect(fBounds);
+		fOffscreenView->Sync();
+		fOffscreenBitmap->Unlock();
+	}
+
+	// a mix of transparent, translucent and opaque pixels
+	fAlphaBitmap = new BBitmap(fBounds, B_RGBA32);
+	uint8* bits = (uint8*)fAlphaBitmap->Bits();
+	int32 bytesPerRow = fAlphaBitmap->BytesPerRow();
+	for (int32 y = 0; y <= fBounds.IntegerHeight(); y++) {
+		uint8* row = bits + y * bytesPerRow;
+		for (int32 x = 0; x <= fBounds.IntegerWidth(); x++) {
+			row[0] = x;
+			row[1] = y;
+			row[2] = x + y;
+			row[3] = (x / 64) % 3 == 0 ? 255 : x ^ y;
+			row += 4;
+		}
+	}
+
+	for (int32 i = 0; i < kOperationCount; i++)
+		fDurations[i] = 0;
+	fIterations = 0;
+}
+
+
+bool
+DrawingModeTest::RunIteration(BView* view)
+{
+	if (!fOffscreenBitmap->Lock())
+		return false;
+
+	for (int32 i = 0; i < kOperationCount; i++) {
+		bigtime_t now = system_time();
+		_RunOperation(i);
+		fOffscreenView->Sync();
+		fDurations[i] += system_time() - now;
+	}
+
+	fOffscreenBitmap->Unlock();
+
+	// show some progress
+	view->DrawBitmap(fOffscreenBitmap, fBounds, view->Bounds());
+	view->Sync();
+
+	fIterations++;
+	return fIterations < fMaxIterations;
+}
+
+
+void
+DrawingModeTest::PrintResults(BView* view)
+{
+	if (fIterations == 0) {
+		printf("Test was not run.\n");
+		return;
+	}
+
+	printf("Offscreen size: %ldx%ld\n", fBounds.IntegerWidth() + 1,
+		fBounds.IntegerHeight() + 1);
+	printf("Iterations: %lu\n", fIterations);
+
+	double pixels = (fBounds.IntegerWidth() + 1.0)
+		* (fBounds.IntegerHeight() + 1.0);
+	for (int32 i = 0; i < kOperationCount; i++) {
+		// the fills are ellipses, which cover about pi / 4 of the bounds
+		double operationPixels = i == kAlphaPixelBitmap
+			? pixels : pixels * 0.785;
+		double seconds = fDurations[i] / 1000000.0 / fIterations;
+		printf("%-24s %8.3f ms  %8.1f Mpixels/s\n", kOperationNames[i],
+			seconds * 1000, operationPixels / seconds / 1000000);
+	}
+}
+
+
+void
+DrawingModeTest::_RunOperation(int32 operation)
+{
+	BView* view = fOffscreenView;
+	view->SetHighColor(fIterations & 0xff, 128, 64);
+
+	switch (operation) {
+		case kCopy:
+			view->SetDrawingMode(B_OP_COPY);
+			view->FillEllipse(fBounds);
+			break;
+
+		case kOver:
+			view->SetDrawingMode(B_OP_OVER);
+			view->FillEllipse(fBounds);
+			break;
+
+		case kOverGradient:
+		{
+			BGradientLinear gradient(fBounds.LeftTop(), fBounds.RightBottom());
+			gradient.AddColor(make_color(255, 0, 0, 255), 0);
+			gradient.AddColor(make_color(0, 0, 255, 0), 255);
+			view->SetDrawingMode(B_OP_OVER);
+			view->FillEllipse(fBounds, gradient);
+			break;
+		}
+
+		case kAlphaConstantOverlay:
+			view->SetHighColor(0, 255, 0, 128);
+			view->SetDrawingMode(B_OP_ALPHA);
+			view->SetBlendingMode(B_CONSTANT_ALPHA, B_ALPHA_OVERLAY);
+			view->FillEllipse(fBounds);
+			break;
+
+		case kAlphaConstantComposite:
+			view->SetHighColor(0, 0, 255, 128);
+			view->SetDrawingMode(B_OP_ALPHA);
+			view->SetBlendingMode(B_CONSTANT_ALPHA, B_ALPHA_COMPOSITE);
+			view->FillEllipse(fBounds);
+			break;
+
+		case kAlphaPixelBitmap:
+			view->SetDrawingMode(B_OP_ALPHA);
+			view->SetBlendingMode(B_PIXEL_ALPHA, B_ALPHA_OVERLAY);
+			view->DrawBitmap(fAlphaBitmap, B_ORIGIN);
+			break;
+	}
+}
+
+
+Test*
+DrawingModeTest::CreateTest()
+{
+	return new DrawingModeTest();
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef DRAWING_MODE_TEST_H
+#define DRAWING_MODE_TEST_H
+
+#include <Rect.h>
+
+#include "Test.h"
+
+class BBitmap;
+
+// Measures antialiased fills and alpha blended bitmaps in each of the
+// drawing modes that have optimized span blenders in the app_server. Like
+// LargeFillTest, it draws into a 3840x2160 offscreen bitmap.
+class DrawingModeTest : public Test {
+public:
+								DrawingModeTest();
+	virtual						~DrawingModeTest();
+
+	virtual	void				Prepare(BView* view);
+	virtual	bool				RunIteration(BView* view);
+	virtual	void				PrintResults(BView* view);
+
+	static	Test*				CreateTest();
+
+private:
+			enum {
+				kCopy = 0,
+				kOver,
+				kOverGradient,
+				kAlphaConstantOverlay,
+				kAlphaConstantComposite,
+				kAlphaPixelBitmap,
+				kOperationCount
+			};
+
+			void				_RunOperation(int32 operation);
+
+private:
+			BBitmap*			fOffscreenBitmap;
+			BView*				fOffscreenView;
+			BBitmap*			fAlphaBitmap;
+			BRect				fBounds;
+
+			bigtime_t			fDurations[kOperationCount];
+			uint32				fIterations;
+			uint32				fMaxIterations;
+};
+
+#endif // DRAWING_MODE_TEST_H
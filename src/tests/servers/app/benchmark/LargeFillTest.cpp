@@ -0,0 +1,160 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "LargeFillTest.h"
+
+#include <stdio.h>
+
+#include <Bitmap.h>
+#include <GradientLinear.h>
+#include <View.h>
+
+
+static const char* const kOperationNames[] = {
+	"Solid fill",
+	"Vertical gradient fill",
+	"Alpha fill",
+	"Nearest neighbor scale",
+	"Bilinear scale"
+};
+
+
+LargeFillTest::LargeFillTest()
+	: Test(),
+	  fOffscreenBitmap(NULL),
+	  fOffscreenView(NULL),
+	  fSourceBitmap(NULL),
+	  fBounds(0, 0, 3839, 2159),
+
+	  fIterations(0),
+	  fMaxIterations(50)
+{
+	for (int32 i = 0; i < kOperationCount; i++)
+		fDurations[i] = 0;
+}
+
+
+LargeFillTest::~LargeFillTest()
+{
+	delete fOffscreenBitmap;
+	delete fSourceBitmap;
+}
+
+
+void
+LargeFillTest::Prepare(BView* view)
+{
+	fOffscreenBitmap = new BBitmap(fBounds, B_RGB32, true);
+	fOffscreenView = new BView(fBounds, "offscreen", B_FOLLOW_NONE,
+		B_WILL_DRAW);
+	fOffscreenBitmap->AddChild(fOffscreenView);
+
+	// a 720p source, so scaling it to the full bitmap is a 3x scale
+	fSourceBitmap = new BBitmap(BRect(0, 0, 1279, 719), B_RGB32);
+	uint8* bits = (uint8*)fSourceBitmap->Bits();
+	int32 bytesPerRow = fSourceBitmap->BytesPerRow();
+	for (int32 y = 0; y < 720; y++) {
+		uint32* row = (uint32*)(bits + y * bytesPerRow);
+		for (int32 x = 0; x < 1280; x++)
+			row[x] = 0xff000000 | ((x * 0x10203) ^ (y * 0x30201));
+	}
+
+	for (int32 i = 0; i < kOperationCount; i++)
+		fDurations[i] = 0;
+	fIterations = 0;
+}
+
+
+bool
+LargeFillTest::RunIteration(BView* view)
+{
+	if (!fOffscreenBitmap->Lock())
+		return false;
+
+	for (int32 i = 0; i < kOperationCount; i++) {
+		bigtime_t now = system_time();
+		_RunOperation(i);
+		fOffscreenView->Sync();
+		fDurations[i] += system_time() - now;
+	}
+
+	fOffscreenBitmap->Unlock();
+
+	// show some progress
+	view->DrawBitmap(fOffscreenBitmap, fBounds, view->Bounds());
+	view->Sync();
+
+	fIterations++;
+	return fIterations < fMaxIterations;
+}
+
+
+void
+LargeFillTest::PrintResults(BView* view)
+{
+	if (fIterations == 0) {
+		printf("Test was not run.\n");
+		return;
+	}
+
+	printf("Offscreen size: %ldx%ld\n", fBounds.IntegerWidth() + 1,
+		fBounds.IntegerHeight() + 1);
+	printf("Iterations: %lu\n", fIterations);
+
+	double pixels = (fBounds.IntegerWidth() + 1.0)
+		* (fBounds.IntegerHeight() + 1.0);
+	for (int32 i = 0; i < kOperationCount; i++) {
+		double seconds = fDurations[i] / 1000000.0 / fIterations;
+		printf("%-24s %8.3f ms  %8.1f Mpixels/s\n", kOperationNames[i],
+			seconds * 1000, pixels / seconds / 1000000);
+	}
+}
+
+
+void
+LargeFillTest::_RunOperation(int32 operation)
+{
+	BView* view = fOffscreenView;
+	view->SetDrawingMode(B_OP_COPY);
+
+	switch (operation) {
+		case kSolidFill:
+			view->SetHighColor(fIterations & 0xff, 128, 64);
+			view->FillRect(fBounds);
+			break;
+
+		case kGradientFill:
+		{
+			BGradientLinear gradient(fBounds.LeftTop(), fBounds.LeftBottom());
+			gradient.AddColor(make_color(255, 0, 0), 0);
+			gradient.AddColor(make_color(0, 0, 255), 255);
+			view->FillRect(fBounds, gradient);
+			break;
+		}
+
+		case kAlphaFill:
+			view->SetDrawingMode(B_OP_ALPHA);
+			view->SetBlendingMode(B_CONSTANT_ALPHA, B_ALPHA_OVERLAY);
+			view->SetHighColor(0, 255, 0, 128);
+			view->FillRect(fBounds);
+			break;
+
+		case kNearestNeighborScale:
+			view->DrawBitmap(fSourceBitmap, fSourceBitmap->Bounds(), fBounds);
+			break;
+
+		case kBilinearScale:
+			view->DrawBitmap(fSourceBitmap, fSourceBitmap->Bounds(), fBounds,
+				B_FILTER_BITMAP_BILINEAR);
+			break;
+	}
+}
+
+
+Test*
+LargeFillTest::CreateTest()
+{
+	return new LargeFillTest();
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef LARGE_FILL_TEST_H
+#define LARGE_FILL_TEST_H
+
+#include <Rect.h>
+
+#include "Test.h"
+
+class BBitmap;
+
+// Measures full frame fills and bitmap scales at 3840x2160. The drawing
+// happens in an offscreen bitmap, since the test window is much smaller.
+class LargeFillTest : public Test {
+public:
+								LargeFillTest();
+	virtual						~LargeFillTest();
+
+	virtual	void				Prepare(BView* view);
+	virtual	bool				RunIteration(BView* view);
+	virtual	void				PrintResults(BView* view);
+
+	static	Test*				CreateTest();
+
+private:
+			enum {
+				kSolidFill = 0,
+				kGradientFill,
+				kAlphaFill,
+				kNearestNeighborScale,
+				kBilinearScale,
+				kOperationCount
+			};
+
+			void				_RunOperation(int32 operation);
+
+private:
+			BBitmap*			fOffscreenBitmap;
+			BView*				fOffscreenView;
+			BBitmap*			fSourceBitmap;
+			BRect				fBounds;
+
+			bigtime_t			fDurations[kOperationCount];
+			uint32				fIterations;
+			uint32				fMaxIterations;
+};
+
+#endif // LARGE_FILL_TEST_H
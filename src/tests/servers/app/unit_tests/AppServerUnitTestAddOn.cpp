@@ -7,6 +7,7 @@
 #include <TestSuiteAddon.h>
 
 #include "SimpleTransformTest.h"
+#include "SpanKernelsTest.h"
 
 
 BTestSuite*
@@ -15,6 +16,7 @@ getTestSuite()
 	BTestSuite* suite = new BTestSuite("AppServerUnitTests");
 
 	SimpleTransformTest::AddTests(*suite);
+	SpanKernelsTest::AddTests(*suite);
 
 	return suite;
 }
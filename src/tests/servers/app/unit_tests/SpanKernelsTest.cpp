@@ -0,0 +1,366 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "SpanKernelsTest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+
+
+/*!	The SIMD versions of the span kernels are run on random data, and have
+	to produce exactly the same pixels as the scalar versions. Spans of all
+	lengths up to a few times the vector size are tried, so that the loop
+	tails are covered, too.
+*/
+
+
+static const int32 kIterations = 2000;
+static const int32 kMaxPixels = 70;
+static const int32 kSourceWidth = 64;
+
+
+static uint8
+random_byte()
+{
+	return rand() & 0xff;
+}
+
+
+//!	Covers are mostly 0 or 255, as they are for antialiased shapes.
+static uint8
+random_cover()
+{
+	switch (rand() % 4) {
+		case 0:
+			return 0;
+		case 1:
+			return 255;
+		default:
+			return random_byte();
+	}
+}
+
+
+static void
+fill_random(uint8* buffer, int32 size)
+{
+	for (int32 i = 0; i < size; i++)
+		buffer[i] = random_byte();
+}
+
+
+//!	Makes most of the pixels opaque, if \a opaque is true all of them.
+static void
+fill_random_pixels(uint8* pixels, int32 count, bool opaque)
+{
+	fill_random(pixels, count * 4);
+	for (int32 i = 0; i < count; i++) {
+		if (opaque || rand() % 4 != 0)
+			pixels[i * 4 + 3] = 255;
+	}
+}
+
+
+static void
+fill_random_covers(uint8* covers, int32 count)
+{
+	for (int32 i = 0; i < count; i++)
+		covers[i] = random_cover();
+}
+
+
+void
+SpanKernelsTest::BlendSolidSpan()
+{
+#ifdef __x86_64__
+	_TestBlendSolidSpan(gSSE2SpanKernels);
+	if (__builtin_cpu_supports("avx2"))
+		_TestBlendSolidSpan(gAVX2SpanKernels);
+#endif
+}
+
+
+void
+SpanKernelsTest::BlendColorSpan()
+{
+#ifdef __x86_64__
+	_TestBlendColorSpan(gSSE2SpanKernels, false);
+	if (__builtin_cpu_supports("avx2"))
+		_TestBlendColorSpan(gAVX2SpanKernels, false);
+#endif
+}
+
+
+void
+SpanKernelsTest::BlendColorSpanOver()
+{
+#ifdef __x86_64__
+	_TestBlendColorSpan(gSSE2SpanKernels, true);
+	if (__builtin_cpu_supports("avx2"))
+		_TestBlendColorSpan(gAVX2SpanKernels, true);
+#endif
+}
+
+
+void
+SpanKernelsTest::BlendSolidSpanAlphaCO()
+{
+#ifdef __x86_64__
+	_TestBlendSolidSpanAlpha(gSSE2SpanKernels, false);
+	if (__builtin_cpu_supports("avx2"))
+		_TestBlendSolidSpanAlpha(gAVX2SpanKernels, false);
+#endif
+}
+
+
+void
+SpanKernelsTest::BlendSolidSpanAlphaCC()
+{
+#ifdef __x86_64__
+	_TestBlendSolidSpanAlpha(gSSE2SpanKernels, true);
+	if (__builtin_cpu_supports("avx2"))
+		_TestBlendSolidSpanAlpha(gAVX2SpanKernels, true);
+#endif
+}
+
+
+void
+SpanKernelsTest::BlendRowAlpha()
+{
+#ifdef __x86_64__
+	_TestBlendRowAlpha(gSSE2SpanKernels);
+	if (__builtin_cpu_supports("avx2"))
+		_TestBlendRowAlpha(gAVX2SpanKernels);
+#endif
+}
+
+
+void
+SpanKernelsTest::ScaleRowNearest()
+{
+#ifdef __x86_64__
+	_TestScaleRowNearest(gSSE2SpanKernels);
+	if (__builtin_cpu_supports("avx2"))
+		_TestScaleRowNearest(gAVX2SpanKernels);
+#endif
+}
+
+
+void
+SpanKernelsTest::ScaleRowBilinear()
+{
+#ifdef __x86_64__
+	_TestScaleRowBilinear(gSSE2SpanKernels);
+	if (__builtin_cpu_supports("avx2"))
+		_TestScaleRowBilinear(gAVX2SpanKernels);
+#endif
+}
+
+
+void
+SpanKernelsTest::_TestBlendSolidSpan(const SpanKernels& kernels)
+{
+	uint8 expected[kMaxPixels * 4];
+	uint8 result[kMaxPixels * 4];
+	uint8 covers[kMaxPixels];
+
+	srand(1);
+	for (int32 i = 0; i < kIterations; i++) {
+		int32 count = i % kMaxPixels;
+		uint32 color = span_color(random_byte(), random_byte(), random_byte());
+		fill_random_pixels(expected, count, false);
+		memcpy(result, expected, count * 4);
+		fill_random_covers(covers, count);
+
+		gScalarSpanKernels.blendSolidSpan(expected, count, color, covers);
+		kernels.blendSolidSpan(result, count, color, covers);
+		CPPUNIT_ASSERT(memcmp(expected, result, count * 4) == 0);
+	}
+}
+
+
+void
+SpanKernelsTest::_TestBlendColorSpan(const SpanKernels& kernels, bool over)
+{
+	uint8 expected[kMaxPixels * 4];
+	uint8 result[kMaxPixels * 4];
+	uint8 colors[kMaxPixels * 4];
+	uint8 covers[kMaxPixels];
+
+	srand(2);
+	for (int32 i = 0; i < kIterations; i++) {
+		int32 count = i % kMaxPixels;
+		fill_random_pixels(expected, count, false);
+		memcpy(result, expected, count * 4);
+		fill_random(colors, count * 4);
+		for (int32 j = 0; j < count; j++) {
+			if (rand() % 4 == 0)
+				colors[j * 4 + 3] = 0;
+		}
+		fill_random_covers(covers, count);
+
+		// every other span has a single cover for all pixels
+		const uint8* spanCovers = (i / kMaxPixels) % 2 == 0 ? covers : NULL;
+		uint8 cover = random_cover();
+
+		if (over) {
+			gScalarSpanKernels.blendColorSpanOver(expected, count, colors,
+				spanCovers, cover);
+			kernels.blendColorSpanOver(result, count, colors, spanCovers,
+				cover);
+		} else {
+			gScalarSpanKernels.blendColorSpan(expected, count, colors,
+				spanCovers, cover);
+			kernels.blendColorSpan(result, count, colors, spanCovers, cover);
+		}
+		CPPUNIT_ASSERT(memcmp(expected, result, count * 4) == 0);
+	}
+}
+
+
+void
+SpanKernelsTest::_TestBlendSolidSpanAlpha(const SpanKernels& kernels,
+	bool composite)
+{
+	uint8 expected[kMaxPixels * 4];
+	uint8 result[kMaxPixels * 4];
+	uint8 covers[kMaxPixels];
+
+	srand(3);
+	for (int32 i = 0; i < kIterations; i++) {
+		int32 count = i % kMaxPixels;
+		uint32 color = span_color(random_byte(), random_byte(), random_byte());
+		uint8 alpha = random_cover();
+		// the composite version has a fast path for opaque destinations
+		fill_random_pixels(expected, count, i % 2 == 0);
+		memcpy(result, expected, count * 4);
+		fill_random_covers(covers, count);
+
+		if (composite) {
+			gScalarSpanKernels.blendSolidSpanAlphaCC(expected, count, color,
+				alpha, covers);
+			kernels.blendSolidSpanAlphaCC(result, count, color, alpha, covers);
+		} else {
+			gScalarSpanKernels.blendSolidSpanAlphaCO(expected, count, color,
+				alpha, covers);
+			kernels.blendSolidSpanAlphaCO(result, count, color, alpha, covers);
+		}
+		CPPUNIT_ASSERT(memcmp(expected, result, count * 4) == 0);
+	}
+}
+
+
+void
+SpanKernelsTest::_TestBlendRowAlpha(const SpanKernels& kernels)
+{
+	uint8 expected[kMaxPixels * 4];
+	uint8 result[kMaxPixels * 4];
+	uint8 source[kMaxPixels * 4];
+
+	srand(4);
+	for (int32 i = 0; i < kIterations; i++) {
+		int32 count = i % kMaxPixels;
+		fill_random(expected, count * 4);
+		memcpy(result, expected, count * 4);
+		fill_random(source, count * 4);
+		for (int32 j = 0; j < count; j++) {
+			if (rand() % 2 == 0)
+				source[j * 4 + 3] = rand() % 2 == 0 ? 0 : 255;
+		}
+
+		gScalarSpanKernels.blendRowAlpha(expected, source, count);
+		kernels.blendRowAlpha(result, source, count);
+		CPPUNIT_ASSERT(memcmp(expected, result, count * 4) == 0);
+	}
+}
+
+
+void
+SpanKernelsTest::_TestScaleRowNearest(const SpanKernels& kernels)
+{
+	uint8 expected[kMaxPixels * 4];
+	uint8 result[kMaxPixels * 4];
+	uint8 source[kSourceWidth * 4];
+	uint16 xIndices[kMaxPixels];
+
+	srand(5);
+	for (int32 i = 0; i < kIterations; i++) {
+		int32 count = i % kMaxPixels;
+		fill_random(source, sizeof(source));
+		for (int32 j = 0; j < count; j++)
+			xIndices[j] = (rand() % kSourceWidth) * 4;
+
+		gScalarSpanKernels.scaleRowNearest(expected, source, xIndices, count);
+		kernels.scaleRowNearest(result, source, xIndices, count);
+		CPPUNIT_ASSERT(memcmp(expected, result, count * 4) == 0);
+	}
+}
+
+
+void
+SpanKernelsTest::_TestScaleRowBilinear(const SpanKernels& kernels)
+{
+	uint8 expected[kMaxPixels * 4];
+	uint8 result[kMaxPixels * 4];
+	uint8 source[kSourceWidth * 4 * 2];
+	uint16 xWeights[kMaxPixels * 2];
+
+	srand(6);
+	for (int32 i = 0; i < kIterations; i++) {
+		int32 count = i % kMaxPixels;
+		fill_random(expected, count * 4);
+		memcpy(result, expected, count * 4);
+		fill_random(source, sizeof(source));
+		for (int32 j = 0; j < count; j++) {
+			// the right pixel has to be inside the source, too
+			xWeights[j * 2] = (rand() % (kSourceWidth - 1)) * 4;
+			xWeights[j * 2 + 1] = random_cover();
+		}
+		uint16 wTop = random_cover();
+
+		gScalarSpanKernels.scaleRowBilinear(expected, source, kSourceWidth * 4,
+			xWeights, count, wTop);
+		kernels.scaleRowBilinear(result, source, kSourceWidth * 4, xWeights,
+			count, wTop);
+		CPPUNIT_ASSERT(memcmp(expected, result, count * 4) == 0);
+	}
+}
+
+
+/*static*/ void
+SpanKernelsTest::AddTests(BTestSuite& parent)
+{
+	CppUnit::TestSuite& suite = *new CppUnit::TestSuite("SpanKernelsTest");
+
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::BlendSolidSpan",
+		&SpanKernelsTest::BlendSolidSpan));
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::BlendColorSpan",
+		&SpanKernelsTest::BlendColorSpan));
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::BlendColorSpanOver",
+		&SpanKernelsTest::BlendColorSpanOver));
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::BlendSolidSpanAlphaCO",
+		&SpanKernelsTest::BlendSolidSpanAlphaCO));
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::BlendSolidSpanAlphaCC",
+		&SpanKernelsTest::BlendSolidSpanAlphaCC));
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::BlendRowAlpha",
+		&SpanKernelsTest::BlendRowAlpha));
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::ScaleRowNearest",
+		&SpanKernelsTest::ScaleRowNearest));
+	suite.addTest(new CppUnit::TestCaller<SpanKernelsTest>(
+		"SpanKernelsTest::ScaleRowBilinear",
+		&SpanKernelsTest::ScaleRowBilinear));
+
+	parent.addTest("SpanKernelsTest", &suite);
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef SPAN_KERNELS_TEST_H
+#define SPAN_KERNELS_TEST_H
+
+#include <TestCase.h>
+#include <TestSuite.h>
+
+#include "SpanKernels.h"
+
+
+class SpanKernelsTest : public BTestCase {
+public:
+	static	void			AddTests(BTestSuite& parent);
+
+			void			BlendSolidSpan();
+			void			BlendColorSpan();
+			void			BlendColorSpanOver();
+			void			BlendSolidSpanAlphaCO();
+			void			BlendSolidSpanAlphaCC();
+			void			BlendRowAlpha();
+			void			ScaleRowNearest();
+			void			ScaleRowBilinear();
+
+private:
+			void			_TestBlendSolidSpan(const SpanKernels& kernels);
+			void			_TestBlendColorSpan(const SpanKernels& kernels,
+								bool over);
+			void			_TestBlendSolidSpanAlpha(
+								const SpanKernels& kernels, bool composite);
+			void			_TestBlendRowAlpha(const SpanKernels& kernels);
+			void			_TestScaleRowNearest(const SpanKernels& kernels);
+			void			_TestScaleRowBilinear(const SpanKernels& kernels);
+};
+
+
+#endif // SPAN_KERNELS_TEST_H
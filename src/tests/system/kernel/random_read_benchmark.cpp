@@ -0,0 +1,169 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures random read IOPS of a raw disk device at increasing queue
+	depths, like a fio "randread" job. Each outstanding I/O is issued by a
+	thread of its own, so the queue depth is the number of threads.
+
+	Run it against an otherwise idle device, e.g. QEMU's emulated NVMe:
+		random_read_benchmark /dev/disk/nvme/0/raw 1,2,4,8,16,32 10
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Drivers.h>
+#include <OS.h>
+
+
+static const size_t kBlockSize = 4096;
+
+
+struct Worker {
+	pthread_t	thread;
+	int			fd;
+	off_t		blockCount;
+	uint32		seed;
+	bigtime_t	endTime;
+	uint64		reads;
+	status_t	error;
+};
+
+
+static void*
+worker_thread(void* data)
+{
+	Worker* worker = (Worker*)data;
+
+	void* buffer;
+	if (posix_memalign(&buffer, kBlockSize, kBlockSize) != 0) {
+		worker->error = B_NO_MEMORY;
+		return NULL;
+	}
+
+	while (system_time() < worker->endTime) {
+		off_t block = ((off_t)rand_r(&worker->seed) << 16
+			^ rand_r(&worker->seed)) % worker->blockCount;
+		if (pread(worker->fd, buffer, kBlockSize, block * kBlockSize)
+				!= (ssize_t)kBlockSize) {
+			worker->error = errno;
+			break;
+		}
+		worker->reads++;
+	}
+
+	free(buffer);
+	return NULL;
+}
+
+
+static status_t
+run(int fd, off_t blockCount, int32 queueDepth, bigtime_t duration)
+{
+	Worker* workers = new Worker[queueDepth];
+	bigtime_t startTime = system_time();
+
+	for (int32 i = 0; i < queueDepth; i++) {
+		Worker& worker = workers[i];
+		worker.fd = fd;
+		worker.blockCount = blockCount;
+		worker.seed = (i + 1) * 7919;
+		worker.endTime = startTime + duration;
+		worker.reads = 0;
+		worker.error = B_OK;
+		if (pthread_create(&worker.thread, NULL, worker_thread, &worker)
+				!= 0) {
+			fprintf(stderr, "Failed to create thread: %s\n",
+				strerror(errno));
+			exit(1);
+		}
+	}
+
+	uint64 reads = 0;
+	status_t error = B_OK;
+	for (int32 i = 0; i < queueDepth; i++) {
+		pthread_join(workers[i].thread, NULL);
+		reads += workers[i].reads;
+		if (workers[i].error != B_OK)
+			error = workers[i].error;
+	}
+
+	bigtime_t time = system_time() - startTime;
+	delete[] workers;
+
+	if (error != B_OK)
+		return error;
+
+	double iops = reads / (time / 1000000.0);
+	printf("%11" B_PRId32 " %12.0f %10.1f\n", queueDepth, iops,
+		iops * kBlockSize / (1024 * 1024));
+	return B_OK;
+}
+
+
+int
+main(int argc, const char* const* argv)
+{
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "usage: %s <raw device> [<queue depths> "
+			"[<seconds>]]\n"
+			"  e.g. %s /dev/disk/nvme/0/raw 1,2,4,8,16,32 10\n", argv[0],
+			argv[0]);
+		return 1;
+	}
+
+	const char* queueDepths = argc > 2 ? argv[2] : "1,2,4,8,16,32";
+	bigtime_t duration = (argc > 3 ? atoi(argv[3]) : 10) * 1000000LL;
+
+	int fd = open(argv[1], O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open \"%s\": %s\n", argv[1],
+			strerror(errno));
+		return 1;
+	}
+
+	device_geometry geometry;
+	if (ioctl(fd, B_GET_GEOMETRY, &geometry, sizeof(geometry)) != 0) {
+		fprintf(stderr, "Failed to get the geometry of \"%s\": %s\n",
+			argv[1], strerror(errno));
+		return 1;
+	}
+
+	off_t blockCount = (off_t)geometry.bytes_per_sector
+		* geometry.sectors_per_track * geometry.cylinder_count
+		* geometry.head_count / kBlockSize;
+	if (blockCount == 0) {
+		fprintf(stderr, "\"%s\" is too small.\n", argv[1]);
+		return 1;
+	}
+
+	printf("queue depth         IOPS       MB/s\n");
+
+	for (const char* depth = queueDepths; depth != NULL;) {
+		int32 queueDepth = atoi(depth);
+		if (queueDepth > 0) {
+			status_t error = run(fd, blockCount, queueDepth, duration);
+			if (error != B_OK) {
+				fprintf(stderr, "Reading at queue depth %" B_PRId32
+					" failed: %s\n", queueDepth, strerror(error));
+				return 1;
+			}
+		}
+
+		depth = strchr(depth, ',');
+		if (depth != NULL)
+			depth++;
+	}
+
+	close(fd);
+	return 0;
+}
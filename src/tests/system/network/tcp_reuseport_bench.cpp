@@ -0,0 +1,232 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures the connect/accept rate over loopback, either with one shared
+//!	listening socket, or with one SO_REUSEPORT listener per worker.
+
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+static const int kMaxWorkers = 64;
+
+static int sWorkers = 4;
+static int sClients = 4;
+static int sSeconds = 5;
+static bool sReusePort = true;
+static uint16_t sPort = 0;
+
+static volatile bool sQuit = false;
+static int sSharedListener = -1;
+
+struct worker_info {
+	pthread_t	thread;
+	int			listener;
+	long		accepted;
+};
+
+static worker_info sWorkerInfos[kMaxWorkers];
+static long sConnected[kMaxWorkers];
+
+
+static double
+current_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+static int
+create_listener(uint16_t port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		fprintf(stderr, "socket() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	if (sReusePort
+		&& setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) {
+		fprintf(stderr, "SO_REUSEPORT failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = port;
+	if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+		fprintf(stderr, "bind() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+	if (listen(fd, 128) != 0) {
+		fprintf(stderr, "listen() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	socklen_t length = sizeof(address);
+	getsockname(fd, (sockaddr*)&address, &length);
+	sPort = address.sin_port;
+
+	return fd;
+}
+
+
+static void*
+worker_thread(void* _info)
+{
+	worker_info* info = (worker_info*)_info;
+
+	while (true) {
+		int fd = accept(info->listener, NULL, NULL);
+		if (fd < 0) {
+			if (sQuit)
+				break;
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		info->accepted++;
+		close(fd);
+	}
+
+	return NULL;
+}
+
+
+static void*
+client_thread(void* _index)
+{
+	long index = (long)_index;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = sPort;
+
+	while (!sQuit) {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0)
+			break;
+
+		// avoid piling up TIME_WAIT connections on our side
+		struct linger linger = { 1, 0 };
+		setsockopt(fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+
+		if (connect(fd, (sockaddr*)&address, sizeof(address)) == 0)
+			sConnected[index]++;
+
+		close(fd);
+	}
+
+	return NULL;
+}
+
+
+static void
+usage()
+{
+	fprintf(stderr, "usage: tcp_reuseport_bench [-s] [-w <workers>] "
+		"[-c <clients>] [-t <seconds>]\n"
+		"  -s  use a single shared listening socket instead of "
+			"SO_REUSEPORT\n");
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "sw:c:t:h")) != -1) {
+		switch (option) {
+			case 's':
+				sReusePort = false;
+				break;
+			case 'w':
+				sWorkers = atoi(optarg);
+				break;
+			case 'c':
+				sClients = atoi(optarg);
+				break;
+			case 't':
+				sSeconds = atoi(optarg);
+				break;
+			default:
+				usage();
+		}
+	}
+
+	if (sWorkers < 1 || sWorkers > kMaxWorkers || sClients < 1
+		|| sClients > kMaxWorkers || sSeconds < 1)
+		usage();
+
+	if (!sReusePort)
+		sSharedListener = create_listener(0);
+
+	for (int i = 0; i < sWorkers; i++) {
+		worker_info& info = sWorkerInfos[i];
+		info.listener = sReusePort ? create_listener(sPort) : sSharedListener;
+		info.accepted = 0;
+		pthread_create(&info.thread, NULL, &worker_thread, &info);
+	}
+
+	pthread_t clients[kMaxWorkers];
+	double start = current_time();
+	for (long i = 0; i < sClients; i++)
+		pthread_create(&clients[i], NULL, &client_thread, (void*)i);
+
+	sleep(sSeconds);
+	sQuit = true;
+
+	long connected = 0;
+	for (int i = 0; i < sClients; i++) {
+		pthread_join(clients[i], NULL);
+		connected += sConnected[i];
+	}
+	double elapsed = current_time() - start;
+
+	// wake up the workers
+	for (int i = 0; i < sWorkers; i++) {
+		if (sReusePort || i == 0)
+			shutdown(sWorkerInfos[i].listener, SHUT_RDWR);
+	}
+
+	long accepted = 0;
+	for (int i = 0; i < sWorkers; i++) {
+		pthread_join(sWorkerInfos[i].thread, NULL);
+		accepted += sWorkerInfos[i].accepted;
+		if (sReusePort || i == 0)
+			close(sWorkerInfos[i].listener);
+	}
+
+	printf("%s, %d workers, %d clients: %ld connections in %.2f s, "
+		"%.0f connections/s\n", sReusePort ? "SO_REUSEPORT" : "shared listener",
+		sWorkers, sClients, connected, elapsed, connected / elapsed);
+	for (int i = 0; i < sWorkers; i++) {
+		printf("  worker %2d: %8ld accepted (%.1f%%)\n", i,
+			sWorkerInfos[i].accepted,
+			accepted > 0 ? 100.0 * sWorkerInfos[i].accepted / accepted : 0.0);
+	}
+
+	return 0;
+}
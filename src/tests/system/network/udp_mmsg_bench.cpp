@@ -0,0 +1,242 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures the UDP packet rate over loopback using send()/recv(), and
+//!	sendmmsg()/recvmmsg() with increasing batch sizes.
+
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+static const int kMaxBatchSize = 256;
+static const int kMaxPacketSize = 1472;
+
+static int sSeconds = 2;
+static int sPacketSize = 64;
+static int sMaxBatchSize = 64;
+
+static volatile bool sQuit = false;
+
+struct batch_buffers {
+	mmsghdr		messages[kMaxBatchSize];
+	iovec		vecs[kMaxBatchSize];
+	char		data[kMaxBatchSize][kMaxPacketSize];
+};
+
+struct run_info {
+	int			receiver;
+	int			sender;
+	int			batchSize;
+		// 0 means send()/recv()
+	long		sent;
+	long		received;
+};
+
+
+static double
+current_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+static void
+init_buffers(batch_buffers& buffers, int batchSize)
+{
+	memset(&buffers.messages, 0, sizeof(buffers.messages));
+	for (int i = 0; i < batchSize; i++) {
+		buffers.vecs[i].iov_base = buffers.data[i];
+		buffers.vecs[i].iov_len = kMaxPacketSize;
+		buffers.messages[i].msg_hdr.msg_iov = &buffers.vecs[i];
+		buffers.messages[i].msg_hdr.msg_iovlen = 1;
+	}
+}
+
+
+static void*
+sender_thread(void* _info)
+{
+	run_info* info = (run_info*)_info;
+
+	batch_buffers* buffers = new batch_buffers;
+	init_buffers(*buffers, info->batchSize);
+	for (int i = 0; i < info->batchSize; i++)
+		buffers->vecs[i].iov_len = sPacketSize;
+	memset(buffers->data, 'x', sizeof(buffers->data));
+
+	while (!sQuit) {
+		if (info->batchSize == 0) {
+			if (send(info->sender, buffers->data[0], sPacketSize, 0) > 0)
+				info->sent++;
+			continue;
+		}
+
+		int sent = sendmmsg(info->sender, buffers->messages, info->batchSize,
+			0);
+		if (sent > 0)
+			info->sent += sent;
+	}
+
+	delete buffers;
+	return NULL;
+}
+
+
+static void*
+receiver_thread(void* _info)
+{
+	run_info* info = (run_info*)_info;
+
+	batch_buffers* buffers = new batch_buffers;
+	init_buffers(*buffers, info->batchSize);
+
+	while (!sQuit) {
+		if (info->batchSize == 0) {
+			if (recv(info->receiver, buffers->data[0], kMaxPacketSize, 0) > 0)
+				info->received++;
+			continue;
+		}
+
+		int received = recvmmsg(info->receiver, buffers->messages,
+			info->batchSize, MSG_WAITFORONE, NULL);
+		if (received > 0)
+			info->received += received;
+	}
+
+	delete buffers;
+	return NULL;
+}
+
+
+static int
+create_socket(const sockaddr_in* peer)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		fprintf(stderr, "socket() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	int size = 1024 * 1024;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+	// make sure a blocked receiver wakes up regularly to check for the end
+	struct timeval timeout = { 0, 100000 };
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+		fprintf(stderr, "bind() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	if (peer != NULL
+		&& connect(fd, (const sockaddr*)peer, sizeof(sockaddr_in)) != 0) {
+		fprintf(stderr, "connect() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	return fd;
+}
+
+
+static void
+run(int batchSize)
+{
+	run_info info;
+	info.receiver = create_socket(NULL);
+	info.batchSize = batchSize;
+	info.sent = 0;
+	info.received = 0;
+
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+	getsockname(info.receiver, (sockaddr*)&address, &length);
+	info.sender = create_socket(&address);
+
+	sQuit = false;
+
+	pthread_t receiver;
+	pthread_t sender;
+	double start = current_time();
+	pthread_create(&receiver, NULL, &receiver_thread, &info);
+	pthread_create(&sender, NULL, &sender_thread, &info);
+
+	sleep(sSeconds);
+	sQuit = true;
+
+	pthread_join(sender, NULL);
+	pthread_join(receiver, NULL);
+	double elapsed = current_time() - start;
+
+	close(info.sender);
+	close(info.receiver);
+
+	if (batchSize == 0)
+		printf("  send/recv");
+	else
+		printf("  %9d", batchSize);
+	printf("  %12.0f  %12.0f  %5.1f%%\n", info.sent / elapsed,
+		info.received / elapsed,
+		info.sent > 0 ? 100.0 * (info.sent - info.received) / info.sent : 0.0);
+}
+
+
+static void
+usage()
+{
+	fprintf(stderr, "usage: udp_mmsg_bench [-s <packet size>] "
+		"[-b <max batch size>] [-t <seconds per run>]\n");
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "s:b:t:h")) != -1) {
+		switch (option) {
+			case 's':
+				sPacketSize = atoi(optarg);
+				break;
+			case 'b':
+				sMaxBatchSize = atoi(optarg);
+				break;
+			case 't':
+				sSeconds = atoi(optarg);
+				break;
+			default:
+				usage();
+		}
+	}
+
+	if (sPacketSize < 1 || sPacketSize > kMaxPacketSize || sMaxBatchSize < 1
+		|| sMaxBatchSize > kMaxBatchSize || sSeconds < 1)
+		usage();
+
+	printf("%d byte packets, %d s per run\n", sPacketSize, sSeconds);
+	printf("  batch size    sent pkts/s   recv pkts/s   lost\n");
+
+	run(0);
+	for (int batchSize = 1; batchSize <= sMaxBatchSize; batchSize *= 2)
+		run(batchSize);
+
+	return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2026, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures the AF_UNIX stream throughput over a socket pair for transfer
+//!	sizes from 4 KiB to 16 MiB.
+
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+static const size_t kMinTransferSize = 4 * 1024;
+static const size_t kMaxTransferSize = 16 * 1024 * 1024;
+
+static size_t sTotalSize = 256 * 1024 * 1024;
+
+struct run_info {
+	int			fd;
+	size_t		transferSize;
+	size_t		total;
+	char*		buffer;
+};
+
+
+static double
+current_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+static void*
+sender_thread(void* _info)
+{
+	run_info* info = (run_info*)_info;
+
+	size_t left = info->total;
+	while (left > 0) {
+		size_t size = left < info->transferSize ? left : info->transferSize;
+		ssize_t bytesWritten = write(info->fd, info->buffer, size);
+		if (bytesWritten < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "write() failed: %s\n", strerror(errno));
+			exit(1);
+		}
+		left -= bytesWritten;
+	}
+
+	return NULL;
+}
+
+
+static void
+run(size_t transferSize)
+{
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		fprintf(stderr, "socketpair() failed: %s\n", strerror(errno));
+		exit(1);
+	}
+
+	char* sendBuffer = (char*)malloc(transferSize);
+	char* receiveBuffer = (char*)malloc(transferSize);
+	if (sendBuffer == NULL || receiveBuffer == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	memset(sendBuffer, 'x', transferSize);
+	memset(receiveBuffer, 0, transferSize);
+
+	// transfer at least a few chunks of the larger sizes
+	size_t total = sTotalSize;
+	if (total < transferSize * 4)
+		total = transferSize * 4;
+
+	run_info info;
+	info.fd = fds[0];
+	info.transferSize = transferSize;
+	info.total = total;
+	info.buffer = sendBuffer;
+
+	double start = current_time();
+
+	pthread_t sender;
+	pthread_create(&sender, NULL, &sender_thread, &info);
+
+	size_t received = 0;
+	while (received < total) {
+		ssize_t bytesRead = read(fds[1], receiveBuffer, transferSize);
+		if (bytesRead < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "read() failed: %s\n", strerror(errno));
+			exit(1);
+		}
+		if (bytesRead == 0)
+			break;
+		received += bytesRead;
+	}
+
+	pthread_join(sender, NULL);
+	double elapsed = current_time() - start;
+
+	close(fds[0]);
+	close(fds[1]);
+	free(sendBuffer);
+	free(receiveBuffer);
+
+	printf("  %9zu KiB  %10.1f MB/s\n", transferSize / 1024,
+		received / elapsed / 1000000.0);
+}
+
+
+static void
+usage()
+{
+	fprintf(stderr, "usage: unix_stream_bench [-m <MiB per run>]\n");
+	exit(1);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int option;
+	while ((option = getopt(argc, argv, "m:h")) != -1) {
+		switch (option) {
+			case 'm':
+				sTotalSize = (size_t)atoi(optarg) * 1024 * 1024;
+				break;
+			default:
+				usage();
+		}
+	}
+
+	if (sTotalSize == 0)
+		usage();
+
+	printf("%zu MiB per run\n", sTotalSize / 1024 / 1024);
+	printf("  transfer size      throughput\n");
+
+	for (size_t size = kMinTransferSize; size <= kMaxTransferSize; size *= 2)
+		run(size);
+
+	return 0;
+}
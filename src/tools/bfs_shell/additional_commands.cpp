@@ -7,7 +7,9 @@
 #include "fssh.h"
 
 #include "command_checkfs.h"
+#include "command_query.h"
 #include "command_resizefs.h"
+#include "command_writebench.h"
 
 
 namespace FSShell {
@@ -20,6 +22,12 @@ register_additional_commands()
 		"check file system");
 	CommandManager::Default()->AddCommand(command_resizefs, "resizefs",
 		"resize file system");
+	CommandManager::Default()->AddCommand(command_explain, "explain",
+		"describe how a query is evaluated");
+	CommandManager::Default()->AddCommand(command_querybench, "querybench",
+		"create test files and time queries");
+	CommandManager::Default()->AddCommand(command_writebench, "writebench",
+		"write files concurrently and count their extents");
 }
 
 
@@ -130,6 +130,8 @@ command_checkfs(int argc, const char* const* argv)
 		result.stats.double_indirect_block_runs,
 		result.stats.double_indirect_array_blocks,
 		result.stats.blocks_in_double_indirect * result.stats.block_size);
+	fssh_dprintf("\tinline files\t\t\t%" FSSH_B_PRIu64 " (%" FSSH_B_PRIu64
+		")\n", result.stats.inline_files, result.stats.bytes_in_inline);
 
 	if (result.status == B_ENTRY_NOT_FOUND)
 		result.status = B_OK;
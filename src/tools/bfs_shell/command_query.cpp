@@ -0,0 +1,348 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "fssh_dirent.h"
+#include "fssh_stat.h"
+#include "fssh_stdio.h"
+#include "syscalls.h"
+
+#include "bfs.h"
+#include "bfs_control.h"
+
+
+namespace FSShell {
+
+
+static const char* kBenchmarkDirectory = "/myfs/querybench";
+static const int32 kFilesPerDirectory = 1000;
+static const int32 kSenders = 5000;
+static const int32 kBaseTime = 1700000000;
+	// the files are one minute apart, the first one at this time
+
+static const int32 kMaxQueries = 16;
+
+
+static fssh_dev_t
+volume_id()
+{
+	struct stat st;
+	status_t status = _kern_read_stat(-1, "/myfs", false, &st, sizeof(st));
+	if (status != B_OK)
+		return status;
+
+	return st.st_dev;
+}
+
+
+static status_t
+print_query_plan(int rootDir, const char* queryString)
+{
+	query_plan_control control;
+	memset(&control, 0, sizeof(control));
+	strlcpy(control.query, queryString, sizeof(control.query));
+
+	status_t status = _kern_ioctl(rootDir, BFS_IOCTL_EXPLAIN_QUERY, &control,
+		sizeof(control));
+	if (status != B_OK) {
+		fssh_dprintf("Error: Could not explain query: %s\n",
+			fssh_strerror(status));
+		return status;
+	}
+
+	fssh_dprintf("%s", control.plan);
+	return B_OK;
+}
+
+
+static status_t
+write_attribute(int fd, const char* name, uint32 type, const void* data,
+	size_t size)
+{
+	int attribute = _kern_create_attr(fd, name, type, O_WRONLY | O_TRUNC);
+	if (attribute < 0)
+		return attribute;
+
+	ssize_t bytesWritten = _kern_write(attribute, 0, data, size);
+	_kern_close(attribute);
+
+	if (bytesWritten < 0)
+		return bytesWritten;
+	return (size_t)bytesWritten == size ? B_OK : B_IO_ERROR;
+}
+
+
+/*!	Fills kBenchmarkDirectory with \a count files that carry a "MAIL:from"
+	and a "MAIL:when" attribute, both indexed, spread over subdirectories.
+*/
+static status_t
+create_files(fssh_dev_t volumeID, int32 count)
+{
+	status_t status = _kern_create_index(volumeID, "MAIL:from", B_STRING_TYPE,
+		0);
+	if (status == B_OK || status == B_FILE_EXISTS) {
+		status = _kern_create_index(volumeID, "MAIL:when", B_INT32_TYPE, 0);
+		if (status == B_FILE_EXISTS)
+			status = B_OK;
+	}
+	if (status != B_OK) {
+		fssh_dprintf("Error: Could not create indices: %s\n",
+			fssh_strerror(status));
+		return status;
+	}
+
+	status = _kern_create_dir(-1, kBenchmarkDirectory, 0755);
+	if (status != B_OK && status != B_FILE_EXISTS) {
+		fssh_dprintf("Error: Could not create %s: %s\n", kBenchmarkDirectory,
+			fssh_strerror(status));
+		return status;
+	}
+
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < count; i++) {
+		char path[B_PATH_NAME_LENGTH];
+		if (i % kFilesPerDirectory == 0) {
+			snprintf(path, sizeof(path), "%s/%" B_PRId32, kBenchmarkDirectory,
+				i / kFilesPerDirectory);
+			status = _kern_create_dir(-1, path, 0755);
+			if (status != B_OK && status != B_FILE_EXISTS)
+				break;
+		}
+
+		snprintf(path, sizeof(path), "%s/%" B_PRId32 "/file%" B_PRId32,
+			kBenchmarkDirectory, i / kFilesPerDirectory, i);
+		int fd = _kern_open(-1, path, O_CREAT | O_WRONLY, 0644);
+		if (fd < 0) {
+			status = fd;
+			break;
+		}
+
+		char from[64];
+		snprintf(from, sizeof(from), "user%" B_PRId32 "@host%" B_PRId32
+			".example.com", i % kSenders, i % 97);
+		int32 when = kBaseTime + i * 60;
+
+		status = write_attribute(fd, "MAIL:from", B_STRING_TYPE, from,
+			strlen(from) + 1);
+		if (status == B_OK) {
+			status = write_attribute(fd, "MAIL:when", B_INT32_TYPE, &when,
+				sizeof(when));
+		}
+		_kern_close(fd);
+
+		if (status != B_OK)
+			break;
+
+		if ((i + 1) % 10000 == 0) {
+			fssh_dprintf("%9" B_PRId32 " files created\x1b[1A\n", i + 1);
+			_kern_sync();
+		}
+	}
+
+	if (status != B_OK) {
+		fssh_dprintf("Error: Creating files failed: %s\n",
+			fssh_strerror(status));
+		return status;
+	}
+
+	_kern_sync();
+
+	fssh_dprintf("%9" B_PRId32 " files created in %g s\n", count,
+		(system_time() - start) / 1000000.0);
+	return B_OK;
+}
+
+
+static status_t
+create_trigrams(fssh_dev_t volumeID)
+{
+	static const char* kIndices[] = {"name@trigrams", "MAIL:from@trigrams"};
+
+	for (int32 i = 0; i < 2; i++) {
+		bigtime_t start = system_time();
+
+		status_t status = _kern_create_index(volumeID, kIndices[i],
+			B_UINT32_TYPE, 0);
+		if (status != B_OK && status != B_FILE_EXISTS) {
+			fssh_dprintf("Error: Could not create \"%s\": %s\n", kIndices[i],
+				fssh_strerror(status));
+			return status;
+		}
+
+		if (status == B_OK) {
+			fssh_dprintf("%s created in %g s\n", kIndices[i],
+				(system_time() - start) / 1000000.0);
+		}
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+run_query(fssh_dev_t volumeID, const char* queryString, int32& _count)
+{
+	int fd = _kern_open_query(volumeID, queryString, strlen(queryString), 0,
+		-1, -1);
+	if (fd < 0)
+		return fd;
+
+	char buffer[sizeof(struct dirent) + B_FILE_NAME_LENGTH];
+	struct dirent* entry = (struct dirent*)buffer;
+
+	int32 count = 0;
+	ssize_t entriesRead;
+	while ((entriesRead = _kern_read_dir(fd, entry, sizeof(buffer), 1)) == 1)
+		count++;
+
+	_kern_close(fd);
+
+	if (entriesRead < 0)
+		return entriesRead;
+
+	_count = count;
+	return B_OK;
+}
+
+
+fssh_status_t
+command_explain(int argc, const char* const* argv)
+{
+	if (argc != 2) {
+		fssh_dprintf("Usage: %s <query string>\n", argv[0]);
+		return B_BAD_VALUE;
+	}
+
+	int rootDir = _kern_open_dir(-1, "/myfs");
+	if (rootDir < 0) {
+		fssh_dprintf("Error: Couldn't open root directory\n");
+		return rootDir;
+	}
+
+	status_t status = print_query_plan(rootDir, argv[1]);
+
+	_kern_close(rootDir);
+	return status;
+}
+
+
+fssh_status_t
+command_querybench(int argc, const char* const* argv)
+{
+	int32 createCount = 0;
+	int32 runs = 3;
+	bool trigrams = false;
+	const char* queries[kMaxQueries];
+	int32 queryCount = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+			if (fssh_sscanf(argv[++i], "%" B_SCNd32, &createCount) < 1)
+				createCount = -1;
+		} else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			if (fssh_sscanf(argv[++i], "%" B_SCNd32, &runs) < 1)
+				runs = -1;
+		} else if (!strcmp(argv[i], "-t"))
+			trigrams = true;
+		else if (argv[i][0] != '-' && queryCount < kMaxQueries)
+			queries[queryCount++] = argv[i];
+		else
+			createCount = -1;
+	}
+
+	if (createCount < 0 || runs < 1) {
+		fssh_dprintf("Usage: %s [-c <files>] [-t] [-r <runs>] [<query> ...]\n"
+			"  -c  first create <files> files with indexed MAIL:from and "
+				"MAIL:when\n"
+			"      attributes in %s\n"
+			"  -t  create the trigram indices for \"name\" and \"MAIL:from\"\n"
+			"  -r  run each query <runs> times (default 3)\n"
+			"Without a query, a set of queries matching the created files "
+				"is run.\n", argv[0], kBenchmarkDirectory);
+		return B_BAD_VALUE;
+	}
+
+	fssh_dev_t volumeID = volume_id();
+	if (volumeID < 0)
+		return volumeID;
+
+	if (createCount > 0) {
+		status_t status = create_files(volumeID, createCount);
+		if (status != B_OK)
+			return status;
+	}
+
+	if (trigrams) {
+		status_t status = create_trigrams(volumeID);
+		if (status != B_OK)
+			return status;
+	}
+
+	// the default queries look at the last week of the created files
+	char defaultQueries[5][256];
+	if (queryCount == 0) {
+		int32 total = createCount;
+		if (total == 0) {
+			// count the files created by a previous run
+			status_t status = run_query(volumeID, "MAIL:when>=0", total);
+			if (status != B_OK)
+				return status;
+		}
+		int32 lastWeek = kBaseTime + total * 60 - 7 * 24 * 60 * 60;
+
+		snprintf(defaultQueries[0], sizeof(defaultQueries[0]),
+			"MAIL:from==\"*user42@*\"");
+		snprintf(defaultQueries[1], sizeof(defaultQueries[1]),
+			"MAIL:when>%" B_PRId32, lastWeek);
+		snprintf(defaultQueries[2], sizeof(defaultQueries[2]),
+			"(MAIL:from==\"*user42@*\")&&(MAIL:when>%" B_PRId32 ")", lastWeek);
+		snprintf(defaultQueries[3], sizeof(defaultQueries[3]),
+			"(name==\"file12*\")&&(MAIL:when>%" B_PRId32 ")", lastWeek);
+		snprintf(defaultQueries[4], sizeof(defaultQueries[4]),
+			"name==\"*[Ll][Ee]123*\"");
+
+		for (int32 i = 0; i < 5; i++)
+			queries[queryCount++] = defaultQueries[i];
+	}
+
+	int rootDir = _kern_open_dir(-1, "/myfs");
+	if (rootDir < 0) {
+		fssh_dprintf("Error: Couldn't open root directory\n");
+		return rootDir;
+	}
+
+	status_t status = B_OK;
+	for (int32 i = 0; i < queryCount; i++) {
+		bigtime_t best = -1;
+		int32 count = 0;
+		for (int32 run = 0; run < runs; run++) {
+			bigtime_t start = system_time();
+			status = run_query(volumeID, queries[i], count);
+			if (status != B_OK)
+				break;
+
+			bigtime_t elapsed = system_time() - start;
+			if (best < 0 || elapsed < best)
+				best = elapsed;
+		}
+
+		if (status != B_OK) {
+			fssh_dprintf("%s: query failed: %s\n", queries[i],
+				fssh_strerror(status));
+			break;
+		}
+
+		fssh_dprintf("%s\n  %" B_PRId32 " entries, best of %" B_PRId32
+			": %g ms\n", queries[i], count, runs, best / 1000.0);
+		print_query_plan(rootDir, queries[i]);
+	}
+
+	_kern_close(rootDir);
+	return status;
+}
+
+
+}	// namespace FSShell
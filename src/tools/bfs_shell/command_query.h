@@ -0,0 +1,22 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef COMMAND_QUERY_H
+#define COMMAND_QUERY_H
+
+
+#include "fssh_types.h"
+
+
+namespace FSShell {
+
+
+fssh_status_t command_explain(int argc, const char* const* argv);
+fssh_status_t command_querybench(int argc, const char* const* argv);
+
+
+}	// namespace FSShell
+
+
+#endif	// COMMAND_QUERY_H
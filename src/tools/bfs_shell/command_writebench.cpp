@@ -0,0 +1,273 @@
+/*
+ * Copyright 2026, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "fssh_kernel_export.h"
+#include "fssh_stat.h"
+#include "fssh_stdio.h"
+#include "syscalls.h"
+#include "vfs.h"
+
+#include "bfs.h"
+
+
+namespace FSShell {
+
+
+static const char* kBenchmarkDirectory = "/myfs/writebench";
+static const int32 kMaxWriters = 32;
+static const size_t kRecordSize = 10240;
+	// tar writes its files in records of this size
+static const size_t kMaxFileMapVecs = 16;
+
+struct writer_info {
+	int32		file;
+	int			fd;
+	off_t		size;
+	off_t		offset;
+};
+
+static char sBuffer[kRecordSize];
+
+
+/*!	Returns the size of the file with the given \a index: mostly small files,
+	and every 16th one larger, roughly like a source tree.
+*/
+static off_t
+file_size(int32 index)
+{
+	uint32 hash = (uint32)index * 2654435761U;
+	if (hash % 16 == 0)
+		return 128 * 1024 + hash % (2 * 1024 * 1024);
+
+	return 256 + hash % (48 * 1024);
+}
+
+
+static void
+file_path(char* path, size_t size, int32 writers, int32 file)
+{
+	snprintf(path, size, "%s/%" B_PRId32 "/file%" B_PRId32,
+		kBenchmarkDirectory, file % writers, file);
+}
+
+
+/*!	Lets the \a writer write its next record, and opens the next file once
+	the current one is complete. Returns \c B_ENTRY_NOT_FOUND when the writer
+	has nothing left to do.
+*/
+static status_t
+write_next_record(writer_info& writer, int32 writers, int32 files)
+{
+	if (writer.fd < 0) {
+		if (writer.file >= files)
+			return B_ENTRY_NOT_FOUND;
+
+		char path[B_PATH_NAME_LENGTH];
+		file_path(path, sizeof(path), writers, writer.file);
+		writer.fd = _kern_open(-1, path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+		if (writer.fd < 0)
+			return writer.fd;
+
+		writer.size = file_size(writer.file);
+		writer.offset = 0;
+	}
+
+	size_t length = min_c((off_t)kRecordSize, writer.size - writer.offset);
+	ssize_t bytesWritten = _kern_write(writer.fd, writer.offset, sBuffer,
+		length);
+	if (bytesWritten < 0)
+		return bytesWritten;
+	if ((size_t)bytesWritten != length)
+		return B_IO_ERROR;
+
+	writer.offset += length;
+	if (writer.offset == writer.size) {
+		_kern_close(writer.fd);
+		writer.fd = -1;
+		writer.file += writers;
+	}
+	return B_OK;
+}
+
+
+/*!	Counts the extents the file at \a path is made of. */
+static status_t
+count_runs(const char* path, int32& _runs)
+{
+	int fd = _kern_open(-1, path, O_RDONLY, 0);
+	if (fd < 0)
+		return fd;
+
+	struct stat st;
+	status_t status = _kern_read_stat(fd, NULL, false, &st, sizeof(st));
+
+	void* vnode;
+	if (status == B_OK)
+		status = vfs_get_vnode_from_fd(fd, true, &vnode);
+	if (status != B_OK) {
+		_kern_close(fd);
+		return status;
+	}
+
+	int32 runs = 0;
+	off_t offset = 0;
+	off_t lastEnd = -1;
+	while (offset < st.st_size) {
+		file_io_vec vecs[kMaxFileMapVecs];
+		size_t count = kMaxFileMapVecs;
+		status = vfs_get_file_map(vnode, offset, st.st_size - offset, vecs,
+			&count);
+		if (status == B_UNSUPPORTED && offset == 0) {
+			// the data is stored inline, and does not need any extents
+			status = B_OK;
+			break;
+		}
+		if (status != B_OK && status != B_BUFFER_OVERFLOW)
+			break;
+		if (count == 0) {
+			status = B_ERROR;
+			break;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			// runs that happen to be adjacent on disk count as one
+			if (vecs[i].offset != lastEnd)
+				runs++;
+			lastEnd = vecs[i].offset + vecs[i].length;
+			offset += vecs[i].length;
+		}
+		status = B_OK;
+	}
+
+	vfs_put_vnode(vnode);
+	_kern_close(fd);
+
+	_runs = runs;
+	return status;
+}
+
+
+fssh_status_t
+command_writebench(int argc, const char* const* argv)
+{
+	int32 writers = 4;
+	int32 files = 2000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+			if (fssh_sscanf(argv[++i], "%" B_SCNd32, &writers) < 1)
+				writers = -1;
+		} else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			if (fssh_sscanf(argv[++i], "%" B_SCNd32, &files) < 1)
+				files = -1;
+		} else
+			files = -1;
+	}
+
+	if (writers < 1 || writers > kMaxWriters || files < 1) {
+		fssh_dprintf("Usage: %s [-w <writers>] [-n <files>]\n"
+			"  -w  number of interleaved writers (default 4, at most %"
+				B_PRId32 ")\n"
+			"  -n  number of files to write (default 2000)\n"
+			"The files are written to %s like \"tar -x\" would, and the "
+				"number of\nextents per file is reported afterwards.\n",
+			argv[0], kMaxWriters, kBenchmarkDirectory);
+		return B_BAD_VALUE;
+	}
+
+	status_t status = _kern_create_dir(-1, kBenchmarkDirectory, 0755);
+	if (status != B_OK) {
+		fssh_dprintf("Error: Could not create %s: %s\n", kBenchmarkDirectory,
+			fssh_strerror(status));
+		return status;
+	}
+
+	memset(sBuffer, 'x', sizeof(sBuffer));
+
+	writer_info infos[kMaxWriters];
+	for (int32 i = 0; i < writers; i++) {
+		char path[B_PATH_NAME_LENGTH];
+		snprintf(path, sizeof(path), "%s/%" B_PRId32, kBenchmarkDirectory, i);
+		status = _kern_create_dir(-1, path, 0755);
+		if (status != B_OK)
+			return status;
+
+		infos[i].file = i;
+		infos[i].fd = -1;
+	}
+
+	bigtime_t start = system_time();
+
+	// The writers take turns record by record, so that their files grow at
+	// the same time, as with concurrent "tar -x" runs.
+	int32 active = writers;
+	while (active > 0 && status == B_OK) {
+		active = 0;
+		for (int32 i = 0; i < writers; i++) {
+			status = write_next_record(infos[i], writers, files);
+			if (status == B_ENTRY_NOT_FOUND) {
+				status = B_OK;
+				continue;
+			}
+			if (status != B_OK)
+				break;
+
+			active++;
+		}
+	}
+
+	for (int32 i = 0; i < writers; i++) {
+		if (infos[i].fd >= 0)
+			_kern_close(infos[i].fd);
+	}
+
+	_kern_sync();
+	bigtime_t elapsed = system_time() - start;
+
+	if (status != B_OK) {
+		fssh_dprintf("Error: Writing files failed: %s\n",
+			fssh_strerror(status));
+		return status;
+	}
+
+	off_t bytes = 0;
+	for (int32 i = 0; i < files; i++)
+		bytes += file_size(i);
+
+	fssh_dprintf("%" B_PRId32 " files, %g MB in %g s with %" B_PRId32
+		" writers: %g MB/s\n", files, bytes / 1048576.0, elapsed / 1000000.0,
+		writers, bytes / 1048576.0 / (elapsed / 1000000.0));
+
+	int64 totalRuns = 0;
+	int32 maxRuns = 0;
+	int32 fragmented = 0;
+	for (int32 i = 0; i < files; i++) {
+		char path[B_PATH_NAME_LENGTH];
+		file_path(path, sizeof(path), writers, i);
+
+		int32 runs;
+		status = count_runs(path, runs);
+		if (status != B_OK) {
+			fssh_dprintf("Error: Could not map %s: %s\n", path,
+				fssh_strerror(status));
+			return status;
+		}
+
+		totalRuns += runs;
+		if (runs > maxRuns)
+			maxRuns = runs;
+		if (runs > 1)
+			fragmented++;
+	}
+
+	fssh_dprintf("%g extents per file (at most %" B_PRId32 "), %" B_PRId32
+		" files with more than one\n", (double)totalRuns / files, maxRuns,
+		fragmented);
+	return B_OK;
+}
+
+
+}	// namespace FSShell